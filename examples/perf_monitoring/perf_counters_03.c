@@ -0,0 +1,192 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Export the performance counters in shared memory, and read them back from
+ * the region the way an external monitoring tool does.
+ */
+
+#include <starpu.h>
+#include <string.h>
+#include <inttypes.h>
+
+#if defined(STARPU_HAVE_UNISTD_H) && !defined(STARPU_SIMGRID) && !defined(STARPU_HAVE_WINDOWS)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+#define NTASKS 1000
+
+void func(void *buffers[], void *cl_args)
+{
+	(void)buffers;
+	(void)cl_args;
+}
+
+struct starpu_codelet cl =
+{
+	.cpu_funcs      = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers       = 0,
+	.name           = "perf_counter_export_f"
+};
+
+static const struct starpu_perf_export_header *header;
+
+/* Copy a value block, retrying while it is being updated */
+static void read_block(int scope, unsigned i, struct starpu_perf_export_block *copy)
+{
+	const struct starpu_perf_export_block *block = (const struct starpu_perf_export_block *) ((const char *) header + header->blocks_offset[scope] + i * header->block_size[scope]);
+	while (1)
+	{
+		uint64_t seq = block->seq;
+		if (seq & 1)
+			continue;
+		STARPU_RMB();
+		memcpy(copy, (const void *) block, header->block_size[scope]);
+		STARPU_RMB();
+		if (block->seq == seq)
+			return;
+	}
+}
+
+/* Return the int64 value of the counter in the block copy */
+static int64_t get_value(int scope, const struct starpu_perf_export_block *copy, const char *name)
+{
+	const struct starpu_perf_export_counter *counters = (const struct starpu_perf_export_counter *) ((const char *) header + header->counters_offset);
+	const union starpu_perf_export_value *values = (const union starpu_perf_export_value *) (copy + 1);
+	int s;
+	unsigned c;
+	for (s = 0; s < scope; s++)
+		counters += header->ncounters[s];
+	for (c = 0; c < header->ncounters[scope]; c++)
+		if (strcmp(counters[c].name, name) == 0)
+		{
+			STARPU_ASSERT(counters[c].type == starpu_perf_counter_type_int64);
+			return values[c].int64_val;
+		}
+	STARPU_ABORT();
+	return -1;
+}
+
+int main(void)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "/starpu_perf_counters_03.%d", (int) getpid());
+	setenv("STARPU_PERF_COUNTER_EXPORT", name, 1);
+	setenv("STARPU_PERF_COUNTER_EXPORT_PERIOD", "10", 1);
+
+	int ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+	{
+		/* the shared memory region could not be created */
+		starpu_shutdown();
+		return 77;
+	}
+	struct stat st;
+	ret = fstat(fd, &st);
+	STARPU_ASSERT(ret == 0);
+	void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	STARPU_ASSERT(addr != MAP_FAILED);
+	close(fd);
+	header = addr;
+	STARPU_ASSERT(memcmp(header->magic, STARPU_PERF_EXPORT_MAGIC, sizeof(header->magic)) == 0);
+	STARPU_ASSERT(header->version == STARPU_PERF_EXPORT_VERSION);
+	STARPU_ASSERT(header->size <= (uint64_t) st.st_size);
+	STARPU_ASSERT(header->nworkers == starpu_worker_get_count());
+	STARPU_ASSERT(header->running);
+
+	int i;
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl, 0);
+		if (ret == -ENODEV)
+			goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	size_t max_block_size = header->block_size[STARPU_PERF_EXPORT_GLOBAL];
+	if (header->block_size[STARPU_PERF_EXPORT_PER_WORKER] > max_block_size)
+		max_block_size = header->block_size[STARPU_PERF_EXPORT_PER_WORKER];
+	if (header->block_size[STARPU_PERF_EXPORT_PER_CODELET] > max_block_size)
+		max_block_size = header->block_size[STARPU_PERF_EXPORT_PER_CODELET];
+	struct starpu_perf_export_block *copy = malloc(max_block_size);
+
+	/* wait for the values to get published */
+	int64_t total_executed;
+	do
+	{
+		starpu_usleep(10000.);
+		total_executed = 0;
+		if (header->ncodelets > 0)
+		{
+			STARPU_RMB();
+			read_block(STARPU_PERF_EXPORT_PER_CODELET, 0, copy);
+			total_executed = get_value(STARPU_PERF_EXPORT_PER_CODELET, copy, "starpu.task.c_total_executed");
+		}
+	}
+	while (total_executed < NTASKS);
+
+	STARPU_ASSERT(header->ncodelets == 1);
+	STARPU_ASSERT(strcmp(copy->name, cl.name) == 0);
+	STARPU_ASSERT(get_value(STARPU_PERF_EXPORT_PER_CODELET, copy, "starpu.task.c_total_submitted") == NTASKS);
+	FPRINTF(stdout, "codelet %s: %"PRId64" tasks executed\n", copy->name, total_executed);
+
+	read_block(STARPU_PERF_EXPORT_GLOBAL, 0, copy);
+	int64_t total_submitted = get_value(STARPU_PERF_EXPORT_GLOBAL, copy, "starpu.task.g_total_submitted");
+	FPRINTF(stdout, "global: %"PRId64" tasks submitted\n", total_submitted);
+	STARPU_ASSERT(total_submitted >= NTASKS);
+
+	int64_t workers_executed = 0;
+	unsigned w;
+	for (w = 0; w < header->nworkers; w++)
+	{
+		read_block(STARPU_PERF_EXPORT_PER_WORKER, w, copy);
+		int64_t executed = get_value(STARPU_PERF_EXPORT_PER_WORKER, copy, "starpu.task.w_total_executed");
+		FPRINTF(stdout, "worker %s: %"PRId64" tasks executed\n", copy->name, executed);
+		workers_executed += executed;
+	}
+	STARPU_ASSERT(workers_executed >= NTASKS);
+
+	free(copy);
+	starpu_shutdown();
+
+	/* the final values remain readable, but the region is removed */
+	STARPU_ASSERT(!header->running);
+	STARPU_ASSERT(shm_open(name, O_RDONLY, 0) < 0);
+	munmap(addr, st.st_size);
+	return 0;
+
+enodev:
+	starpu_shutdown();
+	munmap(addr, st.st_size);
+	return 77;
+}
+#else
+int main(void)
+{
+	return 77;
+}
+#endif
@@ -0,0 +1,198 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Submit a chain of long tasks among many independent short tasks, and check
+ * that the critical path tracker finds the chain, first when it is made of
+ * implicit data dependencies, then of explicit task dependencies going
+ * through an empty task. Last, join the chain with a short branch which
+ * terminates after it, and check that the joining task keeps the chain.
+ */
+
+#include <starpu.h>
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+#define CHAIN 10
+#define NINDEPENDENT 50
+
+#define CHAIN_US 1000
+#define INDEPENDENT_US 100
+
+void sleep_func(void *buffers[], void *cl_arg)
+{
+	(void)buffers;
+	int duration;
+	starpu_codelet_unpack_args(cl_arg, &duration);
+	starpu_sleep(duration / 1000000.);
+}
+
+struct starpu_codelet chain_cl =
+{
+	.cpu_funcs = {sleep_func},
+	.cpu_funcs_name = {"sleep_func"},
+	.nbuffers = STARPU_VARIABLE_NBUFFERS,
+	.name = "critical_path_chain"
+};
+
+struct starpu_codelet independent_cl =
+{
+	.cpu_funcs = {sleep_func},
+	.cpu_funcs_name = {"sleep_func"},
+	.nbuffers = 0,
+	.name = "critical_path_independent"
+};
+
+static int submit_independent(void)
+{
+	int duration = INDEPENDENT_US;
+	int i, ret;
+	for (i = 0; i < NINDEPENDENT; i++)
+	{
+		ret = starpu_task_insert(&independent_cl, STARPU_VALUE, &duration, sizeof(duration), 0);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static void check(const char *phase, unsigned long ntasks)
+{
+	struct starpu_profiling_critical_path_info info;
+	starpu_profiling_critical_path_get_info(&info);
+
+	FPRINTF(stdout, "%s: critical path of %lu tasks, %.2lf us, stalled %.2lf us for workers and %.2lf us for data, over %.2lf us\n",
+		phase, info.ntasks, info.length, info.worker_stall, info.data_stall, info.elapsed);
+	if (!getenv("STARPU_SSILENT"))
+		starpu_profiling_critical_path_display_summary(stdout);
+
+	/* sleeping may last longer than requested, but not shorter */
+	STARPU_ASSERT(info.ntasks == ntasks);
+	STARPU_ASSERT(info.length >= ntasks * CHAIN_US);
+	STARPU_ASSERT(info.elapsed >= info.length);
+	STARPU_ASSERT(info.ncodelets == 1);
+	STARPU_ASSERT(info.codelets[0] == &chain_cl);
+	STARPU_ASSERT(info.codelet_length[0] == info.length);
+}
+
+int main(void)
+{
+	int ret;
+	int i;
+	int duration = CHAIN_US;
+	starpu_data_handle_t handle;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	starpu_void_data_register(&handle);
+	starpu_perf_counter_collection_start();
+
+	/* chain through implicit data dependencies */
+	for (i = 0; i < CHAIN; i++)
+	{
+		ret = starpu_task_insert(&chain_cl, STARPU_RW, handle, STARPU_VALUE, &duration, sizeof(duration), 0);
+		if (ret == -ENODEV)
+			goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		if (i == 0)
+		{
+			ret = submit_independent();
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	}
+	starpu_task_wait_for_all();
+	check("data dependencies", CHAIN);
+
+	starpu_profiling_critical_path_reset();
+
+	/* chain through task dependencies, with an empty task in the middle,
+	 * all declared before submission since the tasks are destroyed once
+	 * they are terminated */
+	struct starpu_task *tasks[CHAIN+1];
+	for (i = 0; i < CHAIN+1; i++)
+	{
+		if (i == CHAIN / 2)
+		{
+			tasks[i] = starpu_task_create();
+			tasks[i]->cl = NULL;
+		}
+		else
+			tasks[i] = starpu_task_build(&chain_cl, STARPU_VALUE, &duration, sizeof(duration), 0);
+		if (i > 0)
+			starpu_task_declare_deps(tasks[i], 1, tasks[i-1]);
+	}
+	for (i = 0; i < CHAIN+1; i++)
+	{
+		ret = starpu_task_submit(tasks[i]);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		if (i == 0)
+		{
+			ret = submit_independent();
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	}
+	starpu_task_wait_for_all();
+	check("task dependencies", CHAIN);
+
+	starpu_profiling_critical_path_reset();
+
+	/* fork/join: the chain and a short task, which only starts once the
+	 * chain is over, thanks to an empty gate task submitted late, are
+	 * joined by one task */
+	struct starpu_task *gate, *short_task, *join;
+	int short_duration = INDEPENDENT_US;
+	for (i = 0; i < CHAIN; i++)
+	{
+		tasks[i] = starpu_task_build(&chain_cl, STARPU_VALUE, &duration, sizeof(duration), 0);
+		if (i > 0)
+			starpu_task_declare_deps(tasks[i], 1, tasks[i-1]);
+	}
+	tasks[CHAIN-1]->detach = 0;
+	gate = starpu_task_create();
+	gate->cl = NULL;
+	short_task = starpu_task_build(&independent_cl, STARPU_VALUE, &short_duration, sizeof(short_duration), 0);
+	starpu_task_declare_deps(short_task, 1, gate);
+	join = starpu_task_build(&chain_cl, STARPU_VALUE, &duration, sizeof(duration), 0);
+	starpu_task_declare_deps(join, 2, tasks[CHAIN-1], short_task);
+	for (i = 0; i < CHAIN; i++)
+	{
+		ret = starpu_task_submit(tasks[i]);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+	ret = starpu_task_submit(short_task);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	ret = starpu_task_submit(join);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	ret = starpu_task_wait(tasks[CHAIN-1]);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait");
+	ret = starpu_task_submit(gate);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	starpu_task_wait_for_all();
+	check("fork/join", CHAIN+1);
+
+	starpu_perf_counter_collection_stop();
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+	return 0;
+
+enodev:
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+	return 77;
+}
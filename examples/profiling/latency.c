@@ -0,0 +1,112 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Record the latency histograms of tasks which mostly take 100us, but
+ * sometimes 2ms, and check that the tail latency shows up in the 99th
+ * percentile while the median is not affected.
+ */
+
+#include <starpu.h>
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 100
+#else
+#define NTASKS 400
+#endif
+
+#define SHORT_US 100
+#define LONG_US 2000
+/* one task out of LONG_RATIO is long */
+#define LONG_RATIO 20
+
+void sleep_func(void *buffers[], void *cl_arg)
+{
+	(void)buffers;
+	int duration;
+	starpu_codelet_unpack_args(cl_arg, &duration);
+	starpu_sleep(duration / 1000000.);
+}
+
+struct starpu_codelet cl =
+{
+	.cpu_funcs = {sleep_func},
+	.cpu_funcs_name = {"sleep_func"},
+	.nbuffers = 0,
+	.name = "latency_sleep"
+};
+
+int main(void)
+{
+	int ret;
+	int i;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	STARPU_ASSERT(starpu_perf_counter_name_to_id(starpu_perf_counter_scope_per_worker, "starpu.latency.w_queue_p99") >= 0);
+	STARPU_ASSERT(starpu_perf_counter_name_to_id(starpu_perf_counter_scope_per_codelet, "starpu.latency.c_exec_p999") >= 0);
+
+	starpu_perf_counter_collection_start();
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		int duration = i % LONG_RATIO == LONG_RATIO - 1 ? LONG_US : SHORT_US;
+		ret = starpu_task_insert(&cl, STARPU_VALUE, &duration, sizeof(duration), 0);
+		if (ret == -ENODEV)
+			goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	starpu_perf_counter_collection_stop();
+
+	double p50 = starpu_profiling_codelet_latency_percentile(&cl, 50.);
+	double p99 = starpu_profiling_codelet_latency_percentile(&cl, 99.);
+	double p999 = starpu_profiling_codelet_latency_percentile(&cl, 99.9);
+	FPRINTF(stdout, "codelet %s: p50 %.2lf us p99 %.2lf us p999 %.2lf us\n", cl.name, p50, p99, p999);
+	/* sleeping may last longer than requested, but not shorter, and the
+	 * buckets have a 1/16 precision */
+	STARPU_ASSERT(p50 >= SHORT_US * 15. / 16.);
+	STARPU_ASSERT(p50 < LONG_US * 15. / 16.);
+	STARPU_ASSERT(p99 >= LONG_US * 15. / 16.);
+	STARPU_ASSERT(p999 >= p99);
+
+	/* all tasks ran on the workers, which thus measured the same execution times */
+	double worker_p99 = starpu_profiling_worker_latency_percentile(-1, STARPU_PROFILING_LATENCY_EXEC, 99.);
+	STARPU_ASSERT(worker_p99 >= LONG_US * 15. / 16.);
+	double queue_p50 = starpu_profiling_worker_latency_percentile(-1, STARPU_PROFILING_LATENCY_QUEUE, 50.);
+	double fetch_p50 = starpu_profiling_worker_latency_percentile(-1, STARPU_PROFILING_LATENCY_FETCH, 50.);
+	FPRINTF(stdout, "all workers: queue p50 %.2lf us fetch p50 %.2lf us exec p99 %.2lf us\n", queue_p50, fetch_p50, worker_p99);
+	STARPU_ASSERT(queue_p50 > 0.);
+
+	if (!getenv("STARPU_SSILENT"))
+		starpu_profiling_latency_display_summary(stdout);
+
+	starpu_profiling_latency_reset();
+	STARPU_ASSERT(starpu_profiling_codelet_latency_percentile(&cl, 50.) == 0.);
+
+	starpu_shutdown();
+	return 0;
+
+enodev:
+	starpu_shutdown();
+	return 77;
+}
@@ -0,0 +1,477 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * This computes an SPMV with a sparse matrix whose rows have various lengths,
+ * stored both in the CSR format and in the SELL-C-sigma format, and compares
+ * the throughput of the CSR kernel with the one of the SELL kernels.
+ *
+ * The SELL-C-sigma kernels process the c rows of a slice at the same time in
+ * SIMD registers. They are available for c = 8 with AVX2 and c = 16 with
+ * AVX-512, when StarPU is built with e.g. CFLAGS=-march=native, otherwise a
+ * scalar kernel is used. -scalar forces using the scalar kernel.
+ */
+#include "spmv.h"
+
+#ifdef STARPU_QUICK_CHECK
+uint32_t size = 16*1024;
+unsigned niter = 2;
+#else
+uint32_t size = 512*1024;
+unsigned niter = 10;
+#endif
+unsigned nblocks = 4;
+#if defined(__AVX512F__)
+uint32_t c = 16;
+#else
+uint32_t c = 8;
+#endif
+uint32_t sigma = 256;
+unsigned scalar = 0;
+
+/* Maximum number of non-zero entries of a row */
+#define MAX_ROW_NNZ 32
+
+static void parse_args(int argc, char **argv)
+{
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-size") == 0)
+		{
+			char *argptr;
+			size = strtol(argv[++i], &argptr, 10);
+		}
+
+		if (strcmp(argv[i], "-nblocks") == 0)
+		{
+			char *argptr;
+			nblocks = strtol(argv[++i], &argptr, 10);
+		}
+
+		if (strcmp(argv[i], "-niter") == 0)
+		{
+			char *argptr;
+			niter = strtol(argv[++i], &argptr, 10);
+		}
+
+		if (strcmp(argv[i], "-c") == 0)
+		{
+			char *argptr;
+			c = strtol(argv[++i], &argptr, 10);
+		}
+
+		if (strcmp(argv[i], "-sigma") == 0)
+		{
+			char *argptr;
+			sigma = strtol(argv[++i], &argptr, 10);
+		}
+
+		if (strcmp(argv[i], "-scalar") == 0)
+			scalar = 1;
+	}
+}
+
+/* Number of non-zero entries of a row, spread between 1 and MAX_ROW_NNZ */
+static uint32_t row_nnz(uint32_t row)
+{
+	return 1 + (row * 2654435761U >> 16) % MAX_ROW_NNZ;
+}
+
+static struct starpu_codelet csr_spmv_cl =
+{
+	.cpu_funcs = {spmv_kernel_cpu},
+	.cpu_funcs_name = {"spmv_kernel_cpu"},
+	.nbuffers = 3,
+	.modes = {STARPU_R, STARPU_R, STARPU_W},
+	.name = "csr_spmv"
+};
+
+/* Implementation of sell_spmv_cl to use */
+static unsigned sell_impl;
+
+static int sell_can_execute(unsigned workerid, struct starpu_task *task, unsigned nimpl)
+{
+	(void)workerid;
+	(void)task;
+	return nimpl == sell_impl;
+}
+
+enum sell_impls
+{
+	SELL_IMPL_SCALAR,
+#ifdef __AVX2__
+	SELL_IMPL_AVX2,
+#endif
+#ifdef __AVX512F__
+	SELL_IMPL_AVX512,
+#endif
+};
+
+static const char *sell_impl_names[] =
+{
+	"scalar",
+#ifdef __AVX2__
+	"AVX2",
+#endif
+#ifdef __AVX512F__
+	"AVX-512",
+#endif
+};
+
+static struct starpu_codelet sell_spmv_cl =
+{
+	.can_execute = sell_can_execute,
+	.cpu_funcs =
+	{
+		sell_spmv_kernel_cpu,
+#ifdef __AVX2__
+		sell_spmv_kernel_avx2,
+#endif
+#ifdef __AVX512F__
+		sell_spmv_kernel_avx512,
+#endif
+	},
+	.cpu_funcs_name =
+	{
+		"sell_spmv_kernel_cpu",
+#ifdef __AVX2__
+		"sell_spmv_kernel_avx2",
+#endif
+#ifdef __AVX512F__
+		"sell_spmv_kernel_avx512",
+#endif
+	},
+	.nbuffers = 3,
+	.modes = {STARPU_R, STARPU_R, STARPU_W},
+	.name = "sell_spmv"
+};
+
+/* Used by compare_rows to sort the rows of a window by decreasing length */
+static uint32_t *sort_rowptr;
+
+static int compare_rows(const void *a, const void *b)
+{
+	uint32_t row_a = *(const uint32_t *) a;
+	uint32_t row_b = *(const uint32_t *) b;
+	uint32_t nnz_a = sort_rowptr[row_a+1] - sort_rowptr[row_a];
+	uint32_t nnz_b = sort_rowptr[row_b+1] - sort_rowptr[row_b];
+
+	if (nnz_a != nnz_b)
+		return nnz_a > nnz_b ? -1 : 1;
+	/* Keep the original order of rows of the same length */
+	return row_a < row_b ? -1 : row_a > row_b;
+}
+
+/* Convert a CSR matrix into a SELL-C-sigma matrix, whose arrays are allocated */
+static void csr_to_sell(uint32_t nrow, float *csr_nzval, uint32_t *csr_colind, uint32_t *rowptr,
+			uint32_t *nnz, float **nzval, uint32_t **colind, uint32_t **sliceptr, uint32_t **rowind)
+{
+	uint32_t nslices = (nrow + c - 1) / c;
+	uint32_t row, slice;
+
+	starpu_malloc((void **)rowind, nrow*sizeof(uint32_t));
+	starpu_malloc((void **)sliceptr, (nslices+1)*sizeof(uint32_t));
+
+	/* Sort the rows within the windows */
+	for (row = 0; row < nrow; row++)
+		(*rowind)[row] = row;
+	sort_rowptr = rowptr;
+	for (row = 0; row < nrow; row += sigma)
+		qsort(&(*rowind)[row], STARPU_MIN(sigma, nrow - row), sizeof(uint32_t), compare_rows);
+
+	/* Each slice is as wide as its longest row, i.e. its first one */
+	(*sliceptr)[0] = 0;
+	for (slice = 0; slice < nslices; slice++)
+	{
+		uint32_t first = (*rowind)[slice*c];
+		(*sliceptr)[slice+1] = (*sliceptr)[slice] + (rowptr[first+1] - rowptr[first]) * c;
+	}
+	*nnz = (*sliceptr)[nslices];
+
+	starpu_malloc((void **)nzval, *nnz*sizeof(float));
+	starpu_malloc((void **)colind, *nnz*sizeof(uint32_t));
+
+	for (slice = 0; slice < nslices; slice++)
+	{
+		uint32_t width = ((*sliceptr)[slice+1] - (*sliceptr)[slice]) / c;
+		uint32_t i, j;
+
+		for (i = 0; i < c; i++)
+		{
+			uint32_t lane_nnz = 0, lane_first = 0;
+			if (slice*c + i < nrow)
+			{
+				uint32_t lane_row = (*rowind)[slice*c + i];
+				lane_first = rowptr[lane_row];
+				lane_nnz = rowptr[lane_row+1] - lane_first;
+			}
+
+			for (j = 0; j < width; j++)
+			{
+				uint32_t index = (*sliceptr)[slice] + j*c + i;
+				if (j < lane_nnz)
+				{
+					(*nzval)[index] = csr_nzval[lane_first + j];
+					(*colind)[index] = csr_colind[lane_first + j];
+				}
+				else
+				{
+					/* padding */
+					(*nzval)[index] = 0.0f;
+					(*colind)[index] = 0;
+				}
+			}
+		}
+	}
+}
+
+/* Submit niter SPMVs on the nparts parts of the matrix, and return the time they took */
+static double run(struct starpu_codelet *cl, starpu_data_handle_t matrix, starpu_data_handle_t vector_in, starpu_data_handle_t vector_out, unsigned nparts)
+{
+	double start, end;
+	unsigned iter, part;
+	int ret;
+
+	start = starpu_timing_now();
+	for (iter = 0; iter < niter; iter++)
+	{
+		for (part = 0; part < nparts; part++)
+		{
+			ret = starpu_task_insert(cl,
+						 STARPU_R, starpu_data_get_sub_data(matrix, 1, part),
+						 STARPU_R, vector_in,
+						 STARPU_W, starpu_data_get_sub_data(vector_out, 1, part),
+						 0);
+			if (ret == -ENODEV)
+			{
+				FPRINTF(stderr, "No worker may execute this task\n");
+				starpu_shutdown();
+				exit(77);
+			}
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	}
+	starpu_task_wait_for_all();
+	end = starpu_timing_now();
+
+	return end - start;
+}
+
+static int check(float *vector_out, float *vector_exp_out, const char *format)
+{
+	uint32_t row;
+	for (row = 0; row < size; row++)
+	{
+		if (fabsf(vector_out[row] - vector_exp_out[row]) > 1e-5f * fabsf(vector_exp_out[row]))
+		{
+			FPRINTF(stderr, "%s check failed at %u: %f vs expected %f\n", format, row, vector_out[row], vector_exp_out[row]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	unsigned part, nparts_sell;
+	uint32_t row, pos;
+	double csr_timing, sell_timing;
+
+	/* CSR matrix description */
+	float *csr_nzval;
+	uint32_t csr_nnz;
+	uint32_t *csr_colind;
+	uint32_t *rowptr;
+
+	/* SELL-C-sigma matrix description */
+	float *sell_nzval;
+	uint32_t sell_nnz;
+	uint32_t *sell_colind;
+	uint32_t *sliceptr;
+	uint32_t *rowind;
+
+	float *vector_in_ptr;
+	float *vector_out_csr_ptr;
+	float *vector_out_sell_ptr;
+	float *vector_exp_out_ptr;
+	uint32_t *vector_parts;
+
+	starpu_data_handle_t csr_matrix, sell_matrix;
+	starpu_data_handle_t vector_in, vector_out_csr, vector_out_sell;
+
+	parse_args(argc, argv);
+
+	if (c == 0 || sigma < c || sigma % c)
+	{
+		FPRINTF(stderr, "sigma (%u) needs to be a multiple of c (%u)\n", sigma, c);
+		return EXIT_FAILURE;
+	}
+
+	sell_impl = SELL_IMPL_SCALAR;
+#ifdef __AVX2__
+	if (!scalar && c == 8)
+		sell_impl = SELL_IMPL_AVX2;
+#endif
+#ifdef __AVX512F__
+	if (!scalar && c == 16)
+		sell_impl = SELL_IMPL_AVX512;
+#endif
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		FPRINTF(stderr, "This example needs CPU workers\n");
+		starpu_shutdown();
+		return 77;
+	}
+
+	/*
+	 *	Create the CSR matrix, and convert it
+	 */
+	csr_nnz = 0;
+	for (row = 0; row < size; row++)
+		csr_nnz += row_nnz(row);
+	starpu_malloc((void **)&csr_nzval, csr_nnz*sizeof(float));
+	starpu_malloc((void **)&csr_colind, csr_nnz*sizeof(uint32_t));
+	starpu_malloc((void **)&rowptr, (size+1)*sizeof(uint32_t));
+
+	for (row = 0, pos = 0; row < size; row++)
+	{
+		uint32_t j;
+		rowptr[row] = pos;
+		for (j = 0; j < row_nnz(row); j++)
+		{
+			csr_nzval[pos] = 1 + (row + j) % 4;
+			csr_colind[pos] = (row + j * 97) % size;
+			pos++;
+		}
+	}
+	rowptr[size] = csr_nnz;
+
+	csr_to_sell(size, csr_nzval, csr_colind, rowptr, &sell_nnz, &sell_nzval, &sell_colind, &sliceptr, &rowind);
+
+	starpu_malloc((void **)&vector_in_ptr, size*sizeof(float));
+	starpu_malloc((void **)&vector_out_csr_ptr, size*sizeof(float));
+	starpu_malloc((void **)&vector_out_sell_ptr, size*sizeof(float));
+	vector_exp_out_ptr = malloc(size*sizeof(float));
+	for (row = 0; row < size; row++)
+		vector_in_ptr[row] = row % 100;
+	for (row = 0; row < size; row++)
+	{
+		vector_exp_out_ptr[row] = 0.0f;
+		for (pos = rowptr[row]; pos < rowptr[row+1]; pos++)
+			vector_exp_out_ptr[row] += csr_nzval[pos] * vector_in_ptr[csr_colind[pos]];
+	}
+
+	/*
+	 *	Register and partition the data
+	 */
+	starpu_csr_data_register(&csr_matrix, STARPU_MAIN_RAM, csr_nnz, size, (uintptr_t)csr_nzval, csr_colind, rowptr, 0, sizeof(float));
+	starpu_sell_data_register(&sell_matrix, STARPU_MAIN_RAM, sell_nnz, size, c, sigma, (uintptr_t)sell_nzval, sell_colind, sliceptr, rowind, 0, sizeof(float));
+	starpu_vector_data_register(&vector_in, STARPU_MAIN_RAM, (uintptr_t)vector_in_ptr, size, sizeof(float));
+	starpu_vector_data_register(&vector_out_csr, STARPU_MAIN_RAM, (uintptr_t)vector_out_csr_ptr, size, sizeof(float));
+	starpu_vector_data_register(&vector_out_sell, STARPU_MAIN_RAM, (uintptr_t)vector_out_sell_ptr, size, sizeof(float));
+
+	{
+		struct starpu_data_filter csr_f =
+		{
+			.filter_func = starpu_csr_filter_vertical_block,
+			.nchildren = nblocks,
+		};
+		struct starpu_data_filter vector_f =
+		{
+			.filter_func = starpu_vector_filter_block,
+			.nchildren = nblocks,
+		};
+		starpu_data_partition(csr_matrix, &csr_f);
+		starpu_data_partition(vector_out_csr, &vector_f);
+	}
+
+	/* The SELL-C-sigma matrix can only be split on window boundaries */
+	nparts_sell = STARPU_MIN(nblocks, (size + sigma - 1) / sigma);
+	vector_parts = malloc(nparts_sell*sizeof(*vector_parts));
+	{
+		struct starpu_data_filter sell_f =
+		{
+			.filter_func = starpu_sell_filter_vertical_block,
+			.nchildren = nparts_sell,
+		};
+		struct starpu_data_filter vector_f =
+		{
+			.filter_func = starpu_vector_filter_list,
+			.nchildren = nparts_sell,
+			.filter_arg_ptr = vector_parts,
+		};
+		starpu_data_partition(sell_matrix, &sell_f);
+		for (part = 0; part < nparts_sell; part++)
+			vector_parts[part] = starpu_sell_get_nrow(starpu_data_get_sub_data(sell_matrix, 1, part));
+		starpu_data_partition(vector_out_sell, &vector_f);
+	}
+
+	/*
+	 *	Run the SPMVs
+	 */
+	csr_timing = run(&csr_spmv_cl, csr_matrix, vector_in, vector_out_csr, nblocks);
+	sell_timing = run(&sell_spmv_cl, sell_matrix, vector_in, vector_out_sell, nparts_sell);
+
+	starpu_data_unpartition(csr_matrix, STARPU_MAIN_RAM);
+	starpu_data_unpartition(vector_out_csr, STARPU_MAIN_RAM);
+	starpu_data_unpartition(sell_matrix, STARPU_MAIN_RAM);
+	starpu_data_unpartition(vector_out_sell, STARPU_MAIN_RAM);
+	free(vector_parts);
+
+	starpu_data_unregister(csr_matrix);
+	starpu_data_unregister(sell_matrix);
+	starpu_data_unregister(vector_in);
+	starpu_data_unregister(vector_out_csr);
+	starpu_data_unregister(vector_out_sell);
+
+	starpu_shutdown();
+
+	/*
+	 *	Check and display the results
+	 */
+	ret = check(vector_out_csr_ptr, vector_exp_out_ptr, "CSR");
+	ret |= check(vector_out_sell_ptr, vector_exp_out_ptr, "SELL");
+
+	FPRINTF(stderr, "%u rows, %u non-zero entries, %u stored entries in SELL-%u-%u (%.1f%% of padding)\n",
+		size, csr_nnz, sell_nnz, c, sigma, 100. * (sell_nnz - csr_nnz) / sell_nnz);
+	FPRINTF(stderr, "CSR: %.3f ms per SPMV, %.3f GFlop/s\n",
+		csr_timing / niter / 1000, 2. * csr_nnz * niter / csr_timing / 1000);
+	FPRINTF(stderr, "SELL-%u-%u (%s kernel): %.3f ms per SPMV, %.3f GFlop/s\n",
+		c, sigma, sell_impl_names[sell_impl],
+		sell_timing / niter / 1000, 2. * csr_nnz * niter / sell_timing / 1000);
+
+	starpu_free_noflag(csr_nzval, csr_nnz*sizeof(float));
+	starpu_free_noflag(csr_colind, csr_nnz*sizeof(uint32_t));
+	starpu_free_noflag(rowptr, (size+1)*sizeof(uint32_t));
+	starpu_free_noflag(sell_nzval, sell_nnz*sizeof(float));
+	starpu_free_noflag(sell_colind, sell_nnz*sizeof(uint32_t));
+	starpu_free_noflag(sliceptr, ((size + c - 1) / c + 1)*sizeof(uint32_t));
+	starpu_free_noflag(rowind, size*sizeof(uint32_t));
+	starpu_free_noflag(vector_in_ptr, size*sizeof(float));
+	starpu_free_noflag(vector_out_csr_ptr, size*sizeof(float));
+	starpu_free_noflag(vector_out_sell_ptr, size*sizeof(float));
+	free(vector_exp_out_ptr);
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* CPU codelets for SPMV with a SELL-C-sigma matrix */
+
+#include "spmv.h"
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/* The rows of a slice are processed together: the j-th entries of the c rows
+ * are contiguous, so that they can be loaded in one SIMD register, and the
+ * corresponding entries of the input vector are gathered. The result of each
+ * lane is then stored at the original index of its row. */
+
+void sell_spmv_kernel_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	float *nzval = (float *)STARPU_SELL_GET_NZVAL(descr[0]);
+	uint32_t *colind = STARPU_SELL_GET_COLIND(descr[0]);
+	uint32_t *sliceptr = STARPU_SELL_GET_SLICEPTR(descr[0]);
+	uint32_t *rowind = STARPU_SELL_GET_ROWIND(descr[0]);
+	uint32_t nrow = STARPU_SELL_GET_NROW(descr[0]);
+	uint32_t c = STARPU_SELL_GET_C(descr[0]);
+	uint32_t nslices = STARPU_SELL_GET_NSLICES(descr[0]);
+	uint32_t firstentry = STARPU_SELL_GET_FIRSTENTRY(descr[0]);
+	uint32_t firstrow = STARPU_SELL_GET_FIRSTROW(descr[0]);
+
+	float *vecin = (float *)STARPU_VECTOR_GET_PTR(descr[1]);
+	float *vecout = (float *)STARPU_VECTOR_GET_PTR(descr[2]);
+
+	float tmp[c];
+	uint32_t slice;
+
+	STARPU_ASSERT(nrow == STARPU_VECTOR_GET_NX(descr[2]));
+
+	for (slice = 0; slice < nslices; slice++)
+	{
+		uint32_t first = sliceptr[slice] - firstentry;
+		uint32_t width = (sliceptr[slice+1] - sliceptr[slice]) / c;
+		uint32_t nlanes = STARPU_MIN(c, nrow - slice*c);
+		uint32_t i, j;
+
+		for (i = 0; i < c; i++)
+			tmp[i] = 0.0f;
+
+		for (j = 0; j < width; j++)
+		{
+			float *val = &nzval[first + j*c];
+			uint32_t *col = &colind[first + j*c];
+			for (i = 0; i < c; i++)
+				tmp[i] += val[i]*vecin[col[i]];
+		}
+
+		for (i = 0; i < nlanes; i++)
+			vecout[rowind[slice*c + i] - firstrow] = tmp[i];
+	}
+}
+
+#ifdef __AVX2__
+void sell_spmv_kernel_avx2(void *descr[], void *arg)
+{
+	(void)arg;
+	float *nzval = (float *)STARPU_SELL_GET_NZVAL(descr[0]);
+	uint32_t *colind = STARPU_SELL_GET_COLIND(descr[0]);
+	uint32_t *sliceptr = STARPU_SELL_GET_SLICEPTR(descr[0]);
+	uint32_t *rowind = STARPU_SELL_GET_ROWIND(descr[0]);
+	uint32_t nrow = STARPU_SELL_GET_NROW(descr[0]);
+	uint32_t nslices = STARPU_SELL_GET_NSLICES(descr[0]);
+	uint32_t firstentry = STARPU_SELL_GET_FIRSTENTRY(descr[0]);
+	uint32_t firstrow = STARPU_SELL_GET_FIRSTROW(descr[0]);
+
+	float *vecin = (float *)STARPU_VECTOR_GET_PTR(descr[1]);
+	float *vecout = (float *)STARPU_VECTOR_GET_PTR(descr[2]);
+
+	float tmp[8] STARPU_ATTRIBUTE_ALIGNED(32);
+	uint32_t slice;
+
+	STARPU_ASSERT(STARPU_SELL_GET_C(descr[0]) == 8);
+	STARPU_ASSERT(nrow == STARPU_VECTOR_GET_NX(descr[2]));
+
+	for (slice = 0; slice < nslices; slice++)
+	{
+		uint32_t first = sliceptr[slice] - firstentry;
+		uint32_t last = sliceptr[slice+1] - firstentry;
+		uint32_t nlanes = STARPU_MIN(8, nrow - slice*8);
+		__m256 sum = _mm256_setzero_ps();
+		uint32_t index, i;
+
+		for (index = first; index < last; index += 8)
+		{
+			__m256 val = _mm256_loadu_ps(&nzval[index]);
+			__m256i col = _mm256_loadu_si256((__m256i *) &colind[index]);
+			__m256 x = _mm256_i32gather_ps(vecin, col, sizeof(float));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(val, x));
+		}
+
+		_mm256_store_ps(tmp, sum);
+		for (i = 0; i < nlanes; i++)
+			vecout[rowind[slice*8 + i] - firstrow] = tmp[i];
+	}
+}
+#endif /* __AVX2__ */
+
+#ifdef __AVX512F__
+void sell_spmv_kernel_avx512(void *descr[], void *arg)
+{
+	(void)arg;
+	float *nzval = (float *)STARPU_SELL_GET_NZVAL(descr[0]);
+	uint32_t *colind = STARPU_SELL_GET_COLIND(descr[0]);
+	uint32_t *sliceptr = STARPU_SELL_GET_SLICEPTR(descr[0]);
+	uint32_t *rowind = STARPU_SELL_GET_ROWIND(descr[0]);
+	uint32_t nrow = STARPU_SELL_GET_NROW(descr[0]);
+	uint32_t nslices = STARPU_SELL_GET_NSLICES(descr[0]);
+	uint32_t firstentry = STARPU_SELL_GET_FIRSTENTRY(descr[0]);
+	uint32_t firstrow = STARPU_SELL_GET_FIRSTROW(descr[0]);
+
+	float *vecin = (float *)STARPU_VECTOR_GET_PTR(descr[1]);
+	float *vecout = (float *)STARPU_VECTOR_GET_PTR(descr[2]);
+
+	__m512i vfirstrow = _mm512_set1_epi32(firstrow);
+	uint32_t slice;
+
+	STARPU_ASSERT(STARPU_SELL_GET_C(descr[0]) == 16);
+	STARPU_ASSERT(nrow == STARPU_VECTOR_GET_NX(descr[2]));
+
+	for (slice = 0; slice < nslices; slice++)
+	{
+		uint32_t first = sliceptr[slice] - firstentry;
+		uint32_t last = sliceptr[slice+1] - firstentry;
+		uint32_t nlanes = STARPU_MIN(16, nrow - slice*16);
+		__mmask16 lanes = (__mmask16) ((1U << nlanes) - 1);
+		__m512 sum = _mm512_setzero_ps();
+		__m512i rows;
+		uint32_t index;
+
+		for (index = first; index < last; index += 16)
+		{
+			__m512 val = _mm512_loadu_ps(&nzval[index]);
+			__m512i col = _mm512_loadu_si512(&colind[index]);
+			__m512 x = _mm512_i32gather_ps(col, vecin, sizeof(float));
+			sum = _mm512_add_ps(sum, _mm512_mul_ps(val, x));
+		}
+
+		/* The last slice may be partial, only store the lanes of actual rows */
+		rows = _mm512_maskz_loadu_epi32(lanes, &rowind[slice*16]);
+		rows = _mm512_sub_epi32(rows, vfirstrow);
+		_mm512_mask_i32scatter_ps(vecout, lanes, rows, sum, sizeof(float));
+	}
+}
+#endif /* __AVX512F__ */
@@ -18,11 +18,17 @@
 /*
  * This computes an SPMV with a CSR sparse matrix, by splitting it in
  * horizontal stripes and processing them in parallel.
+ *
+ * With -powerlaw, the matrix has a power-law distribution of its non-zero
+ * entries instead of being 3-band, and with -nnz, the stripes contain the
+ * same number of non-zero entries instead of the same number of rows.
  */
 #include "spmv.h"
 
 unsigned nblocks = 4;
 uint32_t size = 4*1024*1024;
+unsigned powerlaw = 0;
+unsigned balance_nnz = 0;
 
 starpu_data_handle_t sparse_matrix;
 starpu_data_handle_t vector_in, vector_out;
@@ -43,6 +49,12 @@ static void parse_args(int argc, char **argv)
 			char *argptr;
 			nblocks = strtol(argv[++i], &argptr, 10);
 		}
+
+		if (strcmp(argv[i], "-powerlaw") == 0)
+			powerlaw = 1;
+
+		if (strcmp(argv[i], "-nnz") == 0)
+			balance_nnz = 1;
 	}
 }
 
@@ -62,6 +74,14 @@ static struct starpu_data_filter vector_f =
 	.nchildren = -1,
 };
 
+/* Number of non-zero entries of row i of the power-law matrix: a few rows
+ * are very dense, most of them only have a handful of entries */
+static uint32_t powerlaw_row_nnz(uint32_t row)
+{
+	uint32_t row_nnz = 1 + (size / 8) / (row + 1);
+	return STARPU_MIN(row_nnz, size);
+}
+
 static struct starpu_codelet spmv_cl =
 {
 	.cpu_funcs = {spmv_kernel_cpu},
@@ -88,6 +108,7 @@ int main(int argc, char **argv)
 	double start, end;
 	unsigned row, pos;
 	unsigned ind;
+	uint32_t *vector_parts;
 
 	/* CSR matrix description */
 	float *nzval;
@@ -114,9 +135,17 @@ int main(int argc, char **argv)
 	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
 
 	/*
-	 *	Create a 3-band sparse matrix as input example
+	 *	Create a 3-band sparse matrix as input example, or a
+	 *	power-law one
 	 */
-	nnz = 3*size-2;
+	if (powerlaw)
+	{
+		nnz = 0;
+		for (row = 0; row < size; row++)
+			nnz += powerlaw_row_nnz(row);
+	}
+	else
+		nnz = 3*size-2;
 	starpu_malloc((void **)&nzval, nnz*sizeof(float));
 	starpu_malloc((void **)&colind, nnz*sizeof(uint32_t));
 	starpu_malloc((void **)&rowptr, (size+1)*sizeof(uint32_t));
@@ -130,6 +159,20 @@ int main(int argc, char **argv)
 	{
 		rowptr[row] = pos;
 
+		if (powerlaw)
+		{
+			/* spread the entries of the row over the columns */
+			uint32_t row_nnz = powerlaw_row_nnz(row);
+			uint32_t j;
+			for (j = 0; j < row_nnz; j++)
+			{
+				nzval[pos] = 1 + j % 4;
+				colind[pos] = (uint32_t) (((uint64_t) j * size) / row_nnz);
+				pos++;
+			}
+			continue;
+		}
+
 		if (row > 0)
 		{
 			nzval[pos] = LOWER_BAND;
@@ -178,9 +221,28 @@ int main(int argc, char **argv)
 	 */
 	csr_f.nchildren = nblocks;
 	vector_f.nchildren = nblocks;
+	vector_parts = malloc(nblocks*sizeof(*vector_parts));
+	if (balance_nnz)
+	{
+		/* split the output vector along the rows of the CSR stripes */
+		csr_f.filter_func = starpu_csr_filter_vertical_block_nnz;
+		for (part = 0; part < nblocks; part++)
+		{
+			size_t part_nrow;
+			starpu_filter_nparts_compute_nnz_chunk_size_and_offset(rowptr, size, nblocks, part, &part_nrow, NULL);
+			vector_parts[part] = part_nrow;
+		}
+		vector_f.filter_func = starpu_vector_filter_list;
+		vector_f.filter_arg_ptr = vector_parts;
+	}
 	starpu_data_partition(sparse_matrix, &csr_f);
 	starpu_data_partition(vector_out, &vector_f);
 
+	for (part = 0; part < nblocks; part++)
+		FPRINTF(stderr, "block %u: %u rows, %u non-zero entries\n", part,
+			starpu_csr_get_nrow(starpu_data_get_sub_data(sparse_matrix, 1, part)),
+			starpu_csr_get_nnz(starpu_data_get_sub_data(sparse_matrix, 1, part)));
+
 	/*
 	 *	If we use OpenCL, we need to compile the SpMV kernel
 	 */
@@ -218,6 +280,7 @@ int main(int argc, char **argv)
 	 */
 	starpu_data_unpartition(sparse_matrix, STARPU_MAIN_RAM);
 	starpu_data_unpartition(vector_out, STARPU_MAIN_RAM);
+	free(vector_parts);
 
 	/*
 	 *	Unregister data
@@ -238,6 +301,12 @@ int main(int argc, char **argv)
 	memset(vector_exp_out_ptr, 0, sizeof(vector_exp_out_ptr[0])*size);
 	for (row = 0; row < size; row++)
 	{
+		if (powerlaw)
+		{
+			for (pos = rowptr[row]; pos < rowptr[row+1]; pos++)
+				vector_exp_out_ptr[row] += nzval[pos] * vector_in_ptr[colind[pos]];
+			continue;
+		}
 		if (row > 0)
 			vector_exp_out_ptr[row] += LOWER_BAND * vector_in_ptr[row-1];
 		vector_exp_out_ptr[row] += MIDDLE_BAND * vector_in_ptr[row];
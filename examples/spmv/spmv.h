@@ -38,4 +38,12 @@ void compile_spmv_opencl_kernel(void);
 
 void spmv_kernel_cpu(void *descr[], void *arg);
 
+void sell_spmv_kernel_cpu(void *descr[], void *arg);
+#ifdef __AVX2__
+void sell_spmv_kernel_avx2(void *descr[], void *arg);
+#endif
+#ifdef __AVX512F__
+void sell_spmv_kernel_avx512(void *descr[], void *arg);
+#endif
+
 #endif /* __SPMV_H__ */
@@ -404,6 +404,18 @@ struct starpu_data_interface_ops *starpu_bcsr_filter_canonical_block_child_ops(s
 */
 void starpu_bcsr_filter_vertical_block(void *parent_interface, void *child_interface, struct starpu_data_filter *f, unsigned id, unsigned nparts);
 
+/**
+   Partition a block-sparse matrix into block-sparse matrices, like
+   starpu_bcsr_filter_vertical_block(), but such that the parts contain
+   about the same number of non-zero blocks instead of the same number of
+   rows of blocks, which balances the parts of matrices with irregular
+   rows. See starpu_filter_nparts_compute_nnz_chunk_size_and_offset() for
+   the split.
+
+   See \ref BCSRDataInterface for more details.
+*/
+void starpu_bcsr_filter_vertical_block_nnz(void *parent_interface, void *child_interface, struct starpu_data_filter *f, unsigned id, unsigned nparts);
+
 /** @} */
 
 /**
@@ -420,6 +432,38 @@ void starpu_bcsr_filter_vertical_block(void *parent_interface, void *child_inter
 */
 void starpu_csr_filter_vertical_block(void *parent_interface, void *child_interface, struct starpu_data_filter *f, unsigned id, unsigned nparts);
 
+/**
+   Partition a sparse matrix into vertical sparse matrices, like
+   starpu_csr_filter_vertical_block(), but such that the parts contain about
+   the same number of non-zero entries instead of the same number of rows,
+   which balances the parts of matrices with irregular rows, e.g. with a
+   power-law distribution of the non-zero entries. See
+   starpu_filter_nparts_compute_nnz_chunk_size_and_offset() for the split.
+
+   See \ref CSRDataInterface for more details.
+*/
+void starpu_csr_filter_vertical_block_nnz(void *parent_interface, void *child_interface, struct starpu_data_filter *f, unsigned id, unsigned nparts);
+
+/** @} */
+
+/**
+   @name Predefined SELL Filter Functions
+   Predefined partitioning functions for SELL-C-sigma data. Examples on how to
+   use them are shown in \ref PartitioningData.
+   @{
+*/
+
+/**
+   Partition a SELL-C-sigma sparse matrix into vertical SELL-C-sigma sparse
+   matrices. The split is done on the boundaries of the sorting windows of
+   sigma rows, so that each part holds a contiguous range of rows of the
+   original matrix, and its slices are left untouched. The number of parts
+   thus can not be larger than the number of sorting windows.
+
+   See \ref SELLDataInterface for more details.
+*/
+void starpu_sell_filter_vertical_block(void *parent_interface, void *child_interface, struct starpu_data_filter *f, unsigned id, unsigned nparts);
+
 /** @} */
 
 /**
@@ -1144,6 +1188,19 @@ struct starpu_data_interface_ops *starpu_ndim_filter_to_variable_child_ops(struc
  */
 void starpu_filter_nparts_compute_chunk_size_and_offset(unsigned n, unsigned nparts, size_t elemsize, unsigned id, size_t blocksize, size_t *chunk_size, size_t *offset);
 
+/**
+   Given the row pointer array \p rowptr of a sparse matrix of \p nrow rows,
+   and \p nparts the number of parts it must be divided in, determine the
+   number of rows \p chunk_size and the index of the first row \p offset of
+   the part \p id, such that all the parts contain about the same number of
+   non-zero entries. Each part contains at least one row, so \p nparts must not
+   be greater than \p nrow.
+   This is the split made by starpu_csr_filter_vertical_block_nnz() and
+   starpu_bcsr_filter_vertical_block_nnz(), and can e.g. be used to partition
+   vectors accordingly with starpu_vector_filter_list().
+ */
+void starpu_filter_nparts_compute_nnz_chunk_size_and_offset(const uint32_t *rowptr, unsigned nrow, unsigned nparts, unsigned id, size_t *chunk_size, size_t *offset);
+
 /** @} */
 
 /** @} */
@@ -389,7 +389,8 @@ enum starpu_data_interface_id
 	STARPU_COO_INTERFACE_ID		= 8,  /**< Identifier for the COO data interface*/
 	STARPU_TENSOR_INTERFACE_ID	= 9,  /**< Identifier for the tensor data interface*/
 	STARPU_NDIM_INTERFACE_ID	= 10, /**< Identifier for the ndim array data interface*/
-	STARPU_MAX_INTERFACE_ID		= 11  /**< Maximum number of data interfaces */
+	STARPU_SELL_INTERFACE_ID	= 11, /**< Identifier for the SELL-C-sigma data interface*/
+	STARPU_MAX_INTERFACE_ID		= 12  /**< Maximum number of data interfaces */
 };
 
 /**
@@ -1097,6 +1098,31 @@ void starpu_check_on_node(unsigned node, uintptr_t addr, size_t size);
 */
 void starpu_malloc_on_node_set_default_flags(unsigned node, int flags);
 
+/**
+   Statistics of the allocation pool of a memory node, see
+   starpu_malloc_pool_get_stats().
+*/
+struct starpu_malloc_pool_stats
+{
+	unsigned long hits;	/**< allocations served from the pool */
+	unsigned long misses;	/**< allocations which had to be performed by the underlying allocator */
+	unsigned long cached;	/**< deallocations whose buffer was kept in the pool */
+	unsigned long released;	/**< deallocations which were given back to the underlying allocator because the pool was full */
+	unsigned long flushed;	/**< buffers released from the pool to make room for other allocations */
+	size_t cached_size;	/**< amount of memory currently kept in the pool */
+	size_t max_cached_size;	/**< maximum amount of memory which was kept in the pool */
+};
+
+/**
+   Fill \p stats with the statistics of the allocation pool of the
+   memory node \p node, which is used by starpu_malloc_on_node_flags()
+   for allocations which are not suballocated, when the environment
+   variable \ref STARPU_MALLOC_POOL is set. Return -ENODEV if the pools
+   are disabled, 0 otherwise.
+	See \ref AllocationPools for more details.
+*/
+int starpu_malloc_pool_get_stats(unsigned node, struct starpu_malloc_pool_stats *stats);
+
 /** @} */
 
 /**
@@ -2695,6 +2721,233 @@ size_t starpu_bcsr_get_elemsize(starpu_data_handle_t handle);
 
 /** @} */
 
+/**
+   @name SELL Data Interface
+   @{
+*/
+
+extern struct starpu_data_interface_ops starpu_interface_sell_ops;
+
+/**
+   SELL-C-sigma interface for sparse matrices (sliced ELLPACK with a
+   sorting window).
+
+   The rows are cut in slices of \p c consecutive rows, which are stored
+   column-major and padded to the length of their longest row, so that
+   a SIMD unit of \p c lanes can process the \p c rows of a slice at the
+   same time. To limit the padding, rows are first sorted by decreasing
+   number of non-zero entries within windows of \p sigma rows. The row
+   stored at lane i of slice s is thus the row rowind[s*c+i] of the
+   original matrix, and its j-th entry is at index
+   sliceptr[s]-firstentry+j*c+i of nzval and colind. Padding entries
+   have a zero value and a zero column index.
+
+   Note: when a SELL-C-sigma matrix is partitioned, nzval, colind,
+   sliceptr and rowind point into the corresponding parent arrays. The
+   sliceptr content is thus the same as the parent's. Firstentry is
+   used to offset this so it becomes valid for the child arrays, and
+   firstrow gives the original index of the first row of the child.
+*/
+struct starpu_sell_interface
+{
+	enum starpu_data_interface_id id; /**< Identifier of the interface */
+
+	uint32_t nnz;   /**< number of stored entries, including the padding */
+	uint32_t nrow;  /**< number of rows */
+	uint32_t c;     /**< number of rows of the slices */
+	uint32_t sigma; /**< number of rows of the sorting windows, a multiple of c */
+
+	uintptr_t nzval;        /**< stored values: nnz elements, slice by slice, column-major within slices */
+	uint32_t *colind;       /**< array of nnz elements, colind[i] is the column index of nzval[i] */
+	uint32_t *sliceptr;     /**< array of (nrow+c-1)/c+1 elements, sliceptr[s] is the index in nzval of the first entry of slice s, the last one is the number of stored entries */
+	uint32_t *rowind;       /**< array of nrow elements, rowind[i] is the original index of the i-th stored row */
+	uint32_t *ram_colind;   /**< array of nnz elements (stored in RAM) */
+	uint32_t *ram_sliceptr; /**< array of (nrow+c-1)/c+1 elements (stored in RAM) */
+	uint32_t *ram_rowind;   /**< array of nrow elements (stored in RAM) */
+
+	uint32_t firstentry; /**< k for k-based indexing of sliceptr (0 or 1 usually). Also useful when partitioning the matrix. */
+	uint32_t firstrow;   /**< original index of the first row, i.e. the smallest value of rowind */
+
+	size_t elemsize; /**< size of the elements of the matrix */
+};
+
+/**
+   This variant of starpu_data_register() uses the SELL-C-sigma (sliced
+   ELLPACK with a sorting window) sparse matrix interface. Register the
+   sparse matrix of \p nrow rows cut in slices of \p c rows, whose \p
+   nnz stored entries (including the padding) of size \p elemsize are
+   stored in \p nzval and whose column indexes are stored in \p colind,
+   and initialize \p handle to represent it. \p sliceptr is an array of
+   (nrow+c-1)/c+1 elements, sliceptr[s] is the index in \p nzval of the
+   first entry of slice s, and the last element is the number of stored
+   entries. \p rowind is an array of \p nrow elements which gives the
+   original index of each stored row, rows having been sorted within
+   windows of \p sigma rows, \p sigma being a multiple of \p c. \p
+   firstentry is the index of the first entry of \p sliceptr (usually 0
+   or 1).
+
+   Here an example with the following matrix, with c = 2 and sigma = 4:
+
+   \code  |  1   0   0   0 | \endcode
+   \code  |  2   3   4   0 | \endcode
+   \code  |  0   0   5   0 | \endcode
+   \code  |  0   6   0   7 | \endcode
+
+   \code rowind   = [1, 3] ++ [0, 2] \endcode
+   \code nzval    = [2, 6, 3, 7, 4, 0] ++ [1, 5] \endcode
+   \code colind   = [0, 1, 1, 3, 2, 0] ++ [0, 2] \endcode
+   \code sliceptr = [0, 6, 8] \endcode
+
+   See \ref SELLDataInterface for more details.
+*/
+void starpu_sell_data_register(starpu_data_handle_t *handle, int home_node, uint32_t nnz, uint32_t nrow, uint32_t c, uint32_t sigma, uintptr_t nzval, uint32_t *colind, uint32_t *sliceptr, uint32_t *rowind, uint32_t firstentry, size_t elemsize);
+
+/**
+   Return the number of stored entries, including the padding, in the
+   matrix designated by \p handle.
+ */
+uint32_t starpu_sell_get_nnz(starpu_data_handle_t handle);
+
+/**
+   Return the number of rows in the matrix designated by \p handle.
+ */
+uint32_t starpu_sell_get_nrow(starpu_data_handle_t handle);
+
+/**
+   Return the number of rows of the slices of the matrix designated by
+   \p handle.
+ */
+uint32_t starpu_sell_get_c(starpu_data_handle_t handle);
+
+/**
+   Return the number of rows of the sorting windows of the matrix
+   designated by \p handle.
+ */
+uint32_t starpu_sell_get_sigma(starpu_data_handle_t handle);
+
+/**
+   Return the index at which the slice pointers of the matrix
+   designated by \p handle start.
+ */
+uint32_t starpu_sell_get_firstentry(starpu_data_handle_t handle);
+
+/**
+   Return the original index of the first row of the matrix designated
+   by \p handle.
+ */
+uint32_t starpu_sell_get_firstrow(starpu_data_handle_t handle);
+
+/**
+   Return the size of the elements in the matrix designated by \p
+   handle.
+ */
+size_t starpu_sell_get_elemsize(starpu_data_handle_t handle);
+
+/**
+   Return a pointer to the stored values of the matrix designated by
+   \p handle.
+ */
+uintptr_t starpu_sell_get_local_nzval(starpu_data_handle_t handle);
+
+/**
+   Return a pointer to the column indexes of the stored values of the
+   matrix designated by \p handle.
+ */
+uint32_t *starpu_sell_get_local_colind(starpu_data_handle_t handle);
+
+/**
+   Return a pointer to the slice pointer array of the matrix designated
+   by \p handle.
+ */
+uint32_t *starpu_sell_get_local_sliceptr(starpu_data_handle_t handle);
+
+/**
+   Return a pointer to the original row indexes of the matrix designated
+   by \p handle.
+ */
+uint32_t *starpu_sell_get_local_rowind(starpu_data_handle_t handle);
+
+/**
+   Return the number of stored entries, including the padding, in the
+   matrix designated by \p interface.
+ */
+#define STARPU_SELL_GET_NNZ(interface) (((struct starpu_sell_interface *)(interface))->nnz)
+/**
+   Return the number of rows in the matrix designated by \p interface.
+ */
+#define STARPU_SELL_GET_NROW(interface) (((struct starpu_sell_interface *)(interface))->nrow)
+/**
+   Return the number of rows of the slices in the matrix designated by
+   \p interface.
+ */
+#define STARPU_SELL_GET_C(interface) (((struct starpu_sell_interface *)(interface))->c)
+/**
+   Return the number of rows of the sorting windows in the matrix
+   designated by \p interface.
+ */
+#define STARPU_SELL_GET_SIGMA(interface) (((struct starpu_sell_interface *)(interface))->sigma)
+/**
+   Return the number of slices in the matrix designated by \p interface.
+ */
+#define STARPU_SELL_GET_NSLICES(interface) ((STARPU_SELL_GET_NROW(interface) + STARPU_SELL_GET_C(interface) - 1) / STARPU_SELL_GET_C(interface))
+/**
+   Return a pointer to the stored values of the matrix designated by
+   \p interface.
+ */
+#define STARPU_SELL_GET_NZVAL(interface) (((struct starpu_sell_interface *)(interface))->nzval)
+/**
+   Return a pointer to the column indexes of the matrix designated by
+   \p interface.
+ */
+#define STARPU_SELL_GET_COLIND(interface) (((struct starpu_sell_interface *)(interface))->colind)
+/**
+   Return a RAM pointer to the column indexes of the matrix designated
+   by \p interface.
+ */
+#define STARPU_SELL_GET_RAM_COLIND(interface) (((struct starpu_sell_interface *)(interface))->ram_colind)
+/**
+   Return a pointer to the slice pointer array of the matrix designated
+   by \p interface.
+ */
+#define STARPU_SELL_GET_SLICEPTR(interface) (((struct starpu_sell_interface *)(interface))->sliceptr)
+/**
+   Return a RAM pointer to the slice pointer array of the matrix
+   designated by \p interface.
+ */
+#define STARPU_SELL_GET_RAM_SLICEPTR(interface) (((struct starpu_sell_interface *)(interface))->ram_sliceptr)
+/**
+   Return a pointer to the original row indexes of the matrix designated
+   by \p interface.
+ */
+#define STARPU_SELL_GET_ROWIND(interface) (((struct starpu_sell_interface *)(interface))->rowind)
+/**
+   Return a RAM pointer to the original row indexes of the matrix
+   designated by \p interface.
+ */
+#define STARPU_SELL_GET_RAM_ROWIND(interface) (((struct starpu_sell_interface *)(interface))->ram_rowind)
+/**
+   Return the base of the indexing (0 or 1 usually) of the slice
+   pointers in the matrix designated by \p interface.
+ */
+#define STARPU_SELL_GET_FIRSTENTRY(interface) (((struct starpu_sell_interface *)(interface))->firstentry)
+/**
+   Return the original index of the first row of the matrix designated
+   by \p interface.
+ */
+#define STARPU_SELL_GET_FIRSTROW(interface) (((struct starpu_sell_interface *)(interface))->firstrow)
+/**
+   Return the size of elements in the matrix designated by \p interface.
+ */
+#define STARPU_SELL_GET_ELEMSIZE(interface) (((struct starpu_sell_interface *)(interface))->elemsize)
+/**
+   Return the offset in the arrays (nzval, colind, sliceptr, rowind) of
+   the matrix designated by \p interface, to be used with the device
+   handles.
+ */
+#define STARPU_SELL_GET_OFFSET 0
+
+/** @} */
+
 /**
    @name Multiformat Data Interface
    @{
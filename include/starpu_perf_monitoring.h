@@ -259,6 +259,99 @@ double starpu_perf_counter_sample_get_double_value(struct starpu_perf_counter_sa
 
 /** @} */
 
+/**
+   @name Shared Memory Export
+   Layout of the shared memory region in which StarPU periodically
+   publishes all its performance counters when the environment variable
+   \ref STARPU_PERF_COUNTER_EXPORT is set, so that an external process
+   such as \c starpu_perf_counter_display can monitor them (see \ref
+   PerfMonCountCounterShmExport).
+
+   The region starts with a starpu_perf_export_header, followed by the
+   array of counter descriptors of all scopes, and then by the value
+   blocks of each scope: one for the global scope, one per worker for the
+   per-worker scope, and starpu_perf_export_header::max_codelets for the
+   per-codelet scope. Each value block is protected by a sequence lock:
+   its starpu_perf_export_block::seq field is odd while StarPU is
+   updating it, and a reader has to retry its copy of the block until it
+   reads the same even value before and after the copy.
+   @{
+*/
+
+/** Magic string at the beginning of the shared memory region */
+#define STARPU_PERF_EXPORT_MAGIC "STARPUPC"
+/** Version of the layout of the shared memory region */
+#define STARPU_PERF_EXPORT_VERSION 1
+/** Size of the name fields of the shared memory region */
+#define STARPU_PERF_EXPORT_NAME_LEN 64
+
+/** Index of the global scope in the per-scope arrays of starpu_perf_export_header */
+#define STARPU_PERF_EXPORT_GLOBAL 0
+/** Index of the per-worker scope in the per-scope arrays of starpu_perf_export_header */
+#define STARPU_PERF_EXPORT_PER_WORKER 1
+/** Index of the per-codelet scope in the per-scope arrays of starpu_perf_export_header */
+#define STARPU_PERF_EXPORT_PER_CODELET 2
+/** Number of scopes in the shared memory region */
+#define STARPU_PERF_EXPORT_NSCOPES 3
+
+/**
+   Header of the shared memory region.
+*/
+struct starpu_perf_export_header
+{
+	char magic[8];		/**< ::STARPU_PERF_EXPORT_MAGIC, without the terminating null byte */
+	uint32_t version;	/**< ::STARPU_PERF_EXPORT_VERSION */
+	uint32_t header_size;	/**< size of this structure */
+	uint64_t size;		/**< total size of the region */
+	int64_t pid;		/**< process id of the application */
+	uint32_t period;	/**< update period, in ms */
+	volatile uint32_t running;	/**< 1 while the application runs, 0 once it has shut StarPU down */
+	uint32_t ncounters[STARPU_PERF_EXPORT_NSCOPES];	/**< number of counters of each scope */
+	uint32_t nworkers;	/**< number of per-worker value blocks */
+	uint32_t max_codelets;	/**< number of per-codelet value blocks */
+	volatile uint32_t ncodelets;	/**< number of per-codelet value blocks currently in use */
+	uint64_t counters_offset;	/**< offset of the counter descriptors, global ones first, then per-worker ones, then per-codelet ones */
+	uint64_t blocks_offset[STARPU_PERF_EXPORT_NSCOPES];	/**< offset of the first value block of each scope */
+	uint64_t block_size[STARPU_PERF_EXPORT_NSCOPES];	/**< size of the value blocks of each scope */
+};
+
+/**
+   Descriptor of a counter in the shared memory region.
+*/
+struct starpu_perf_export_counter
+{
+	char name[STARPU_PERF_EXPORT_NAME_LEN];	/**< name of the counter */
+	int32_t id;	/**< id of the counter */
+	int32_t type;	/**< type of the counter, see ::starpu_perf_counter_type */
+};
+
+/**
+   Value of a counter in the shared memory region, to be read according
+   to the type of the counter.
+*/
+union starpu_perf_export_value
+{
+	int32_t int32_val;	/**< value of a ::starpu_perf_counter_type_int32 counter */
+	int64_t int64_val;	/**< value of a ::starpu_perf_counter_type_int64 counter */
+	float float_val;	/**< value of a ::starpu_perf_counter_type_float counter */
+	double double_val;	/**< value of a ::starpu_perf_counter_type_double counter */
+};
+
+/**
+   Value block of an object (the whole application, a worker or a
+   codelet) in the shared memory region. The values of the counters of
+   the scope follow this structure, as an array of
+   starpu_perf_export_value in the order of the counter descriptors.
+*/
+struct starpu_perf_export_block
+{
+	volatile uint64_t seq;	/**< sequence number, odd while the block is being updated */
+	double timestamp;	/**< date of the last update, in µs, as returned by starpu_timing_now() */
+	char name[STARPU_PERF_EXPORT_NAME_LEN];	/**< name of the worker or of the codelet */
+};
+
+/** @} */
+
 /** @} */
 
 #ifdef __cplusplus
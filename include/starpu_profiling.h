@@ -374,6 +374,112 @@ void starpu_profiling_bus_helper_display_summary(void);
 */
 void starpu_profiling_worker_helper_display_summary(void);
 
+/**
+   Kinds of latencies recorded in the latency histograms of the workers,
+   while the performance counters are being collected (see \ref
+   LatencyHistograms).
+*/
+enum starpu_profiling_latency
+{
+	STARPU_PROFILING_LATENCY_QUEUE,	/**< time between the task becoming ready and the worker starting to fetch its data */
+	STARPU_PROFILING_LATENCY_FETCH,	/**< time the worker spent waiting for the data of the task */
+	STARPU_PROFILING_LATENCY_EXEC,	/**< execution time of the task */
+	STARPU_PROFILING_LATENCY_NKINDS	/**< number of kinds of latencies */
+};
+
+/**
+   Return the given \p percentile (e.g. 50, 99 or 99.9) of the latencies of
+   kind \p kind recorded by the worker \p workerid, in microseconds. If \p
+   workerid is -1, the histograms of all workers are merged. Return 0 if no
+   latency was recorded.
+   See \ref LatencyHistograms for more details.
+*/
+double starpu_profiling_worker_latency_percentile(int workerid, enum starpu_profiling_latency kind, double percentile);
+
+/**
+   Return the given \p percentile (e.g. 50, 99 or 99.9) of the execution
+   times of the tasks of the codelet \p cl, in microseconds. Return 0 if no
+   execution time was recorded.
+   See \ref LatencyHistograms for more details.
+*/
+double starpu_profiling_codelet_latency_percentile(struct starpu_codelet *cl, double percentile);
+
+/**
+   Reset the latency histograms of all workers and codelets.
+   See \ref LatencyHistograms for more details.
+*/
+void starpu_profiling_latency_reset(void);
+
+/**
+   Display the p50, p99 and p999 latencies of each worker and of each
+   codelet on \p stream.
+   See \ref LatencyHistograms for more details.
+*/
+void starpu_profiling_latency_display_summary(FILE *stream);
+
+/**
+   Display the latency percentiles on \c stderr if the environment
+   variable \ref STARPU_LATENCY_STATS is defined. The function is called
+   automatically by starpu_shutdown().
+   See \ref LatencyHistograms for more details.
+*/
+void starpu_profiling_latency_helper_display_summary(void);
+
+/** Maximum number of codelets reported in starpu_profiling_critical_path_info */
+#define STARPU_PROFILING_CRITICAL_PATH_NCODELETS 8
+
+/**
+   Critical path of the tasks executed since the performance counters
+   are being collected, as maintained by the critical path tracker (see
+   \ref CriticalPathTracker).
+*/
+struct starpu_profiling_critical_path_info
+{
+	/** Sum of the measured execution times of the tasks of the critical path, in µs */
+	double length;
+	/** Time the tasks of the critical path waited for a worker while being ready, in µs */
+	double worker_stall;
+	/** Time the tasks of the critical path waited for their data, in µs */
+	double data_stall;
+	/** Time elapsed since the first task tracked became ready, in µs */
+	double elapsed;
+	/** Number of tasks of the critical path */
+	unsigned long ntasks;
+	/** Number of entries in starpu_profiling_critical_path_info::codelets */
+	unsigned ncodelets;
+	/** Codelets which contribute the most to the critical path, in decreasing order of their contribution */
+	struct starpu_codelet *codelets[STARPU_PROFILING_CRITICAL_PATH_NCODELETS];
+	/** Cumulated execution time of each of these codelets on the critical path, in µs */
+	double codelet_length[STARPU_PROFILING_CRITICAL_PATH_NCODELETS];
+};
+
+/**
+   Fill \p info with the current critical path.
+   See \ref CriticalPathTracker for more details.
+*/
+void starpu_profiling_critical_path_get_info(struct starpu_profiling_critical_path_info *info);
+
+/**
+   Forget the current critical path, and start tracking a new one from the
+   tasks which become ready from now on.
+   See \ref CriticalPathTracker for more details.
+*/
+void starpu_profiling_critical_path_reset(void);
+
+/**
+   Display the current critical path on \p stream.
+   See \ref CriticalPathTracker for more details.
+*/
+void starpu_profiling_critical_path_display_summary(FILE *stream);
+
+/**
+   Display the critical path on \c stderr if the environment variable
+   \ref STARPU_CRITICAL_PATH_STATS is defined. The function is called
+   automatically by starpu_shutdown().
+   See \ref CriticalPathTracker for more details.
+*/
+void starpu_profiling_critical_path_helper_display_summary(void);
+
 /**
    Display statistics about the current data handles registered
    within StarPU. StarPU must have been configured with the configure
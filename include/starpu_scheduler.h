@@ -559,6 +559,18 @@ int starpu_wake_worker_locked(int workerid);
 */
 int starpu_wake_worker_relax_light(int workerid);
 
+/**
+   Wake up to \p n of the \p nworkers workers of \p workerids, typically
+   after pushing tasks to a queue which they share, \p n being the number
+   of tasks waiting in the queue. Idle workers which are spinning or
+   parked on their futex (see \ref STARPU_WORKER_PARKING) are woken
+   without taking their sched mutex. If none of them could be woken this
+   way, a single worker is woken with starpu_wake_worker_relax_light().
+   Return the number of workers which were woken up.
+   See \ref DefiningANewBasicSchedulingPolicy for more details.
+*/
+unsigned starpu_wake_workers_relax_light(const int *workerids, unsigned nworkers, unsigned n);
+
 /** @} */
 
 /** @} */
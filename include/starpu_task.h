@@ -654,6 +654,7 @@ struct starpu_codelet
 
 	struct starpu_perf_counter_sample *perf_counter_sample;
 	struct starpu_perf_counter_sample_cl_values *perf_counter_values;
+	struct starpu_profiling_latency_histogram *latency_histogram;
 
 	/**
 	   Whether _starpu_codelet_check_deprecated_fields was already done or not.
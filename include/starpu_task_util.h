@@ -507,6 +507,69 @@ int starpu_insert_task(struct starpu_codelet *cl, ...);
 #define starpu_insert_task(cl, ...) starpu_insert_task(cl, STARPU_TASK_FILE, __FILE__, STARPU_TASK_LINE, __LINE__, ##__VA_ARGS__)
 #endif
 
+/**
+   Opaque descriptor of a prepared insertion, i.e. the argument
+   signature of starpu_task_insert() parsed once by
+   starpu_task_insert_prepare() so that many tasks with the same
+   signature can be submitted without parsing the variable argument
+   list again.
+   See \ref PreparedTaskInsertion for more details.
+*/
+struct starpu_task_insert_prepared;
+
+/**
+   Parse once the argument signature of tasks to be inserted for the
+   codelet \p cl and return a descriptor which can be given to
+   starpu_task_insert_prepared_submit() many times. The argument list
+   must be zero-terminated. The arguments can be of the following
+   types:
+   <ul>
+   <li> ::STARPU_R, ::STARPU_W, ::STARPU_RW, ::STARPU_SCRATCH,
+   ::STARPU_REDUX an access mode, which is <b>not</b> followed by a
+   data handle, the handle will be given at submission;
+   <li> ::STARPU_VALUE followed by the size of the value, which will
+   be given at submission;
+   <li> ::STARPU_PRIORITY, ::STARPU_NAME, ::STARPU_SCHED_CTX,
+   ::STARPU_EXECUTE_WHERE, ::STARPU_FLOPS, ::STARPU_CALLBACK,
+   ::STARPU_CALLBACK_ARG_NFREE followed by the same objects as for
+   starpu_task_insert(), their value being shared by all the tasks
+   submitted with the descriptor.
+   </ul>
+   The descriptor has to be released with
+   starpu_task_insert_prepared_destroy().
+   See \ref PreparedTaskInsertion for more details.
+*/
+struct starpu_task_insert_prepared *starpu_task_insert_prepare(struct starpu_codelet *cl, ...);
+
+/**
+   Create a task from the descriptor \p prepared, using the data
+   handles given in the array \p handles in the order of the access
+   modes given to starpu_task_insert_prepare(), and the values
+   pointed to by the array \p values in the order of the
+   ::STARPU_VALUE given to starpu_task_insert_prepare(). The values
+   are packed in the same format as starpu_task_insert() does, so that
+   the codelet can use starpu_codelet_unpack_args(). The task is
+   returned without being submitted, so that it can be further
+   modified before calling starpu_task_submit().
+   See \ref PreparedTaskInsertion for more details.
+*/
+struct starpu_task *starpu_task_insert_prepared_build(struct starpu_task_insert_prepared *prepared, starpu_data_handle_t *handles, void **values);
+
+/**
+   Create and submit a task from the descriptor \p prepared, see
+   starpu_task_insert_prepared_build() for the meaning of \p handles
+   and \p values. Return the same values as starpu_task_insert().
+   See \ref PreparedTaskInsertion for more details.
+*/
+int starpu_task_insert_prepared_submit(struct starpu_task_insert_prepared *prepared, starpu_data_handle_t *handles, void **values);
+
+/**
+   Release the descriptor \p prepared. Tasks which were already
+   submitted with it are not affected.
+   See \ref PreparedTaskInsertion for more details.
+*/
+void starpu_task_insert_prepared_destroy(struct starpu_task_insert_prepared *prepared);
+
 /**
    Assuming that there are already \p current_buffer data handles
    passed to the task, and if *allocated_buffers is not 0, the
@@ -0,0 +1,141 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Measure the time to broadcast large panels from node 0 to all the other
+ * nodes with cooperative sends, the same way as mpi/tests/coop_large.c does.
+ * With the MPI backend, large data are pipelined through a tree of the
+ * recipients when STARPU_MPI_COOP_SEGMENT_SIZE is set, run without it to
+ * compare with the owner sending the data to each recipient, and with
+ * different values of STARPU_MPI_COOP_SEGMENT_SIZE and
+ * STARPU_MPI_COOP_TREE_ARITY to tune them.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+#ifdef STARPU_QUICK_CHECK
+#define MIN_SIZE_DEFAULT (1024*1024)
+#define MAX_SIZE_DEFAULT (1024*1024)
+#define LOOPS_DEFAULT 2
+#else
+#define MIN_SIZE_DEFAULT (1024*1024)
+#define MAX_SIZE_DEFAULT (64*1024*1024)
+#define LOOPS_DEFAULT 10
+#endif
+
+static void usage(void)
+{
+	fprintf(stderr, "-N iterations - iterations per size [%d]\n", LOOPS_DEFAULT);
+	fprintf(stderr, "-min size - smallest panel size in bytes [%d]\n", MIN_SIZE_DEFAULT);
+	fprintf(stderr, "-max size - largest panel size in bytes [%d]\n", MAX_SIZE_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+	int ret, rank, size, i, iter;
+	int iterations = LOOPS_DEFAULT;
+	size_t min_size = MIN_SIZE_DEFAULT, max_size = MAX_SIZE_DEFAULT, panel_size;
+	const char *segment_size = getenv("STARPU_MPI_COOP_SEGMENT_SIZE");
+	const char *arity = getenv("STARPU_MPI_COOP_TREE_ARITY");
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-N") == 0)
+			iterations = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-min") == 0)
+			min_size = atol(argv[++i]);
+		else if (strcmp(argv[i], "-max") == 0)
+			max_size = atol(argv[++i]);
+		else
+		{
+			fprintf(stderr, "%s: illegal argument %s\n", argv[0], argv[i]);
+			usage();
+			exit(1);
+		}
+	}
+
+	ret = starpu_mpi_init_conf(&argc, &argv, 1, MPI_COMM_WORLD, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (size < 3)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 3 processes.\n");
+		starpu_mpi_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	if (rank == 0)
+	{
+		printf("# %d nodes, segment size %s, tree arity %s\n", size, segment_size ? segment_size : "default", arity ? arity : "default");
+		printf("# size (bytes)\ttime (ms)\tbandwidth per recipient (MB/s)\n");
+	}
+
+	for (panel_size = min_size; panel_size <= max_size; panel_size *= 2)
+	{
+		size_t nx = panel_size / sizeof(float);
+		float *panel = malloc(nx * sizeof(float));
+		starpu_data_handle_t handle;
+		double start, time;
+
+		STARPU_ASSERT(panel);
+		for (i = 0; i < (int) nx; i++)
+			panel[i] = rank == 0 ? (float) i : -1.f;
+		starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) panel, nx, sizeof(float));
+		starpu_mpi_data_register(handle, 42, 0);
+
+		starpu_mpi_barrier(MPI_COMM_WORLD);
+		start = starpu_timing_now();
+		for (iter = 0; iter < iterations; iter++)
+		{
+			if (rank == 0)
+			{
+				/* Tell StarPU this send will be a broadcast to all nodes */
+				starpu_mpi_coop_sends_data_handle_nb_sends(handle, size - 1);
+				for (i = 1; i < size; i++)
+				{
+					ret = starpu_mpi_isend_detached(handle, i, 42, MPI_COMM_WORLD, NULL, NULL);
+					STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend_detached");
+				}
+				starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+			}
+			else
+			{
+				ret = starpu_mpi_recv(handle, 0, 42, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_recv");
+			}
+			starpu_mpi_barrier(MPI_COMM_WORLD);
+		}
+		time = (starpu_timing_now() - start) / iterations;
+
+		if (rank == 0)
+			printf("%lu\t%.3f\t%.1f\n", (unsigned long) panel_size, time / 1000., panel_size / time);
+
+		starpu_data_unregister(handle);
+		if (rank != 0)
+			for (i = 0; i < (int) nx; i++)
+				STARPU_ASSERT(panel[i] == (float) i);
+		free(panel);
+	}
+
+	starpu_mpi_shutdown();
+
+	return 0;
+}
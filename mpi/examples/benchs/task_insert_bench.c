@@ -0,0 +1,136 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Measure the cost of inserting tasks on MPI nodes which are not involved in
+ * them: all the data are owned by node 0, which executes all the tasks, the
+ * other nodes only have to process the task insertions. Both
+ * starpu_mpi_task_insert() and starpu_mpi_task_insert_prepared_submit() are
+ * measured.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS_DEFAULT 1000
+#else
+#define NTASKS_DEFAULT 100000
+#endif
+#define NDATA 256
+
+static void func_cpu(void *descr[], void *args)
+{
+	(void)descr;
+	(void)args;
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = { func_cpu },
+	.cpu_funcs_name = { "func_cpu" },
+	.nbuffers = 3,
+	.modes = { STARPU_RW, STARPU_R, STARPU_R },
+	.name = "task_insert_bench"
+};
+
+static void print_time(int rank, const char *name, double time, int ntasks)
+{
+	if (rank <= 1)
+		printf("node %d (%s): %s %.3f us per task\n", rank, rank == 0 ? "involved" : "not involved", name, time / ntasks);
+}
+
+int main(int argc, char **argv)
+{
+	int ret, rank, size, i, ntasks = NTASKS_DEFAULT;
+	starpu_data_handle_t handles[NDATA];
+	int values[NDATA];
+	double start, time;
+
+	if (argc > 1)
+		ntasks = atoi(argv[1]);
+
+	ret = starpu_mpi_init_conf(&argc, &argv, 1, MPI_COMM_WORLD, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (size < 2 || starpu_cpu_worker_get_count() == 0)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need 2 processes and CPU workers.\n");
+		starpu_mpi_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NDATA; i++)
+	{
+		values[i] = i;
+		if (rank == 0)
+			starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&values[i], sizeof(values[i]));
+		else
+			starpu_variable_data_register(&handles[i], -1, (uintptr_t)NULL, sizeof(values[i]));
+		starpu_mpi_data_register(handles[i], i, 0);
+	}
+
+	starpu_mpi_barrier(MPI_COMM_WORLD);
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &cl,
+					     STARPU_RW, handles[i % NDATA],
+					     STARPU_R, handles[(i + 1) % NDATA],
+					     STARPU_R, handles[(i + 2) % NDATA],
+					     STARPU_VALUE, &i, sizeof(i),
+					     STARPU_PRIORITY, 1,
+					     0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+	}
+	time = starpu_timing_now() - start;
+	starpu_task_wait_for_all();
+	print_time(rank, "starpu_mpi_task_insert", time, ntasks);
+
+	struct starpu_task_insert_prepared *prepared;
+	prepared = starpu_task_insert_prepare(&cl,
+					      STARPU_RW, STARPU_R, STARPU_R,
+					      STARPU_VALUE, sizeof(i),
+					      STARPU_PRIORITY, 1,
+					      0);
+	STARPU_ASSERT(prepared != NULL);
+
+	starpu_mpi_barrier(MPI_COMM_WORLD);
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		starpu_data_handle_t task_handles[] = { handles[i % NDATA], handles[(i + 1) % NDATA], handles[(i + 2) % NDATA] };
+		void *task_values[] = { &i };
+		ret = starpu_mpi_task_insert_prepared_submit(MPI_COMM_WORLD, prepared, task_handles, task_values);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert_prepared_submit");
+	}
+	time = starpu_timing_now() - start;
+	starpu_task_wait_for_all();
+	print_time(rank, "starpu_mpi_task_insert_prepared_submit", time, ntasks);
+
+	starpu_task_insert_prepared_destroy(prepared);
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+
+	starpu_mpi_shutdown();
+
+	return 0;
+}
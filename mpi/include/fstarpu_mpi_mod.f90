@@ -594,6 +594,7 @@ module fstarpu_mpi_mod
 
                 ! #define STARPU_MPI_NODE_SELECTION_CURRENT_POLICY -1
                 ! #define STARPU_MPI_NODE_SELECTION_MOST_R_DATA    0
+                ! #define STARPU_MPI_NODE_SELECTION_MIN_COST       1
 
                 ! int starpu_mpi_node_selection_register_policy(starpu_mpi_select_node_policy_func_t policy_func);
                 function fstarpu_mpi_node_selection_register_policy(policy_func) &
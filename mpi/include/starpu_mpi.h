@@ -707,6 +707,21 @@ int starpu_mpi_task_post_build(MPI_Comm comm, struct starpu_codelet *codelet, ..
  */
 int starpu_mpi_task_post_build_v(MPI_Comm comm, struct starpu_codelet *codelet, va_list varg_list);
 
+/**
+   Similar to starpu_mpi_task_insert(), for a task described by the
+   descriptor \p prepared returned by starpu_task_insert_prepare(),
+   see starpu_task_insert_prepared_submit() for the meaning of \p
+   handles and \p values. Since the access modes are already known,
+   the MPI node executing the task is determined from the owners of
+   the data only, without parsing any argument list, and the nodes
+   which neither execute the task nor own any of its data only drop
+   from their cache the data written by the task. The node is chosen by the current
+   node selection policy when the written data have different owners,
+   ::STARPU_MPI_REDUX is not supported.
+   See \ref MPIInsertPrepared for more details.
+*/
+int starpu_mpi_task_insert_prepared_submit(MPI_Comm comm, struct starpu_task_insert_prepared *prepared, starpu_data_handle_t *handles, void **values);
+
 /**
    Structure used to pass data from
    starpu_mpi_task_exchange_data_before_execution() to
@@ -792,6 +807,18 @@ void starpu_mpi_data_migrate(MPI_Comm comm, starpu_data_handle_t handle, int new
    most data in ::STARPU_R mode
 */
 #define STARPU_MPI_NODE_SELECTION_MOST_R_DATA 0
+/**
+   Define the policy in which the selected node is the one with the
+   smallest estimated cost, i.e. the time to transfer the data it does
+   not own or have in its cache, according to \ref
+   STARPU_MPI_NETWORK_LATENCY and \ref STARPU_MPI_NETWORK_BANDWIDTH,
+   plus the predicted execution time of the tasks already assigned to
+   it beyond the least loaded node. The execution time of tasks is
+   predicted from their number of flops given with ::STARPU_FLOPS,
+   \ref STARPU_MPI_WORKER_GFLOPS and the number of workers of the
+   node, so that all nodes take the same decision.
+*/
+#define STARPU_MPI_NODE_SELECTION_MIN_COST 1
 
 typedef int (*starpu_mpi_select_node_policy_func_t)(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data);
 
@@ -842,7 +869,9 @@ int starpu_mpi_node_selection_get_current_policy(void);
    Set the current policy used to select the node which will execute
    the codelet. The policy ::STARPU_MPI_NODE_SELECTION_MOST_R_DATA
    selects the node having the most data in ::STARPU_R mode so as to
-   minimize the amount of data to be transferred.
+   minimize the amount of data to be transferred. The policy
+   ::STARPU_MPI_NODE_SELECTION_MIN_COST also considers the data cached
+   by the nodes and the tasks already assigned to them.
 */
 int starpu_mpi_node_selection_set_current_policy(int policy);
 
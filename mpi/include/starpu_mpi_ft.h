@@ -38,7 +38,8 @@ typedef struct _starpu_mpi_checkpoint_template *starpu_mpi_checkpoint_template_t
 int starpu_mpi_checkpoint_init(void);
 
 /**
-   Shutdown the checkpoint mechanism
+   Shutdown the checkpoint mechanism, after waiting for the
+   checkpoints in progress to be acknowledged
 */
 int starpu_mpi_checkpoint_shutdown(void);
 
@@ -106,6 +107,9 @@ int starpu_mpi_checkpoint_template_freeze(starpu_mpi_checkpoint_template_t *cp_t
  * The data internal to StarPU (aka handles given with ::STARPU_R) will be saved with their value at
  * execution time (when the task submitted before the ::starpu_mpi_checkpoint_template_submit() have been executed,
  * and before this data is modified by the tasks submitted after the ::starpu_mpi_checkpoint_template_submit())
+ * When \ref STARPU_MPI_CHECKPOINT_INCREMENTAL is set to 1, the data internal to StarPU which have not been written by
+ * tasks inserted with ::starpu_mpi_task_insert() since they were last saved are not sent again. The transfers are
+ * submitted with the priority \p prio.
  */
 int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_template, int prio);
 
@@ -34,7 +34,21 @@ struct starpu_mpi_lb_conf
 
 /**
    Initialize the load balancer's environment with the load policy provided by the
-   user
+   user. The environment variable \c STARPU_MPI_LB can be used to override
+   \p lb_policy_name.
+
+   The \c heat policy needs both methods of the given starpu_mpi_lb_conf. The
+   \c diffusion policy periodically balances the work predicted by the
+   performance models for the tasks inserted with starpu_mpi_task_insert() by
+   migrating the ownership of data between nodes. It accepts a \c NULL
+   starpu_mpi_lb_conf or \c NULL methods, in which case the neighbours of a
+   node are the nodes whose rank differs from its own by one bit, and the data
+   to migrate are chosen from the work written to them. The loads are
+   exchanged in the background, and used at the next balancing step.
+   The data have to be registered with a tag on all nodes, and must remain
+   registered until starpu_mpi_lb_shutdown() is called, which gives them back
+   to their original owner. See \ref STARPU_MPI_LB_DIFFUSION_PERIOD and \ref
+   STARPU_MPI_LB_DIFFUSION_THRESHOLD.
 */
 void starpu_mpi_lb_init(const char *lb_policy_name, struct starpu_mpi_lb_conf *);
 void starpu_mpi_lb_shutdown(void);
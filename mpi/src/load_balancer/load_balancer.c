@@ -23,6 +23,7 @@
 #include <common/config.h>
 
 #include <starpu_mpi_lb.h>
+#include <starpu_mpi_task_insert.h>
 #include "policy/load_balancer_policy.h"
 
 #if defined(STARPU_USE_MPI_MPI)
@@ -43,6 +44,7 @@ static void post_exec_hook_wrapper(struct starpu_task *task, unsigned sched_ctx_
 static struct load_balancer_policy *predefined_policies[] =
 {
 	&load_heat_propagation_policy,
+	&load_diffusion_policy,
 	NULL
 };
 
@@ -103,6 +105,9 @@ void starpu_mpi_lb_init(const char *lb_policy_name, struct starpu_mpi_lb_conf *i
 	if (defined_policy->submitted_task_entry_point)
 		starpu_mpi_pre_submit_hook_register(defined_policy->submitted_task_entry_point);
 
+	if (defined_policy->submitting_task_entry_point || defined_policy->inserted_task_entry_point)
+		_starpu_mpi_lb_hooks_register(defined_policy->submitting_task_entry_point, defined_policy->inserted_task_entry_point);
+
 	/* starpu_register_hook(finished_task, defined_policy->finished_task_entry_point); */
 	if (defined_policy->finished_task_entry_point)
 	{
@@ -140,6 +145,9 @@ void starpu_mpi_lb_shutdown()
 	if (defined_policy->submitted_task_entry_point)
 		starpu_mpi_pre_submit_hook_unregister();
 
+	if (defined_policy->submitting_task_entry_point || defined_policy->inserted_task_entry_point)
+		_starpu_mpi_lb_hooks_register(NULL, NULL);
+
 	/* starpu_unregister_hook(finished_task, defined_policy->finished_task_entry_point); */
 	if (defined_policy->finished_task_entry_point)
 	{
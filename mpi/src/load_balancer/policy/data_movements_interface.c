@@ -227,7 +227,7 @@ static int data_movements_peek_data(starpu_data_handle_t handle, unsigned node,
 
 	int size = 0;
 	memcpy(&size, data, sizeof(int));
-	STARPU_ASSERT(count == (2 * size * sizeof(int)) + sizeof(int));
+	STARPU_ASSERT(count == (size * sizeof(starpu_mpi_tag_t)) + (size * sizeof(int)) + sizeof(int));
 
 	data_movements_reallocate_tables(handle, node, size);
 
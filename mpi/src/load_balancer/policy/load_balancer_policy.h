@@ -38,6 +38,18 @@ struct load_balancer_policy
 	void (*submitted_task_entry_point)();
 	void (*finished_task_entry_point)();
 
+	/** Optional, called with the tasks inserted with
+	 * starpu_mpi_task_insert() which the local node is going to execute,
+	 * right before they get submitted.
+	 */
+	void (*submitting_task_entry_point)(struct starpu_task *task);
+	/** Optional, called on all the nodes each time a task has been
+	 * inserted with starpu_mpi_task_insert(), whichever node executes it.
+	 * Since all the nodes go through the same sequence of calls, this is
+	 * where a policy can perform collective balancing steps.
+	 */
+	void (*inserted_task_entry_point)(void);
+
 	/** Name of the load balancing policy. The selection of the load balancer is
 	 * performed through the use of the STARPU_MPI_LB=name environment
 	 * variable.
@@ -46,6 +58,7 @@ struct load_balancer_policy
 };
 
 extern struct load_balancer_policy load_heat_propagation_policy;
+extern struct load_balancer_policy load_diffusion_policy;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,580 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Diffusion load balancer.
+ *
+ * Every STARPU_MPI_LB_DIFFUSION_PERIOD tasks inserted with
+ * starpu_mpi_task_insert(), all the nodes perform a balancing step at the same
+ * point of the task flow:
+ *  - the load of a node is the work predicted by the performance models for the
+ *    tasks it was given during the last period, divided by its number of
+ *    workers; it is exchanged with its neighbours in the background, and used
+ *    at the next balancing step,
+ *  - following the first-order diffusion scheme, a node sends to each less
+ *    loaded neighbour an amount of work proportional to their load difference,
+ *  - the work is moved by migrating the ownership of pieces of data: those
+ *    which were written by the most work during the last period are picked,
+ *    unless the application provides its own get_data_unit_to_migrate(),
+ *  - the resulting data movements are exchanged between all the nodes, which
+ *    all call starpu_mpi_data_migrate() in the same order.
+ *
+ * Unless the application provides its own get_neighbors(), the neighbours of
+ * a node are the nodes whose rank differs from its own by one bit, which
+ * keeps the graph connected with at most log2(world_size) neighbours per node.
+ *
+ * All the migrated data are given back to their original owner when the load
+ * balancer is shut down.
+ */
+
+#include <starpu_mpi.h>
+#include <mpi/starpu_mpi_tag.h>
+#include <common/uthash.h>
+#include <common/utils.h>
+#include <math.h>
+#include <starpu_mpi_private.h>
+#include "load_balancer_policy.h"
+#include "data_movements_interface.h"
+#include <common/config.h>
+
+#if defined(STARPU_USE_MPI_MPI)
+
+/* The tags are taken high enough not to collide with the application ones */
+static starpu_mpi_tag_t TAG_LOAD(int n)
+{
+	return (((starpu_mpi_tag_t) 1) << 48) + n;
+}
+
+static starpu_mpi_tag_t TAG_MOV(int n)
+{
+	return (((starpu_mpi_tag_t) 2) << 48) + n;
+}
+
+/* Load of a node, as exchanged with its neighbours */
+struct diffusion_load
+{
+	/* Predicted work of the tasks given to the node during the last period */
+	double work;
+	/* Number of workers of the node */
+	double nworkers;
+};
+
+/* Hash table of the predicted work written to the local pieces of data during
+ * the current period */
+struct data_work_entry
+{
+	UT_hash_handle hh;
+	starpu_data_handle_t handle;
+	double work;
+	int selected;
+};
+
+static struct data_work_entry *data_work = NULL;
+
+/* Hash table of the pieces of data which have been migrated by the load
+ * balancer, along with their original owner. Since all the nodes apply the
+ * same migrations in the same order, this table is the same on all of them. */
+struct moved_data_entry
+{
+	UT_hash_handle hh;
+	starpu_data_handle_t handle;
+	int home_rank;
+};
+
+static struct moved_data_entry *moved_data = NULL;
+
+/* MPI infos */
+static int my_rank;
+static int world_size;
+
+static int *neighbor_ids = NULL;
+static int nneighbors = 0;
+
+static struct diffusion_load local_load;
+static starpu_data_handle_t local_load_handle;
+static struct diffusion_load *neighbor_loads = NULL;
+static starpu_data_handle_t *neighbor_load_handles = NULL;
+
+/* Requests of the load exchange posted at the previous balancing step */
+static starpu_mpi_req *load_reqs = NULL;
+static int load_pending;
+/* Work sent to each neighbour at the previous balancing step, which the
+ * exchanged loads do not reflect yet */
+static double *sent_work = NULL;
+
+/* One data_movements handle per node, exchanged following an all-to-all
+ * model since all the nodes must know about all the data movements */
+static starpu_data_handle_t *data_movements_handles = NULL;
+
+static struct starpu_mpi_lb_conf *user_itf = NULL;
+
+static unsigned period;
+static double threshold;
+
+static unsigned long ninserted;
+static double window_work;
+static double predicted_work;
+static unsigned long npredicted;
+static unsigned long nmigrated;
+
+/******************************************************************************
+ *                              Balancing                                     *
+ *****************************************************************************/
+
+static void wait_requests(starpu_mpi_req *reqs, int nreqs)
+{
+	int i;
+	for (i = 0; i < nreqs; i++)
+	{
+		int ret = starpu_mpi_wait(&reqs[i], MPI_STATUS_IGNORE);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_wait");
+	}
+}
+
+/* Send the load of the period which just ended to the neighbours, the
+ * requests are only completed at the next balancing step */
+static void post_loads(void)
+{
+	int i, ret;
+
+	starpu_data_acquire(local_load_handle, STARPU_W);
+	local_load.work = window_work;
+	local_load.nworkers = starpu_worker_get_count();
+	starpu_data_release(local_load_handle);
+
+	for (i = 0; i < nneighbors; i++)
+	{
+		ret = starpu_mpi_isend(local_load_handle, &load_reqs[2*i], neighbor_ids[i], TAG_LOAD(my_rank), MPI_COMM_WORLD);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend");
+		ret = starpu_mpi_irecv(neighbor_load_handles[i], &load_reqs[2*i+1], neighbor_ids[i], TAG_LOAD(neighbor_ids[i]), MPI_COMM_WORLD);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_irecv");
+	}
+	load_pending = 1;
+}
+
+/* Return whether loads were posted at the previous balancing step, after
+ * waiting for them */
+static int complete_loads(void)
+{
+	if (!load_pending)
+		return 0;
+	wait_requests(load_reqs, 2*nneighbors);
+	load_pending = 0;
+	return 1;
+}
+
+static void exchange_data_movements(void)
+{
+	int i, ret, nreqs = 0;
+	starpu_mpi_req reqs[2*world_size];
+
+	for (i = 0; i < world_size; i++)
+	{
+		if (i == my_rank)
+			continue;
+		ret = starpu_mpi_isend(data_movements_handles[my_rank], &reqs[nreqs++], i, TAG_MOV(my_rank), MPI_COMM_WORLD);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend");
+		ret = starpu_mpi_irecv(data_movements_handles[i], &reqs[nreqs++], i, TAG_MOV(i), MPI_COMM_WORLD);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_irecv");
+	}
+	wait_requests(reqs, nreqs);
+}
+
+struct flow
+{
+	/* Index in neighbor_ids */
+	int neighbor;
+	int rank;
+	double work;
+};
+
+static int flow_cmp(const void *a, const void *b)
+{
+	const struct flow *fa = a, *fb = b;
+	return (fa->work < fb->work) - (fa->work > fb->work);
+}
+
+static int data_work_cmp(struct data_work_entry *a, struct data_work_entry *b)
+{
+	return (a->work < b->work) - (a->work > b->work);
+}
+
+static void add_movement(starpu_mpi_tag_t **tags, int **ranks, int *nmoves, int *size, starpu_data_handle_t handle, int dst)
+{
+	if (*nmoves == *size)
+	{
+		*size = *size ? 2 * *size : 16;
+		_STARPU_MPI_REALLOC(*tags, *size * sizeof(**tags));
+		_STARPU_MPI_REALLOC(*ranks, *size * sizeof(**ranks));
+	}
+	(*tags)[*nmoves] = starpu_mpi_data_get_tag(handle);
+	(*ranks)[*nmoves] = dst;
+	(*nmoves)++;
+}
+
+/* Compute the work to send to each less loaded neighbour, and fill
+ * data_movements_handles[my_rank] with the pieces of data to migrate for this */
+static void compute_data_movements(void)
+{
+	struct flow flows[nneighbors+1];
+	int nflows = 0;
+	starpu_mpi_tag_t *tags = NULL;
+	int *ranks = NULL;
+	int nmoves = 0, size = 0;
+	int i, n;
+	double my_nworkers = local_load.nworkers > 0. ? local_load.nworkers : 1.;
+	double my_work = local_load.work;
+	double my_load;
+	/* First-order diffusion coefficient */
+	double alpha = 1. / (nneighbors + 1);
+
+	/* The loads were measured before the previous migrations */
+	for (n = 0; n < nneighbors; n++)
+		my_work -= sent_work[n];
+	my_load = my_work > 0. ? my_work / my_nworkers : 0.;
+
+	for (n = 0; n < nneighbors; n++)
+	{
+		starpu_data_acquire(neighbor_load_handles[n], STARPU_R);
+		double nworkers = neighbor_loads[n].nworkers > 0. ? neighbor_loads[n].nworkers : 1.;
+		double load = (neighbor_loads[n].work + sent_work[n]) / nworkers;
+		starpu_data_release(neighbor_load_handles[n]);
+
+		sent_work[n] = 0.;
+
+		if (my_load <= 0. || my_load - load <= threshold * my_load)
+			continue;
+
+		/* Amount of work which would make both loads equal when
+		 * alpha is 1/2, scaled down by alpha */
+		flows[nflows].neighbor = n;
+		flows[nflows].rank = neighbor_ids[n];
+		flows[nflows].work = 2. * alpha * (my_load - load) * my_nworkers * nworkers / (my_nworkers + nworkers);
+		_STARPU_DEBUG("[node %d] load %f, neighbour %d load %f, sending %f\n", my_rank, my_load, neighbor_ids[n], load, flows[nflows].work);
+		nflows++;
+	}
+	qsort(flows, nflows, sizeof(flows[0]), flow_cmp);
+
+	if (nflows && user_itf && user_itf->get_data_unit_to_migrate)
+	{
+		for (i = 0; i < nflows; i++)
+		{
+			starpu_data_handle_t *handles = NULL;
+			int nhandles = 0;
+			user_itf->get_data_unit_to_migrate(&handles, &nhandles, flows[i].rank);
+			for (n = 0; n < nhandles; n++)
+				add_movement(&tags, &ranks, &nmoves, &size, handles[n], flows[i].rank);
+			free(handles);
+			if (nhandles)
+				sent_work[flows[i].neighbor] = flows[i].work;
+		}
+	}
+	else if (nflows)
+	{
+		/* Greedily pick the pieces of data which carried the most work
+		 * and still fit in what has to be sent */
+		HASH_SORT(data_work, data_work_cmp);
+		for (i = 0; i < nflows; i++)
+		{
+			double remaining = flows[i].work;
+			struct data_work_entry *entry, *tmp;
+			HASH_ITER(hh, data_work, entry, tmp)
+			{
+				if (entry->selected || entry->work > remaining)
+					continue;
+				/* It may have been migrated since the task was submitted */
+				if (starpu_mpi_data_get_rank(entry->handle) != my_rank)
+					continue;
+				entry->selected = 1;
+				remaining -= entry->work;
+				add_movement(&tags, &ranks, &nmoves, &size, entry->handle, flows[i].rank);
+			}
+			sent_work[flows[i].neighbor] = flows[i].work - remaining;
+		}
+	}
+
+	starpu_data_acquire_on_node(data_movements_handles[my_rank], STARPU_MAIN_RAM, STARPU_RW);
+	data_movements_reallocate_tables(data_movements_handles[my_rank], STARPU_MAIN_RAM, nmoves);
+	if (nmoves)
+	{
+		memcpy(data_movements_get_tags_table(data_movements_handles[my_rank]), tags, nmoves * sizeof(*tags));
+		memcpy(data_movements_get_ranks_table(data_movements_handles[my_rank]), ranks, nmoves * sizeof(*ranks));
+	}
+	starpu_data_release_on_node(data_movements_handles[my_rank], STARPU_MAIN_RAM);
+	free(tags);
+	free(ranks);
+}
+
+static void migrate(starpu_data_handle_t handle, int dst_rank)
+{
+	struct moved_data_entry *md = NULL;
+	HASH_FIND_PTR(moved_data, &handle, md);
+	if (!md)
+	{
+		_STARPU_MPI_MALLOC(md, sizeof(*md));
+		md->handle = handle;
+		md->home_rank = starpu_mpi_data_get_rank(handle);
+		HASH_ADD_PTR(moved_data, handle, md);
+	}
+	else if (md->home_rank == dst_rank)
+	{
+		HASH_DEL(moved_data, md);
+		free(md);
+	}
+
+	_STARPU_DEBUG("[node %d] Migrating data %"PRIi64" from node %d to node %d\n", my_rank, starpu_mpi_data_get_tag(handle), starpu_mpi_data_get_rank(handle), dst_rank);
+	starpu_mpi_data_migrate(MPI_COMM_WORLD, handle, dst_rank);
+	nmigrated++;
+}
+
+static void apply_data_movements(void)
+{
+	int i, j;
+
+	for (i = 0; i < world_size; i++)
+	{
+		int nmoves = data_movements_get_size_tables(data_movements_handles[i]);
+		starpu_mpi_tag_t *tags = data_movements_get_tags_table(data_movements_handles[i]);
+		int *ranks = data_movements_get_ranks_table(data_movements_handles[i]);
+
+		for (j = 0; j < nmoves; j++)
+		{
+			starpu_data_handle_t handle = _starpu_mpi_tag_get_data_handle_from_tag(tags[j]);
+			STARPU_ASSERT_MSG(handle, "The data with tag %"PRIi64" migrated by the load balancer is not registered on node %d\n", tags[j], my_rank);
+			migrate(handle, ranks[j]);
+		}
+	}
+}
+
+static void reset_period(void)
+{
+	struct data_work_entry *entry, *tmp;
+	HASH_ITER(hh, data_work, entry, tmp)
+	{
+		HASH_DEL(data_work, entry);
+		free(entry);
+	}
+	window_work = 0.;
+}
+
+static void diffusion_balance(void)
+{
+	/* All the nodes have posted their loads at the same previous step, so
+	 * they all agree on whether to balance */
+	if (complete_loads())
+	{
+		compute_data_movements();
+		exchange_data_movements();
+		apply_data_movements();
+	}
+	post_loads();
+	reset_period();
+}
+
+/******************************************************************************
+ *                    Diffusion Load Balancer Entry Points                    *
+ *****************************************************************************/
+
+static void submitting_task_diffusion(struct starpu_task *task)
+{
+	unsigned sched_ctx = task->sched_ctx;
+	if (sched_ctx == STARPU_NMAX_SCHED_CTXS)
+		sched_ctx = starpu_sched_ctx_get_context();
+	if (sched_ctx == STARPU_NMAX_SCHED_CTXS)
+		sched_ctx = 0;
+	double work = starpu_task_expected_length_average(task, sched_ctx);
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned i, nowned = 0;
+
+	if (isnan(work) || work <= 0.)
+		/* No prediction available yet, take the average of the
+		 * predicted ones, or count tasks */
+		work = npredicted ? predicted_work / npredicted : 1.;
+	else
+	{
+		predicted_work += work;
+		npredicted++;
+	}
+	window_work += work;
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		if ((STARPU_TASK_GET_MODE(task, i) & STARPU_W) && starpu_mpi_data_get_rank(handle) == my_rank && starpu_mpi_data_get_tag(handle) != -1)
+			nowned++;
+	}
+
+	/* Attribute the work to the local data it writes, which determine
+	 * where such tasks are executed */
+	for (i = 0; i < nbuffers; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		struct data_work_entry *entry;
+
+		if (!(STARPU_TASK_GET_MODE(task, i) & STARPU_W) || starpu_mpi_data_get_rank(handle) != my_rank || starpu_mpi_data_get_tag(handle) == -1)
+			continue;
+
+		HASH_FIND_PTR(data_work, &handle, entry);
+		if (!entry)
+		{
+			_STARPU_MPI_CALLOC(entry, 1, sizeof(*entry));
+			entry->handle = handle;
+			HASH_ADD_PTR(data_work, handle, entry);
+		}
+		entry->work += work / nowned;
+	}
+}
+
+static void inserted_task_diffusion(void)
+{
+	ninserted++;
+	if (ninserted % period == 0)
+	{
+		_STARPU_DEBUG("[node %d] Balancing after %lu tasks\n", my_rank, ninserted);
+		diffusion_balance();
+	}
+}
+
+/******************************************************************************
+ *                  Initialization / Deinitialization                         *
+ *****************************************************************************/
+
+static int init_diffusion(struct starpu_mpi_lb_conf *itf)
+{
+	int i, bit;
+
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &world_size);
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &my_rank);
+
+	period = starpu_getenv_number_default("STARPU_MPI_LB_DIFFUSION_PERIOD", 1000);
+	if (period == 0)
+		period = 1;
+	threshold = starpu_getenv_float_default("STARPU_MPI_LB_DIFFUSION_THRESHOLD", 0.1);
+
+	if (itf)
+	{
+		_STARPU_MPI_MALLOC(user_itf, sizeof(struct starpu_mpi_lb_conf));
+		memcpy(user_itf, itf, sizeof(struct starpu_mpi_lb_conf));
+	}
+
+	if (user_itf && user_itf->get_neighbors)
+		user_itf->get_neighbors(&neighbor_ids, &nneighbors);
+	else
+	{
+		/* Hypercube, where the missing nodes are skipped when
+		 * world_size is not a power of 2 */
+		nneighbors = 0;
+		_STARPU_MPI_MALLOC(neighbor_ids, world_size * sizeof(int));
+		for (bit = 1; bit < world_size; bit <<= 1)
+			if ((my_rank ^ bit) < world_size)
+				neighbor_ids[nneighbors++] = my_rank ^ bit;
+	}
+
+	starpu_variable_data_register(&local_load_handle, STARPU_MAIN_RAM, (uintptr_t) &local_load, sizeof(local_load));
+	starpu_mpi_data_register(local_load_handle, TAG_LOAD(my_rank), my_rank);
+
+	_STARPU_MPI_CALLOC(neighbor_loads, nneighbors + 1, sizeof(*neighbor_loads));
+	_STARPU_MPI_CALLOC(neighbor_load_handles, nneighbors + 1, sizeof(*neighbor_load_handles));
+	for (i = 0; i < nneighbors; i++)
+	{
+		starpu_variable_data_register(&neighbor_load_handles[i], STARPU_MAIN_RAM, (uintptr_t) &neighbor_loads[i], sizeof(neighbor_loads[i]));
+		starpu_mpi_data_register(neighbor_load_handles[i], TAG_LOAD(neighbor_ids[i]), neighbor_ids[i]);
+	}
+	_STARPU_MPI_MALLOC(load_reqs, (2*nneighbors + 1) * sizeof(*load_reqs));
+	_STARPU_MPI_CALLOC(sent_work, nneighbors + 1, sizeof(*sent_work));
+	load_pending = 0;
+
+	_STARPU_MPI_MALLOC(data_movements_handles, world_size*sizeof(starpu_data_handle_t));
+	for (i = 0; i < world_size; i++)
+	{
+		data_movements_data_register(&data_movements_handles[i], STARPU_MAIN_RAM, NULL, NULL, 0);
+		starpu_mpi_data_register(data_movements_handles[i], TAG_MOV(i), i);
+	}
+
+	data_work = NULL;
+	moved_data = NULL;
+	ninserted = 0;
+	window_work = 0.;
+	predicted_work = 0.;
+	npredicted = 0;
+	nmigrated = 0;
+
+	return 0;
+}
+
+static int deinit_diffusion()
+{
+	int i;
+	struct moved_data_entry *md, *tmp;
+
+	_STARPU_DEBUG("[node %d] Shutting down diffusion lb policy after %lu migrations, moving back %u data\n", my_rank, nmigrated, HASH_COUNT(moved_data));
+
+	complete_loads();
+	free(load_reqs);
+	load_reqs = NULL;
+	free(sent_work);
+	sent_work = NULL;
+
+	/* All the nodes have the same table, in the same order */
+	HASH_ITER(hh, moved_data, md, tmp)
+	{
+		HASH_DEL(moved_data, md);
+		starpu_mpi_data_migrate(MPI_COMM_WORLD, md->handle, md->home_rank);
+		free(md);
+	}
+	reset_period();
+
+	starpu_data_unregister(local_load_handle);
+	for (i = 0; i < nneighbors; i++)
+		starpu_data_unregister(neighbor_load_handles[i]);
+	free(neighbor_load_handles);
+	neighbor_load_handles = NULL;
+	free(neighbor_loads);
+	neighbor_loads = NULL;
+
+	for (i = 0; i < world_size; i++)
+	{
+		starpu_data_acquire_on_node(data_movements_handles[i], STARPU_MAIN_RAM, STARPU_W);
+		data_movements_reallocate_tables(data_movements_handles[i], STARPU_MAIN_RAM, 0);
+		starpu_data_release_on_node(data_movements_handles[i], STARPU_MAIN_RAM);
+		starpu_data_unregister(data_movements_handles[i]);
+	}
+	free(data_movements_handles);
+	data_movements_handles = NULL;
+
+	nneighbors = 0;
+	free(neighbor_ids);
+	neighbor_ids = NULL;
+	free(user_itf);
+	user_itf = NULL;
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                  Policy                                    *
+ *****************************************************************************/
+
+struct load_balancer_policy load_diffusion_policy =
+{
+	.init = init_diffusion,
+	.deinit = deinit_diffusion,
+	.submitting_task_entry_point = submitting_task_diffusion,
+	.inserted_task_entry_point = inserted_task_diffusion,
+	.policy_name = "diffusion"
+};
+
+#endif
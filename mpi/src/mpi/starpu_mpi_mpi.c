@@ -58,9 +58,16 @@ static unsigned nready_process;
 /* Force allocation of early data */
 static int early_data_force_allocate;
 
+/* Size of the segments of pipelined cooperative sends, 0 disables pipelining */
+static starpu_ssize_t coop_segment_size;
+
+/* Number of children of each node in the diffusion tree of pipelined cooperative sends */
+static int coop_tree_arity;
+
 static void _starpu_mpi_handle_ready_request(struct _starpu_mpi_req *req);
 static void _starpu_mpi_handle_request_termination(struct _starpu_mpi_req *req);
 static void _starpu_mpi_handle_detached_request(struct _starpu_mpi_req *req);
+static void _starpu_mpi_destroy_detached_request(struct _starpu_mpi_req *req);
 static void _starpu_mpi_early_data_cb(void* arg);
 
 /* The list of ready requests */
@@ -163,6 +170,397 @@ struct _starpu_mpi_early_data_cb_args
 	unsigned buffer_node;
 };
 
+/********************************************************/
+/*                                                      */
+/*  Pipelined cooperative sends                         */
+/*                                                      */
+/********************************************************/
+
+/* A large data sent to several nodes is packed once by its owner and cut into
+ * segments which flow down a tree of the recipients: each node forwards a
+ * segment to its children as soon as it has received it, so that the
+ * transfers between the different levels of the tree overlap. The owner sends
+ * to each recipient an envelope telling it which node it receives the
+ * segments from and which nodes it has to forward them to. */
+struct _starpu_mpi_coop_pipeline
+{
+	/* On the owner, the send requests of the coop_sends bag, sorted by priority */
+	struct _starpu_mpi_req **reqs;
+	unsigned nreqs;
+	unsigned started;
+	/* On the recipients, the request receiving the data */
+	struct _starpu_mpi_req *req;
+
+	MPI_Comm comm;
+	int mpi_tag;
+	int nchildren;
+	int children[_STARPU_MPI_COOP_MAX_ARITY];
+
+	/* Packed data */
+	unsigned node;
+	void *ptr;
+	starpu_ssize_t size;
+	starpu_ssize_t segment_size;
+	int nsegments;
+
+	/* Next segment whose reception is to be tested */
+	int next_segment;
+	/* Next segment whose forwarding is to be tested */
+	int next_sent_segment;
+	MPI_Request *recv_requests;
+	MPI_Request *send_requests;
+	int nsend_requests;
+
+	struct _starpu_mpi_coop_pipeline *next;
+};
+
+/* Pipelines being progressed, protected by progress_mutex */
+static struct _starpu_mpi_coop_pipeline *coop_pipelines;
+
+/* Pipelines which the progression thread has yet to start, protected by progress_mutex */
+static unsigned coop_pipelines_to_start;
+
+/* Segments to be received or forwarded whose requests have not completed yet,
+ * only accessed by the progression thread, which does not need to poll for
+ * pipelines otherwise */
+static unsigned coop_segments_pending;
+
+/* Sequence number of the pipelines started by this node, to allocate them MPI tags */
+static unsigned coop_pipeline_seq;
+
+static void _starpu_mpi_coop_pipeline_push(struct _starpu_mpi_coop_pipeline *pipeline)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+	pipeline->next = coop_pipelines;
+	coop_pipelines = pipeline;
+	if (!pipeline->started)
+		coop_pipelines_to_start++;
+	STARPU_PTHREAD_COND_SIGNAL(&progress_cond);
+#ifdef STARPU_SIMGRID
+	starpu_pthread_queue_signal(&_starpu_mpi_thread_dontsleep);
+#endif
+	STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+}
+
+static void _starpu_mpi_coop_pipeline_set_size(struct _starpu_mpi_coop_pipeline *pipeline, starpu_ssize_t size, starpu_ssize_t segment_size)
+{
+	size_t nsegments;
+
+	/* The counts and the request indexes given to MPI are int */
+	STARPU_MPI_ASSERT_MSG(segment_size > 0 && segment_size <= INT_MAX, "Invalid segment size %ld for pipelined cooperative sends", (long) segment_size);
+	nsegments = size ? ((size_t) size + segment_size - 1) / segment_size : 1;
+	STARPU_MPI_ASSERT_MSG(nsegments * STARPU_MAX(pipeline->nchildren, 1) <= INT_MAX, "Too many segments (%lu) for pipelined cooperative sends, STARPU_MPI_COOP_SEGMENT_SIZE should be increased", (unsigned long) nsegments);
+
+	pipeline->size = size;
+	pipeline->segment_size = segment_size;
+	pipeline->nsegments = (int) nsegments;
+	if (pipeline->nchildren)
+	{
+		pipeline->nsend_requests = pipeline->nsegments * pipeline->nchildren;
+		_STARPU_MPI_MALLOC(pipeline->send_requests, pipeline->nsend_requests * sizeof(MPI_Request));
+	}
+}
+
+/* Allocate an MPI tag for a new pipeline rooted on this node. Pipelines from
+ * different roots get different tags, so that a node can receive segments of
+ * several of them from the same parent */
+static int _starpu_mpi_coop_pipeline_tag(MPI_Comm comm, int rank)
+{
+	int *tag_ub, flag, size, nslots;
+
+	MPI_Comm_get_attr(comm, MPI_TAG_UB, &tag_ub, &flag);
+	STARPU_MPI_ASSERT_MSG(flag, "MPI_TAG_UB is not available");
+	MPI_Comm_size(comm, &size);
+	nslots = (*tag_ub - (_STARPU_MPI_TAG_COOP_DATA)) / size;
+	STARPU_MPI_ASSERT_MSG(nslots > 0, "Not enough MPI tags available for pipelined cooperative sends, MPI_TAG_UB is %d", *tag_ub);
+
+	return _STARPU_MPI_TAG_COOP_DATA + (int) (coop_pipeline_seq++ % nslots) * size + rank;
+}
+
+static void _starpu_mpi_coop_pipeline_forward(struct _starpu_mpi_coop_pipeline *pipeline, int segment)
+{
+	starpu_ssize_t offset = (starpu_ssize_t) segment * pipeline->segment_size;
+	int count = STARPU_MIN(pipeline->segment_size, pipeline->size - offset);
+	int i, ret;
+
+	for (i = 0; i < pipeline->nchildren; i++)
+	{
+		_STARPU_MPI_COMM_TO_DEBUG(pipeline->ptr, count, MPI_BYTE, pipeline->children[i], pipeline->mpi_tag, (int64_t)segment, pipeline->comm);
+		ret = MPI_Isend((char *) pipeline->ptr + offset, count, MPI_BYTE, pipeline->children[i], pipeline->mpi_tag, pipeline->comm, &pipeline->send_requests[segment * pipeline->nchildren + i]);
+		STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Isend returning %s", _starpu_mpi_get_mpi_error_code(ret));
+	}
+}
+
+/* Test whether the data is large enough to be worth pipelining, and whether it can be sent in packed form */
+static int _starpu_mpi_coop_pipeline_eligible(struct _starpu_mpi_coop_sends *coop_sends)
+{
+	starpu_data_handle_t data_handle = coop_sends->data_handle;
+	struct starpu_data_interface_ops *ops = starpu_data_get_interface_ops(data_handle);
+	unsigned i, j;
+
+	if (coop_segment_size <= 0 || (starpu_ssize_t) starpu_data_get_size(data_handle) <= coop_segment_size)
+		return 0;
+
+	/* The recipients which have not registered the data yet would expect
+	 * the layout of user-defined MPI datatypes, only use StarPU's
+	 * interfaces */
+	if (starpu_data_get_interface_id(data_handle) >= STARPU_MAX_INTERFACE_ID || !ops->pack_data || (!ops->peek_data && !ops->unpack_data))
+		return 0;
+
+	for (i = 0; i < coop_sends->n; i++)
+	{
+		if (coop_sends->reqs_array[i]->request_type != SEND_REQ)
+			return 0;
+		/* A node appearing twice in the tree would get the segments of both positions mixed */
+		for (j = 0; j < i; j++)
+			if (coop_sends->reqs_array[j]->node_tag.node.rank == coop_sends->reqs_array[i]->node_tag.node.rank)
+				return 0;
+	}
+	return 1;
+}
+
+/* Called by the progression thread on the owner of the data: pack it, send
+ * the envelopes, and start sending the segments to the first level of the
+ * tree. Node 0 of the tree is the owner, node i+1 is the recipient of
+ * reqs[i], and the children of node p are nodes p*arity+1 to p*arity+arity. */
+static void _starpu_mpi_coop_pipeline_start_send(struct _starpu_mpi_coop_pipeline *pipeline)
+{
+	struct _starpu_mpi_req *first = pipeline->reqs[0];
+	unsigned arity = coop_tree_arity, i, j;
+	int rank, ret;
+
+	MPI_Comm_rank(pipeline->comm, &rank);
+	pipeline->node = first->node;
+	starpu_data_pack_node(first->data_handle, pipeline->node, &pipeline->ptr, &pipeline->size);
+	pipeline->mpi_tag = _starpu_mpi_coop_pipeline_tag(pipeline->comm, rank);
+
+	for (i = 0; i < arity && i < pipeline->nreqs; i++)
+		pipeline->children[pipeline->nchildren++] = pipeline->reqs[i]->node_tag.node.rank;
+	_starpu_mpi_coop_pipeline_set_size(pipeline, pipeline->size, pipeline->segment_size);
+
+	_STARPU_MPI_DEBUG(0, "pipelining cooperative sends of %ld bytes to %u nodes in %d segments with tag %d\n", (long) pipeline->size, pipeline->nreqs, pipeline->nsegments, pipeline->mpi_tag);
+
+	for (i = 0; i < pipeline->nreqs; i++)
+	{
+		struct _starpu_mpi_req *req = pipeline->reqs[i];
+		struct _starpu_mpi_envelope *envelope;
+		unsigned parent = i / arity;
+
+		_STARPU_MPI_TRACE_ISEND_SUBMIT_BEGIN(req->node_tag.node.rank, req->node_tag.data_tag, 0);
+
+		_STARPU_MPI_CALLOC(envelope, 1, sizeof(struct _starpu_mpi_envelope));
+		envelope->mode = _STARPU_MPI_ENVELOPE_COOP_DATA;
+		envelope->size = pipeline->size;
+		envelope->data_tag = req->node_tag.data_tag;
+		envelope->sync = 0;
+		envelope->coop_parent = parent == 0 ? rank : pipeline->reqs[parent-1]->node_tag.node.rank;
+		envelope->coop_mpi_tag = pipeline->mpi_tag;
+		envelope->coop_segment_size = pipeline->segment_size;
+		for (j = (i+1) * arity + 1; j <= (i+1) * arity + arity && j <= pipeline->nreqs; j++)
+			envelope->coop_children[envelope->coop_nchildren++] = pipeline->reqs[j-1]->node_tag.node.rank;
+		req->backend->envelope = envelope;
+
+		req->ptr = pipeline->ptr;
+		req->count = pipeline->size;
+		req->datatype = MPI_BYTE;
+		req->registered_datatype = 0;
+
+		_STARPU_MPI_COMM_TO_DEBUG(envelope, _STARPU_MPI_ENVELOPE_SIZE(envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, envelope->data_tag, pipeline->comm);
+		ret = MPI_Isend(envelope, _STARPU_MPI_ENVELOPE_SIZE(envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, pipeline->comm, &req->backend->size_req);
+		STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "when sending envelope, MPI_Isend returning %s", _starpu_mpi_get_mpi_error_code(ret));
+
+		_STARPU_MPI_TRACE_ISEND_SUBMIT_END(_STARPU_MPI_FUT_POINT_TO_POINT_SEND, req, 0);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&req->backend->req_mutex);
+		req->submitted = 1;
+		STARPU_PTHREAD_COND_BROADCAST(&req->backend->req_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
+	}
+
+	for (i = 0; i < (unsigned) pipeline->nchildren; i++)
+		_starpu_mpi_comm_amounts_inc(pipeline->comm, pipeline->node, pipeline->children[i], MPI_BYTE, pipeline->size);
+	for (i = 0; i < (unsigned) pipeline->nsegments; i++)
+		_starpu_mpi_coop_pipeline_forward(pipeline, i);
+
+	/* The owner does not receive anything */
+	pipeline->next_segment = pipeline->nsegments;
+	pipeline->started = 1;
+	coop_segments_pending += pipeline->nsegments;
+}
+
+/* Called by the progression thread on a recipient when the envelope of a
+ * pipelined send arrives, req->ptr is a buffer of the size of the packed data */
+static void _starpu_mpi_coop_pipeline_start_recv(struct _starpu_mpi_req *req, struct _starpu_mpi_envelope *envelope)
+{
+	struct _starpu_mpi_coop_pipeline *pipeline;
+	int i, ret;
+
+	_STARPU_MPI_DEBUG(0, "receiving pipelined data with tag %"PRIi64" of %ld bytes from %d with tag %d, forwarding to %d nodes\n", req->node_tag.data_tag, (long) envelope->size, envelope->coop_parent, envelope->coop_mpi_tag, envelope->coop_nchildren);
+
+	_STARPU_MPI_TRACE_IRECV_SUBMIT_BEGIN(req->node_tag.node.rank, req->node_tag.data_tag);
+
+	_STARPU_MPI_CALLOC(pipeline, 1, sizeof(*pipeline));
+	pipeline->req = req;
+	pipeline->started = 1;
+	pipeline->comm = req->node_tag.node.comm;
+	pipeline->mpi_tag = envelope->coop_mpi_tag;
+	pipeline->nchildren = envelope->coop_nchildren;
+	memcpy(pipeline->children, envelope->coop_children, envelope->coop_nchildren * sizeof(pipeline->children[0]));
+	pipeline->node = req->node;
+	pipeline->ptr = req->ptr;
+	_starpu_mpi_coop_pipeline_set_size(pipeline, envelope->size, envelope->coop_segment_size);
+
+	_STARPU_MPI_MALLOC(pipeline->recv_requests, pipeline->nsegments * sizeof(MPI_Request));
+	for (i = 0; i < pipeline->nsegments; i++)
+	{
+		starpu_ssize_t offset = (starpu_ssize_t) i * pipeline->segment_size;
+		int count = STARPU_MIN(pipeline->segment_size, pipeline->size - offset);
+		_STARPU_MPI_COMM_FROM_DEBUG(pipeline->ptr, count, MPI_BYTE, envelope->coop_parent, pipeline->mpi_tag, (int64_t)i, pipeline->comm);
+		ret = MPI_Irecv((char *) pipeline->ptr + offset, count, MPI_BYTE, envelope->coop_parent, pipeline->mpi_tag, pipeline->comm, &pipeline->recv_requests[i]);
+		STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Irecv returning %s", _starpu_mpi_get_mpi_error_code(ret));
+	}
+	for (i = 0; i < pipeline->nchildren; i++)
+		_starpu_mpi_comm_amounts_inc(pipeline->comm, pipeline->node, pipeline->children[i], MPI_BYTE, pipeline->size);
+
+	_STARPU_MPI_TRACE_IRECV_SUBMIT_END(req->node_tag.node.rank, req->node_tag.data_tag);
+
+	coop_segments_pending += pipeline->nsegments;
+	_starpu_mpi_coop_pipeline_push(pipeline);
+}
+
+/* Forward the segments received so far, and return whether everything has been received and forwarded */
+static int _starpu_mpi_coop_pipeline_progress(struct _starpu_mpi_coop_pipeline *pipeline)
+{
+	int flag, ret;
+
+	if (!pipeline->started)
+		_starpu_mpi_coop_pipeline_start_send(pipeline);
+
+	while (pipeline->next_segment < pipeline->nsegments)
+	{
+		ret = MPI_Test(&pipeline->recv_requests[pipeline->next_segment], &flag, MPI_STATUS_IGNORE);
+		STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Test returning %s", _starpu_mpi_get_mpi_error_code(ret));
+		if (!flag)
+			break;
+		_starpu_mpi_coop_pipeline_forward(pipeline, pipeline->next_segment);
+		pipeline->next_segment++;
+	}
+
+	/* A segment is done once it has been received and forwarded */
+	while (pipeline->next_sent_segment < pipeline->next_segment)
+	{
+		if (pipeline->nchildren)
+		{
+			ret = MPI_Testall(pipeline->nchildren, &pipeline->send_requests[pipeline->next_sent_segment * pipeline->nchildren], &flag, MPI_STATUSES_IGNORE);
+			STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Testall returning %s", _starpu_mpi_get_mpi_error_code(ret));
+			if (!flag)
+				break;
+		}
+		pipeline->next_sent_segment++;
+		coop_segments_pending--;
+	}
+
+	return pipeline->next_sent_segment == pipeline->nsegments;
+}
+
+static void _starpu_mpi_coop_pipeline_send_termination(struct _starpu_mpi_req *req)
+{
+	int ret;
+
+	ret = MPI_Wait(&req->backend->size_req, MPI_STATUS_IGNORE);
+	STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Wait returning %s", _starpu_mpi_get_mpi_error_code(ret));
+	_STARPU_MPI_TRACE_TERMINATED(req);
+
+	req->ptr = NULL;
+	_starpu_mpi_release_req_data(req);
+
+	free(req->backend->envelope);
+	req->backend->envelope = NULL;
+
+	_STARPU_MPI_INC_POSTED_REQUESTS(req, -1);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&req->backend->req_mutex);
+	req->completed = 1;
+	STARPU_PTHREAD_COND_BROADCAST(&req->backend->req_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
+
+	_starpu_mpi_request_destroy(req);
+}
+
+static void _starpu_mpi_coop_pipeline_complete(struct _starpu_mpi_coop_pipeline *pipeline)
+{
+	if (pipeline->reqs)
+	{
+		unsigned i;
+
+		starpu_free_on_node_flags(pipeline->node, (uintptr_t) pipeline->ptr, pipeline->size, 0);
+		/* Note: the coop_sends bag disappears with the last request */
+		for (i = 0; i < pipeline->nreqs; i++)
+			_starpu_mpi_coop_pipeline_send_termination(pipeline->reqs[i]);
+		free(pipeline->reqs);
+	}
+	else
+	{
+		struct _starpu_mpi_req *req = pipeline->req;
+
+		/* There is no MPI request to complete, the usual termination will unpack the data */
+		req->backend->data_request = MPI_REQUEST_NULL;
+		if (req->detached)
+		{
+			_starpu_mpi_handle_request_termination(req);
+			_starpu_mpi_destroy_detached_request(req);
+		}
+		else
+		{
+			/* starpu_mpi_wait and starpu_mpi_test can now terminate it */
+			STARPU_PTHREAD_MUTEX_LOCK(&req->backend->req_mutex);
+			req->submitted = 1;
+			STARPU_PTHREAD_COND_BROADCAST(&req->backend->req_cond);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
+		}
+	}
+
+	free(pipeline->recv_requests);
+	free(pipeline->send_requests);
+	free(pipeline);
+}
+
+// We suppose progress_mutex is locked
+static void _starpu_mpi_test_coop_pipelines(void)
+{
+	struct _starpu_mpi_coop_pipeline *pipeline, *next, *remaining = NULL;
+
+	if (!coop_pipelines)
+		return;
+
+	/* Only this thread removes pipelines from the list, take them all,
+	 * they all get started below */
+	pipeline = coop_pipelines;
+	coop_pipelines = NULL;
+	coop_pipelines_to_start = 0;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+
+	for ( ; pipeline; pipeline = next)
+	{
+		next = pipeline->next;
+		if (_starpu_mpi_coop_pipeline_progress(pipeline))
+			_starpu_mpi_coop_pipeline_complete(pipeline);
+		else
+		{
+			pipeline->next = remaining;
+			remaining = pipeline;
+		}
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+	for ( ; remaining; remaining = next)
+	{
+		next = remaining->next;
+		remaining->next = coop_pipelines;
+		coop_pipelines = remaining;
+	}
+}
+
 #if 0
 void _starpu_mpi_coop_sends_build_tree(struct _starpu_mpi_coop_sends *coop_sends)
 {
@@ -176,6 +574,22 @@ void _starpu_mpi_submit_coop_sends(struct _starpu_mpi_coop_sends *coop_sends, in
 	(void)submit_control;
 	unsigned i, n = coop_sends->n;
 
+	if (submit_data && _starpu_mpi_coop_pipeline_eligible(coop_sends))
+	{
+		struct _starpu_mpi_coop_pipeline *pipeline;
+
+		/* Let the progression thread pack the data and build the tree */
+		_STARPU_MPI_CALLOC(pipeline, 1, sizeof(*pipeline));
+		_STARPU_MPI_MALLOC(pipeline->reqs, n * sizeof(*pipeline->reqs));
+		memcpy(pipeline->reqs, coop_sends->reqs_array, n * sizeof(*pipeline->reqs));
+		pipeline->nreqs = n;
+		pipeline->comm = pipeline->reqs[0]->node_tag.node.comm;
+		pipeline->segment_size = coop_segment_size;
+		_STARPU_MPI_DEBUG(0, "cooperative sends %p pipelined to %u nodes\n", coop_sends, n);
+		_starpu_mpi_coop_pipeline_push(pipeline);
+		return;
+	}
+
 	/* Note: coop_sends might disappear very very soon after last request is submitted */
 	for (i = 0; i < n; i++)
 	{
@@ -472,8 +886,8 @@ void _starpu_mpi_isend_size_func(struct _starpu_mpi_req *req)
 		MPI_Type_size(req->datatype, &size);
 		req->backend->envelope->size = (starpu_ssize_t)req->count * size;
 		_STARPU_MPI_DEBUG(20, "Post MPI isend count (%ld) datatype_size %ld request to %d\n",req->count,starpu_data_get_size(req->data_handle), req->node_tag.node.rank);
-		_STARPU_MPI_COMM_TO_DEBUG(req->backend->envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->backend->envelope->data_tag, req->node_tag.node.comm);
-		ret = MPI_Isend(req->backend->envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm, &req->backend->size_req);
+		_STARPU_MPI_COMM_TO_DEBUG(req->backend->envelope, _STARPU_MPI_ENVELOPE_SIZE(req->backend->envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->backend->envelope->data_tag, req->node_tag.node.comm);
+		ret = MPI_Isend(req->backend->envelope, _STARPU_MPI_ENVELOPE_SIZE(req->backend->envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm, &req->backend->size_req);
 		STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "when sending envelope, MPI_Isend returning %s", _starpu_mpi_get_mpi_error_code(ret));
 	}
 	else
@@ -488,8 +902,8 @@ void _starpu_mpi_isend_size_func(struct _starpu_mpi_req *req)
 			// We already know the size of the data, let's send it to overlap with the packing of the data
 			_STARPU_MPI_DEBUG(20, "Sending size %ld (%ld %s) to node %d (first call to pack)\n", req->backend->envelope->size, sizeof(req->count), "MPI_BYTE", req->node_tag.node.rank);
 			req->count = req->backend->envelope->size;
-			_STARPU_MPI_COMM_TO_DEBUG(req->backend->envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->backend->envelope->data_tag, req->node_tag.node.comm);
-			ret = MPI_Isend(req->backend->envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm, &req->backend->size_req);
+			_STARPU_MPI_COMM_TO_DEBUG(req->backend->envelope, _STARPU_MPI_ENVELOPE_SIZE(req->backend->envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->backend->envelope->data_tag, req->node_tag.node.comm);
+			ret = MPI_Isend(req->backend->envelope, _STARPU_MPI_ENVELOPE_SIZE(req->backend->envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm, &req->backend->size_req);
 			STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "when sending size, MPI_Isend returning %s", _starpu_mpi_get_mpi_error_code(ret));
 		}
 
@@ -499,8 +913,8 @@ void _starpu_mpi_isend_size_func(struct _starpu_mpi_req *req)
 		{
 			// We know the size now, let's send it
 			_STARPU_MPI_DEBUG(20, "Sending size %ld (%ld %s) to node %d (second call to pack)\n", req->backend->envelope->size, sizeof(req->count), "MPI_BYTE", req->node_tag.node.rank);
-			_STARPU_MPI_COMM_TO_DEBUG(req->backend->envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->backend->envelope->data_tag, req->node_tag.node.comm);
-			ret = MPI_Isend(req->backend->envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm, &req->backend->size_req);
+			_STARPU_MPI_COMM_TO_DEBUG(req->backend->envelope, _STARPU_MPI_ENVELOPE_SIZE(req->backend->envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->backend->envelope->data_tag, req->node_tag.node.comm);
+			ret = MPI_Isend(req->backend->envelope, _STARPU_MPI_ENVELOPE_SIZE(req->backend->envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm, &req->backend->size_req);
 			STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "when sending size, MPI_Isend returning %s", _starpu_mpi_get_mpi_error_code(ret));
 		}
 		else
@@ -546,8 +960,8 @@ void _starpu_mpi_irecv_size_func(struct _starpu_mpi_req *req)
 		_envelope->mode = _STARPU_MPI_ENVELOPE_SYNC_READY;
 		_envelope->data_tag = req->node_tag.data_tag;
 		_STARPU_MPI_DEBUG(20, "Telling node %d it can send the data and waiting for the data back ...\n", req->node_tag.node.rank);
-		_STARPU_MPI_COMM_TO_DEBUG(_envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, _envelope->data_tag, req->node_tag.node.comm);
-		req->ret = MPI_Send(_envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm);
+		_STARPU_MPI_COMM_TO_DEBUG(_envelope, _STARPU_MPI_ENVELOPE_SIZE(_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, _envelope->data_tag, req->node_tag.node.comm);
+		req->ret = MPI_Send(_envelope, _STARPU_MPI_ENVELOPE_SIZE(_envelope), MPI_BYTE, req->node_tag.node.rank, _STARPU_MPI_TAG_ENVELOPE, req->node_tag.node.comm);
 		STARPU_MPI_ASSERT_MSG(req->ret == MPI_SUCCESS, "MPI_Send returning %s", _starpu_mpi_get_mpi_error_code(req->ret));
 		free(_envelope);
 		_envelope = NULL;
@@ -1085,6 +1499,26 @@ static void _starpu_mpi_early_data_cb(void* arg)
 	args = NULL;
 }
 
+/* Destroy a detached request which was just terminated */
+static void _starpu_mpi_destroy_detached_request(struct _starpu_mpi_req *req)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&req->backend->req_mutex);
+	/* We don't want to free internal non-detached
+	   requests, we need to get their MPI request before
+	   destroying them */
+	if (req->backend->is_internal_req && !req->backend->to_destroy)
+	{
+		/* We have completed the request, let the application request destroy it */
+		req->backend->to_destroy = 1;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
+	}
+	else
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
+		_starpu_mpi_request_destroy(req);
+	}
+}
+
 // We suppose progress_mutex is locked
 static void _starpu_mpi_test_detached_requests(void)
 {
@@ -1139,21 +1573,7 @@ static void _starpu_mpi_test_detached_requests(void)
 
 			_STARPU_MPI_TRACE_COMPLETE_END(req->request_type, req->node_tag.node.rank, req->node_tag.data_tag);
 
-			STARPU_PTHREAD_MUTEX_LOCK(&req->backend->req_mutex);
-			/* We don't want to free internal non-detached
-			   requests, we need to get their MPI request before
-			   destroying them */
-			if (req->backend->is_internal_req && !req->backend->to_destroy)
-			{
-				/* We have completed the request, let the application request destroy it */
-				req->backend->to_destroy = 1;
-				STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
-			}
-			else
-			{
-				STARPU_PTHREAD_MUTEX_UNLOCK(&req->backend->req_mutex);
-				_starpu_mpi_request_destroy(req);
-			}
+			_starpu_mpi_destroy_detached_request(req);
 
 			req = next_req;
 			_STARPU_MPI_TRACE_POLLING_BEGIN();
@@ -1286,7 +1706,23 @@ static void _starpu_mpi_receive_early_data(struct _starpu_mpi_envelope *envelope
 	// posted before receiving an other envelope
 	_starpu_mpi_req_list_erase(&ready_recv_requests, early_data_handle->req);
 	STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
-	_starpu_mpi_handle_ready_request(early_data_handle->req);
+	if (envelope->mode == _STARPU_MPI_ENVELOPE_COOP_DATA)
+	{
+		struct _starpu_mpi_req *req = early_data_handle->req;
+		if (req->registered_datatype == 1)
+		{
+			/* The data comes in packed form */
+			_starpu_mpi_datatype_free(req->data_handle, &req->datatype);
+			req->datatype = MPI_BYTE;
+			req->registered_datatype = 0;
+			req->count = envelope->size;
+			req->ptr = (void *)starpu_malloc_on_node_flags(req->node, req->count, 0);
+			starpu_memory_allocate(req->node, req->count, STARPU_MEMORY_OVERFLOW);
+		}
+		_starpu_mpi_coop_pipeline_start_recv(req, envelope);
+	}
+	else
+		_starpu_mpi_handle_ready_request(early_data_handle->req);
 	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
 }
 
@@ -1347,7 +1783,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 
 	_starpu_mpi_comm_amounts_init(argc_argv->comm);
 	_starpu_mpi_cache_init(argc_argv->comm);
-	_starpu_mpi_select_node_init();
+	_starpu_mpi_select_node_init(argc_argv->comm);
 	_starpu_mpi_tag_init();
 	_starpu_mpi_comm_init(argc_argv->comm);
 	_starpu_mpi_tags_init();
@@ -1386,7 +1822,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 		starpu_pthread_wait_reset(&_starpu_mpi_thread_wait);
 #endif
 		/* shall we block ? */
-		unsigned block = _starpu_mpi_req_list_empty(&ready_recv_requests) && _starpu_mpi_req_prio_list_empty(&ready_send_requests) && _starpu_mpi_early_request_count() == 0 && _starpu_mpi_sync_data_count() == 0 && _starpu_mpi_req_list_empty(&detached_requests);
+		unsigned block = _starpu_mpi_req_list_empty(&ready_recv_requests) && _starpu_mpi_req_prio_list_empty(&ready_send_requests) && _starpu_mpi_early_request_count() == 0 && _starpu_mpi_sync_data_count() == 0 && _starpu_mpi_req_list_empty(&detached_requests) && !coop_pipelines_to_start && !coop_segments_pending;
 
 		if (block)
 		{
@@ -1466,6 +1902,9 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 		/* test whether there are some terminated "detached request" */
 		_starpu_mpi_test_detached_requests();
 
+		/* forward the received segments of pipelined cooperative sends */
+		_starpu_mpi_test_coop_pipelines();
+
 		if (envelope_request_submitted == 1)
 		{
 			int flag;
@@ -1479,7 +1918,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 			if (flag)
 			{
 				_STARPU_MPI_TRACE_POLLING_END();
-				_STARPU_MPI_COMM_FROM_DEBUG(envelope, sizeof(struct _starpu_mpi_envelope), MPI_BYTE, envelope_status.MPI_SOURCE, _STARPU_MPI_TAG_ENVELOPE, envelope->data_tag, envelope_comm);
+				_STARPU_MPI_COMM_FROM_DEBUG(envelope, _STARPU_MPI_ENVELOPE_SIZE(envelope), MPI_BYTE, envelope_status.MPI_SOURCE, _STARPU_MPI_TAG_ENVELOPE, envelope->data_tag, envelope_comm);
 				_STARPU_MPI_DEBUG(4, "Envelope received with mode %d\n", envelope->mode);
 				if (envelope->mode == _STARPU_MPI_ENVELOPE_SYNC_READY)
 				{
@@ -1552,29 +1991,46 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 						_STARPU_MPI_DEBUG(2000, "Request sync %d\n", envelope->sync);
 
 						early_request->sync = envelope->sync;
-						_starpu_mpi_datatype_allocate(early_request->data_handle, early_request);
-						if (early_request->registered_datatype == 1)
-						{
-							early_request->count = 1;
-							early_request->ptr = starpu_data_handle_to_pointer(early_request->data_handle, early_request->node);
-						}
-						else
+						if (envelope->mode == _STARPU_MPI_ENVELOPE_COOP_DATA)
 						{
+							/* The data comes in packed form through a diffusion tree */
+							early_request->datatype = MPI_BYTE;
+							early_request->registered_datatype = 0;
 							early_request->count = envelope->size;
 							early_request->ptr = (void *)starpu_malloc_on_node_flags(early_request->node, early_request->count, 0);
 							starpu_memory_allocate(early_request->node, early_request->count, STARPU_MEMORY_OVERFLOW);
-
 							STARPU_MPI_ASSERT_MSG(early_request->ptr, "cannot allocate message of size %ld\n", early_request->count);
-						}
 
-						_STARPU_MPI_DEBUG(3, "Handling new request... \n");
-						/* handling a request is likely to block for a while
-						 * (on a sync_data_with_mem call), we want to let the
-						 * application submit requests in the meantime, so we
-						 * release the lock. */
-						STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
-						_starpu_mpi_handle_ready_request(early_request);
-						STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+							STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+							_starpu_mpi_coop_pipeline_start_recv(early_request, envelope);
+							STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+						}
+						else
+						{
+							_starpu_mpi_datatype_allocate(early_request->data_handle, early_request);
+							if (early_request->registered_datatype == 1)
+							{
+								early_request->count = 1;
+								early_request->ptr = starpu_data_handle_to_pointer(early_request->data_handle, early_request->node);
+							}
+							else
+							{
+								early_request->count = envelope->size;
+								early_request->ptr = (void *)starpu_malloc_on_node_flags(early_request->node, early_request->count, 0);
+								starpu_memory_allocate(early_request->node, early_request->count, STARPU_MEMORY_OVERFLOW);
+
+								STARPU_MPI_ASSERT_MSG(early_request->ptr, "cannot allocate message of size %ld\n", early_request->count);
+							}
+
+							_STARPU_MPI_DEBUG(3, "Handling new request... \n");
+							/* handling a request is likely to block for a while
+							 * (on a sync_data_with_mem call), we want to let the
+							 * application submit requests in the meantime, so we
+							 * release the lock. */
+							STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+							_starpu_mpi_handle_ready_request(early_request);
+							STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+						}
 					}
 				}
 				envelope_request_submitted = 0;
@@ -1648,6 +2104,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 #endif
 
 	STARPU_MPI_ASSERT_MSG(_starpu_mpi_req_list_empty(&detached_requests), "List of detached requests not empty");
+	STARPU_MPI_ASSERT_MSG(!coop_pipelines, "List of pipelined cooperative sends not empty");
 	STARPU_MPI_ASSERT_MSG(ndetached_send_requests == 0, "Number of detached send requests not 0");
 	STARPU_MPI_ASSERT_MSG(_starpu_mpi_req_list_empty(&ready_recv_requests), "List of ready requests not empty");
 	STARPU_MPI_ASSERT_MSG(_starpu_mpi_req_prio_list_empty(&ready_send_requests), "List of ready requests not empty");
@@ -1695,6 +2152,13 @@ int _starpu_mpi_progress_init(struct _starpu_mpi_argc_argv *argc_argv)
 	nready_process = starpu_getenv_number_default("STARPU_MPI_NREADY_PROCESS", 10);
 	ndetached_send_requests_max = starpu_getenv_number_default("STARPU_MPI_NDETACHED_SEND", 10);
 	early_data_force_allocate = starpu_getenv_number_default("STARPU_MPI_EARLYDATA_ALLOCATE", 0);
+	coop_segment_size = starpu_getenv_number_default("STARPU_MPI_COOP_SEGMENT_SIZE", 0);
+	coop_tree_arity = starpu_getenv_number_default("STARPU_MPI_COOP_TREE_ARITY", 2);
+	if (coop_tree_arity < 1 || coop_tree_arity > _STARPU_MPI_COOP_MAX_ARITY)
+	{
+		_STARPU_DISP("Warning: STARPU_MPI_COOP_TREE_ARITY must be between 1 and %d\n", _STARPU_MPI_COOP_MAX_ARITY);
+		coop_tree_arity = STARPU_MAX(1, STARPU_MIN(coop_tree_arity, _STARPU_MPI_COOP_MAX_ARITY));
+	}
 
 #ifdef STARPU_SIMGRID
 	STARPU_PTHREAD_MUTEX_INIT(&wait_counter_mutex, NULL);
@@ -40,11 +40,22 @@ extern int _starpu_mpi_tag;
 #define _STARPU_MPI_TAG_EXT_DATA  _starpu_mpi_tag+5
 #define _STARPU_MPI_TAG_CP_INFO    _starpu_mpi_tag+6
 #endif // STARPU_USE_MPI_FT
+/** First tag used for the segments of pipelined cooperative sends, the tags
+ * above it are allocated by the root of each diffusion tree */
+#define _STARPU_MPI_TAG_COOP_DATA _starpu_mpi_tag+7
+
+/** Maximum number of children of a node in the diffusion tree of pipelined
+ * cooperative sends */
+#define _STARPU_MPI_COOP_MAX_ARITY 8
 
 enum _starpu_envelope_mode
 {
 	_STARPU_MPI_ENVELOPE_DATA=0,
-	_STARPU_MPI_ENVELOPE_SYNC_READY=1
+	_STARPU_MPI_ENVELOPE_SYNC_READY=1,
+	/** The data is sent in packed form as segments through a diffusion
+	 * tree, the envelope tells where to receive them from and where to
+	 * forward them to */
+	_STARPU_MPI_ENVELOPE_COOP_DATA=2
 };
 
 struct _starpu_mpi_envelope
@@ -53,8 +64,27 @@ struct _starpu_mpi_envelope
 	starpu_ssize_t size;
 	starpu_mpi_tag_t data_tag;
 	unsigned sync;
+	/** The following fields are only used by _STARPU_MPI_ENVELOPE_COOP_DATA */
+	/** Node the segments are received from */
+	int coop_parent;
+	/** MPI tag the segments are sent with */
+	int coop_mpi_tag;
+	/** Size of the segments, the last one may be smaller */
+	starpu_ssize_t coop_segment_size;
+	/** Nodes the segments have to be forwarded to */
+	int coop_nchildren;
+	int coop_children[_STARPU_MPI_COOP_MAX_ARITY];
 };
 
+/** Number of bytes of \p envelope to be sent. The fields of cooperative sends
+ * are only sent with _STARPU_MPI_ENVELOPE_COOP_DATA, and only the children
+ * actually used, so that the other envelopes do not get larger. Envelopes
+ * are always received in a whole struct _starpu_mpi_envelope. */
+#define _STARPU_MPI_ENVELOPE_SIZE(envelope) \
+	((envelope)->mode == _STARPU_MPI_ENVELOPE_COOP_DATA \
+	 ? offsetof(struct _starpu_mpi_envelope, coop_children) + (envelope)->coop_nchildren * sizeof((envelope)->coop_children[0]) \
+	 : offsetof(struct _starpu_mpi_envelope, coop_parent))
+
 struct _starpu_mpi_req_backend
 {
 	MPI_Request data_request;
@@ -31,6 +31,52 @@
 
 starpu_pthread_mutex_t cp_lib_mutex;
 
+/* Number of acknowledgements that this node awaits for its checkpoints, and
+ * of checkpoint data and discard messages that it has not processed yet as a
+ * backup */
+static int pending_count;
+static starpu_pthread_mutex_t pending_mutex;
+static starpu_pthread_cond_t pending_cond;
+
+void _starpu_mpi_checkpoint_pending_init(void)
+{
+	pending_count = 0;
+	STARPU_PTHREAD_MUTEX_INIT(&pending_mutex, NULL);
+	STARPU_PTHREAD_COND_INIT(&pending_cond, NULL);
+}
+
+void _starpu_mpi_checkpoint_pending_shutdown(void)
+{
+	STARPU_PTHREAD_MUTEX_DESTROY(&pending_mutex);
+	STARPU_PTHREAD_COND_DESTROY(&pending_cond);
+}
+
+void _starpu_mpi_checkpoint_pending_add(int n)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&pending_mutex);
+	pending_count += n;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pending_mutex);
+}
+
+void _starpu_mpi_checkpoint_pending_done(void)
+{
+	/* When all the data are skipped, the owner may validate a checkpoint
+	 * before its backup has submitted it, the count can then temporarily
+	 * go below zero */
+	STARPU_PTHREAD_MUTEX_LOCK(&pending_mutex);
+	if (--pending_count <= 0)
+		STARPU_PTHREAD_COND_BROADCAST(&pending_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pending_mutex);
+}
+
+void _starpu_mpi_checkpoint_pending_wait(void)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&pending_mutex);
+	while (pending_count > 0)
+		STARPU_PTHREAD_COND_WAIT(&pending_cond, &pending_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pending_mutex);
+}
+
 void _ack_msg_send_cb(void* _args)
 {
 	struct _starpu_mpi_cp_ack_arg_cb* arg = (struct _starpu_mpi_cp_ack_arg_cb*) _args;
@@ -59,6 +105,7 @@ void _ack_msg_recv_cb(void* _args)
 void _starpu_mpi_store_data_and_send_ack_cb(struct _starpu_mpi_cp_ack_arg_cb* arg)
 {
 	checkpoint_package_data_add(arg->msg.checkpoint_id, arg->msg.checkpoint_instance, arg->rank, arg->tag, arg->type, arg->copy_handle, arg->count);
+	_starpu_mpi_checkpoint_pending_done();
 	_STARPU_MPI_DEBUG(3,"Send ack msg to %d: id=%d inst=%d\n", arg->rank, arg->msg.checkpoint_id, arg->msg.checkpoint_instance);
 	_starpu_mpi_ft_service_post_send((void *) &arg->msg, sizeof(struct _starpu_mpi_cp_ack_msg), arg->rank,
 					 _STARPU_MPI_TAG_CP_ACK, MPI_COMM_WORLD, _ack_msg_send_cb, arg);
@@ -104,6 +151,7 @@ void _send_cp_internal_data_cb(void* _args)
 	_starpu_mpi_push_cp_ack_recv_cb(_args);
 	if (!arg->cache_flag)
 	{
+		_STARPU_MPI_FT_STATS_CP_DATA_STALL(starpu_timing_now() - arg->send_start);
 		//TODO: check cp_domain!
 		struct _starpu_mpi_checkpoint_tracker* tracker = _starpu_mpi_checkpoint_template_get_tracking_inst_by_id_inst(0, arg->checkpoint_instance_hint);
 		if(!tracker->first_msg_sent_flag)
@@ -138,6 +186,7 @@ int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_te
 	current_instance = increment_current_instance();
 	_starpu_mpi_checkpoint_post_cp_discard_recv(cp_template);
 	_starpu_mpi_checkpoint_template_create_instance_tracker(cp_template, cp_template->cp_id, cp_template->checkpoint_domain, current_instance);
+	_starpu_mpi_checkpoint_pending_add(cp_template->message_to_send_number);
 	//TODO check what happens when all the ack msg are received when we arrive here.
 	item = _starpu_mpi_checkpoint_template_get_first_data(cp_template);
 	while (item != _starpu_mpi_checkpoint_template_end(cp_template))
@@ -171,6 +220,7 @@ int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_te
 					starpu_variable_data_register(&arg->handle, STARPU_MAIN_RAM, (uintptr_t)cpy_ptr, item->count);
 					arg->rank = item->backup_of;
 					_STARPU_MPI_DEBUG(0, "Submit CP: receiving external data tag:%ld, from :%d\n", arg->tag, arg->rank);
+					_starpu_mpi_checkpoint_pending_add(1);
 					ret = starpu_mpi_irecv_detached(arg->handle, arg->rank, arg->tag, MPI_COMM_WORLD,
 									&_recv_cp_external_data_cb, (void*)arg);
 					STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_irecv_detached");
@@ -184,12 +234,21 @@ int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_te
 				{
 					if (!mpi_data->modified)
 					{
-						_starpu_mpi_checkpoint_tracker_update(cp_template, cp_template->cp_id, cp_template->checkpoint_domain, current_instance);
-						//TODO: check if the data are all acknowledged
+						// No ack will come for this data, count it as acknowledged right away
+						_checkpoint_template_digest_ack_reception(cp_template->cp_id, current_instance);
 						_STARPU_MPI_DEBUG(0, "Submit CP: skip send starPU data to %d (tag %d)\n", item->backupped_by, (int)starpu_mpi_data_get_tag(handle));
 						_STARPU_MPI_FT_STATS_SEND_CACHED_CP_DATA(starpu_data_get_size(handle));
 						break; // We don't want to CP a data that is still at initial state.
 					}
+					if (_starpu_mpi_checkpoint_incremental && mpi_data->nwrites == item->checkpointed_nwrites)
+					{
+						// The backup still holds the copy of the previous checkpoint of this data
+						_checkpoint_template_digest_ack_reception(cp_template->cp_id, current_instance);
+						_STARPU_MPI_DEBUG(0, "Submit CP: skip send of unchanged starPU data to %d (tag %d)\n", item->backupped_by, (int)starpu_mpi_data_get_tag(handle));
+						_STARPU_MPI_FT_STATS_SEND_SKIPPED_CP_DATA(starpu_data_get_size(handle));
+						break;
+					}
+					item->checkpointed_nwrites = mpi_data->nwrites;
 					_STARPU_MPI_DEBUG(0, "Submit CP: sending starPU data to %d (tag %d)\n", item->backupped_by, (int)starpu_mpi_data_get_tag(handle));
 					_STARPU_MALLOC(arg, sizeof(struct _starpu_mpi_cp_ack_arg_cb));
 					arg->rank = item->backupped_by;
@@ -198,6 +257,7 @@ int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_te
 					arg->type = STARPU_R;
 					arg->count = item->count;
 					arg->checkpoint_instance_hint = current_instance;
+					arg->send_start = starpu_timing_now();
 					_starpu_mpi_isend_cache_aware(handle, item->backupped_by, starpu_mpi_data_get_tag(handle), MPI_COMM_WORLD, 1, 0, prio,
 					                              &_send_cp_internal_data_cb, (void*)arg, 1, &arg->cache_flag);
 					// the callbacks need to post ack recv. The cache one needs to release the handle.
@@ -211,6 +271,14 @@ int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_te
 						_STARPU_MPI_FT_STATS_RECV_CACHED_CP_DATA(starpu_data_get_size(handle));
 						break; // We don't want to CP a data that is still at initial state.
 					}
+					if (_starpu_mpi_checkpoint_incremental && mpi_data->nwrites == item->checkpointed_nwrites)
+					{
+						// Keep the copy of the previous checkpoint of this data, the owner does not send it again
+						_STARPU_MPI_DEBUG(0, "Submit CP: skip recv of unchanged starPU data from %d (tag %d)\n", item->backup_of, (int)starpu_mpi_data_get_tag(handle));
+						_STARPU_MPI_FT_STATS_RECV_SKIPPED_CP_DATA(starpu_data_get_size(handle));
+						break;
+					}
+					item->checkpointed_nwrites = mpi_data->nwrites;
 					_STARPU_MPI_DEBUG(0, "Submit CP: receiving starPU data from %d (tag %d)\n", starpu_mpi_data_get_rank(handle), (int)starpu_mpi_data_get_tag(handle));
 					_STARPU_MALLOC(arg, sizeof(struct _starpu_mpi_cp_ack_arg_cb));
 					arg->rank = item->backup_of;
@@ -220,6 +288,7 @@ int starpu_mpi_checkpoint_template_submit(starpu_mpi_checkpoint_template_t cp_te
 					arg->count = item->count;
 					arg->msg.checkpoint_id = cp_template->cp_id;
 					arg->msg.checkpoint_instance = current_instance;
+					_starpu_mpi_checkpoint_pending_add(1);
 					_starpu_mpi_irecv_cache_aware(handle, starpu_mpi_data_get_rank(handle), starpu_mpi_data_get_tag(handle), MPI_COMM_WORLD, 1, 0,
 								      NULL, NULL, 1, 0, 1, &arg->cache_flag);
 					// The callback needs to do nothing. The cached one must release the handle.
@@ -27,6 +27,8 @@ extern "C"
 #endif
 
 extern int _my_rank;
+/** Whether checkpoints only save the data which have been written since they were last saved */
+extern int _starpu_mpi_checkpoint_incremental;
 
 struct _starpu_mpi_cp_ack_msg
 {
@@ -53,6 +55,7 @@ struct _starpu_mpi_cp_ack_arg_cb
 	struct _starpu_mpi_cp_ack_msg msg;
 	int checkpoint_instance_hint;
 	int cache_flag;
+	double send_start;
 };
 
 struct _starpu_mpi_cp_discard_arg_cb
@@ -63,6 +66,14 @@ struct _starpu_mpi_cp_discard_arg_cb
 
 void _ack_msg_recv_cb(void* _args);
 
+void _starpu_mpi_checkpoint_pending_init(void);
+void _starpu_mpi_checkpoint_pending_shutdown(void);
+void _starpu_mpi_checkpoint_pending_add(int n);
+void _starpu_mpi_checkpoint_pending_done(void);
+/** Wait for the acknowledgements of the checkpoints submitted by this node, and
+ * for the checkpoint data and discard messages of the nodes that it backs up */
+void _starpu_mpi_checkpoint_pending_wait(void);
+
 #ifdef __cplusplus
 }
 #endif
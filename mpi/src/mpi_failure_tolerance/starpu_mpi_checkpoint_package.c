@@ -129,6 +129,27 @@ int _checkpoint_package_data_delete(struct _starpu_mpi_checkpoint_data* checkpoi
 	return size;
 }
 
+/* Whether a more recent copy of the data is part of the checkpoint instance
+ * cp_inst. Incremental checkpoints do not save again the data which have not
+ * been modified, the copy from the previous instance then remains the valid
+ * one. */
+static int _checkpoint_package_data_superseded(struct _starpu_mpi_checkpoint_data* old_checkpoint_data, int cp_inst)
+{
+	struct _starpu_mpi_checkpoint_data* checkpoint_data;
+	for (checkpoint_data = _starpu_mpi_checkpoint_data_list_begin(checkpoint_data_list) ;
+	     checkpoint_data != _starpu_mpi_checkpoint_data_list_end(checkpoint_data_list) ;
+	     checkpoint_data = _starpu_mpi_checkpoint_data_list_next(checkpoint_data))
+	{
+		if (checkpoint_data->rank == old_checkpoint_data->rank && checkpoint_data->tag == old_checkpoint_data->tag
+		    && checkpoint_data->type == old_checkpoint_data->type
+		    && checkpoint_data->cp_inst > old_checkpoint_data->cp_inst && checkpoint_data->cp_inst <= cp_inst)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 int checkpoint_package_data_del(int cp_id, int cp_inst, int rank)
 {
 	(void)cp_id;
@@ -141,8 +162,8 @@ int checkpoint_package_data_del(int cp_id, int cp_inst, int rank)
 	{
 		next_checkpoint_data = _starpu_mpi_checkpoint_data_list_next(checkpoint_data);
 		// I delete all the old data (i.e. the cp inst is strictly lower than the one of the just validated CP) only for
-		// the rank that initiated the CP
-		if (checkpoint_data->cp_inst<cp_inst && checkpoint_data->rank==rank)
+		// the rank that initiated the CP, and only if the just validated CP holds a more recent copy
+		if (checkpoint_data->cp_inst<cp_inst && checkpoint_data->rank==rank && _checkpoint_package_data_superseded(checkpoint_data, cp_inst))
 		{
 			size += _checkpoint_package_data_delete(checkpoint_data);
 			done++;
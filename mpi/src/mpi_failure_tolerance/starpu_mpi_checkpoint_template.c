@@ -176,6 +176,7 @@ void _cp_discard_message_recv_cb(void* _args)
 	_STARPU_MPI_FT_STATS_RECV_FT_SERVICE_MSG(sizeof(struct _starpu_mpi_cp_ack_msg));
 	_STARPU_MPI_DEBUG(0, "DISCARDING OLD CHECKPOINT DATA of rank %d - new one is CPID:%d - CPINST:%d\n", arg->rank, arg->msg.checkpoint_id, arg->msg.checkpoint_instance);
 	checkpoint_package_data_del(arg->msg.checkpoint_id, arg->msg.checkpoint_instance, arg->rank);
+	_starpu_mpi_checkpoint_pending_done();
 	// TODO free _args
 }
 
@@ -195,6 +196,7 @@ int _starpu_mpi_checkpoint_post_cp_discard_recv(starpu_mpi_checkpoint_template_t
 		_STARPU_MPI_MALLOC(arg, sizeof(struct _starpu_mpi_cp_discard_arg_cb));
 		arg->rank = cp_template->backup_of_array[i];
 		_STARPU_MPI_DEBUG(10, "Post DISCARD msg reception from %d\n", arg->rank);
+		_starpu_mpi_checkpoint_pending_add(1);
 
 		_starpu_mpi_ft_service_post_special_recv(_STARPU_MPI_TAG_CP_INFO);
 //		_ft_service_msg_irecv_cb(&arg->msg, sizeof(struct _starpu_mpi_cp_ack_msg), arg->rank, _STARPU_MPI_TAG_CP_INFO,
@@ -461,6 +463,7 @@ int _checkpoint_template_digest_ack_reception(int checkpoint_id, int checkpoint_
 	_STARPU_MPI_DEBUG(20, "Digesting ack recv: id=%d, inst=%d\n", checkpoint_id, checkpoint_instance);
 
 	tracker = _starpu_mpi_checkpoint_tracker_update(cp_template, checkpoint_id, cp_template->checkpoint_domain, checkpoint_instance);
+	_starpu_mpi_checkpoint_pending_done();
 	remaining_ack_messages = _starpu_mpi_checkpoint_check_tracker(tracker);
 
 	if (remaining_ack_messages>0)
@@ -471,25 +474,19 @@ int _checkpoint_template_digest_ack_reception(int checkpoint_id, int checkpoint_
 	else if (remaining_ack_messages==0)
 	{
 		_STARPU_MPI_DEBUG(0, "The CP (id:%d - inst:%d) has been successfully saved and acknowledged.\n", checkpoint_id, checkpoint_instance);
-		tracker = _starpu_mpi_checkpoint_tracker_validate_instance(tracker);
+		_STARPU_MPI_FT_STATS_CP_COMPLETED(starpu_timing_now() - tracker->start_time);
+		tracker1 = _starpu_mpi_checkpoint_tracker_validate_instance(tracker);
 		_STARPU_MPI_TRACE_CHECKPOINT_END(checkpoint_instance, cp_template->checkpoint_domain);
-		if (tracker==NULL)
+		if (tracker1==NULL)
 		{
 			// TODO:should warn some people, because the msg logging is not implemented(this precise nodes to contact)
 			_STARPU_MPI_DEBUG(0, "No previous checkpoint to discard\n");
 		}
-		else
-		{
-			if (tracker->old)
-			{
-				tracker1 = _starpu_mpi_checkpoint_tracker_get_last_valid_tracker(tracker->cp_domain);
-				_starpu_mpi_checkpoint_post_cp_discard_send(tracker->cp_template, tracker1->cp_id, tracker1->cp_inst);
-			}
-			else
-			{
-				_starpu_mpi_checkpoint_post_cp_discard_send(tracker->cp_template, checkpoint_id, checkpoint_instance);
-			}
-		}
+		/* The backups of this checkpoint post one discard reception per
+		 * submission, always send it, even if there is nothing to discard
+		 * yet, so that they know when they have received them all. */
+		tracker1 = _starpu_mpi_checkpoint_tracker_get_last_valid_tracker(tracker->cp_domain);
+		_starpu_mpi_checkpoint_post_cp_discard_send(cp_template, tracker1->cp_id, tracker1->cp_inst);
 	}
 	else if (remaining_ack_messages==-1)
 	{
@@ -69,6 +69,7 @@ LIST_TYPE(_starpu_mpi_checkpoint_template_item,
 	int              backupped_by;
 	int              backup_of;
 	starpu_mpi_tag_t tag;
+	unsigned long    checkpointed_nwrites; // Number of writes to the data when it was last checkpointed
 )
 
 struct _starpu_mpi_checkpoint_template
@@ -52,6 +52,7 @@ static inline void _starpu_mpi_checkpoint_domain_tracker_entry_init(struct _star
 	entry->tracker.cp_template = NULL;
 	entry->tracker.ack_msg_count = 0;
 	entry->tracker.first_msg_sent_flag = 0;
+	entry->tracker.start_time = 0.;
 	entry->tracker.valid = 0;
 	entry->tracker.old = 0;
 }
@@ -102,6 +103,7 @@ static inline struct _starpu_mpi_checkpoint_domain_tracker_entry* add_tracker_en
 	entry->tracker.cp_domain = cp_domain;
 	entry->tracker.cp_template = cp_template;
 	entry->tracker.ack_msg_count = cp_template->message_to_send_number;
+	entry->tracker.start_time = starpu_timing_now();
 	HASH_ADD_INT(index->tracked_inst_hash_table, instance, entry);
 	return entry;
 }
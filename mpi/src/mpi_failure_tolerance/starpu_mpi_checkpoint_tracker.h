@@ -30,6 +30,7 @@ struct _starpu_mpi_checkpoint_tracker
 	starpu_mpi_checkpoint_template_t cp_template;
 	int                              ack_msg_count;
 	int                              first_msg_sent_flag;
+	double                           start_time;
 	int                              old:1;
 	int                              valid: 1;
 };
@@ -22,11 +22,14 @@
 
 starpu_pthread_mutex_t           ft_mutex;
 int                              _my_rank;
+int                              _starpu_mpi_checkpoint_incremental;
 
 int starpu_mpi_checkpoint_init(void)
 {
 	STARPU_PTHREAD_MUTEX_INIT(&ft_mutex, NULL);
 	starpu_mpi_comm_rank(MPI_COMM_WORLD, &_my_rank); //TODO: check compatibility with several Comms behaviour
+	_starpu_mpi_checkpoint_incremental = starpu_getenv_number_default("STARPU_MPI_CHECKPOINT_INCREMENTAL", 0);
+	_starpu_mpi_checkpoint_pending_init();
 	starpu_mpi_ft_service_lib_init(_ack_msg_recv_cb, _cp_discard_message_recv_cb);
 	checkpoint_template_lib_init();
 	_starpu_mpi_checkpoint_tracker_init();
@@ -37,9 +40,11 @@ int starpu_mpi_checkpoint_init(void)
 
 int starpu_mpi_checkpoint_shutdown(void)
 {
+	_starpu_mpi_checkpoint_pending_wait();
 	checkpoint_template_lib_quit();
 	checkpoint_package_shutdown();
 	_starpu_mpi_checkpoint_tracker_shutdown();
+	_starpu_mpi_checkpoint_pending_shutdown();
 	STARPU_PTHREAD_MUTEX_DESTROY(&ft_mutex);
 	_STARPU_MPI_FT_STATS_WRITE_TO_FD(stderr);
 	_STARPU_MPI_FT_STATS_SHUTDOWN();
@@ -30,6 +30,16 @@ size_t cp_data_msgs_received_cached_total_size;
 int cp_data_msgs_received_cp_cached_count;
 size_t cp_data_msgs_received_cp_cached_total_size;
 
+int cp_data_msgs_sent_skipped_count;
+size_t cp_data_msgs_sent_skipped_total_size;
+int cp_data_msgs_received_skipped_count;
+size_t cp_data_msgs_received_skipped_total_size;
+
+double cp_data_stall_time_total;
+int cp_completed_count;
+double cp_completion_time_total;
+double cp_completion_time_max;
+
 int ft_service_msgs_sent_count;
 size_t ft_service_msgs_sent_total_size;
 int ft_service_msgs_received_count;
@@ -41,6 +41,16 @@ extern size_t cp_data_msgs_received_cached_total_size;
 extern int cp_data_msgs_received_cp_cached_count;
 extern size_t cp_data_msgs_received_cp_cached_total_size;
 
+extern int cp_data_msgs_sent_skipped_count;
+extern size_t cp_data_msgs_sent_skipped_total_size;
+extern int cp_data_msgs_received_skipped_count;
+extern size_t cp_data_msgs_received_skipped_total_size;
+
+extern double cp_data_stall_time_total;
+extern int cp_completed_count;
+extern double cp_completion_time_total;
+extern double cp_completion_time_max;
+
 extern int ft_service_msgs_sent_count;
 extern size_t ft_service_msgs_sent_total_size;
 extern int ft_service_msgs_received_count;
@@ -58,6 +68,10 @@ static inline void _starpu_ft_stats_send_data_cached(size_t size);;
 static inline void _starpu_ft_stats_recv_data(size_t size);
 static inline void _starpu_ft_stats_recv_data_cached(size_t size);
 static inline void _starpu_ft_stats_recv_data_cp_cached(size_t size);
+static inline void _starpu_ft_stats_send_data_skipped(size_t size);
+static inline void _starpu_ft_stats_recv_data_skipped(size_t size);
+static inline void _starpu_ft_stats_data_stall(double time);
+static inline void _starpu_ft_stats_cp_completed(double time);
 static inline void _starpu_ft_stats_service_msg_send(size_t size);
 static inline void _starpu_ft_stats_service_msg_recv(size_t size);
 static inline void _starpu_ft_stats_add_cp_data_in_memory(size_t size);
@@ -74,6 +88,10 @@ static inline void _starpu_ft_stats_free_cp_data_in_memory(size_t size);
 #define _STARPU_MPI_FT_STATS_CANCEL_RECV_CP_DATA(size) do{ _starpu_ft_stats_cancel_recv_data(size); }while(0)
 #define _STARPU_MPI_FT_STATS_RECV_CACHED_CP_DATA(size) do{ _starpu_ft_stats_recv_data_cached(size); }while(0)
 #define _STARPU_MPI_FT_STATS_RECV_CP_CACHED_CP_DATA(size) do{ _starpu_ft_stats_recv_data_cp_cached(size); }while(0)
+#define _STARPU_MPI_FT_STATS_SEND_SKIPPED_CP_DATA(size) do{ _starpu_ft_stats_send_data_skipped(size); }while(0)
+#define _STARPU_MPI_FT_STATS_RECV_SKIPPED_CP_DATA(size) do{ _starpu_ft_stats_recv_data_skipped(size); }while(0)
+#define _STARPU_MPI_FT_STATS_CP_DATA_STALL(time) do{ _starpu_ft_stats_data_stall(time); }while(0)
+#define _STARPU_MPI_FT_STATS_CP_COMPLETED(time) do{ _starpu_ft_stats_cp_completed(time); }while(0)
 #define _STARPU_MPI_FT_STATS_SEND_FT_SERVICE_MSG(size) do{ _starpu_ft_stats_service_msg_send(size); }while(0)
 #define _STARPU_MPI_FT_STATS_RECV_FT_SERVICE_MSG(size) do{ _starpu_ft_stats_service_msg_recv(size); }while(0)
 #define _STARPU_MPI_FT_STATS_STORE_CP_DATA(size) do{ _starpu_ft_stats_add_cp_data_in_memory(size); }while(0)
@@ -90,6 +108,10 @@ static inline void _starpu_ft_stats_free_cp_data_in_memory(size_t size);
 #define _STARPU_MPI_FT_STATS_CANCEL_RECV_CP_DATA(size) do{}while(0)
 #define _STARPU_MPI_FT_STATS_RECV_CACHED_CP_DATA(size) do{}while(0)
 #define _STARPU_MPI_FT_STATS_RECV_CP_CACHED_CP_DATA(size) do{}while(0)
+#define _STARPU_MPI_FT_STATS_SEND_SKIPPED_CP_DATA(size) do{}while(0)
+#define _STARPU_MPI_FT_STATS_RECV_SKIPPED_CP_DATA(size) do{}while(0)
+#define _STARPU_MPI_FT_STATS_CP_DATA_STALL(time) do{}while(0)
+#define _STARPU_MPI_FT_STATS_CP_COMPLETED(time) do{}while(0)
 #define _STARPU_MPI_FT_STATS_SEND_FT_SERVICE_MSG(size) do{}while(0)
 #define _STARPU_MPI_FT_STATS_RECV_FT_SERVICE_MSG(size) do{}while(0)
 #define _STARPU_MPI_FT_STATS_STORE_CP_DATA(size) do{}while(0)
@@ -117,6 +139,16 @@ static inline void stat_init()
 	cp_data_msgs_received_cp_cached_count = 0;
 	cp_data_msgs_received_cp_cached_total_size = 0;
 
+	cp_data_msgs_sent_skipped_count = 0;
+	cp_data_msgs_sent_skipped_total_size = 0;
+	cp_data_msgs_received_skipped_count = 0;
+	cp_data_msgs_received_skipped_total_size = 0;
+
+	cp_data_stall_time_total = 0.;
+	cp_completed_count = 0;
+	cp_completion_time_total = 0.;
+	cp_completion_time_max = 0.;
+
 	ft_service_msgs_sent_count = 0;
 	ft_service_msgs_sent_total_size = 0;
 	ft_service_msgs_received_count = 0;
@@ -189,6 +221,46 @@ static inline void _starpu_ft_stats_recv_data_cp_cached(size_t size)
 	STARPU_PTHREAD_MUTEX_UNLOCK(&_ft_stats_mutex);
 }
 
+static inline void _starpu_ft_stats_send_data_skipped(size_t size)
+{
+	STARPU_ASSERT_MSG((int)size != -1, "Cannot count a data of size -1. An error has occurred.\n");
+	STARPU_PTHREAD_MUTEX_LOCK(&_ft_stats_mutex);
+	cp_data_msgs_sent_skipped_count++;
+	cp_data_msgs_sent_skipped_total_size+=size;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_ft_stats_mutex);
+}
+
+static inline void _starpu_ft_stats_recv_data_skipped(size_t size)
+{
+	STARPU_ASSERT_MSG((int)size != -1, "Cannot count a data of size -1. An error has occurred.\n");
+	STARPU_PTHREAD_MUTEX_LOCK(&_ft_stats_mutex);
+	cp_data_msgs_received_skipped_count++;
+	cp_data_msgs_received_skipped_total_size+=size;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_ft_stats_mutex);
+}
+
+/* Time during which a data was held by its checkpoint send, i.e. during
+ * which the tasks writing to it had to wait for the checkpoint */
+static inline void _starpu_ft_stats_data_stall(double time)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&_ft_stats_mutex);
+	cp_data_stall_time_total+=time;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_ft_stats_mutex);
+}
+
+/* Time between the submission of a checkpoint and its last acknowledgement */
+static inline void _starpu_ft_stats_cp_completed(double time)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&_ft_stats_mutex);
+	cp_completed_count++;
+	cp_completion_time_total+=time;
+	if (time>cp_completion_time_max)
+	{
+		cp_completion_time_max = time;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_ft_stats_mutex);
+}
+
 static inline void _starpu_ft_stats_service_msg_send(size_t size)
 {
 	STARPU_ASSERT_MSG((int)size != -1, "Cannot count a data of size -1. An error has occurred.\n");
@@ -254,12 +326,17 @@ static inline void _ft_stats_free_cp_data_in_memory_list()
 static inline void _starpu_ft_stats_write_to_fd(FILE* fd)
 {
 	// HEADER
-	fprintf(fd, "TYPE\tCP_DATA_NORMAL_COUNT\tCP_DATA_NORMAL_TOTAL_SIZE\tCP_DATA_CACHED_COUNT\tCP_DATA_CACHED_SIZE\tFT_SERVICE_MSGS_COUNT\tFT_SERVICE_MSGS_TOTAL_SIZE\n");
+	fprintf(fd, "TYPE\tCP_DATA_NORMAL_COUNT\tCP_DATA_NORMAL_TOTAL_SIZE\tCP_DATA_CACHED_COUNT\tCP_DATA_CACHED_SIZE\tCP_DATA_SKIPPED_COUNT\tCP_DATA_SKIPPED_SIZE\tFT_SERVICE_MSGS_COUNT\tFT_SERVICE_MSGS_TOTAL_SIZE\n");
 	// DATA
-	fprintf(fd, "SEND\t%d\t"                 "%ld\t"                    "%d\t"               "%ld\t"               "%d\t"                 "%ld\n",
-	        cp_data_msgs_sent_count, cp_data_msgs_sent_total_size, cp_data_msgs_sent_cached_count, cp_data_msgs_sent_cached_total_size, ft_service_msgs_sent_count, ft_service_msgs_sent_total_size);
-	fprintf(fd, "RECV\t%d\t"                 "%ld\t"                    "%d\t"               "%ld\t"               "%d\t"                 "%ld\n",
-	        cp_data_msgs_received_count, cp_data_msgs_received_total_size, cp_data_msgs_received_cached_count, cp_data_msgs_received_cached_total_size+cp_data_msgs_received_cp_cached_total_size, ft_service_msgs_received_count, ft_service_msgs_received_total_size);
+	fprintf(fd, "SEND\t%d\t"                 "%ld\t"                    "%d\t"               "%ld\t"               "%d\t"                "%ld\t"                "%d\t"                 "%ld\n",
+	        cp_data_msgs_sent_count, cp_data_msgs_sent_total_size, cp_data_msgs_sent_cached_count, cp_data_msgs_sent_cached_total_size, cp_data_msgs_sent_skipped_count, cp_data_msgs_sent_skipped_total_size, ft_service_msgs_sent_count, ft_service_msgs_sent_total_size);
+	fprintf(fd, "RECV\t%d\t"                 "%ld\t"                    "%d\t"               "%ld\t"               "%d\t"                "%ld\t"                "%d\t"                 "%ld\n",
+	        cp_data_msgs_received_count, cp_data_msgs_received_total_size, cp_data_msgs_received_cached_count, cp_data_msgs_received_cached_total_size+cp_data_msgs_received_cp_cached_total_size, cp_data_msgs_received_skipped_count, cp_data_msgs_received_skipped_total_size, ft_service_msgs_received_count, ft_service_msgs_received_total_size);
+	fprintf(fd, "\n");
+	fprintf(fd, "CP_COMPLETED:%d\n", cp_completed_count);
+	fprintf(fd, "CP_COMPLETION_TIME_AVG_US:%.1f\n", cp_completed_count?cp_completion_time_total/cp_completed_count:0.);
+	fprintf(fd, "CP_COMPLETION_TIME_MAX_US:%.1f\n", cp_completion_time_max);
+	fprintf(fd, "CP_DATA_STALL_TIME_TOTAL_US:%.1f\n", cp_data_stall_time_total);
 	fprintf(fd, "\n");
 	fprintf(fd, "IN_MEM_CP_DATA_TOTAL:%lu\n", cp_data_in_memory_size_total);
 	fprintf(fd, "\n");
@@ -323,7 +323,7 @@ int starpu_mpi_issend_detached(starpu_data_handle_t data_handle, int dest, starp
 struct _starpu_mpi_req* _starpu_mpi_isend_cache_aware(starpu_data_handle_t data_handle, int dest, starpu_mpi_tag_t data_tag, MPI_Comm comm, unsigned detached, unsigned sync, int prio, void (*callback)(void *), void *_arg, int sequential_consistency, int* cache_flag)
 {
 	struct _starpu_mpi_req* req = NULL;
-	int already_sent = starpu_mpi_cached_send_set(data_handle, dest);
+	int already_sent = _starpu_mpi_cached_cp_send_set(data_handle, dest);
 	if (already_sent == 0)
 	{
 		*cache_flag = 0;
@@ -339,6 +339,7 @@ struct _starpu_mpi_req* _starpu_mpi_isend_cache_aware(starpu_data_handle_t data_
 		if (callback)
 			callback(_arg);
 	}
+	_starpu_mpi_cache_evict();
 	return req;
 }
 
@@ -461,6 +462,7 @@ struct _starpu_mpi_req* _starpu_mpi_irecv_cache_aware(starpu_data_handle_t data_
 		if (callback)
 			callback(_arg);
 	}
+	_starpu_mpi_cache_evict();
 	return req;
 }
 
@@ -489,6 +491,7 @@ void _starpu_mpi_data_clear(starpu_data_handle_t data_handle)
 	_starpu_spin_destroy(&data->coop_lock);
 	free(data->redux_map);
 	data->redux_map = NULL;
+	free(data->selection_cached);
 	free(data);
 }
 
@@ -563,7 +566,7 @@ char* starpu_mpi_data_get_redux_map(starpu_data_handle_t data)
 
 int starpu_mpi_get_data_on_node_detached(MPI_Comm comm, starpu_data_handle_t data_handle, int node, void (*callback)(void*), void *arg)
 {
-	int me, rank;
+	int me, rank, ret = 0;
 	starpu_mpi_tag_t data_tag;
 
 	rank = starpu_mpi_data_get_rank(data_handle);
@@ -589,7 +592,7 @@ int starpu_mpi_get_data_on_node_detached(MPI_Comm comm, starpu_data_handle_t dat
 		if (already_received == 0)
 		{
 			_STARPU_MPI_DEBUG(1, "Receiving data %p from %d\n", data_handle, rank);
-			return starpu_mpi_irecv_detached(data_handle, rank, data_tag, comm, callback, arg);
+			ret = starpu_mpi_irecv_detached(data_handle, rank, data_tag, comm, callback, arg);
 		}
 	}
 	else if (me == rank)
@@ -599,15 +602,16 @@ int starpu_mpi_get_data_on_node_detached(MPI_Comm comm, starpu_data_handle_t dat
 		if (already_sent == 0)
 		{
 			_STARPU_MPI_DEBUG(1, "Sending data %p to %d\n", data_handle, node);
-			return starpu_mpi_isend_detached(data_handle, node, data_tag, comm, NULL, NULL);
+			ret = starpu_mpi_isend_detached(data_handle, node, data_tag, comm, NULL, NULL);
 		}
 	}
-	return 0;
+	_starpu_mpi_cache_evict();
+	return ret;
 }
 
 int starpu_mpi_get_data_on_node(MPI_Comm comm, starpu_data_handle_t data_handle, int node)
 {
-	int me, rank;
+	int me, rank, ret = 0;
 	starpu_mpi_tag_t data_tag;
 
 	rank = starpu_mpi_data_get_rank(data_handle);
@@ -634,7 +638,7 @@ int starpu_mpi_get_data_on_node(MPI_Comm comm, starpu_data_handle_t data_handle,
 		if (already_received == 0)
 		{
 			_STARPU_MPI_DEBUG(1, "Receiving data %p from %d\n", data_handle, rank);
-			return starpu_mpi_recv(data_handle, rank, data_tag, comm, &status);
+			ret = starpu_mpi_recv(data_handle, rank, data_tag, comm, &status);
 		}
 	}
 	else if (me == rank)
@@ -644,10 +648,11 @@ int starpu_mpi_get_data_on_node(MPI_Comm comm, starpu_data_handle_t data_handle,
 		if (already_sent == 0)
 		{
 			_STARPU_MPI_DEBUG(1, "Sending data %p to %d\n", data_handle, node);
-			return starpu_mpi_send(data_handle, node, data_tag, comm);
+			ret = starpu_mpi_send(data_handle, node, data_tag, comm);
 		}
 	}
-	return 0;
+	_starpu_mpi_cache_evict();
+	return ret;
 }
 
 void starpu_mpi_get_data_on_all_nodes_detached(MPI_Comm comm, starpu_data_handle_t data_handle)
@@ -683,7 +688,11 @@ int starpu_mpi_wait_for_all(MPI_Comm comm)
 	/* If the user forgets to call mpi_redux_data or insert R tasks on the reduced handles */
 	/* then, we wrap reduction patterns for them. This is typical of benchmarks */
 	_starpu_mpi_redux_wrapup_data_all();
-	return _mpi_backend._starpu_mpi_backend_wait_for_all(comm);
+	int ret = _mpi_backend._starpu_mpi_backend_wait_for_all(comm);
+	/* All nodes reach this point after submitting the same tasks, they
+	 * can thus all forget the load of these tasks, which are now over */
+	_starpu_mpi_select_node_reset_load();
+	return ret;
 }
 
 int starpu_mpi_wait_for_all_in_ctx(MPI_Comm comm, unsigned sched_ctx)
@@ -16,11 +16,13 @@
 
 #include <starpu.h>
 #include <common/uthash.h>
+#include <common/list.h>
 #include <datawizard/coherency.h>
 
 #include <starpu_mpi_cache.h>
 #include <starpu_mpi_cache_stats.h>
 #include <starpu_mpi_private.h>
+#include <starpu_mpi_select_node.h>
 #include <mpi_failure_tolerance/starpu_mpi_ft_stats.h>
 
 /* Whether we are allowed to keep copies of remote data. */
@@ -30,11 +32,38 @@ struct _starpu_data_entry
 	starpu_data_handle_t data_handle;
 };
 
+/* When the size of the cache is bounded, the received copies of the data
+ * owned by each node are kept in the order of their last use, and so are the
+ * data sent to each node. Since the sender and the receiver of a data see the
+ * same sequence of uses of the data, they take the same eviction decisions,
+ * which keeps the send cache of the owner coherent with the receive cache of
+ * the other node without exchanging any message. */
+LIST_TYPE(_starpu_mpi_cache_lru_entry,
+	starpu_data_handle_t data_handle;
+	size_t size;
+	/** Owner of the data for a received copy, destination for a sent one */
+	int node;
+	/** The copy is used as a checkpoint backup, it must not be evicted */
+	unsigned pinned;
+);
+
+struct _starpu_mpi_cache_lru
+{
+	struct _starpu_mpi_cache_lru_entry_list list;
+	size_t size;
+};
+
 static starpu_pthread_mutex_t _cache_mutex;
 static struct _starpu_data_entry *_cache_data = NULL;
 int _starpu_cache_enabled=1;
 static MPI_Comm _starpu_cache_comm;
 static int _starpu_cache_comm_size;
+/* Maximum size of the copies received from each node, 0 when unbounded */
+static size_t _cache_lru_budget;
+/* Indexed by the owner of the data */
+static struct _starpu_mpi_cache_lru *_cache_lru_received;
+/* Indexed by the node the data were sent to */
+static struct _starpu_mpi_cache_lru *_cache_lru_sent;
 
 static void _starpu_mpi_cache_flush_nolock(starpu_data_handle_t data_handle);
 
@@ -69,6 +98,20 @@ void _starpu_mpi_cache_init(MPI_Comm comm)
 	{
 		_starpu_cache_enabled = 1;
 	}
+	_starpu_cache_enabled = !!_starpu_cache_enabled;
+
+	int cache_size = starpu_getenv_number_default("STARPU_MPI_CACHE_SIZE", 0);
+	starpu_mpi_comm_size(comm, &_starpu_cache_comm_size);
+	if (_starpu_cache_comm_size > 1)
+	{
+		/* Senders evict their cache entries without any message, which
+		 * is only coherent with the same settings on all nodes */
+		int values[4] = { _starpu_cache_enabled, -_starpu_cache_enabled, cache_size, -cache_size };
+		int ret = MPI_Allreduce(MPI_IN_PLACE, values, 4, MPI_INT, MPI_MAX, comm);
+		STARPU_MPI_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Allreduce returning %s", _starpu_mpi_get_mpi_error_code(ret));
+		STARPU_ASSERT_MSG(values[0] == -values[1], "STARPU_MPI_CACHE has to be the same on all nodes");
+		STARPU_ASSERT_MSG(values[2] == -values[3], "STARPU_MPI_CACHE_SIZE has to be the same on all nodes, it is set between %d and %d", -values[3], values[2]);
+	}
 
 	if (_starpu_cache_enabled == 0)
 	{
@@ -77,9 +120,28 @@ void _starpu_mpi_cache_init(MPI_Comm comm)
 	}
 
 	_starpu_cache_comm = comm;
-	starpu_mpi_comm_size(comm, &_starpu_cache_comm_size);
 	_starpu_mpi_cache_stats_init();
 	STARPU_PTHREAD_MUTEX_INIT(&_cache_mutex, NULL);
+
+	/* The budget is shared evenly between the other nodes, so that each
+	 * pair of nodes can apply it on its own */
+	_cache_lru_budget = (size_t) cache_size * 1024 * 1024;
+	if (_cache_lru_budget && _starpu_cache_comm_size > 1)
+	{
+		int i;
+		_cache_lru_budget /= _starpu_cache_comm_size - 1;
+		if (_cache_lru_budget == 0)
+			_cache_lru_budget = 1;
+		_STARPU_MPI_CALLOC(_cache_lru_received, _starpu_cache_comm_size, sizeof(_cache_lru_received[0]));
+		_STARPU_MPI_CALLOC(_cache_lru_sent, _starpu_cache_comm_size, sizeof(_cache_lru_sent[0]));
+		for (i = 0; i < _starpu_cache_comm_size; i++)
+		{
+			_starpu_mpi_cache_lru_entry_list_init(&_cache_lru_received[i].list);
+			_starpu_mpi_cache_lru_entry_list_init(&_cache_lru_sent[i].list);
+		}
+	}
+	else
+		_cache_lru_budget = 0;
 }
 
 void _starpu_mpi_cache_shutdown()
@@ -95,6 +157,32 @@ void _starpu_mpi_cache_shutdown()
 		HASH_DEL(_cache_data, entry);
 		free(entry);
 	}
+	if (_cache_lru_budget)
+	{
+		int i;
+		for (i = 0; i < _starpu_cache_comm_size; i++)
+		{
+			while (!_starpu_mpi_cache_lru_entry_list_empty(&_cache_lru_received[i].list))
+			{
+				struct _starpu_mpi_cache_lru_entry *lru_entry = _starpu_mpi_cache_lru_entry_list_pop_front(&_cache_lru_received[i].list);
+				struct _starpu_mpi_data *mpi_data = lru_entry->data_handle->mpi_data;
+				mpi_data->cache_received_lru = NULL;
+				_starpu_mpi_cache_lru_entry_delete(lru_entry);
+			}
+			while (!_starpu_mpi_cache_lru_entry_list_empty(&_cache_lru_sent[i].list))
+			{
+				struct _starpu_mpi_cache_lru_entry *lru_entry = _starpu_mpi_cache_lru_entry_list_pop_front(&_cache_lru_sent[i].list);
+				struct _starpu_mpi_data *mpi_data = lru_entry->data_handle->mpi_data;
+				mpi_data->cache_sent_lru[i] = NULL;
+				_starpu_mpi_cache_lru_entry_delete(lru_entry);
+			}
+		}
+		free(_cache_lru_received);
+		_cache_lru_received = NULL;
+		free(_cache_lru_sent);
+		_cache_lru_sent = NULL;
+		_cache_lru_budget = 0;
+	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
 	STARPU_PTHREAD_MUTEX_DESTROY(&_cache_mutex);
 	_starpu_mpi_cache_stats_shutdown();
@@ -119,6 +207,7 @@ void _starpu_mpi_cache_data_clear(starpu_data_handle_t data_handle)
 	}
 
 	free(mpi_data->cache_sent);
+	free(mpi_data->cache_sent_lru);
 }
 
 void _starpu_mpi_cache_data_init(starpu_data_handle_t data_handle)
@@ -138,9 +227,72 @@ void _starpu_mpi_cache_data_init(starpu_data_handle_t data_handle)
 	{
 		mpi_data->cache_sent[i] = 0;
 	}
+	if (_cache_lru_budget)
+		_STARPU_MPI_CALLOC(mpi_data->cache_sent_lru, _starpu_cache_comm_size, sizeof(mpi_data->cache_sent_lru[0]));
 	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
 }
 
+/* Note a use of the data in the given LRU list */
+static void _starpu_mpi_cache_lru_touch_nolock(struct _starpu_mpi_cache_lru *lru, struct _starpu_mpi_cache_lru_entry **lru_entry, starpu_data_handle_t data_handle, int node, unsigned pin)
+{
+	struct _starpu_mpi_cache_lru_entry *entry = *lru_entry;
+
+	if (entry == NULL)
+	{
+		entry = _starpu_mpi_cache_lru_entry_new();
+		entry->data_handle = data_handle;
+		entry->size = starpu_data_get_size(data_handle);
+		entry->node = node;
+		entry->pinned = 0;
+		lru->size += entry->size;
+		*lru_entry = entry;
+	}
+	else
+		_starpu_mpi_cache_lru_entry_list_erase(&lru->list, entry);
+	_starpu_mpi_cache_lru_entry_list_push_front(&lru->list, entry);
+	entry->pinned |= pin;
+}
+
+static void _starpu_mpi_cache_lru_remove_nolock(struct _starpu_mpi_cache_lru *lru, struct _starpu_mpi_cache_lru_entry **lru_entry)
+{
+	struct _starpu_mpi_cache_lru_entry *entry = *lru_entry;
+
+	if (entry == NULL)
+		return;
+	_starpu_mpi_cache_lru_entry_list_erase(&lru->list, entry);
+	lru->size -= entry->size;
+	_starpu_mpi_cache_lru_entry_delete(entry);
+	*lru_entry = NULL;
+}
+
+static void _starpu_mpi_cache_received_lru_touch_nolock(starpu_data_handle_t data_handle, int mpi_rank, unsigned pin)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+	if (_cache_lru_budget && mpi_rank >= 0)
+		_starpu_mpi_cache_lru_touch_nolock(&_cache_lru_received[mpi_rank], &mpi_data->cache_received_lru, data_handle, mpi_rank, pin);
+}
+
+static void _starpu_mpi_cache_received_lru_remove_nolock(starpu_data_handle_t data_handle)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+	if (_cache_lru_budget && mpi_data->cache_received_lru)
+		_starpu_mpi_cache_lru_remove_nolock(&_cache_lru_received[mpi_data->cache_received_lru->node], &mpi_data->cache_received_lru);
+}
+
+static void _starpu_mpi_cache_sent_lru_touch_nolock(starpu_data_handle_t data_handle, int dest, unsigned pin)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+	if (_cache_lru_budget)
+		_starpu_mpi_cache_lru_touch_nolock(&_cache_lru_sent[dest], &mpi_data->cache_sent_lru[dest], data_handle, dest, pin);
+}
+
+static void _starpu_mpi_cache_sent_lru_remove_nolock(starpu_data_handle_t data_handle, int dest)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+	if (_cache_lru_budget)
+		_starpu_mpi_cache_lru_remove_nolock(&_cache_lru_sent[dest], &mpi_data->cache_sent_lru[dest]);
+}
+
 static void _starpu_mpi_cache_data_add_nolock(starpu_data_handle_t data_handle)
 {
 	struct _starpu_data_entry *entry;
@@ -172,6 +324,83 @@ static void _starpu_mpi_cache_data_remove_nolock(starpu_data_handle_t data_handl
 	}
 }
 
+/* Remove the data from the table of cached data if it has no cached state
+ * left */
+static void _starpu_mpi_cache_data_release_nolock(starpu_data_handle_t data_handle)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+	int i;
+
+	if (mpi_data->cache_received)
+		return;
+	for (i = 0; i < _starpu_cache_comm_size; i++)
+		if (mpi_data->cache_sent[i])
+			return;
+	_starpu_mpi_cache_data_remove_nolock(data_handle);
+}
+
+/* Evict the least recently used copies beyond the budget of each list. The
+ * last used one is always kept, and the invalidation of the received copies is
+ * submitted after the tasks already submitted, so this has to be called once
+ * the tasks which use the cache have been submitted. */
+void _starpu_mpi_cache_evict(void)
+{
+	int node;
+
+	if (_starpu_cache_enabled == 0 || _cache_lru_budget == 0)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&_cache_mutex);
+	for (node = 0; node < _starpu_cache_comm_size; node++)
+	{
+		struct _starpu_mpi_cache_lru *lru = &_cache_lru_received[node];
+		struct _starpu_mpi_cache_lru_entry *entry, *prev;
+
+		for (entry = _starpu_mpi_cache_lru_entry_list_last(&lru->list);
+		     lru->size > _cache_lru_budget && entry != _starpu_mpi_cache_lru_entry_list_front(&lru->list);
+		     entry = prev)
+		{
+			starpu_data_handle_t data_handle = entry->data_handle;
+			struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+
+			prev = _starpu_mpi_cache_lru_entry_list_prev(entry);
+			if (entry->pinned)
+				continue;
+
+			_STARPU_MPI_DEBUG(2, "Evicting received copy of data %p from the cache\n", data_handle);
+			_starpu_mpi_cache_stats_evicted(data_handle);
+			_starpu_mpi_cache_stats_dec(node, data_handle);
+			_starpu_mpi_cache_lru_remove_nolock(lru, &mpi_data->cache_received_lru);
+			mpi_data->cache_received = 0;
+			mpi_data->ft_induced_cache_received = 0;
+			mpi_data->ft_induced_cache_received_count = 0;
+			starpu_data_invalidate_submit(data_handle);
+			_starpu_mpi_cache_data_release_nolock(data_handle);
+		}
+
+		lru = &_cache_lru_sent[node];
+		for (entry = _starpu_mpi_cache_lru_entry_list_last(&lru->list);
+		     lru->size > _cache_lru_budget && entry != _starpu_mpi_cache_lru_entry_list_front(&lru->list);
+		     entry = prev)
+		{
+			starpu_data_handle_t data_handle = entry->data_handle;
+			struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+
+			prev = _starpu_mpi_cache_lru_entry_list_prev(entry);
+			if (entry->pinned)
+				continue;
+
+			/* The destination evicts its copy at the same time */
+			_STARPU_MPI_DEBUG(2, "Forgetting that data %p was sent to %d\n", data_handle, node);
+			_starpu_mpi_cache_stats_dec(node, data_handle);
+			_starpu_mpi_cache_lru_remove_nolock(lru, &mpi_data->cache_sent_lru[node]);
+			mpi_data->cache_sent[node] = 0;
+			_starpu_mpi_cache_data_release_nolock(data_handle);
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
+}
+
 /**************************************
  * Received cache
  **************************************/
@@ -197,6 +426,7 @@ void starpu_mpi_cached_receive_clear(starpu_data_handle_t data_handle)
 		mpi_data->ft_induced_cache_received = 0;
 		mpi_data->ft_induced_cache_received_count = 0;
 		starpu_data_invalidate_submit(data_handle);
+		_starpu_mpi_cache_received_lru_remove_nolock(data_handle);
 		_starpu_mpi_cache_data_remove_nolock(data_handle);
 		_starpu_mpi_cache_stats_dec(mpi_rank, data_handle);
 	}
@@ -217,6 +447,8 @@ int starpu_mpi_cached_receive_set(starpu_data_handle_t data_handle)
 	STARPU_MPI_ASSERT_MSG(mpi_rank < _starpu_cache_comm_size, "Node %d invalid. Max node is %d\n", mpi_rank, _starpu_cache_comm_size);
 
 	int already_received = mpi_data->cache_received;
+	_starpu_mpi_cache_stats_received(already_received);
+	_starpu_mpi_cache_received_lru_touch_nolock(data_handle, mpi_rank, 0);
 	if (already_received == 0)
 	{
 		_STARPU_MPI_DEBUG(2, "Noting that data %p has already been received by %d\n", data_handle, mpi_rank);
@@ -253,6 +485,8 @@ int starpu_mpi_cached_cp_receive_set(starpu_data_handle_t data_handle)
 	STARPU_MPI_ASSERT_MSG(mpi_rank < _starpu_cache_comm_size, "Node %d invalid. Max node is %d\n", mpi_rank, _starpu_cache_comm_size);
 
 	int already_received = mpi_data->cache_received;
+	/* The copy is now a checkpoint backup */
+	_starpu_mpi_cache_received_lru_touch_nolock(data_handle, mpi_rank, 1);
 	if (already_received == 0)
 	{
 		_STARPU_MPI_DEBUG(2, "Noting that data %p has already been received by %d\n", data_handle, mpi_rank);
@@ -312,13 +546,14 @@ void starpu_mpi_cached_send_clear(starpu_data_handle_t data_handle)
 		{
 			_STARPU_MPI_DEBUG(2, "Clearing send cache for data %p\n", data_handle);
 			mpi_data->cache_sent[n] = 0;
+			_starpu_mpi_cache_sent_lru_remove_nolock(data_handle, n);
 			_starpu_mpi_cache_data_remove_nolock(data_handle);
 		}
 	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
 }
 
-int starpu_mpi_cached_send_set(starpu_data_handle_t data_handle, int dest)
+static int _starpu_mpi_cached_send_set(starpu_data_handle_t data_handle, int dest, unsigned checkpoint)
 {
 	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
 
@@ -329,6 +564,8 @@ int starpu_mpi_cached_send_set(starpu_data_handle_t data_handle, int dest)
 
 	STARPU_PTHREAD_MUTEX_LOCK(&_cache_mutex);
 	int already_sent = mpi_data->cache_sent[dest];
+	/* The destination makes the same decisions for its copy */
+	_starpu_mpi_cache_sent_lru_touch_nolock(data_handle, dest, checkpoint);
 	if (mpi_data->cache_sent[dest] == 0)
 	{
 		mpi_data->cache_sent[dest] = 1;
@@ -343,6 +580,16 @@ int starpu_mpi_cached_send_set(starpu_data_handle_t data_handle, int dest)
 	return already_sent;
 }
 
+int starpu_mpi_cached_send_set(starpu_data_handle_t data_handle, int dest)
+{
+	return _starpu_mpi_cached_send_set(data_handle, dest, 0);
+}
+
+int _starpu_mpi_cached_cp_send_set(starpu_data_handle_t data_handle, int dest)
+{
+	return _starpu_mpi_cached_send_set(data_handle, dest, 1);
+}
+
 int starpu_mpi_cached_send(starpu_data_handle_t data_handle, int dest)
 {
 	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
@@ -373,6 +620,7 @@ static void _starpu_mpi_cache_flush_nolock(starpu_data_handle_t data_handle)
 		{
 			_STARPU_MPI_DEBUG(2, "Clearing send cache for data %p\n", data_handle);
 			mpi_data->cache_sent[i] = 0;
+			_starpu_mpi_cache_sent_lru_remove_nolock(data_handle, i);
 			_starpu_mpi_cache_stats_dec(i, data_handle);
 		}
 	}
@@ -384,6 +632,7 @@ static void _starpu_mpi_cache_flush_nolock(starpu_data_handle_t data_handle)
 		mpi_data->cache_received = 0;
 		mpi_data->ft_induced_cache_received = 0;
 		mpi_data->ft_induced_cache_received_count = 0;
+		_starpu_mpi_cache_received_lru_remove_nolock(data_handle);
 		_starpu_mpi_cache_stats_dec(mpi_rank, data_handle);
 	}
 }
@@ -404,6 +653,7 @@ static void _starpu_mpi_cache_flush_and_invalidate_nolock(MPI_Comm comm, starpu_
 void starpu_mpi_cache_flush(MPI_Comm comm, starpu_data_handle_t data_handle)
 {
 	_starpu_mpi_data_flush(data_handle);
+	_starpu_mpi_select_node_data_flush(data_handle);
 
 	if (_starpu_cache_enabled == 0)
 		return;
@@ -418,6 +668,8 @@ void starpu_mpi_cache_flush_all_data(MPI_Comm comm)
 {
 	struct _starpu_data_entry *entry=NULL, *tmp=NULL;
 
+	_starpu_mpi_select_node_flush_all();
+
 	if (_starpu_cache_enabled == 0)
 		return;
 
@@ -34,6 +34,15 @@ void _starpu_mpi_cache_shutdown();
 void _starpu_mpi_cache_data_init(starpu_data_handle_t data_handle);
 void _starpu_mpi_cache_data_clear(starpu_data_handle_t data_handle);
 
+/** Note that the data is sent to \p dest as a checkpoint backup, which must
+ * stay in the cache */
+int _starpu_mpi_cached_cp_send_set(starpu_data_handle_t data_handle, int dest);
+
+/** When the size of the cache is bounded with STARPU_MPI_CACHE_SIZE, evict
+ * the least recently used cached copies which exceed it. This has to be called
+ * after submitting the tasks which use the cache. */
+void _starpu_mpi_cache_evict(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,10 @@
 #include <starpu_mpi_private.h>
 
 static int stats_enabled=0;
+static unsigned long nhits;
+static unsigned long nmisses;
+static unsigned long nevictions;
+static size_t evicted_size;
 
 void _starpu_mpi_cache_stats_init()
 {
@@ -39,6 +43,32 @@ void _starpu_mpi_cache_stats_shutdown()
 {
 	if (stats_enabled == 0)
 		return;
+
+	_STARPU_MPI_MSG("[communication cache] received data: %lu hits, %lu misses, %lu evictions (%ld bytes)\n", nhits, nmisses, nevictions, (long)evicted_size);
+	nhits = 0;
+	nmisses = 0;
+	nevictions = 0;
+	evicted_size = 0;
+}
+
+void _starpu_mpi_cache_stats_received(int hit)
+{
+	if (stats_enabled == 0)
+		return;
+
+	if (hit)
+		nhits++;
+	else
+		nmisses++;
+}
+
+void _starpu_mpi_cache_stats_evicted(starpu_data_handle_t data_handle)
+{
+	if (stats_enabled == 0)
+		return;
+
+	nevictions++;
+	evicted_size += starpu_data_get_size(data_handle);
 }
 
 void _starpu_mpi_cache_stats_update(unsigned dst, starpu_data_handle_t data_handle, int count)
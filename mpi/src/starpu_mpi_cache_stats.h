@@ -36,6 +36,11 @@ void _starpu_mpi_cache_stats_update(unsigned dst, starpu_data_handle_t data_hand
 #define _starpu_mpi_cache_stats_inc(dst, data_handle) _starpu_mpi_cache_stats_update(dst, data_handle, +1)
 #define _starpu_mpi_cache_stats_dec(dst, data_handle) _starpu_mpi_cache_stats_update(dst, data_handle, -1)
 
+/** Account a lookup of a received copy in the cache */
+void _starpu_mpi_cache_stats_received(int hit);
+/** Account the eviction of a received copy from the cache */
+void _starpu_mpi_cache_stats_evicted(starpu_data_handle_t data_handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -222,6 +222,54 @@ static int handle_to_datatype_ndim(starpu_data_handle_t data_handle, unsigned no
 	return 0;
 }
 
+/*
+ * 	SELL
+ */
+
+static int handle_to_datatype_sell(starpu_data_handle_t data_handle, unsigned node, MPI_Datatype *datatype)
+{
+	struct starpu_sell_interface *sell_interface = starpu_data_get_interface_on_node(data_handle, node);
+
+	uint32_t nnz = STARPU_SELL_GET_NNZ(sell_interface);
+	uint32_t nrow = STARPU_SELL_GET_NROW(sell_interface);
+	uint32_t nslices = STARPU_SELL_GET_NSLICES(sell_interface);
+	size_t elemsize = STARPU_SELL_GET_ELEMSIZE(sell_interface);
+
+	/* The arrays are separately allocated, the blocks are given in the
+	 * order of the packed data, relatively to sliceptr which is what
+	 * the to_pointer method returns */
+	void *addrs[4] = { STARPU_SELL_GET_SLICEPTR(sell_interface), STARPU_SELL_GET_ROWIND(sell_interface), STARPU_SELL_GET_COLIND(sell_interface), (void *) STARPU_SELL_GET_NZVAL(sell_interface) };
+	size_t sizes[4] = { (nslices+1)*sizeof(uint32_t), nrow*sizeof(uint32_t), nnz*sizeof(uint32_t), nnz*elemsize };
+	int block_lengths[4];
+	MPI_Aint displacements[4];
+	MPI_Datatype block_types[4];
+	MPI_Aint base;
+	int block_count = 0;
+	int i, ret;
+
+	MPI_Get_address(addrs[0], &base);
+	for (i = 0; i < 4; i++)
+	{
+		if (!sizes[i])
+			continue;
+		STARPU_ASSERT_MSG(sizes[i] <= INT_MAX, "MPI Datatype creation failed, the SELL matrix is too large");
+		MPI_Get_address(addrs[i], &displacements[block_count]);
+		displacements[block_count] -= base;
+		block_lengths[block_count] = sizes[i];
+		block_types[block_count] = MPI_BYTE;
+		block_count++;
+	}
+
+	_STARPU_MPI_DEBUG(1200, "creating datatype for sell using MPI_Type_create_struct with %d blocks\n", block_count);
+	ret = MPI_Type_create_struct(block_count, block_lengths, displacements, block_types, datatype);
+	STARPU_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Type_create_struct failed");
+
+	ret = MPI_Type_commit(datatype);
+	STARPU_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Type_commit failed");
+
+	return 0;
+}
+
 /*
  * 	Vector
  */
@@ -305,6 +353,7 @@ static starpu_mpi_datatype_node_allocate_func_t handle_to_datatype_funcs[STARPU_
 	[STARPU_VECTOR_INTERFACE_ID]	= handle_to_datatype_vector,
 	[STARPU_CSR_INTERFACE_ID]	= NULL, /* Sent through pack/unpack operations */
 	[STARPU_BCSR_INTERFACE_ID]	= NULL, /* Sent through pack/unpack operations */
+	[STARPU_SELL_INTERFACE_ID]	= handle_to_datatype_sell,
 	[STARPU_VARIABLE_INTERFACE_ID]	= handle_to_datatype_variable,
 	[STARPU_VOID_INTERFACE_ID]	= handle_to_datatype_void,
 	[STARPU_MULTIFORMAT_INTERFACE_ID] = NULL,
@@ -414,6 +463,7 @@ static starpu_mpi_datatype_free_func_t handle_free_datatype_funcs[STARPU_MAX_INT
 	[STARPU_NDIM_INTERFACE_ID]	= _starpu_mpi_handle_free_simple_datatype,
 	[STARPU_CSR_INTERFACE_ID]	= NULL,  /* Sent through pack/unpack operations */
 	[STARPU_BCSR_INTERFACE_ID]	= NULL,  /* Sent through pack/unpack operations */
+	[STARPU_SELL_INTERFACE_ID]	= _starpu_mpi_handle_free_simple_datatype,
 	[STARPU_VARIABLE_INTERFACE_ID]	= _starpu_mpi_handle_free_simple_datatype,
 	[STARPU_VOID_INTERFACE_ID]      = _starpu_mpi_handle_free_simple_datatype,
 	[STARPU_MULTIFORMAT_INTERFACE_ID] = NULL,
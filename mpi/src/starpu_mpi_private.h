@@ -212,6 +212,8 @@ struct _starpu_mpi_coop_sends
 	long pre_sync_jobid;
 };
 
+struct _starpu_mpi_cache_lru_entry;
+
 /** Initialized in starpu_mpi_data_register_comm */
 struct _starpu_mpi_data
 {
@@ -219,9 +221,18 @@ struct _starpu_mpi_data
 	struct _starpu_mpi_node_tag node_tag;
 	char *cache_sent;
 	unsigned int cache_received;
+	/** Entries of the data in the LRU lists of the cache, when its size is
+	  * bounded: for the received copy, and for each node it was sent to */
+	struct _starpu_mpi_cache_lru_entry *cache_received_lru;
+	struct _starpu_mpi_cache_lru_entry **cache_sent_lru;
 	unsigned int ft_induced_cache_received:1;
 	unsigned int ft_induced_cache_received_count:1;
 	unsigned int modified:1; // Whether the data has been modified since the registration.
+	/** Number of tasks writing to the data, including reductions, which
+	  * have been submitted so far with starpu_mpi_task_insert() and
+	  * similar functions. This is computed from the sequence of submitted
+	  * tasks only, so that it is the same on all nodes. */
+	unsigned long nwrites;
 
 	/** Array used to store the contributing nodes to this data
 	  * when it is accessed in (MPI_)REDUX mode. */
@@ -235,6 +246,14 @@ struct _starpu_mpi_data
 
 	/** When provided, wait the given number of sends to start a coop, instead of just waiting that data are ready */
 	unsigned nb_future_sends;
+
+	/** Nodes which are expected to have a cached copy of the data, as
+	  * seen by the ::STARPU_MPI_NODE_SELECTION_MIN_COST policy. This is
+	  * computed from the sequence of submitted tasks only, so that it is
+	  * the same on all nodes. */
+	char *selection_cached;
+	/** Flush epoch at which selection_cached was last updated */
+	unsigned selection_cached_epoch;
 };
 
 struct _starpu_mpi_data *_starpu_mpi_data_get(starpu_data_handle_t data_handle);
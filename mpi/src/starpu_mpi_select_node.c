@@ -25,18 +25,84 @@
 #include <datawizard/coherency.h>
 
 static int _current_policy = STARPU_MPI_NODE_SELECTION_MOST_R_DATA;
-static int _last_predefined_policy = STARPU_MPI_NODE_SELECTION_MOST_R_DATA;
+static int _last_predefined_policy = STARPU_MPI_NODE_SELECTION_MIN_COST;
 static starpu_mpi_select_node_policy_func_t _policies[_STARPU_MPI_NODE_SELECTION_MAX_POLICY];
 
 int _starpu_mpi_select_node_with_most_data(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data);
+int _starpu_mpi_select_node_with_min_cost(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data);
 
-void _starpu_mpi_select_node_init()
+/* Network performance used by STARPU_MPI_NODE_SELECTION_MIN_COST */
+static double _network_latency;		/* µs */
+static double _network_bandwidth;	/* MB/s, i.e. bytes per µs */
+
+/* Execution speed of a worker used by STARPU_MPI_NODE_SELECTION_MIN_COST */
+static double _worker_gflops;
+/* Execution time on a worker of the tasks which do not provide their flops (µs) */
+static double _task_length;
+
+/* Number of workers of each node of the communicator given at initialization,
+ * exchanged so that all nodes take the same decisions */
+static int *_node_nworkers;
+static int _node_nworkers_size;
+
+/* Predicted execution time of the tasks assigned to each node (µs) */
+static starpu_pthread_mutex_t _cost_mutex;
+static double *_node_load;
+static int _node_load_size;
+/* Incremented by starpu_mpi_cache_flush_all_data() to forget all cached copies */
+static unsigned _flush_epoch;
+
+/* Check that the value of \p name is the same on all nodes, as the nodes would
+ * otherwise select different nodes for the same task */
+static void _starpu_mpi_select_node_check_same(MPI_Comm comm, const char *name, double value)
 {
-	int i;
+	double values[2] = { value, -value };
+
+	MPI_Allreduce(MPI_IN_PLACE, values, 2, MPI_DOUBLE, MPI_MAX, comm);
+	STARPU_ASSERT_MSG(values[0] == value && -values[1] == value, "%s has to be the same on all nodes (%f here, between %f and %f)", name, value, -values[1], values[0]);
+}
+
+void _starpu_mpi_select_node_init(MPI_Comm comm)
+{
+	int i, nworkers;
 
 	_policies[STARPU_MPI_NODE_SELECTION_MOST_R_DATA] = _starpu_mpi_select_node_with_most_data;
+	_policies[STARPU_MPI_NODE_SELECTION_MIN_COST] = _starpu_mpi_select_node_with_min_cost;
 	for(i=_last_predefined_policy+1 ; i<_STARPU_MPI_NODE_SELECTION_MAX_POLICY ; i++)
 		_policies[i] = NULL;
+
+	_network_latency = starpu_getenv_float_default("STARPU_MPI_NETWORK_LATENCY", 2.);
+	_network_bandwidth = starpu_getenv_float_default("STARPU_MPI_NETWORK_BANDWIDTH", 10000.);
+	_worker_gflops = starpu_getenv_float_default("STARPU_MPI_WORKER_GFLOPS", 10.);
+	_task_length = starpu_getenv_float_default("STARPU_MPI_TASK_LENGTH", 100.);
+	STARPU_ASSERT_MSG(_network_latency >= 0. && _network_bandwidth > 0., "STARPU_MPI_NETWORK_LATENCY must be positive and STARPU_MPI_NETWORK_BANDWIDTH strictly positive");
+	STARPU_ASSERT_MSG(_worker_gflops > 0., "STARPU_MPI_WORKER_GFLOPS must be strictly positive");
+	STARPU_ASSERT_MSG(_task_length >= 0., "STARPU_MPI_TASK_LENGTH must be positive");
+	_starpu_mpi_select_node_check_same(comm, "STARPU_MPI_NETWORK_LATENCY", _network_latency);
+	_starpu_mpi_select_node_check_same(comm, "STARPU_MPI_NETWORK_BANDWIDTH", _network_bandwidth);
+	_starpu_mpi_select_node_check_same(comm, "STARPU_MPI_WORKER_GFLOPS", _worker_gflops);
+	_starpu_mpi_select_node_check_same(comm, "STARPU_MPI_TASK_LENGTH", _task_length);
+
+	MPI_Comm_size(comm, &_node_nworkers_size);
+	_STARPU_MPI_MALLOC(_node_nworkers, _node_nworkers_size * sizeof(int));
+	nworkers = starpu_worker_get_count();
+	MPI_Allgather(&nworkers, 1, MPI_INT, _node_nworkers, 1, MPI_INT, comm);
+
+	STARPU_PTHREAD_MUTEX_INIT(&_cost_mutex, NULL);
+	_node_load = NULL;
+	_node_load_size = 0;
+	_flush_epoch = 1;
+}
+
+void _starpu_mpi_select_node_shutdown()
+{
+	free(_node_nworkers);
+	_node_nworkers = NULL;
+	_node_nworkers_size = 0;
+	free(_node_load);
+	_node_load = NULL;
+	_node_load_size = 0;
+	STARPU_PTHREAD_MUTEX_DESTROY(&_cost_mutex);
 }
 
 int starpu_mpi_node_selection_get_current_policy()
@@ -116,6 +182,183 @@ int _starpu_mpi_select_node_with_most_data(int me, int nb_nodes, struct starpu_d
 	return xrank;
 }
 
+/* Whether node is expected to have data, either as owner or in its cache */
+static int _starpu_mpi_data_is_on_node(struct _starpu_mpi_data *mpi_data, int node)
+{
+	if (mpi_data->node_tag.node.rank == node)
+		return 1;
+	return mpi_data->selection_cached
+		&& mpi_data->selection_cached_epoch == _flush_epoch
+		&& mpi_data->selection_cached[node];
+}
+
+static double _starpu_mpi_transfer_cost(size_t size)
+{
+	return _network_latency + size / _network_bandwidth;
+}
+
+/* Must be called with _cost_mutex held */
+static void _starpu_mpi_node_load_resize(int nb_nodes)
+{
+	if (nb_nodes <= _node_load_size)
+		return;
+	_STARPU_MPI_REALLOC(_node_load, nb_nodes * sizeof(*_node_load));
+	memset(&_node_load[_node_load_size], 0, (nb_nodes - _node_load_size) * sizeof(*_node_load));
+	_node_load_size = nb_nodes;
+}
+
+int _starpu_mpi_select_node_with_min_cost(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data)
+{
+	double min_load, best_cost = 0.;
+	int i, node, xrank = 0;
+
+	(void)me;
+	STARPU_PTHREAD_MUTEX_LOCK(&_cost_mutex);
+	_starpu_mpi_node_load_resize(nb_nodes);
+
+	min_load = _node_load[0];
+	for (node = 1; node < nb_nodes; node++)
+		if (_node_load[node] < min_load)
+			min_load = _node_load[node];
+
+	for (node = 0; node < nb_nodes; node++)
+	{
+		/* The execution time of the task itself is the same on all
+		 * nodes, only the work already assigned to them differs */
+		double cost = _node_load[node] - min_load;
+
+		for (i = 0; i < nb_data; i++)
+		{
+			starpu_data_handle_t data = descr[i].handle;
+			enum starpu_data_access_mode mode = descr[i].mode;
+			struct _starpu_mpi_data *mpi_data = _starpu_mpi_data_get(data);
+			int rank = mpi_data->node_tag.node.rank;
+			size_t size = data->ops->get_size(data);
+
+			if (rank == STARPU_MPI_PER_NODE || rank == -1)
+				/* Each of them has it, or nobody does */
+				continue;
+
+			if ((mode & STARPU_R) && !_starpu_mpi_data_is_on_node(mpi_data, node))
+				cost += _starpu_mpi_transfer_cost(size);
+
+			if ((mode & STARPU_W) && rank != node)
+				/* Would have to transfer it back */
+				cost += _starpu_mpi_transfer_cost(size);
+		}
+
+		if (node == 0 || cost < best_cost)
+		{
+			best_cost = cost;
+			xrank = node;
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cost_mutex);
+
+	return xrank;
+}
+
+/* Predicted time for \p node to execute a task of \p flops with all its
+ * workers. This only depends on values which are the same on all nodes. */
+static double _starpu_mpi_expected_length(int node, int nb_nodes, double flops)
+{
+	int nworkers = 1;
+	double length;
+
+	if (flops > 0.)
+		/* GFlop/s are flop/ns, i.e. 1000 flop/µs */
+		length = flops / (_worker_gflops * 1000.);
+	else
+		/* We do not know, at least count the task */
+		length = _task_length;
+
+	if (nb_nodes == _node_nworkers_size && _node_nworkers[node] > 0)
+		/* Otherwise this is another communicator, whose ranks we
+		 * cannot map, consider the nodes are all the same */
+		nworkers = _node_nworkers[node];
+
+	return length / nworkers;
+}
+
+void _starpu_mpi_select_node_account(int policy, int xrank, int nb_nodes, struct starpu_data_descr *descr, int nb_data, double flops)
+{
+	int i, node;
+
+	if (policy == STARPU_MPI_NODE_SELECTION_CURRENT_POLICY)
+		policy = _current_policy;
+	if (policy != STARPU_MPI_NODE_SELECTION_MIN_COST || xrank < 0)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&_cost_mutex);
+	_starpu_mpi_node_load_resize(nb_nodes);
+
+	if (xrank == STARPU_MPI_PER_NODE)
+	{
+		for (node = 0; node < nb_nodes; node++)
+			_node_load[node] += _starpu_mpi_expected_length(node, nb_nodes, flops);
+	}
+	else
+	{
+		STARPU_ASSERT(xrank < nb_nodes);
+		_node_load[xrank] += _starpu_mpi_expected_length(xrank, nb_nodes, flops);
+	}
+
+	if (starpu_mpi_cache_is_enabled() && xrank != STARPU_MPI_PER_NODE)
+	{
+		for (i = 0; i < nb_data; i++)
+		{
+			enum starpu_data_access_mode mode = descr[i].mode;
+			if (!descr[i].handle)
+				continue;
+			struct _starpu_mpi_data *mpi_data = _starpu_mpi_data_get(descr[i].handle);
+			int rank = mpi_data->node_tag.node.rank;
+
+			if (rank == STARPU_MPI_PER_NODE || rank == -1)
+				continue;
+
+			int size;
+			starpu_mpi_comm_size(mpi_data->node_tag.node.comm, &size);
+			if (!mpi_data->selection_cached)
+				_STARPU_MPI_CALLOC(mpi_data->selection_cached, size, sizeof(char));
+			if (mpi_data->selection_cached_epoch != _flush_epoch || (mode & (STARPU_W|STARPU_REDUX)))
+			{
+				/* The data was flushed or modified, only its owner has it */
+				memset(mpi_data->selection_cached, 0, size);
+				mpi_data->selection_cached_epoch = _flush_epoch;
+			}
+			if ((mode & STARPU_R) && !(mode & (STARPU_W|STARPU_REDUX)) && xrank != rank)
+				mpi_data->selection_cached[xrank] = 1;
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cost_mutex);
+}
+
+void _starpu_mpi_select_node_data_flush(starpu_data_handle_t data_handle)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+
+	if (!mpi_data)
+		return;
+	STARPU_PTHREAD_MUTEX_LOCK(&_cost_mutex);
+	mpi_data->selection_cached_epoch = 0;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cost_mutex);
+}
+
+void _starpu_mpi_select_node_reset_load(void)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&_cost_mutex);
+	if (_node_load)
+		memset(_node_load, 0, _node_load_size * sizeof(*_node_load));
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cost_mutex);
+}
+
+void _starpu_mpi_select_node_flush_all(void)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&_cost_mutex);
+	_flush_epoch++;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cost_mutex);
+}
+
 int _starpu_mpi_select_node(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data, int policy)
 {
 	int ppolicy = policy == STARPU_MPI_NODE_SELECTION_CURRENT_POLICY ? _current_policy : policy;
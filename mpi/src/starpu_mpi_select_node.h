@@ -28,9 +28,22 @@ extern "C"
 
 #define _STARPU_MPI_NODE_SELECTION_MAX_POLICY 24
 
-void _starpu_mpi_select_node_init();
+/** Initialize the node selection, collectively over \p comm */
+void _starpu_mpi_select_node_init(MPI_Comm comm);
+void _starpu_mpi_select_node_shutdown();
 int _starpu_mpi_select_node(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data, int policy);
 
+/** Record that the task of \p flops accessing \p descr is executed on
+ * \p xrank, when the node selection \p policy of the task is
+ * ::STARPU_MPI_NODE_SELECTION_MIN_COST */
+void _starpu_mpi_select_node_account(int policy, int xrank, int nb_nodes, struct starpu_data_descr *descr, int nb_data, double flops);
+/** Forget the load of the nodes, once all the tasks have completed */
+void _starpu_mpi_select_node_reset_load(void);
+/** Forget the cached copies of \p data_handle */
+void _starpu_mpi_select_node_data_flush(starpu_data_handle_t data_handle);
+/** Forget the cached copies of all data */
+void _starpu_mpi_select_node_flush_all(void);
+
 #ifdef __cplusplus
 }
 #endif
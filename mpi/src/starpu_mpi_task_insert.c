@@ -42,6 +42,8 @@
 	} while (0)
 
 static void (*pre_submit_hook)(struct starpu_task *task) = NULL;
+static void (*lb_submitting_hook)(struct starpu_task *task) = NULL;
+static void (*lb_inserted_hook)(void) = NULL;
 
 /* reduction wrap-up */
 // entry in the table
@@ -73,6 +75,24 @@ int starpu_mpi_pre_submit_hook_unregister()
 	return 0;
 }
 
+void _starpu_mpi_lb_hooks_register(void (*submitting)(struct starpu_task *task), void (*inserted)(void))
+{
+	lb_submitting_hook = submitting;
+	lb_inserted_hook = inserted;
+}
+
+void _starpu_mpi_lb_submitting_hook_call(struct starpu_task *task)
+{
+	if (lb_submitting_hook)
+		lb_submitting_hook(task);
+}
+
+void _starpu_mpi_lb_inserted_hook_call(void)
+{
+	if (lb_inserted_hook)
+		lb_inserted_hook();
+}
+
 int _starpu_mpi_find_executee_node(starpu_data_handle_t data, enum starpu_data_access_mode mode, int me, int *do_execute, int *inconsistent_execute, int *xrank)
 {
 	if (mode & STARPU_W || mode & STARPU_REDUX)
@@ -179,6 +199,14 @@ int _starpu_mpi_exchange_data_before_execution(starpu_data_handle_t data, enum s
 static
 int _starpu_mpi_exchange_data_after_execution(starpu_data_handle_t data, enum starpu_data_access_mode mode, int me, int xrank, int do_execute, int prio, MPI_Comm comm)
 {
+	if (mode & STARPU_REDUX || mode & STARPU_MPI_REDUX)
+	{
+		/* All the nodes take part in reductions, they thus all count
+		 * the write, which lands when the reduction is wrapped up */
+		struct _starpu_mpi_data *mpi_data = _starpu_mpi_data_get(data);
+		if (mpi_data)
+			mpi_data->nwrites++;
+	}
 	if (mode & STARPU_W && !(mode & STARPU_MPI_REDUX))
 	{
 		int mpi_rank = starpu_mpi_data_get_rank(data);
@@ -189,6 +217,7 @@ int _starpu_mpi_exchange_data_after_execution(starpu_data_handle_t data, enum st
 			_STARPU_ERROR("StarPU needs to be told the MPI rank of this data, using starpu_mpi_data_register\n");
 		}
 		mpi_data->modified=1;
+		mpi_data->nwrites++;
 		if (mpi_rank == STARPU_MPI_PER_NODE)
 		{
 			mpi_rank = me;
@@ -246,8 +275,84 @@ void _starpu_mpi_clear_data_after_execution(starpu_data_handle_t data, enum star
 	}
 }
 
+/* Whether the node \p me takes part in the task, i.e. it executes it, it owns
+ * some of its data, or it has to take part in a reduction. Otherwise the node
+ * only has to drop its cached copies of the data written by the task, see
+ * _starpu_mpi_task_skip_data(). This only looks at the owners of the data, so
+ * that the nodes which are not involved in a task spend as little time as
+ * possible on it. */
 static
-int _starpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nodes, int *xrank, int *do_execute, struct starpu_data_descr **descrs_p, int *nb_data_p, int *prio_p, va_list varg_list)
+int _starpu_mpi_task_involves(int me, int xrank, struct starpu_data_descr *descrs, int nb_data)
+{
+	int i;
+
+	if (xrank == me || xrank == STARPU_MPI_PER_NODE)
+		return 1;
+
+	for(i=0 ; i<nb_data ; i++)
+	{
+		starpu_data_handle_t data = descrs[i].handle;
+		enum starpu_data_access_mode mode = descrs[i].mode;
+		struct _starpu_mpi_data *mpi_data;
+
+		if (!data)
+			continue;
+		if (mode & STARPU_REDUX || mode & STARPU_MPI_REDUX)
+			return 1;
+		mpi_data = data->mpi_data;
+		/* Let the complete path report unregistered data */
+		if (!mpi_data || mpi_data->node_tag.node.rank == -1)
+			return 1;
+		if (mpi_data->node_tag.node.rank == me || mpi_data->node_tag.node.rank == STARPU_MPI_PER_NODE)
+			return 1;
+		if (mode & STARPU_R && mpi_data->redux_map)
+			/* The pending reduction has to be wrapped up by all nodes */
+			return 1;
+	}
+	return 0;
+}
+
+/* What remains to be done for a task by a node which is not involved in it */
+static
+void _starpu_mpi_task_skip_data(struct starpu_data_descr *descrs, int nb_data)
+{
+	int i;
+
+	for(i=0 ; i<nb_data ; i++)
+	{
+		if (descrs[i].handle && descrs[i].mode & STARPU_W)
+		{
+			struct _starpu_mpi_data *mpi_data = descrs[i].handle->mpi_data;
+			mpi_data->modified = 1;
+			mpi_data->nwrites++;
+			/* Another node modifies the data, drop our copy if we
+			 * received it. We do not own it, so we never sent it. */
+			starpu_mpi_cached_receive_clear(descrs[i].handle);
+		}
+	}
+}
+
+static
+void _starpu_mpi_task_exchange_before(MPI_Comm comm, int me, int xrank, int do_execute, struct starpu_data_descr *descrs, int nb_data, int prio)
+{
+	int i;
+
+	for(i=0 ; i<nb_data ; i++)
+	{
+		if (descrs[i].handle && descrs[i].handle->mpi_data)
+		{
+			char *redux_map = starpu_mpi_data_get_redux_map(descrs[i].handle);
+			if (redux_map != NULL && descrs[i].mode & STARPU_R && descrs[i].mode & ~ STARPU_REDUX && descrs[i].mode & ~ STARPU_MPI_REDUX)
+			{
+				_starpu_mpi_redux_wrapup_data(descrs[i].handle);
+			}
+		}
+		_starpu_mpi_exchange_data_before_execution(descrs[i].handle, descrs[i].mode, me, xrank, do_execute, prio, comm);
+	}
+}
+
+static
+int _starpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nodes, int *xrank, int *do_execute, struct starpu_data_descr **descrs_p, int *nb_data_p, int *prio_p, double *flops_p, int *select_node_policy_p, va_list varg_list)
 {
 	/* XXX: _fstarpu_mpi_task_decode_v needs to be updated at the same time */
 	va_list varg_list_copy;
@@ -258,6 +363,7 @@ int _starpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nod
 	struct starpu_data_descr *descrs;
 	int nb_data;
 	int prio = 0;
+	double flops = 0.;
 	int select_node_policy = STARPU_MPI_NODE_SELECTION_CURRENT_POLICY;
 
 	_STARPU_TRACE_TASK_MPI_DECODE_START();
@@ -463,7 +569,7 @@ int _starpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nod
 		}
 		else if (arg_type==STARPU_FLOPS)
 		{
-			(void)va_arg(varg_list_copy, double);
+			flops = va_arg(varg_list_copy, double);
 		}
 		else if (arg_type==STARPU_SCHED_CTX)
 		{
@@ -632,6 +738,10 @@ int _starpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nod
 	*descrs_p = descrs;
 	*nb_data_p = nb_data;
 	*prio_p = prio;
+	if (flops_p)
+		*flops_p = flops;
+	if (select_node_policy_p)
+		*select_node_policy_p = select_node_policy;
 
 	_STARPU_TRACE_TASK_MPI_DECODE_END();
 	return 0;
@@ -642,10 +752,11 @@ int _starpu_mpi_task_build_v(MPI_Comm comm, struct starpu_codelet *codelet, stru
 {
 	int me, do_execute, xrank, nb_nodes;
 	int ret;
-	int i;
 	struct starpu_data_descr *descrs = NULL;
 	int nb_data;
 	int prio;
+	double flops;
+	int select_node_policy;
 
 	_STARPU_MPI_LOG_IN();
 
@@ -653,24 +764,15 @@ int _starpu_mpi_task_build_v(MPI_Comm comm, struct starpu_codelet *codelet, stru
 	starpu_mpi_comm_size(comm, &nb_nodes);
 
 	/* Find out whether we are to execute the data because we own the data to be written to. */
-	ret = _starpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, varg_list);
+	ret = _starpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, &flops, &select_node_policy, varg_list);
 	if (ret < 0)
 		return ret;
+	_starpu_mpi_select_node_account(select_node_policy, xrank, nb_nodes, descrs, nb_data, flops);
 
 	_STARPU_TRACE_TASK_MPI_PRE_START();
 	/* Send and receive data as requested */
-	for(i=0 ; i<nb_data ; i++)
-	{
-                if (descrs[i].handle && descrs[i].handle->mpi_data)
-		{
-			char *redux_map = starpu_mpi_data_get_redux_map(descrs[i].handle);
-			if (redux_map != NULL && descrs[i].mode & STARPU_R && descrs[i].mode & ~ STARPU_REDUX && descrs[i].mode & ~ STARPU_MPI_REDUX)
-			{
-				_starpu_mpi_redux_wrapup_data(descrs[i].handle);
-			}
-		}
-		_starpu_mpi_exchange_data_before_execution(descrs[i].handle, descrs[i].mode, me, xrank, do_execute, prio, comm);
-	}
+	if (_starpu_mpi_task_involves(me, xrank, descrs, nb_data))
+		_starpu_mpi_task_exchange_before(comm, me, xrank, do_execute, descrs, nb_data, prio);
 
 	if (xrank_p)
 		*xrank_p = xrank;
@@ -733,6 +835,12 @@ int _starpu_mpi_task_postbuild_v(MPI_Comm comm, int xrank, int do_execute, struc
 	_STARPU_TRACE_TASK_MPI_POST_START();
 	starpu_mpi_comm_rank(comm, &me);
 
+	if (!do_execute && !_starpu_mpi_task_involves(me, xrank, descrs, nb_data))
+	{
+		_starpu_mpi_task_skip_data(descrs, nb_data);
+		goto out;
+	}
+
 	for(i=0 ; i<nb_data ; i++)
 	{
 		if ((descrs[i].mode & STARPU_REDUX || descrs[i].mode & STARPU_MPI_REDUX) && descrs[i].handle)
@@ -773,7 +881,10 @@ int _starpu_mpi_task_postbuild_v(MPI_Comm comm, int xrank, int do_execute, struc
 		_starpu_mpi_exchange_data_after_execution(descrs[i].handle, descrs[i].mode, me, xrank, do_execute, prio, comm);
 		_starpu_mpi_clear_data_after_execution(descrs[i].handle, descrs[i].mode, me, do_execute);
 	}
+	/* The task has been submitted, the copies it uses can be evicted */
+	_starpu_mpi_cache_evict();
 
+out:
 	_STARPU_TRACE_TASK_MPI_POST_END();
 	_STARPU_MPI_LOG_OUT();
 	return 0;
@@ -797,6 +908,7 @@ int _starpu_mpi_task_insert_v(MPI_Comm comm, struct starpu_codelet *codelet, va_
 	if (ret == 1)
 	{
 		do_execute = 1;
+		_starpu_mpi_lb_submitting_hook_call(task);
 		ret = starpu_task_submit(task);
 
 		if (STARPU_UNLIKELY(ret == -ENODEV))
@@ -810,6 +922,8 @@ int _starpu_mpi_task_insert_v(MPI_Comm comm, struct starpu_codelet *codelet, va_
 			task->destroy = 0;
 			starpu_task_destroy(task);
 			free(descrs);
+			/* The other nodes do count this insertion */
+			_starpu_mpi_lb_inserted_hook_call();
 			return -ENODEV;
 		}
 	}
@@ -819,6 +933,7 @@ int _starpu_mpi_task_insert_v(MPI_Comm comm, struct starpu_codelet *codelet, va_
 
 	if (ret == 1)
 		_starpu_mpi_pre_submit_hook_call(task);
+	_starpu_mpi_lb_inserted_hook_call();
 
 	return val;
 }
@@ -883,7 +998,7 @@ int starpu_mpi_task_post_build(MPI_Comm comm, struct starpu_codelet *codelet, ..
 
 	va_start(varg_list, codelet);
 	/* Find out whether we are to execute the data because we own the data to be written to. */
-	ret = _starpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, varg_list);
+	ret = _starpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, NULL, NULL, varg_list);
 	va_end(varg_list);
 	if (ret < 0)
 		return ret;
@@ -905,7 +1020,7 @@ int starpu_mpi_task_post_build_v(MPI_Comm comm, struct starpu_codelet *codelet,
 	starpu_mpi_comm_size(comm, &nb_nodes);
 
 	/* Find out whether we are to execute the data because we own the data to be written to. */
-	ret = _starpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, varg_list);
+	ret = _starpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, NULL, NULL, varg_list);
 	if (ret < 0)
 		return ret;
 
@@ -914,6 +1029,92 @@ int starpu_mpi_task_post_build_v(MPI_Comm comm, struct starpu_codelet *codelet,
 	return ret;
 }
 
+int starpu_mpi_task_insert_prepared_submit(MPI_Comm comm, struct starpu_task_insert_prepared *prepared, starpu_data_handle_t *handles, void **values)
+{
+	struct starpu_data_descr descrs_static[STARPU_NMAXBUFS];
+	struct starpu_data_descr *descrs = descrs_static;
+	struct starpu_task *task = NULL;
+	int nb_data = prepared->nbuffers;
+	int prio = prepared->priority;
+	int me, nb_nodes, xrank = -1, do_execute = -1, inconsistent_execute = 0;
+	int i, ret = 0;
+
+	starpu_mpi_comm_rank(comm, &me);
+	starpu_mpi_comm_size(comm, &nb_nodes);
+
+	if (nb_data > STARPU_NMAXBUFS)
+		_STARPU_MPI_MALLOC(descrs, nb_data * sizeof(descrs[0]));
+
+	/* The modes are already known, only look at the owners of the data */
+	_STARPU_TRACE_TASK_MPI_DECODE_START();
+	for(i=0 ; i<nb_data ; i++)
+	{
+		descrs[i].handle = handles[i];
+		descrs[i].mode = prepared->modes[i];
+		STARPU_ASSERT_MSG(!(descrs[i].mode & STARPU_MPI_REDUX), "STARPU_MPI_REDUX is not supported by starpu_mpi_task_insert_prepared_submit()");
+		ret = _starpu_mpi_find_executee_node(handles[i], descrs[i].mode, me, &do_execute, &inconsistent_execute, &xrank);
+		if (ret == -EINVAL)
+		{
+			_STARPU_TRACE_TASK_MPI_DECODE_END();
+			goto out;
+		}
+	}
+	if (inconsistent_execute == 1 || xrank == -1)
+		xrank = _starpu_mpi_select_node(me, nb_nodes, descrs, nb_data, STARPU_MPI_NODE_SELECTION_CURRENT_POLICY);
+	do_execute = xrank == STARPU_MPI_PER_NODE || me == xrank;
+	_STARPU_TRACE_TASK_MPI_DECODE_END();
+	_starpu_mpi_select_node_account(STARPU_MPI_NODE_SELECTION_CURRENT_POLICY, xrank, nb_nodes, descrs, nb_data, prepared->flops);
+
+	if (!_starpu_mpi_task_involves(me, xrank, descrs, nb_data))
+	{
+		/* Neither the task nor its data are for us */
+		_starpu_mpi_task_skip_data(descrs, nb_data);
+		_starpu_mpi_lb_inserted_hook_call();
+		goto out;
+	}
+
+	_STARPU_TRACE_TASK_MPI_PRE_START();
+	_starpu_mpi_task_exchange_before(comm, me, xrank, do_execute, descrs, nb_data, prio);
+	if (do_execute)
+	{
+		task = starpu_task_insert_prepared_build(prepared, handles, values);
+		if (task->sched_ctx == STARPU_NMAX_SCHED_CTXS)
+			/* we suppose the current context is not going to change between now and the execution of the task */
+			task->sched_ctx = _starpu_sched_ctx_get_current_context();
+	}
+	_STARPU_TRACE_TASK_MPI_PRE_END();
+
+	if (do_execute)
+	{
+		_starpu_mpi_lb_submitting_hook_call(task);
+		ret = starpu_task_submit(task);
+		if (STARPU_UNLIKELY(ret == -ENODEV))
+		{
+			_STARPU_MSG("submission of task %p with codelet %p failed (symbol `%s') (err: ENODEV)\n",
+				    task, task->cl,
+				    task->cl->name ? task->cl->name :
+				    (task->cl->model && task->cl->model->symbol)?task->cl->model->symbol:"none");
+
+			task->destroy = 0;
+			starpu_task_destroy(task);
+			/* The other nodes do count this insertion */
+			_starpu_mpi_lb_inserted_hook_call();
+			goto out;
+		}
+	}
+
+	ret = _starpu_mpi_task_postbuild_v(comm, xrank, do_execute, descrs, nb_data, prio);
+
+	if (do_execute)
+		_starpu_mpi_pre_submit_hook_call(task);
+	_starpu_mpi_lb_inserted_hook_call();
+
+out:
+	if (descrs != descrs_static)
+		free(descrs);
+	return ret;
+}
+
 int starpu_mpi_task_exchange_data_before_execution(MPI_Comm comm, struct starpu_task *task, struct starpu_data_descr *descrs, struct starpu_mpi_task_exchange_params *params)
 {
 	int me, nb_nodes, inconsistent_execute;
@@ -952,6 +1153,7 @@ int starpu_mpi_task_exchange_data_before_execution(MPI_Comm comm, struct starpu_
 		_STARPU_MPI_DEBUG(100, "Inconsistent=%d - xrank=%d\n", inconsistent_execute, params->xrank);
 		params->do_execute = (params->xrank == STARPU_MPI_PER_NODE) || (me == params->xrank);
 	}
+	_starpu_mpi_select_node_account(select_node_policy, params->xrank, nb_nodes, descrs, nb_data, task->flops);
 
 	for(i=0 ; i<nb_data ; i++)
 	{
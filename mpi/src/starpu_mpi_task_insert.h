@@ -31,6 +31,15 @@ void _starpu_mpi_redux_wrapup_data_all();
 void _starpu_mpi_redux_wrapup_data(starpu_data_handle_t data_handle);
 void _starpu_mpi_pre_submit_hook_call(struct starpu_task *task);
 
+/** Register the hooks of the load balancer: \p submitting is called with the
+ * tasks executed by the local node right before they get submitted, and \p
+ * inserted is called on all nodes each time a task has been inserted, so that
+ * all of them can perform collective operations at the same point of the task
+ * flow. */
+void _starpu_mpi_lb_hooks_register(void (*submitting)(struct starpu_task *task), void (*inserted)(void));
+void _starpu_mpi_lb_submitting_hook_call(struct starpu_task *task);
+void _starpu_mpi_lb_inserted_hook_call(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,7 +27,7 @@
 
 #ifdef HAVE_MPI_COMM_F2C
 static
-int _fstarpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nodes, int *xrank, int *do_execute, struct starpu_data_descr **descrs_p, int *nb_data_p, int *prio_p, void **arglist)
+int _fstarpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_nodes, int *xrank, int *do_execute, struct starpu_data_descr **descrs_p, int *nb_data_p, int *prio_p, double *flops_p, int *select_node_policy_p, void **arglist)
 {
 	int arg_i = 0;
 	int inconsistent_execute = 0;
@@ -36,6 +36,7 @@ int _fstarpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_no
 	struct starpu_data_descr *descrs;
 	int nb_data;
 	int prio = 0;
+	double flops = 0.;
 	int select_node_policy = STARPU_MPI_NODE_SELECTION_CURRENT_POLICY;
 
 	_STARPU_TRACE_TASK_MPI_DECODE_START();
@@ -270,7 +271,7 @@ int _fstarpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_no
 		else if (arg_type==STARPU_FLOPS)
 		{
 			arg_i++;
-			/* double* */
+			flops = *(double *)arglist[arg_i];
 		}
 		else if (arg_type==STARPU_SCHED_CTX)
 		{
@@ -463,6 +464,10 @@ int _fstarpu_mpi_task_decode_v(struct starpu_codelet *codelet, int me, int nb_no
 	*descrs_p = descrs;
 	*nb_data_p = nb_data;
 	*prio_p = prio;
+	if (flops_p)
+		*flops_p = flops;
+	if (select_node_policy_p)
+		*select_node_policy_p = select_node_policy;
 
 	_STARPU_TRACE_TASK_MPI_DECODE_END();
 	return 0;
@@ -477,6 +482,8 @@ int _fstarpu_mpi_task_build_v(MPI_Comm comm, struct starpu_codelet *codelet, str
 	struct starpu_data_descr *descrs;
 	int nb_data;
 	int prio;
+	double flops;
+	int select_node_policy;
 
 	_STARPU_MPI_LOG_IN();
 
@@ -484,9 +491,10 @@ int _fstarpu_mpi_task_build_v(MPI_Comm comm, struct starpu_codelet *codelet, str
 	starpu_mpi_comm_size(comm, &nb_nodes);
 
 	/* Find out whether we are to execute the data because we own the data to be written to. */
-	ret = _fstarpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, arglist);
+	ret = _fstarpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, &flops, &select_node_policy, arglist);
 	if (ret < 0)
 		return ret;
+	_starpu_mpi_select_node_account(select_node_policy, xrank, nb_nodes, descrs, nb_data, flops);
 
 	_STARPU_TRACE_TASK_MPI_PRE_START();
 	/* Send and receive data as requested */
@@ -572,6 +580,7 @@ int _fstarpu_mpi_task_insert_v(MPI_Comm comm, struct starpu_codelet *codelet, vo
 	if (ret == 1)
 	{
 		do_execute = 1;
+		_starpu_mpi_lb_submitting_hook_call(task);
 		ret = starpu_task_submit(task);
 
 		if (STARPU_UNLIKELY(ret == -ENODEV))
@@ -585,6 +594,8 @@ int _fstarpu_mpi_task_insert_v(MPI_Comm comm, struct starpu_codelet *codelet, vo
 			task->destroy = 0;
 			starpu_task_destroy(task);
 			free(descrs);
+			/* The other nodes do count this insertion */
+			_starpu_mpi_lb_inserted_hook_call();
 			return -ENODEV;
 		}
 	}
@@ -594,6 +605,7 @@ int _fstarpu_mpi_task_insert_v(MPI_Comm comm, struct starpu_codelet *codelet, vo
 
 	if (ret == 1)
 		_starpu_mpi_pre_submit_hook_call(task);
+	_starpu_mpi_lb_inserted_hook_call();
 
 	return val;
 }
@@ -647,7 +659,7 @@ void fstarpu_mpi_task_post_build(void **arglist)
 	starpu_mpi_comm_size(MPI_Comm_f2c(comm), &nb_nodes);
 
 	/* Find out whether we are to execute the data because we own the data to be written to. */
-	ret = _fstarpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, arglist+2);
+	ret = _fstarpu_mpi_task_decode_v(codelet, me, nb_nodes, &xrank, &do_execute, &descrs, &nb_data, &prio, NULL, NULL, arglist+2);
 	STARPU_ASSERT(ret >= 0);
 
 	ret = _starpu_mpi_task_postbuild_v(MPI_Comm_f2c(comm), xrank, do_execute, descrs, nb_data, prio);
@@ -100,37 +100,16 @@ int pseudotest_checkpoint_template_register(int argc, char* argv[])
 	return 0;
 }
 
-int test_checkpoint_submit(int argc, char* argv[])
+int test_checkpoint_submit(void)
 {
-	int ret;
 	starpu_data_handle_t handle0, handle1;
 	starpu_mpi_checkpoint_template_t cp_template;
 	int val0 = 0;
 	int val1 = 0;
 	int stage = 10;
-	struct starpu_conf conf;
-	int mpi_init;
-
-	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
-
-	FPRINTF(stderr, "Go\n");
-
-	starpu_conf_init(&conf);
-	starpu_conf_noworker(&conf);
-	conf.ncpus = -1;
-	conf.nmpi_ms = -1;
-	conf.ntcpip_ms = -1;
-
-	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, &conf);
-	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
-
-	starpu_mpi_comm_size(MPI_COMM_WORLD, &nb_nodes);
-	starpu_mpi_comm_rank(MPI_COMM_WORLD, &me);
 
 	stage+=me;
 
-	FPRINTF_MPI(stderr, "Init ok - my rnk %d - size %d\n", me, nb_nodes);
-
 	starpu_variable_data_register(&handle0, STARPU_MAIN_RAM, (uintptr_t)&val0, sizeof(int));
 	starpu_mpi_data_register(handle0, 100, 0);
 
@@ -183,22 +162,137 @@ int test_checkpoint_submit(int argc, char* argv[])
 
 	FPRINTF_MPI(stderr, "Submitted\n");
 
-	sleep(2);
-	fprintf(stderr, "\n\n");
 	starpu_mpi_wait_for_all(MPI_COMM_WORLD);
-	FPRINTF_MPI(stderr, "Bye!\n");
+	starpu_mpi_barrier(MPI_COMM_WORLD);
 
-	starpu_mpi_shutdown();
+	starpu_data_unregister(handle0);
+	starpu_data_unregister(handle1);
 
-	if (!mpi_init)
-		MPI_Finalize();
+	return 0;
+}
+
+#define NTILES 8
+#define NITER 6
+
+void increment_cpu(void *descr[], void *_args)
+{
+	(void)_args;
+	int *val = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	(*val)++;
+}
+
+struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "increment"
+};
+
+/*
+ * Checkpoint tiles of which only a subset is modified between two
+ * checkpoints, so that incremental checkpoints only save the modified ones,
+ * while the computation goes on during the checkpoint transfers.
+ */
+int test_incremental_checkpoint(void)
+{
+	starpu_data_handle_t handles[NTILES];
+	starpu_mpi_checkpoint_template_t cp_template;
+	int tiles[NTILES];
+	int expected[NTILES];
+	int i, iter, ret;
+
+	starpu_mpi_checkpoint_template_create(&cp_template, 654, 0);
+	for (i=0 ; i<NTILES ; i++)
+	{
+		tiles[i] = i;
+		expected[i] = i;
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&tiles[i], sizeof(int));
+		starpu_mpi_data_register(handles[i], 1000+i, i%nb_nodes);
+		starpu_mpi_checkpoint_template_add_entry(&cp_template, STARPU_R, handles[i], (i+1)%nb_nodes);
+	}
+	starpu_mpi_checkpoint_template_freeze(&cp_template);
+
+	for (iter=0 ; iter<NITER ; iter++)
+	{
+		/* Only update the tiles whose index is a multiple of the iteration number */
+		for (i=0 ; i<NTILES ; i++)
+		{
+			if (i % (iter+1))
+				continue;
+			ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &increment_cl, STARPU_RW, handles[i], 0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+			expected[i]++;
+		}
+		/* Let the checkpoint transfers overlap with the next iteration */
+		ret = starpu_mpi_checkpoint_template_submit(cp_template, STARPU_MIN_PRIO);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_checkpoint_template_submit");
+	}
+
+	starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+	starpu_mpi_barrier(MPI_COMM_WORLD);
+
+	for (i=0 ; i<NTILES ; i++)
+	{
+		if (starpu_mpi_data_get_rank(handles[i]) == me)
+		{
+			starpu_data_acquire(handles[i], STARPU_R);
+			STARPU_ASSERT_MSG(tiles[i] == expected[i], "tile %d is %d instead of %d\n", i, tiles[i], expected[i]);
+			starpu_data_release(handles[i]);
+		}
+		starpu_data_unregister(handles[i]);
+	}
 
 	return 0;
 }
 
 int main(int argc, char* argv[])
 {
+	int ret;
+	struct starpu_conf conf;
+	int mpi_init;
+
+	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
+
+	FPRINTF(stderr, "Go\n");
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, &conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &nb_nodes);
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &me);
+
+	if (nb_nodes < 2 || starpu_cpu_worker_get_count() == 0)
+	{
+		if (me == 0)
+			FPRINTF(stderr, "We need at least 2 processes and 1 CPU worker.\n");
+		starpu_mpi_shutdown();
+		if (!mpi_init)
+			MPI_Finalize();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	FPRINTF_MPI(stderr, "Init ok - my rnk %d - size %d\n", me, nb_nodes);
+
+	starpu_mpi_checkpoint_init();
+
 	//pseudotest_checkpoint_template_register(argc, argv);
-	test_checkpoint_submit(argc, argv);
+	test_checkpoint_submit();
+	test_incremental_checkpoint();
+
+	FPRINTF_MPI(stderr, "Bye!\n");
+
+	starpu_mpi_checkpoint_shutdown();
+	starpu_mpi_shutdown();
+
+	if (!mpi_init)
+		MPI_Finalize();
+
 	return 0;
 }
@@ -0,0 +1,157 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Broadcast a non-contiguous matrix with cooperative sends cut into small
+ * segments, so that they are pipelined through a tree of the recipients with
+ * the MPI backend. The recipients receive it in different ways: with a
+ * detached receive, with a blocking receive, or after the data has arrived
+ * (node 2 first waits for another data which is sent once the matrix has been
+ * completely sent).
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define NX 300
+#define NY 200
+#define LD (NX+17)
+#define NITER 3
+
+int main(int argc, char **argv)
+{
+	int ret, rank, size, iter, n;
+	unsigned x, y;
+	int mpi_init;
+	float *matrix;
+	int var;
+	starpu_data_handle_t matrix_handle, var_handle;
+	struct starpu_conf conf;
+
+	setenv("STARPU_MPI_COOP_SEGMENT_SIZE", "4096", 1);
+	setenv("STARPU_MPI_COOP_TREE_ARITY", "2", 1);
+
+	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, &conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (size < 3)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 3 processes.\n");
+		starpu_mpi_shutdown();
+		if (!mpi_init)
+			MPI_Finalize();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	matrix = malloc(LD * NY * sizeof(float));
+	starpu_matrix_data_register(&matrix_handle, STARPU_MAIN_RAM, (uintptr_t) matrix, LD, NX, NY, sizeof(float));
+	starpu_variable_data_register(&var_handle, STARPU_MAIN_RAM, (uintptr_t) &var, sizeof(var));
+
+	for (iter = 0; iter < NITER; iter++)
+	{
+		for (y = 0; y < NY; y++)
+			for (x = 0; x < LD; x++)
+				matrix[y*LD + x] = rank == 0 ? iter * 1000.f + y * NX + x : -1.f;
+		var = rank == 0 ? iter : -1;
+
+		if (rank == 0)
+		{
+			starpu_mpi_coop_sends_data_handle_nb_sends(matrix_handle, size-1);
+			for (n = 1; n < size; n++)
+			{
+				ret = starpu_mpi_isend_detached(matrix_handle, n, 1, MPI_COMM_WORLD, NULL, NULL);
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend_detached");
+			}
+			for (n = 1; n < size; n++)
+			{
+				if (n == 2)
+					continue;
+				ret = starpu_mpi_isend_detached(var_handle, n, 2, MPI_COMM_WORLD, NULL, NULL);
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend_detached");
+			}
+			/* Node 2 has received the matrix before posting its receive */
+			starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+			ret = starpu_mpi_isend_detached(var_handle, 2, 2, MPI_COMM_WORLD, NULL, NULL);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend_detached");
+		}
+		else if (rank == 2)
+		{
+			/* The matrix arrives while we are waiting for var */
+			ret = starpu_mpi_recv(var_handle, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_recv");
+			ret = starpu_mpi_recv(matrix_handle, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_recv");
+		}
+		else if (rank % 2)
+		{
+			ret = starpu_mpi_irecv_detached(matrix_handle, 0, 1, MPI_COMM_WORLD, NULL, NULL);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_irecv_detached");
+			ret = starpu_mpi_irecv_detached(var_handle, 0, 2, MPI_COMM_WORLD, NULL, NULL);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_irecv_detached");
+		}
+		else
+		{
+			ret = starpu_mpi_recv(matrix_handle, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_recv");
+			ret = starpu_mpi_recv(var_handle, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_recv");
+		}
+
+		starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+
+		starpu_data_acquire(matrix_handle, STARPU_R);
+		starpu_data_acquire(var_handle, STARPU_R);
+		STARPU_ASSERT_MSG(var == iter, "var = %d, expected %d\n", var, iter);
+		for (y = 0; y < NY; y++)
+			for (x = 0; x < NX; x++)
+				STARPU_ASSERT_MSG(matrix[y*LD + x] == iter * 1000.f + y * NX + x, "matrix[%u][%u] = %f, expected %f\n", y, x, matrix[y*LD + x], iter * 1000.f + y * NX + x);
+		starpu_data_release(var_handle);
+		starpu_data_release(matrix_handle);
+
+		starpu_mpi_barrier(MPI_COMM_WORLD);
+	}
+
+	starpu_data_unregister(matrix_handle);
+	starpu_data_unregister(var_handle);
+	free(matrix);
+
+	starpu_mpi_shutdown();
+	if (!mpi_init)
+		MPI_Finalize();
+
+	return 0;
+}
+#endif
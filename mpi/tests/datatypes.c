@@ -577,6 +577,119 @@ void exchange_csr(int rank, int *error)
 	}
 }
 
+/*
+ * SELL
+ */
+void check_sell(starpu_data_handle_t handle_s, starpu_data_handle_t handle_r, int *error)
+{
+	STARPU_ASSERT(starpu_sell_get_elemsize(handle_s) == starpu_sell_get_elemsize(handle_r));
+	STARPU_ASSERT(starpu_sell_get_nnz(handle_s) == starpu_sell_get_nnz(handle_r));
+	STARPU_ASSERT(starpu_sell_get_nrow(handle_s) == starpu_sell_get_nrow(handle_r));
+	STARPU_ASSERT(starpu_sell_get_c(handle_s) == starpu_sell_get_c(handle_r));
+	STARPU_ASSERT(starpu_sell_get_sigma(handle_s) == starpu_sell_get_sigma(handle_r));
+	STARPU_ASSERT(starpu_sell_get_firstentry(handle_s) == starpu_sell_get_firstentry(handle_r));
+
+	starpu_data_acquire(handle_s, STARPU_R);
+	starpu_data_acquire(handle_r, STARPU_R);
+
+	uint32_t *colind_s = starpu_sell_get_local_colind(handle_s);
+	uint32_t *colind_r = starpu_sell_get_local_colind(handle_r);
+	uint32_t *sliceptr_s = starpu_sell_get_local_sliceptr(handle_s);
+	uint32_t *sliceptr_r = starpu_sell_get_local_sliceptr(handle_r);
+	uint32_t *rowind_s = starpu_sell_get_local_rowind(handle_s);
+	uint32_t *rowind_r = starpu_sell_get_local_rowind(handle_r);
+
+	int *sell_s = (int *)starpu_sell_get_local_nzval(handle_s);
+	int *sell_r = (int *)starpu_sell_get_local_nzval(handle_r);
+
+	int nnz = starpu_sell_get_nnz(handle_s);
+	int nrows = starpu_sell_get_nrow(handle_s);
+	int c = starpu_sell_get_c(handle_s);
+	int nslices = (nrows + c - 1) / c;
+
+	int x;
+
+	for(x=0 ; x<nnz ; x++)
+	{
+		if (colind_s[x] == colind_r[x] && sell_s[x] == sell_r[x])
+		{
+			FPRINTF_MPI(stderr, "Success with sell[%d] value: %d == %d\n", x, sell_s[x], sell_r[x]);
+		}
+		else
+		{
+			*error = 1;
+			FPRINTF_MPI(stderr, "Error with sell[%d] value: %d != %d or colind %u != %u\n", x, sell_s[x], sell_r[x], colind_s[x], colind_r[x]);
+		}
+	}
+
+	for(x=0 ; x<nslices+1 ; x++)
+	{
+		if (sliceptr_s[x] == sliceptr_r[x])
+		{
+			FPRINTF_MPI(stderr, "Success with sliceptr[%d] value: %u == %u\n", x, sliceptr_s[x], sliceptr_r[x]);
+		}
+		else
+		{
+			*error = 1;
+			FPRINTF_MPI(stderr, "Error with sliceptr[%d] value: %u != %u\n", x, sliceptr_s[x], sliceptr_r[x]);
+		}
+	}
+
+	for(x=0 ; x<nrows ; x++)
+	{
+		if (rowind_s[x] == rowind_r[x])
+		{
+			FPRINTF_MPI(stderr, "Success with rowind[%d] value: %u == %u\n", x, rowind_s[x], rowind_r[x]);
+		}
+		else
+		{
+			*error = 1;
+			FPRINTF_MPI(stderr, "Error with rowind[%d] value: %u != %u\n", x, rowind_s[x], rowind_r[x]);
+		}
+	}
+
+	starpu_data_release(handle_s);
+	starpu_data_release(handle_r);
+}
+
+void exchange_sell(int rank, int *error)
+{
+	/*
+	 *   |  1   0   0   0 |
+	 *   |  2   3   4   0 |
+	 *   |  0   0   5   0 |
+	 *   |  0   6   0   7 |
+	 */
+#define SELL_NROWS 4
+#define SELL_NNZ   8
+#define SELL_C     2
+#define SELL_SIGMA 4
+
+	if (rank == 0)
+	{
+		starpu_data_handle_t sell_handle[2];
+		uint32_t rowind[SELL_NROWS] = {1, 3, 0, 2};
+		uint32_t colind[SELL_NNZ] = {0, 1, 1, 3, 2, 0, 0, 2};
+		uint32_t sliceptr[SELL_NROWS/SELL_C+1] = {0, 6, SELL_NNZ};
+		int nzval[SELL_NNZ] = {2, 6, 3, 7, 4, 0, 1, 5};
+
+		starpu_sell_data_register(&sell_handle[0], STARPU_MAIN_RAM, SELL_NNZ, SELL_NROWS, SELL_C, SELL_SIGMA, (uintptr_t) nzval, colind, sliceptr, rowind, 0, sizeof(nzval[0]));
+		starpu_sell_data_register(&sell_handle[1], -1, SELL_NNZ, SELL_NROWS, SELL_C, SELL_SIGMA, (uintptr_t) NULL, NULL, NULL, NULL, 0, sizeof(nzval[0]));
+
+		send_recv_and_check(rank, 1, sell_handle[0], 0x95, sell_handle[1], 0x8876, error, check_sell);
+
+		starpu_data_unregister(sell_handle[0]);
+		starpu_data_unregister(sell_handle[1]);
+	}
+	else if (rank == 1)
+	{
+		starpu_data_handle_t sell_handle;
+		starpu_sell_data_register(&sell_handle, -1, SELL_NNZ, SELL_NROWS, SELL_C, SELL_SIGMA, (uintptr_t) NULL, NULL, NULL, NULL, 0, sizeof(int));
+		send_recv_and_check(rank, 0, sell_handle, 0x95, NULL, 0x8876, NULL, NULL);
+		starpu_data_unregister(sell_handle);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	int ret, rank, size;
@@ -616,6 +729,7 @@ int main(int argc, char **argv)
 	exchange_block(rank, &error);
 	exchange_bcsr(rank, &error);
 	exchange_csr(rank, &error);
+	exchange_sell(rank, &error);
 
 	starpu_mpi_shutdown();
 
@@ -0,0 +1,180 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Check that with STARPU_MPI_CACHE_SIZE, node 0 keeps at most the given
+ * amount of data received from node 1 in its cache, that node 1 sends again
+ * the data which were evicted, and not the ones which are still cached.
+ */
+
+#include <starpu.h>
+#include <starpu_mpi.h>
+#include <datawizard/malloc.h>
+#include "helper.h"
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define CACHE_SIZE_MB 1
+/* Number of data which fit in the cache */
+#define NB_CACHED 4
+#define NB_DATA (2*NB_CACHED)
+
+void func_cpu(void *descr[], void *_args)
+{
+	(void)_args;
+	int *sum = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	int *v = (int *)STARPU_VECTOR_GET_PTR(descr[1]);
+	*sum += v[0];
+}
+
+struct starpu_codelet mycodelet =
+{
+	.cpu_funcs = {func_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_RW, STARPU_R},
+	.model = &starpu_perfmodel_nop,
+};
+
+static void insert(starpu_data_handle_t sum_handle, starpu_data_handle_t handle)
+{
+	int ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet, STARPU_RW, sum_handle, STARPU_R, handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+}
+
+/* Returns the number of data sent by node 1 to node 0 */
+static size_t test_cache(int rank, int size, starpu_mpi_tag_t initial_tag, const char *cache_size)
+{
+	int i, ret, sum = 0, expected = 0;
+	int *v[NB_DATA];
+	starpu_data_handle_t handles[NB_DATA], sum_handle;
+	/* The budget is shared between the other nodes */
+	unsigned nx = (size_t) CACHE_SIZE_MB * 1024 * 1024 / (size - 1) / NB_CACHED / sizeof(int);
+	size_t data_size = nx * sizeof(int);
+	size_t comm_amount[size];
+	struct starpu_conf conf;
+
+	FPRINTF(stderr, "Testing with STARPU_MPI_CACHE_SIZE=%s\n", cache_size);
+	setenv("STARPU_MPI_CACHE_SIZE", cache_size, 1);
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_mpi_init_conf(NULL, NULL, 0, MPI_COMM_WORLD, &conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_variable_data_register(&sum_handle, rank == 0 ? STARPU_MAIN_RAM : -1, rank == 0 ? (uintptr_t) &sum : 0, sizeof(sum));
+	starpu_mpi_data_register(sum_handle, initial_tag + NB_DATA, 0);
+	for (i = 0; i < NB_DATA; i++)
+	{
+		if (rank == 1)
+		{
+			unsigned j;
+			v[i] = malloc(data_size);
+			for (j = 0; j < nx; j++)
+				v[i][j] = i+1;
+			starpu_vector_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t) v[i], nx, sizeof(int));
+		}
+		else
+		{
+			v[i] = NULL;
+			starpu_vector_data_register(&handles[i], -1, (uintptr_t) NULL, nx, sizeof(int));
+		}
+		starpu_mpi_data_register(handles[i], initial_tag + i, 1);
+	}
+
+	/* Going twice through more data than the cache can hold evicts them
+	 * before they are used again */
+	for (i = 0; i < 2*NB_DATA; i++)
+	{
+		insert(sum_handle, handles[i % NB_DATA]);
+		expected += i % NB_DATA + 1;
+	}
+	starpu_task_wait_for_all();
+
+	if (rank == 0 && strcmp(cache_size, "0") != 0 && !_starpu_malloc_willpin_on_node(STARPU_MAIN_RAM))
+		/* Without GPUs the evicted copies are completely freed */
+		STARPU_ASSERT_MSG(starpu_memory_get_used(STARPU_MAIN_RAM) <= NB_CACHED * data_size, "%ld bytes used in the cache, more than %ld\n", (long) starpu_memory_get_used(STARPU_MAIN_RAM), (long) (NB_CACHED * data_size));
+
+	/* While a few data which fit in the cache are only sent once */
+	for (i = 0; i < 2*NB_DATA; i++)
+	{
+		insert(sum_handle, handles[i % 2]);
+		expected += i % 2 + 1;
+	}
+	starpu_task_wait_for_all();
+
+	starpu_data_unregister(sum_handle);
+	for (i = 0; i < NB_DATA; i++)
+	{
+		starpu_data_unregister(handles[i]);
+		free(v[i]);
+	}
+	if (rank == 0)
+		STARPU_ASSERT_MSG(sum == expected, "sum is %d instead of %d\n", sum, expected);
+
+	starpu_mpi_comm_stats_retrieve(comm_amount);
+	starpu_mpi_shutdown();
+
+	return comm_amount[0] / data_size;
+}
+
+int main(int argc, char **argv)
+{
+	int rank, size;
+	int result = 1;
+	size_t nsent_unbounded, nsent_bounded;
+	char cache_size[16];
+
+	MPI_INIT_THREAD_real(&argc, &argv, MPI_THREAD_SERIALIZED);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+	if (size < 2)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 2 processes.\n");
+		MPI_Finalize();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	setenv("STARPU_MPI_STATS", "1", 1);
+	setenv("STARPU_MPI_CACHE_STATS", "1", 1);
+
+	nsent_unbounded = test_cache(rank, size, 0, "0");
+	snprintf(cache_size, sizeof(cache_size), "%d", CACHE_SIZE_MB);
+	nsent_bounded = test_cache(rank, size, NB_DATA+1, cache_size);
+
+	if (rank == 1)
+	{
+		/* All data are sent once, or at each use in the first loop,
+		 * and the 2 data of the second loop once more */
+		result = nsent_unbounded == NB_DATA && nsent_bounded == 2*NB_DATA + 2;
+		FPRINTF(stderr, "[%d] Bounded communication cache is %sworking (unbounded: %ld sends) (bounded: %ld sends)\n", rank, result?"":"NOT ", (long) nsent_unbounded, (long) nsent_bounded);
+	}
+
+	MPI_Finalize();
+	return !result;
+}
+#endif
@@ -0,0 +1,159 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+/*
+ * Insert tasks with starpu_mpi_task_insert_prepared_submit(), alternating with
+ * starpu_mpi_task_insert(). Node 0 increments x alone, the other nodes are thus
+ * not involved in these tasks, but node 1 has to drop the copy of x it
+ * received for the previous check, to get the new value for the next one.
+ */
+
+#define NITER 10
+
+void inc_cpu(void *descr[], void *_args)
+{
+	int *x = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	(void)_args;
+
+	(*x)++;
+}
+
+struct starpu_codelet inc_cl =
+{
+	.cpu_funcs = {inc_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.model = &starpu_perfmodel_nop,
+	.name = "insert_task_prepared_inc"
+};
+
+void check_cpu(void *descr[], void *_args)
+{
+	int *y = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	int *x = (int *)STARPU_VARIABLE_GET_PTR(descr[1]);
+	int expected, rank;
+
+	starpu_codelet_unpack_args(_args, &expected);
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	FPRINTF_MPI(stderr, "x = %d, expected %d\n", *x, expected);
+
+	STARPU_ASSERT(rank == 1);
+	STARPU_ASSERT(*x == expected);
+	*y = *x;
+}
+
+struct starpu_codelet check_cl =
+{
+	.cpu_funcs = {check_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_RW, STARPU_R},
+	.model = &starpu_perfmodel_nop,
+	.name = "insert_task_prepared_check"
+};
+
+int main(int argc, char **argv)
+{
+	int ret, rank, size, i;
+	int x = 0, y = -1;
+	starpu_data_handle_t x_handle, y_handle;
+	struct starpu_task_insert_prepared *prepared_inc, *prepared_check;
+	struct starpu_conf conf;
+	int mpi_init;
+
+	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, &conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (size < 2 || starpu_cpu_worker_get_count() == 0)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 2 processes and CPU workers.\n");
+		starpu_mpi_shutdown();
+		if (!mpi_init)
+			MPI_Finalize();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	if (rank == 0)
+		starpu_variable_data_register(&x_handle, STARPU_MAIN_RAM, (uintptr_t)&x, sizeof(x));
+	else
+		starpu_variable_data_register(&x_handle, -1, (uintptr_t)NULL, sizeof(x));
+	if (rank == 1)
+		starpu_variable_data_register(&y_handle, STARPU_MAIN_RAM, (uintptr_t)&y, sizeof(y));
+	else
+		starpu_variable_data_register(&y_handle, -1, (uintptr_t)NULL, sizeof(y));
+	starpu_mpi_data_register(x_handle, 42, 0);
+	starpu_mpi_data_register(y_handle, 43, 1);
+
+	prepared_inc = starpu_task_insert_prepare(&inc_cl, STARPU_RW, 0);
+	prepared_check = starpu_task_insert_prepare(&check_cl, STARPU_RW, STARPU_R, STARPU_VALUE, sizeof(int), 0);
+	STARPU_ASSERT(prepared_inc && prepared_check);
+
+	for (i = 1; i <= NITER; i++)
+	{
+		starpu_data_handle_t inc_handles[] = { x_handle };
+		ret = starpu_mpi_task_insert_prepared_submit(MPI_COMM_WORLD, prepared_inc, inc_handles, NULL);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert_prepared_submit");
+
+		if (i % 2)
+		{
+			starpu_data_handle_t check_handles[] = { y_handle, x_handle };
+			void *check_values[] = { &i };
+			ret = starpu_mpi_task_insert_prepared_submit(MPI_COMM_WORLD, prepared_check, check_handles, check_values);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert_prepared_submit");
+		}
+		else
+		{
+			ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &check_cl,
+						     STARPU_RW, y_handle, STARPU_R, x_handle,
+						     STARPU_VALUE, &i, sizeof(i),
+						     0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+		}
+	}
+
+	starpu_task_wait_for_all();
+	starpu_task_insert_prepared_destroy(prepared_inc);
+	starpu_task_insert_prepared_destroy(prepared_check);
+
+	starpu_data_unregister(x_handle);
+	starpu_data_unregister(y_handle);
+
+	if (rank == 0)
+		STARPU_ASSERT(x == NITER);
+	if (rank == 1)
+		STARPU_ASSERT(y == NITER);
+
+	starpu_mpi_shutdown();
+
+	if (!mpi_init)
+		MPI_Finalize();
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Run an imbalanced workload, where node 0 owns all the data, with the
+ * diffusion load balancer: it has to move data to the other nodes, and give
+ * them back to node 0 when it is shut down.
+ */
+
+#include <starpu_mpi.h>
+#include <starpu_mpi_lb.h>
+#include "helper.h"
+
+#if !defined(STARPU_HAVE_SETENV) || !defined(STARPU_USE_MPI_MPI)
+
+#warning setenv is not defined. Skipping test
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define NDATA 16
+#ifdef STARPU_QUICK_CHECK
+#define NITER 4
+#else
+#define NITER 8
+#endif
+
+void func_cpu(void *descr[], void *_args)
+{
+	(void)_args;
+	int *value = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	(*value)++;
+}
+
+struct starpu_codelet mycodelet =
+{
+	.cpu_funcs = {func_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "increment"
+};
+
+static int count_owned(starpu_data_handle_t *handles, int rank)
+{
+	int i, n = 0;
+	for (i = 0; i < NDATA; i++)
+		if (starpu_mpi_data_get_rank(handles[i]) == rank)
+			n++;
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	int ret, rank, size, i, iter;
+	int mpi_init;
+	int values[NDATA];
+	starpu_data_handle_t handles[NDATA];
+	char period[16];
+
+	snprintf(period, sizeof(period), "%d", NDATA);
+	unsetenv("STARPU_MPI_LB");
+	setenv("STARPU_MPI_LB_DIFFUSION_PERIOD", period, 1);
+
+	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
+	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 1 CPU worker.\n");
+		starpu_mpi_shutdown();
+		if (!mpi_init)
+			MPI_Finalize();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NDATA; i++)
+	{
+		values[i] = 0;
+		starpu_variable_data_register(&handles[i], rank == 0 ? STARPU_MAIN_RAM : -1, rank == 0 ? (uintptr_t) &values[i] : 0, sizeof(values[i]));
+		starpu_mpi_data_register(handles[i], i, 0);
+	}
+
+	/* Let the load balancer choose the data to migrate */
+	starpu_mpi_lb_init("diffusion", NULL);
+
+	for (iter = 0; iter < NITER; iter++)
+	{
+		for (i = 0; i < NDATA; i++)
+		{
+			ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet, STARPU_RW, handles[i], 0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+		}
+		if (rank == 0)
+			FPRINTF(stderr, "iteration %d: node 0 owns %d data out of %d\n", iter, count_owned(handles, 0), NDATA);
+	}
+
+	/* The balancing happens at the same time on all nodes */
+	if (size > 1)
+	{
+		STARPU_ASSERT_MSG(count_owned(handles, 0) < NDATA, "the load balancer did not move any data out of node 0\n");
+		for (i = 1; i < size; i++)
+			STARPU_ASSERT_MSG(count_owned(handles, i) > 0, "the load balancer did not move any data to node %d\n", i);
+	}
+
+	starpu_mpi_lb_shutdown();
+
+	/* All data are back on node 0 */
+	STARPU_ASSERT(count_owned(handles, 0) == NDATA);
+
+	starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+
+	if (rank == 0)
+		for (i = 0; i < NDATA; i++)
+			STARPU_ASSERT_MSG(values[i] == NITER, "data %d is %d instead of %d\n", i, values[i], NITER);
+
+	starpu_mpi_shutdown();
+	if (!mpi_init)
+		MPI_Finalize();
+
+	return 0;
+}
+
+#endif
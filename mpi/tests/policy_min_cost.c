@@ -0,0 +1,204 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+/*
+ * Check the choices of the STARPU_MPI_NODE_SELECTION_MIN_COST policy: it
+ * takes into account the data cached by the nodes, and balances the
+ * execution time of the tasks predicted from their number of flops, or from
+ * the default unit cost for the tasks which do not provide it.
+ */
+
+#define NA (256*1024)
+#define NX1 1024
+/* 1ms with the default STARPU_MPI_WORKER_GFLOPS */
+#define TASK_FLOPS 1e7
+/* Negligible execution time, only the transfers matter */
+#define TINY_FLOPS 1.
+
+void func_cpu(void *descr[], void *_args)
+{
+	int node;
+	int rank;
+	(void)descr;
+
+	starpu_codelet_unpack_args(_args, &node);
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	FPRINTF_MPI(stderr, "Expected node: %d - Actual node: %d\n", node, rank);
+
+	STARPU_ASSERT(node == rank);
+}
+
+struct starpu_codelet mycodelet =
+{
+	.cpu_funcs = {func_cpu},
+	.nbuffers = STARPU_VARIABLE_NBUFFERS,
+	.name = "policy_min_cost"
+};
+
+int main(int argc, char **argv)
+{
+	int ret, rank, size, node, i;
+	float *a = NULL;
+	int x0 = 0, y = 0, *x1 = NULL;
+	int l[2] = { 0, 0 };
+	starpu_data_handle_t a_handle, x0_handle, x1_handle, y_handle;
+	starpu_data_handle_t l_handles[2];
+	struct starpu_conf conf;
+	int mpi_init;
+
+	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, &conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (size < 2 || starpu_cpu_worker_get_count() == 0 || !starpu_mpi_cache_is_enabled())
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 2 processes, CPU workers, and the MPI cache.\n");
+		starpu_mpi_shutdown();
+		if (!mpi_init)
+			MPI_Finalize();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	if (rank == 0)
+	{
+		starpu_malloc((void **)&a, NA * sizeof(*a));
+		memset(a, 0, NA * sizeof(*a));
+		starpu_vector_data_register(&a_handle, STARPU_MAIN_RAM, (uintptr_t)a, NA, sizeof(*a));
+		starpu_variable_data_register(&x0_handle, STARPU_MAIN_RAM, (uintptr_t)&x0, sizeof(x0));
+		starpu_vector_data_register(&x1_handle, -1, (uintptr_t)NULL, NX1, sizeof(int));
+		starpu_variable_data_register(&y_handle, -1, (uintptr_t)NULL, sizeof(y));
+		starpu_variable_data_register(&l_handles[0], STARPU_MAIN_RAM, (uintptr_t)&l[0], sizeof(l[0]));
+		starpu_variable_data_register(&l_handles[1], -1, (uintptr_t)NULL, sizeof(l[1]));
+	}
+	else if (rank == 1)
+	{
+		x1 = calloc(NX1, sizeof(*x1));
+		starpu_vector_data_register(&a_handle, -1, (uintptr_t)NULL, NA, sizeof(float));
+		starpu_variable_data_register(&x0_handle, -1, (uintptr_t)NULL, sizeof(x0));
+		starpu_vector_data_register(&x1_handle, STARPU_MAIN_RAM, (uintptr_t)x1, NX1, sizeof(*x1));
+		starpu_variable_data_register(&y_handle, STARPU_MAIN_RAM, (uintptr_t)&y, sizeof(y));
+		starpu_variable_data_register(&l_handles[0], -1, (uintptr_t)NULL, sizeof(l[0]));
+		starpu_variable_data_register(&l_handles[1], STARPU_MAIN_RAM, (uintptr_t)&l[1], sizeof(l[1]));
+	}
+	else
+	{
+		starpu_vector_data_register(&a_handle, -1, (uintptr_t)NULL, NA, sizeof(float));
+		starpu_variable_data_register(&x0_handle, -1, (uintptr_t)NULL, sizeof(x0));
+		starpu_vector_data_register(&x1_handle, -1, (uintptr_t)NULL, NX1, sizeof(int));
+		starpu_variable_data_register(&y_handle, -1, (uintptr_t)NULL, sizeof(y));
+		starpu_variable_data_register(&l_handles[0], -1, (uintptr_t)NULL, sizeof(l[0]));
+		starpu_variable_data_register(&l_handles[1], -1, (uintptr_t)NULL, sizeof(l[1]));
+	}
+	starpu_mpi_data_register(a_handle, 100, 0);
+	starpu_mpi_data_register(x0_handle, 101, 0);
+	starpu_mpi_data_register(x1_handle, 102, 1);
+	starpu_mpi_data_register(y_handle, 103, 1);
+	starpu_mpi_data_register(l_handles[0], 104, 0);
+	starpu_mpi_data_register(l_handles[1], 105, 1);
+
+	ret = starpu_mpi_node_selection_set_current_policy(STARPU_MPI_NODE_SELECTION_MIN_COST);
+	STARPU_ASSERT(ret == 0);
+
+	/* Make node 1 cache the big vector */
+	node = 1;
+	ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet,
+				     STARPU_VALUE, &node, sizeof(node),
+				     STARPU_FLOPS, (double) TINY_FLOPS,
+				     STARPU_R, a_handle, STARPU_RW, y_handle,
+				     0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+
+	/* Node 0 owns the big vector, so it is selected by the policy
+	 * which only counts the owned data */
+	node = 0;
+	ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet,
+				     STARPU_VALUE, &node, sizeof(node),
+				     STARPU_NODE_SELECTION_POLICY, STARPU_MPI_NODE_SELECTION_MOST_R_DATA,
+				     STARPU_R, a_handle, STARPU_RW, x0_handle, STARPU_RW, x1_handle,
+				     0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+
+	/* But node 1 has it in its cache, and would only need the small
+	 * variable, instead of the bigger vector for node 0 */
+	node = 1;
+	ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet,
+				     STARPU_VALUE, &node, sizeof(node),
+				     STARPU_FLOPS, (double) TINY_FLOPS,
+				     STARPU_R, a_handle, STARPU_RW, x0_handle, STARPU_RW, x1_handle,
+				     0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+
+	/* The tasks get balanced over the nodes, the nodes owning one of the
+	 * data first, since they only need to receive the other one */
+	for (i = 0; i < 2*size; i++)
+	{
+		node = i % size;
+		ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet,
+					     STARPU_VALUE, &node, sizeof(node),
+					     STARPU_FLOPS, (double) TASK_FLOPS,
+					     STARPU_RW, l_handles[0], STARPU_RW, l_handles[1],
+					     0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+	}
+
+	/* The tasks without flops are balanced the same way, with the
+	 * default STARPU_MPI_TASK_LENGTH */
+	for (i = 0; i < 2*size; i++)
+	{
+		node = i % size;
+		ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &mycodelet,
+					     STARPU_VALUE, &node, sizeof(node),
+					     STARPU_RW, l_handles[0], STARPU_RW, l_handles[1],
+					     0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+	}
+
+	starpu_task_wait_for_all();
+
+	ret = starpu_mpi_node_selection_set_current_policy(STARPU_MPI_NODE_SELECTION_MOST_R_DATA);
+	STARPU_ASSERT(ret == 0);
+
+	starpu_data_unregister(a_handle);
+	starpu_data_unregister(x0_handle);
+	starpu_data_unregister(x1_handle);
+	starpu_data_unregister(y_handle);
+	starpu_data_unregister(l_handles[0]);
+	starpu_data_unregister(l_handles[1]);
+	if (a)
+		starpu_free_noflag(a, NA * sizeof(*a));
+	free(x1);
+
+	starpu_mpi_shutdown();
+
+	if (!mpi_init)
+		MPI_Finalize();
+
+	return 0;
+}
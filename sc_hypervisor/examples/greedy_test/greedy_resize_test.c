@@ -0,0 +1,190 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Compare the resizing policies of the hypervisor: measure the latency of
+ * one decision of the water-filling distribution used by the greedy
+ * policy, and of the linear program used by the lp policies when GLPK is
+ * available, then run contexts with unbalanced workloads under the policy
+ * given on the command line (greedy by default) and report the time spent
+ * in resizing and the task throughput.
+ *
+ * Usage: greedy_resize_test [policy]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <starpu.h>
+#include <sc_hypervisor.h>
+#include <sc_hypervisor_policy.h>
+#include <sc_hypervisor_lp.h>
+
+#define NCTXS 3
+#define NTASKS 200
+#define NRESIZES 4
+#define NDECISIONS 1000
+#define TASK_FLOPS 1000000.0
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+static double resize_time[NCTXS];
+static int nresizes[NCTXS];
+
+void cpu_func(__attribute__((unused))void *buffers[], __attribute__((unused))void *cl_arg)
+{
+	volatile double x = 1.0;
+	int i;
+	for(i = 0; i < 10000; i++)
+		x *= 1.0000001;
+}
+
+struct starpu_codelet cl =
+{
+	.cpu_funcs = {cpu_func},
+	.nbuffers = 0,
+	.name = "greedy_resize_test"
+};
+
+static unsigned sched_ctxs[NCTXS];
+
+/* context i has (i+1)*NTASKS tasks to execute */
+void* submit_tasks_thread(void *arg)
+{
+	int ctx = (int)(uintptr_t)arg;
+	starpu_sched_ctx_set_context(&sched_ctxs[ctx]);
+	int ntasks = (ctx+1)*NTASKS;
+
+	int i;
+	for(i = 0; i < ntasks; i++)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &cl;
+		task->flops = TASK_FLOPS;
+		int ret = starpu_task_submit(task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+
+		if((i+1) % (ntasks/NRESIZES) == 0)
+		{
+			double start = starpu_timing_now();
+			sc_hypervisor_resize_ctxs(NULL, -1, NULL, -1);
+			resize_time[ctx] += starpu_timing_now() - start;
+			nresizes[ctx]++;
+		}
+	}
+
+	starpu_task_wait_for_all_in_ctx(sched_ctxs[ctx]);
+	return NULL;
+}
+
+static void measure_decision_latency(void)
+{
+	int ns = NCTXS, nw = 1;
+	double speed[ns][nw];
+	double flops[ns];
+	double res[ns][nw];
+	int total_nw[nw];
+	total_nw[0] = starpu_cpu_worker_get_count();
+
+	int i, s;
+	double water_fill_time = 0.0;
+#ifdef STARPU_HAVE_GLPK_H
+	double lp_time = 0.0;
+#endif
+	starpu_srand48(0);
+	for(i = 0; i < NDECISIONS; i++)
+	{
+		for(s = 0; s < ns; s++)
+		{
+			speed[s][0] = 1.0 + 10.0*starpu_drand48();
+			flops[s] = 1.0 + 1000.0*starpu_drand48();
+		}
+
+		double start = starpu_timing_now();
+		sc_hypervisor_policy_water_fill(ns, nw, speed, flops, total_nw, NULL, res);
+		water_fill_time += starpu_timing_now() - start;
+
+#ifdef STARPU_HAVE_GLPK_H
+		start = starpu_timing_now();
+		sc_hypervisor_lp_simulate_distrib_flops(ns, nw, speed, flops, res, total_nw, sched_ctxs, -1.0);
+		lp_time += starpu_timing_now() - start;
+#endif
+	}
+
+	FPRINTF(stdout, "water-filling decision: %.2f us\n", water_fill_time/NDECISIONS);
+#ifdef STARPU_HAVE_GLPK_H
+	FPRINTF(stdout, "linear program decision: %.2f us\n", lp_time/NDECISIONS);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	int ret = starpu_init(NULL);
+
+	if (ret == -ENODEV)
+		return 77;
+
+	int i;
+	for(i = 0; i < NCTXS; i++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "sched_ctx%d", i);
+		sched_ctxs[i] = starpu_sched_ctx_create(NULL, -1, name, STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+	}
+
+	struct sc_hypervisor_policy policy;
+	policy.custom = 0;
+	policy.name = argc > 1 ? argv[1] : "greedy";
+	void *perf_counters = sc_hypervisor_init(&policy);
+
+	for(i = 0; i < NCTXS; i++)
+	{
+		starpu_sched_ctx_set_perf_counters(sched_ctxs[i], perf_counters);
+		sc_hypervisor_register_ctx(sched_ctxs[i], (i+1)*NTASKS*TASK_FLOPS);
+	}
+
+	measure_decision_latency();
+
+	double start = starpu_timing_now();
+	sc_hypervisor_size_ctxs(NULL, -1, NULL, -1);
+	double size_time = starpu_timing_now() - start;
+
+	starpu_pthread_t tid[NCTXS];
+	start = starpu_timing_now();
+	for(i = 0; i < NCTXS; i++)
+		STARPU_PTHREAD_CREATE(&tid[i], NULL, submit_tasks_thread, (void*)(uintptr_t)i);
+	for(i = 0; i < NCTXS; i++)
+		STARPU_PTHREAD_JOIN(tid[i], NULL);
+	double elapsed = starpu_timing_now() - start;
+
+	double total_resize_time = 0.0;
+	int total_nresizes = 0;
+	int ntasks = 0;
+	for(i = 0; i < NCTXS; i++)
+	{
+		total_resize_time += resize_time[i];
+		total_nresizes += nresizes[i];
+		ntasks += (i+1)*NTASKS;
+	}
+
+	FPRINTF(stdout, "policy %s: sizing took %.2f us, %d resizes took %.2f us on average\n",
+		policy.name, size_time, total_nresizes, total_resize_time/total_nresizes);
+	FPRINTF(stdout, "policy %s: %d tasks in %.2f ms (%.2f tasks/s)\n",
+		policy.name, ntasks, elapsed/1000.0, ntasks/(elapsed/1000000.0));
+
+	starpu_shutdown();
+	sc_hypervisor_shutdown();
+
+	return 0;
+}
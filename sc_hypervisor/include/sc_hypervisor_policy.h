@@ -213,6 +213,17 @@ unsigned sc_hypervisor_check_speed_gap_btw_ctxs_on_level(int level, int *workers
 */
 unsigned sc_hypervisor_get_resize_criteria(void);
 
+/**
+   compute in table \p res the number of workers of each type to give to
+   each context, without a linear program: the workers are given one by
+   one to the context which would finish last given its \p flops and its
+   \p speed for each type of worker, until \p total_nw are given or all
+   the contexts reached their \p max_nworkers (which may be <c>NULL</c>,
+   and where a negative value means no limit). Return the estimated time
+   of the slowest context, or -1.0 if no context has flops to execute.
+*/
+double sc_hypervisor_policy_water_fill(int ns, int nw, double speed[ns][nw], double flops[ns], int total_nw[nw], int *max_nworkers, double res[ns][nw]);
+
 /**
    load information concerning the type of workers into a types_of_workers struct
 */
@@ -0,0 +1,172 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Same goal as the feft_lp policy (all the contexts finishing at the same
+ * time), but the distribution of the workers is computed by water-filling
+ * over the monitored speeds of the contexts instead of solving a linear
+ * program, so that a decision takes microseconds and does not need GLPK.
+ */
+
+#include "sc_hypervisor_lp.h"
+#include "sc_hypervisor_policy.h"
+#include "sc_hypervisor_intern.h"
+#include <starpu_config.h>
+
+static double _get_flops(struct sc_hypervisor_wrapper *sc_w)
+{
+	double flops;
+	if(sc_w->to_be_sized)
+	{
+		flops = sc_w->remaining_flops;
+		sc_w->to_be_sized = 0;
+	}
+	else if(sc_w->remaining_flops < 0.0)
+		flops = starpu_sched_ctx_get_nready_flops(sc_w->sched_ctx);
+	else
+		flops = sc_w->remaining_flops;
+
+	/* in gflops */
+	return flops < 0.0 ? 0.0 : flops/1000000000.0;
+}
+
+static void _try_resizing(unsigned *sched_ctxs, int nsched_ctxs, int *workers, int nworkers)
+{
+	int ns = sched_ctxs == NULL ? sc_hypervisor_get_nsched_ctxs() : nsched_ctxs;
+	if(ns <= 0) return;
+
+	unsigned *curr_sched_ctxs = sched_ctxs == NULL ? sc_hypervisor_get_sched_ctxs() : sched_ctxs;
+	unsigned curr_nworkers = nworkers == -1 ? starpu_worker_get_count() : (unsigned)nworkers;
+
+	struct types_of_workers *tw = sc_hypervisor_get_types_of_workers(workers, curr_nworkers);
+	int nw = tw->nw;
+	int total_nw[nw];
+	sc_hypervisor_group_workers_by_type(tw, total_nw);
+
+	double speed[ns][nw];
+	double flops[ns];
+	int max_nworkers[ns];
+	double nworkers_per_ctx[ns][nw];
+	int s, w;
+	for(s = 0; s < ns; s++)
+	{
+		struct sc_hypervisor_wrapper *sc_w = sc_hypervisor_get_wrapper(curr_sched_ctxs[s]);
+		struct sc_hypervisor_policy_config *config = sc_hypervisor_get_config(curr_sched_ctxs[s]);
+		for(w = 0; w < nw; w++)
+			speed[s][w] = sc_hypervisor_get_speed(sc_w, sc_hypervisor_get_arch_for_index(w, tw));
+		flops[s] = _get_flops(sc_w);
+		max_nworkers[s] = config->max_nworkers;
+	}
+
+	double tmax = sc_hypervisor_policy_water_fill(ns, nw, speed, flops, total_nw, max_nworkers, nworkers_per_ctx);
+	if(tmax != -1.0)
+	{
+		for(s = 0; s < ns; s++)
+		{
+			double optimal_v = 0.0;
+			unsigned no_workers = 1;
+			for(w = 0; w < nw; w++)
+			{
+				optimal_v += nworkers_per_ctx[s][w] * speed[s][w];
+				if(nworkers_per_ctx[s][w] != 0.0)
+					no_workers = 0;
+			}
+			_set_optimal_v(curr_sched_ctxs[s], optimal_v);
+
+			/* let the contexts without workers keep a shared one to
+			   finish their last tasks, as the lp policies do */
+			if(no_workers)
+				for(w = 0; w < nw; w++)
+					nworkers_per_ctx[s][w] = -1.0;
+		}
+
+		sc_hypervisor_lp_distribute_floating_no_resources_in_ctxs(curr_sched_ctxs, ns, nw, nworkers_per_ctx, workers, curr_nworkers, tw);
+		sc_hypervisor_lp_share_remaining_resources(ns, curr_sched_ctxs, curr_nworkers, workers);
+	}
+	free(tw);
+}
+
+static void greedy_handle_poped_task(unsigned sched_ctx, int worker,
+				     __attribute__((unused))struct starpu_task *task, __attribute__((unused))uint32_t footprint)
+{
+	(void)sched_ctx;
+	if(worker == -2) return;
+	unsigned criteria = sc_hypervisor_get_resize_criteria();
+	if(criteria != SC_NOTHING && criteria == SC_SPEED)
+	{
+		int ret = starpu_pthread_mutex_trylock(&act_hypervisor_mutex);
+		if(ret != EBUSY)
+		{
+			if(sc_hypervisor_check_speed_gap_btw_ctxs(NULL, -1, NULL, -1))
+				_try_resizing(NULL, -1, NULL, -1);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&act_hypervisor_mutex);
+		}
+	}
+}
+
+static void greedy_handle_idle_cycle(unsigned sched_ctx, int worker)
+{
+	unsigned criteria = sc_hypervisor_get_resize_criteria();
+	if(criteria != SC_NOTHING && criteria == SC_IDLE)
+	{
+		int ret = starpu_pthread_mutex_trylock(&act_hypervisor_mutex);
+		if(ret != EBUSY)
+		{
+			if(sc_hypervisor_check_idle(sched_ctx, worker))
+				_try_resizing(NULL, -1, NULL, -1);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&act_hypervisor_mutex);
+		}
+	}
+}
+
+static void greedy_size_ctxs(unsigned *sched_ctxs, int nsched_ctxs, int *workers, int nworkers)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&act_hypervisor_mutex);
+	int ns = sched_ctxs == NULL ? sc_hypervisor_get_nsched_ctxs() : nsched_ctxs;
+	unsigned *curr_sched_ctxs = sched_ctxs == NULL ? sc_hypervisor_get_sched_ctxs() : sched_ctxs;
+	int s;
+	for(s = 0; s < ns; s++)
+		sc_hypervisor_get_wrapper(curr_sched_ctxs[s])->to_be_sized = 1;
+
+	_try_resizing(sched_ctxs, nsched_ctxs, workers, nworkers);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&act_hypervisor_mutex);
+}
+
+static void greedy_resize_ctxs(unsigned *sched_ctxs, int nsched_ctxs, int *workers, int nworkers)
+{
+	int ret = starpu_pthread_mutex_trylock(&act_hypervisor_mutex);
+	if(ret != EBUSY)
+	{
+		_try_resizing(sched_ctxs, nsched_ctxs, workers, nworkers);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&act_hypervisor_mutex);
+	}
+}
+
+struct sc_hypervisor_policy greedy_policy =
+{
+	.size_ctxs = greedy_size_ctxs,
+	.resize_ctxs = greedy_resize_ctxs,
+	.handle_poped_task = greedy_handle_poped_task,
+	.handle_pushed_task = NULL,
+	.handle_idle_cycle = greedy_handle_idle_cycle,
+	.handle_idle_end = NULL,
+	.handle_post_exec_hook = NULL,
+	.handle_submitted_job = NULL,
+	.end_ctx = NULL,
+	.init_worker = NULL,
+	.custom = 0,
+	.name = "greedy"
+};
@@ -18,6 +18,7 @@
 #include "sc_hypervisor_policy.h"
 #include "sc_hypervisor_intern.h"
 #include "sc_hypervisor_lp.h"
+#include <float.h>
 
 static int _compute_priority(unsigned sched_ctx)
 {
@@ -405,6 +406,87 @@ unsigned sc_hypervisor_get_index_for_arch(enum starpu_worker_archtype arch, stru
 	return 0;
 }
 
+/* water-filling: give the workers one by one to the context which would
+ * currently finish last, picking for it the type of worker for which it has
+ * the best speed relative to the other contexts */
+double sc_hypervisor_policy_water_fill(int ns, int nw, double speed[ns][nw], double flops[ns], int total_nw[nw],
+				       int *max_nworkers, double res[ns][nw])
+{
+	int s, w;
+	double capacity[ns];
+	int nworkers[ns];
+	int available[nw];
+	double avg_speed[nw];
+	int nleft = 0;
+
+	for(s = 0; s < ns; s++)
+	{
+		capacity[s] = 0.0;
+		nworkers[s] = 0;
+		for(w = 0; w < nw; w++)
+			res[s][w] = 0.0;
+	}
+
+	for(w = 0; w < nw; w++)
+	{
+		available[w] = total_nw[w];
+		nleft += total_nw[w];
+		avg_speed[w] = 0.0;
+		for(s = 0; s < ns; s++)
+			avg_speed[w] += speed[s][w];
+		avg_speed[w] /= ns;
+	}
+
+	while(nleft > 0)
+	{
+		int slowest = -1;
+		double slowest_time = -1.0;
+		for(s = 0; s < ns; s++)
+		{
+			if(flops[s] <= 0.0)
+				continue;
+			if(max_nworkers && max_nworkers[s] >= 0 && nworkers[s] >= max_nworkers[s])
+				continue;
+			double time = capacity[s] > 0.0 ? flops[s] / capacity[s] : DBL_MAX;
+			if(time > slowest_time)
+			{
+				slowest_time = time;
+				slowest = s;
+			}
+		}
+		if(slowest == -1)
+			break;
+
+		int best_type = -1;
+		double best_ratio = -1.0;
+		for(w = 0; w < nw; w++)
+		{
+			if(available[w] == 0)
+				continue;
+			double ratio = avg_speed[w] > 0.0 ? speed[slowest][w] / avg_speed[w] : 0.0;
+			if(ratio > best_ratio)
+			{
+				best_ratio = ratio;
+				best_type = w;
+			}
+		}
+
+		res[slowest][best_type] += 1.0;
+		capacity[slowest] += speed[slowest][best_type];
+		nworkers[slowest]++;
+		available[best_type]--;
+		nleft--;
+	}
+
+	double tmax = -1.0;
+	for(s = 0; s < ns; s++)
+	{
+		if(flops[s] > 0.0 && capacity[s] > 0.0 && flops[s] / capacity[s] > tmax)
+			tmax = flops[s] / capacity[s];
+	}
+	return tmax;
+}
+
 void sc_hypervisor_get_tasks_times(int nw, int nt, double times[nw][nt], int *workers, unsigned size_ctxs, struct sc_hypervisor_policy_task_pool *task_pools)
 {
 	struct sc_hypervisor_policy_task_pool *tp;
@@ -46,6 +46,7 @@ extern struct sc_hypervisor_policy throughput_lp_policy;
 extern struct sc_hypervisor_policy ispeed_policy;
 extern struct sc_hypervisor_policy hard_coded_policy;
 extern struct sc_hypervisor_policy perf_count_policy;
+extern struct sc_hypervisor_policy greedy_policy;
 
 
 static struct sc_hypervisor_policy *predefined_policies[] =
@@ -61,7 +62,8 @@ static struct sc_hypervisor_policy *predefined_policies[] =
 	&gflops_rate_policy,
 	&ispeed_policy,
 	&hard_coded_policy,
-	&perf_count_policy
+	&perf_count_policy,
+	&greedy_policy
 };
 
 static void _load_hypervisor_policy(struct sc_hypervisor_policy *policy)
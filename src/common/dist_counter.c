@@ -0,0 +1,257 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <limits.h>
+#include <common/dist_counter.h>
+#include <common/thread.h>
+
+void _starpu_dist_counter_init(struct _starpu_dist_counter *counter)
+{
+	unsigned i;
+
+	counter->nslots = STARPU_NMAXWORKERS + STARPU_DIST_COUNTER_NEXTRA;
+	_STARPU_CALLOC(counter->slots, counter->nslots, sizeof(counter->slots[0]));
+	for (i = 0; i < counter->nslots; i++)
+	{
+		_starpu_spin_init(&counter->slots[i].flops_lock);
+		STARPU_HG_DISABLE_CHECKING(counter->slots[i].incs);
+		STARPU_HG_DISABLE_CHECKING(counter->slots[i].decs);
+	}
+	counter->nwaiters = 0;
+	counter->threshold = 0;
+	counter->pending = 0;
+	STARPU_HG_DISABLE_CHECKING(counter->nwaiters);
+	STARPU_HG_DISABLE_CHECKING(counter->threshold);
+	STARPU_HG_DISABLE_CHECKING(counter->pending);
+	STARPU_PTHREAD_MUTEX_INIT(&counter->mutex, NULL);
+	STARPU_PTHREAD_COND_INIT(&counter->cond, NULL);
+}
+
+void _starpu_dist_counter_destroy(struct _starpu_dist_counter *counter)
+{
+	unsigned i;
+
+	for (i = 0; i < counter->nslots; i++)
+		_starpu_spin_destroy(&counter->slots[i].flops_lock);
+	free(counter->slots);
+	counter->slots = NULL;
+	STARPU_PTHREAD_MUTEX_DESTROY(&counter->mutex);
+	STARPU_PTHREAD_COND_DESTROY(&counter->cond);
+}
+
+static struct _starpu_dist_counter_slot *_starpu_dist_counter_get_slot(struct _starpu_dist_counter *counter)
+{
+	int workerid = starpu_worker_get_id();
+	uintptr_t self;
+
+	if (workerid >= 0)
+		return &counter->slots[workerid];
+
+	/* Not a worker, hash the thread over the extra slots */
+	self = (uintptr_t) starpu_pthread_self();
+	self ^= self >> 17;
+	self *= 0x9e3779b1UL;
+	return &counter->slots[STARPU_NMAXWORKERS + (self >> 7) % STARPU_DIST_COUNTER_NEXTRA];
+}
+
+static void _starpu_dist_counter_add_flops(struct _starpu_dist_counter_slot *slot, double flops)
+{
+	_starpu_spin_lock(&slot->flops_lock);
+	slot->flops += flops;
+	_starpu_spin_unlock(&slot->flops_lock);
+}
+
+void _starpu_dist_counter_increment(struct _starpu_dist_counter *counter, double flops)
+{
+	struct _starpu_dist_counter_slot *slot = _starpu_dist_counter_get_slot(counter);
+
+	if (flops != 0.)
+		_starpu_dist_counter_add_flops(slot, flops);
+	(void) STARPU_ATOMIC_ADDL(&slot->incs, 1);
+}
+
+unsigned _starpu_dist_counter_get(struct _starpu_dist_counter *counter)
+{
+	/* Only the slots of the workers which were actually started can be used */
+	unsigned nworkers = starpu_worker_get_count();
+	unsigned long incs = 0, decs = 0;
+	unsigned i;
+
+	/* Each decrement is preceded by its increment, so reading all
+	 * decrements first can only make us overestimate */
+	STARPU_SYNCHRONIZE();
+	for (i = 0; i < nworkers; i++)
+		decs += *(volatile unsigned long *) &counter->slots[i].decs;
+	for (i = STARPU_NMAXWORKERS; i < counter->nslots; i++)
+		decs += *(volatile unsigned long *) &counter->slots[i].decs;
+	STARPU_RMB();
+	for (i = 0; i < nworkers; i++)
+		incs += *(volatile unsigned long *) &counter->slots[i].incs;
+	for (i = STARPU_NMAXWORKERS; i < counter->nslots; i++)
+		incs += *(volatile unsigned long *) &counter->slots[i].incs;
+
+	return incs - decs;
+}
+
+/* Same as _starpu_dist_counter_get, but reading all increments before all
+ * decrements, so that the result is never higher than the value at the time
+ * of the call */
+static unsigned _starpu_dist_counter_get_lower(struct _starpu_dist_counter *counter)
+{
+	unsigned nworkers = starpu_worker_get_count();
+	unsigned long incs = 0, decs = 0;
+	unsigned i;
+
+	STARPU_SYNCHRONIZE();
+	for (i = 0; i < nworkers; i++)
+		incs += *(volatile unsigned long *) &counter->slots[i].incs;
+	for (i = STARPU_NMAXWORKERS; i < counter->nslots; i++)
+		incs += *(volatile unsigned long *) &counter->slots[i].incs;
+	STARPU_RMB();
+	for (i = 0; i < nworkers; i++)
+		decs += *(volatile unsigned long *) &counter->slots[i].decs;
+	for (i = STARPU_NMAXWORKERS; i < counter->nslots; i++)
+		decs += *(volatile unsigned long *) &counter->slots[i].decs;
+
+	if (decs > incs)
+		return 0;
+	return incs - decs;
+}
+
+/* Set the number of decrements needed before the counter may go down to the
+ * threshold, to be called with the mutex held. This must not be
+ * overestimated, otherwise the decrement which reaches the threshold would
+ * not wake the waiters up: it is thus computed from a lower bound of the
+ * counter, and the compare-and-swap fails if a decrement happened while we
+ * were reducing the counter, since it might not be accounted in the result */
+static void _starpu_dist_counter_set_pending(struct _starpu_dist_counter *counter)
+{
+	unsigned value;
+	int old, pending;
+
+	do
+	{
+		old = counter->pending;
+		value = _starpu_dist_counter_get_lower(counter);
+		if (value <= counter->threshold)
+			pending = 0;
+		else if (value - counter->threshold > INT_MAX)
+			pending = INT_MAX;
+		else
+			pending = value - counter->threshold;
+	}
+	while (!STARPU_BOOL_COMPARE_AND_SWAP(&counter->pending, old, pending));
+}
+
+void _starpu_dist_counter_decrement(struct _starpu_dist_counter *counter, double flops)
+{
+	struct _starpu_dist_counter_slot *slot = _starpu_dist_counter_get_slot(counter);
+
+	if (flops != 0.)
+		_starpu_dist_counter_add_flops(slot, -flops);
+	/* This is a full barrier, so either we see the waiter registered here,
+	 * or the waiter sees our decrement when it reduces the counter */
+	(void) STARPU_ATOMIC_ADDL(&slot->decs, 1);
+
+	if (!counter->nwaiters)
+		return;
+
+	/* The threshold can not be reached before that many decrements */
+	if (STARPU_ATOMIC_ADD(&counter->pending, -1) > 0)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&counter->mutex);
+	if (_starpu_dist_counter_get(counter) > counter->threshold)
+		/* Increments happened meanwhile, wait for more decrements */
+		_starpu_dist_counter_set_pending(counter);
+	if (_starpu_dist_counter_get(counter) <= counter->threshold)
+	{
+		/* have those not happy enough tell us how much again */
+		counter->threshold = 0;
+		counter->pending = 0;
+		STARPU_PTHREAD_COND_BROADCAST(&counter->cond);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&counter->mutex);
+}
+
+double _starpu_dist_counter_get_flops(struct _starpu_dist_counter *counter)
+{
+	unsigned nworkers = starpu_worker_get_count();
+	double flops = 0.;
+	unsigned i;
+
+	for (i = 0; i < counter->nslots; i++)
+	{
+		struct _starpu_dist_counter_slot *slot;
+		if (i == nworkers)
+			/* Skip the slots of the workers which were not started */
+			i = STARPU_NMAXWORKERS;
+		slot = &counter->slots[i];
+		_starpu_spin_lock(&slot->flops_lock);
+		flops += slot->flops;
+		_starpu_spin_unlock(&slot->flops_lock);
+	}
+	return flops;
+}
+
+static unsigned _starpu_dist_counter_wait(struct _starpu_dist_counter *counter, unsigned n)
+{
+	unsigned ret, value;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&counter->mutex);
+	(void) STARPU_ATOMIC_ADD(&counter->nwaiters, 1);
+	ret = value = _starpu_dist_counter_get(counter);
+	while (value > n)
+	{
+		if (counter->threshold < n)
+			counter->threshold = n;
+		_starpu_dist_counter_set_pending(counter);
+		/* Make sure decrementers see the threshold and the number of
+		 * pending decrements before we check again */
+		STARPU_SYNCHRONIZE();
+		value = _starpu_dist_counter_get(counter);
+		if (value <= n)
+			break;
+		STARPU_PTHREAD_COND_WAIT(&counter->cond, &counter->mutex);
+		value = _starpu_dist_counter_get(counter);
+	}
+	(void) STARPU_ATOMIC_ADD(&counter->nwaiters, -1);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&counter->mutex);
+
+	return ret;
+}
+
+unsigned _starpu_dist_counter_wait_for_empty(struct _starpu_dist_counter *counter)
+{
+	return _starpu_dist_counter_wait(counter, 0);
+}
+
+void _starpu_dist_counter_wait_until_down_to_n(struct _starpu_dist_counter *counter, unsigned n)
+{
+	_starpu_dist_counter_wait(counter, n);
+}
+
+int _starpu_dist_counter_check(struct _starpu_dist_counter *counter)
+{
+	if (_starpu_dist_counter_get(counter) == 0)
+	{
+		STARPU_PTHREAD_MUTEX_LOCK(&counter->mutex);
+		STARPU_PTHREAD_COND_BROADCAST(&counter->cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&counter->mutex);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __DIST_COUNTER_H__
+#define __DIST_COUNTER_H__
+
+/** @file */
+
+/*
+ * Distributed counter: each worker thread updates its own cache-line-padded
+ * slot, and the other threads (application submitters, MPI thread, ...) are
+ * hashed over a few extra slots, so that incrementing and decrementing does
+ * not bounce a shared mutex between all the threads. The value is only
+ * reduced over the slots when somebody asks for it, and the wait functions
+ * get woken up by the decrement which brings the value down to the awaited
+ * threshold. Decrements only reduce the counter once enough of them have
+ * happened since the last reduction for the threshold to be possibly
+ * reached.
+ */
+
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/starpu_spinlock.h>
+
+#pragma GCC visibility push(hidden)
+
+/** Number of slots shared by the threads which are not workers */
+#define STARPU_DIST_COUNTER_NEXTRA 8
+
+struct _starpu_dist_counter_slot
+{
+	/** Number of increments and decrements performed through this slot.
+	 * They only ever grow, so that a reduction which reads all the
+	 * decrements before all the increments never underestimates the value */
+	unsigned long incs;
+	unsigned long decs;
+	/** Sum of the flops, only touched when flops are provided */
+	double flops;
+	struct _starpu_spinlock flops_lock;
+	/** Keep the slots of different threads on different cache lines */
+	char padding[STARPU_CACHELINE_SIZE];
+};
+
+struct _starpu_dist_counter
+{
+	struct _starpu_dist_counter_slot *slots;
+	unsigned nslots;
+
+	/** Number of threads waiting in the wait functions. Decrements only
+	 * reduce the counter when this is non-zero */
+	unsigned nwaiters;
+	/** Largest value awaited by the waiters */
+	unsigned threshold;
+	/** Number of decrements still needed, at least, before the counter
+	 * may go down to the threshold. Decrements only reduce the counter
+	 * when this goes down to 0 or below, which happens to all the
+	 * decrements racing with the one which reduces it */
+	int pending;
+	starpu_pthread_mutex_t mutex;
+	starpu_pthread_cond_t cond;
+};
+
+void _starpu_dist_counter_init(struct _starpu_dist_counter *counter);
+void _starpu_dist_counter_destroy(struct _starpu_dist_counter *counter);
+
+void _starpu_dist_counter_increment(struct _starpu_dist_counter *counter, double flops);
+/** Decrement the counter, and wake the waiters if it goes down to their threshold */
+void _starpu_dist_counter_decrement(struct _starpu_dist_counter *counter, double flops);
+
+/** Reduce the slots. The result is exact when there are no concurrent
+ * increments, and otherwise is not lower than the value at the time of the
+ * call, so that it reaching 0 can be relied on */
+unsigned _starpu_dist_counter_get(struct _starpu_dist_counter *counter);
+double _starpu_dist_counter_get_flops(struct _starpu_dist_counter *counter);
+
+/** Wait for the counter to go down to 0, returns the value at the time of the call */
+unsigned _starpu_dist_counter_wait_for_empty(struct _starpu_dist_counter *counter);
+/** Wait for the counter to go down to \p n */
+void _starpu_dist_counter_wait_until_down_to_n(struct _starpu_dist_counter *counter, unsigned n);
+
+/** Wake the waiters if the counter is 0, and return whether it is */
+int _starpu_dist_counter_check(struct _starpu_dist_counter *counter);
+
+#pragma GCC visibility pop
+
+#endif // __DIST_COUNTER_H__
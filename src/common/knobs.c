@@ -83,6 +83,9 @@ void _starpu_perf_counter_init(struct _starpu_machine_config *pconfig)
 
 	/* call counter registration routines in each modules */
 	_starpu__task_c__register_counters();
+	_starpu__driver_common_c__register_counters();
+	_starpu__latency_c__register_counters();
+	_starpu__critical_path_c__register_counters();
 }
 
 void _starpu_perf_counter_exit(void)
@@ -225,6 +228,7 @@ static void _unregister_counter_scope(enum starpu_perf_counter_scope scope)
 	counters->array = NULL;
 	free(counters->updater_array);
 	counters->updater_array = NULL;
+	counters->updater_array_size = 0;
 	counters->size  = 0;
 }
 
@@ -416,8 +420,10 @@ void starpu_perf_counter_set_all_per_worker_listeners(struct starpu_perf_counter
 
 void starpu_perf_counter_set_per_codelet_listener(struct starpu_codelet *cl, struct starpu_perf_counter_listener *listener)
 {
-	STARPU_ASSERT(cl->perf_counter_values == NULL);
-	_STARPU_CALLOC(cl->perf_counter_values, 1, sizeof(*cl->perf_counter_values));
+	/* the values may already have been allocated by the shared memory exporter */
+	STARPU_ASSERT(cl->perf_counter_values == NULL || cl->perf_counter_values->exported);
+	if (cl->perf_counter_values == NULL)
+		_STARPU_CALLOC(cl->perf_counter_values, 1, sizeof(*cl->perf_counter_values));
 
 	STARPU_ASSERT(cl->perf_counter_sample == NULL);
 	_STARPU_MALLOC(cl->perf_counter_sample, sizeof(*cl->perf_counter_sample));
@@ -467,8 +473,11 @@ void starpu_perf_counter_unset_per_codelet_listener(struct starpu_codelet *cl)
 	_starpu_perf_counter_sample_exit(cl->perf_counter_sample);
 	free(cl->perf_counter_sample);
 	cl->perf_counter_sample = NULL;
-	free(cl->perf_counter_values);
-	cl->perf_counter_values = NULL;
+	if (!cl->perf_counter_values->exported)
+	{
+		free(cl->perf_counter_values);
+		cl->perf_counter_values = NULL;
+	}
 }
 
 /* - */
@@ -527,9 +536,26 @@ void _starpu_perf_counter_update_per_worker_sample(unsigned workerid)
 
 void _starpu_perf_counter_update_per_codelet_sample(struct starpu_codelet *cl)
 {
+	/* the codelet may only be monitored by the shared memory exporter */
+	if (cl->perf_counter_sample == NULL)
+		return;
 	update_sample(cl->perf_counter_sample, cl);
 }
 
+/* Fill the values of a sample which is not plugged on any StarPU object, by
+ * calling the updaters of its scope, without calling the listener callback */
+void _starpu_perf_counter_sample_fill(struct starpu_perf_counter_sample *sample, void *context)
+{
+	struct perf_counter_array *counters = _get_counters(sample->scope);
+	STARPU_ASSERT(sample->listener != NULL && sample->listener->set != NULL);
+
+	int upd_id;
+	for (upd_id = 0; upd_id < counters->updater_array_size; upd_id++)
+	{
+		counters->updater_array[upd_id](sample, context);
+	}
+}
+
 #define STARPU_PERF_COUNTER_SAMPLE_GET_TYPED_VALUE(STRING, TYPE) \
 TYPE starpu_perf_counter_sample_get_##STRING##_value(struct starpu_perf_counter_sample *sample, const int counter_id) \
 { \
@@ -206,6 +206,8 @@ struct starpu_perf_counter_sample_cl_values
 		starpu_perf_counter_int64_t total_executed;
 		starpu_perf_counter_double cumul_execution_time;
 	} task;
+	/* whether these values are owned by the shared memory exporter */
+	unsigned exported;
 };
 
 typedef void (*starpu_perf_counter_sample_updater)(struct starpu_perf_counter_sample *sample, void *context);
@@ -243,6 +245,7 @@ void _starpu_perf_counter_register_updater(enum starpu_perf_counter_scope scope,
 void _starpu_perf_counter_update_global_sample(void);
 void _starpu_perf_counter_update_per_worker_sample(unsigned workerid);
 void _starpu_perf_counter_update_per_codelet_sample(struct starpu_codelet *cl);
+void _starpu_perf_counter_sample_fill(struct starpu_perf_counter_sample *sample, void *context);
 
 #define __STARPU_PERF_COUNTER_SAMPLE_SET_TYPED_VALUE(STRING, TYPE) \
 static inline void _starpu_perf_counter_sample_set_##STRING##_value(struct starpu_perf_counter_sample *sample, const int counter_id, const TYPE value) \
@@ -285,6 +288,9 @@ extern starpu_perf_counter_int64_t _starpu_task__g_current_ready__value;
 
 /* performance counter registration routines per modules */
 void _starpu__task_c__register_counters(void);	/* module: task.c */
+void _starpu__driver_common_c__register_counters(void);	/* module: driver_common.c */
+void _starpu__latency_c__register_counters(void);	/* module: latency.c */
+void _starpu__critical_path_c__register_counters(void);	/* module: critical_path.c */
 
 
 /* -------------------------------------------------------------------- */
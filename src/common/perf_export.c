@@ -0,0 +1,415 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Export of the performance counters in a shared memory region.
+ *
+ * The workers keep updating the counters as usual, without any listener. A
+ * dedicated thread periodically collects them through the sample updaters
+ * of each scope, and copies them into the value blocks of the region, each
+ * of them being protected by a sequence lock so that external readers never
+ * block the thread, and never get a torn block. The layout of the region is
+ * described in starpu_perf_monitoring.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/starpu_spinlock.h>
+#include <core/workers.h>
+#include <common/knobs.h>
+#include <common/perf_export.h>
+
+#if defined(HAVE_MMAP) && !defined(STARPU_SIMGRID)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#endif
+
+int _starpu_perf_export_enabled;
+
+#if defined(HAVE_MMAP) && !defined(STARPU_SIMGRID)
+
+#define EXPORT_ALIGN 64
+#define EXPORT_ROUND(size) (((size) + EXPORT_ALIGN - 1) & ~((size_t) EXPORT_ALIGN - 1))
+
+static const enum starpu_perf_counter_scope export_scope_ids[STARPU_PERF_EXPORT_NSCOPES] =
+{
+	[STARPU_PERF_EXPORT_GLOBAL] = starpu_perf_counter_scope_global,
+	[STARPU_PERF_EXPORT_PER_WORKER] = starpu_perf_counter_scope_per_worker,
+	[STARPU_PERF_EXPORT_PER_CODELET] = starpu_perf_counter_scope_per_codelet,
+};
+
+/* Counters of a scope, with the private sample in which they are collected
+ * before being copied to the region */
+struct export_scope
+{
+	int ncounters;
+	enum starpu_perf_counter_type *types;
+	struct starpu_perf_counter_set *set;
+	struct starpu_perf_counter_listener *listener;
+	struct starpu_perf_counter_sample sample;
+	char *blocks;
+	size_t block_size;
+};
+
+static struct export_scope export_scopes[STARPU_PERF_EXPORT_NSCOPES];
+static struct starpu_perf_export_header *header;
+static size_t region_size;
+static char region_name[256];
+static unsigned export_period;
+
+static starpu_pthread_t export_thread;
+static starpu_pthread_mutex_t export_mutex;
+static starpu_pthread_cond_t export_cond;
+static int export_stop;
+
+/* Codelets whose counters are exported, protected by export_mutex. They are
+ * read until _starpu_perf_export_shutdown(), the application must thus not
+ * free them before starpu_shutdown() */
+static struct starpu_codelet **codelets;
+static unsigned ncodelets;
+static unsigned max_codelets;
+static int codelets_full;
+
+static struct starpu_perf_export_block *_get_block(int scope, unsigned i)
+{
+	return (struct starpu_perf_export_block *) (export_scopes[scope].blocks + i * export_scopes[scope].block_size);
+}
+
+static void _publish_block(int scope, unsigned i, void *context, double now)
+{
+	struct export_scope *s = &export_scopes[scope];
+	struct starpu_perf_export_block *block = _get_block(scope, i);
+	union starpu_perf_export_value *values = (union starpu_perf_export_value *) (block + 1);
+
+	_starpu_perf_counter_sample_fill(&s->sample, context);
+
+	/* we are the only writer, readers retry while the sequence is odd or changed */
+	block->seq++;
+	STARPU_WMB();
+	block->timestamp = now;
+	int c;
+	for (c = 0; c < s->ncounters; c++)
+	{
+		switch (s->types[c])
+		{
+			case starpu_perf_counter_type_int32:
+				values[c].int32_val = s->sample.value_array[c].int32_val;
+				break;
+			case starpu_perf_counter_type_int64:
+				values[c].int64_val = s->sample.value_array[c].int64_val;
+				break;
+			case starpu_perf_counter_type_float:
+				values[c].float_val = s->sample.value_array[c].float_val;
+				break;
+			case starpu_perf_counter_type_double:
+				values[c].double_val = s->sample.value_array[c].double_val;
+				break;
+			default:
+				STARPU_ABORT();
+		}
+	}
+	STARPU_WMB();
+	block->seq++;
+}
+
+static void _publish_all(void)
+{
+	double now = starpu_timing_now();
+	unsigned i;
+
+	_publish_block(STARPU_PERF_EXPORT_GLOBAL, 0, NULL, now);
+	for (i = 0; i < header->nworkers; i++)
+		_publish_block(STARPU_PERF_EXPORT_PER_WORKER, i, _starpu_get_worker_struct(i), now);
+
+	unsigned n = header->ncodelets;
+	STARPU_RMB();
+	for (i = 0; i < n; i++)
+		_publish_block(STARPU_PERF_EXPORT_PER_CODELET, i, codelets[i], now);
+}
+
+static void *_perf_export_func(void *arg)
+{
+	(void) arg;
+	starpu_pthread_setname("perf_export");
+
+	STARPU_PTHREAD_MUTEX_LOCK(&export_mutex);
+	while (!export_stop)
+	{
+		struct timeval tv;
+		struct timespec abstime;
+		gettimeofday(&tv, NULL);
+		abstime.tv_sec = tv.tv_sec + export_period / 1000;
+		abstime.tv_nsec = tv.tv_usec * 1000 + (export_period % 1000) * 1000000;
+		if (abstime.tv_nsec >= 1000000000)
+		{
+			abstime.tv_sec++;
+			abstime.tv_nsec -= 1000000000;
+		}
+
+		int ret = starpu_pthread_cond_timedwait(&export_cond, &export_mutex, &abstime);
+		STARPU_ASSERT_MSG(ret == 0 || ret == ETIMEDOUT, "starpu_pthread_cond_timedwait: %s", strerror(ret));
+		if (export_stop)
+			break;
+
+		STARPU_PTHREAD_MUTEX_UNLOCK(&export_mutex);
+		_publish_all();
+		STARPU_PTHREAD_MUTEX_LOCK(&export_mutex);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&export_mutex);
+	return NULL;
+}
+
+void _starpu_perf_export_init(void)
+{
+	const char *name = starpu_getenv("STARPU_PERF_COUNTER_EXPORT");
+	if (name == NULL || name[0] == '\0')
+		return;
+
+	snprintf(region_name, sizeof(region_name), "%s%s", name[0] == '/' ? "" : "/", name);
+	int period = starpu_getenv_number_default("STARPU_PERF_COUNTER_EXPORT_PERIOD", 100);
+	export_period = period > 0 ? period : 1;
+	int max = starpu_getenv_number_default("STARPU_PERF_COUNTER_EXPORT_MAX_CODELETS", 64);
+	max_codelets = max > 0 ? max : 0;
+	unsigned nworkers = starpu_worker_get_count();
+	unsigned nblocks[STARPU_PERF_EXPORT_NSCOPES] = { 1, nworkers, max_codelets };
+
+	/* compute the layout of the region */
+	int s, c;
+	int total_ncounters = 0;
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+	{
+		export_scopes[s].ncounters = starpu_perf_counter_nb(export_scope_ids[s]);
+		total_ncounters += export_scopes[s].ncounters;
+	}
+	size_t counters_offset = EXPORT_ROUND(sizeof(struct starpu_perf_export_header));
+	size_t offset = EXPORT_ROUND(counters_offset + total_ncounters * sizeof(struct starpu_perf_export_counter));
+	size_t blocks_offset[STARPU_PERF_EXPORT_NSCOPES];
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+	{
+		/* separate cache lines, so that readers of a block do not disturb the update of another one */
+		export_scopes[s].block_size = EXPORT_ROUND(sizeof(struct starpu_perf_export_block) + export_scopes[s].ncounters * sizeof(union starpu_perf_export_value));
+		blocks_offset[s] = offset;
+		offset += nblocks[s] * export_scopes[s].block_size;
+	}
+	region_size = offset;
+
+	int fd = shm_open(region_name, O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		_STARPU_DISP("Could not create shared memory region %s to export performance counters: %s\n", region_name, strerror(errno));
+		return;
+	}
+	if (ftruncate(fd, region_size) < 0)
+	{
+		_STARPU_DISP("Could not allocate shared memory region %s to export performance counters: %s\n", region_name, strerror(errno));
+		close(fd);
+		shm_unlink(region_name);
+		return;
+	}
+	void *addr = mmap(NULL, region_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		_STARPU_DISP("Could not map shared memory region %s to export performance counters: %s\n", region_name, strerror(errno));
+		shm_unlink(region_name);
+		return;
+	}
+	header = addr;
+
+	/* describe the counters, and prepare the samples in which they are collected */
+	struct starpu_perf_export_counter *descr = (struct starpu_perf_export_counter *) ((char *) addr + counters_offset);
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+	{
+		struct export_scope *scope = &export_scopes[s];
+		scope->blocks = (char *) addr + blocks_offset[s];
+		scope->set = starpu_perf_counter_set_alloc(export_scope_ids[s]);
+		_STARPU_MALLOC(scope->types, scope->ncounters * sizeof(*scope->types));
+		for (c = 0; c < scope->ncounters; c++)
+		{
+			int id = starpu_perf_counter_nth_to_id(export_scope_ids[s], c);
+			starpu_perf_counter_set_enable_id(scope->set, id);
+			scope->types[c] = starpu_perf_counter_get_type_id(id);
+			snprintf(descr->name, sizeof(descr->name), "%s", starpu_perf_counter_id_to_name(id));
+			descr->id = id;
+			descr->type = scope->types[c];
+			descr++;
+		}
+		scope->listener = starpu_perf_counter_listener_init(scope->set, NULL, NULL);
+		_starpu_perf_counter_sample_init(&scope->sample, export_scope_ids[s]);
+		scope->sample.listener = scope->listener;
+		_STARPU_CALLOC(scope->sample.value_array, scope->set->size, sizeof(*scope->sample.value_array));
+	}
+
+	snprintf(_get_block(STARPU_PERF_EXPORT_GLOBAL, 0)->name, STARPU_PERF_EXPORT_NAME_LEN, "global");
+	unsigned i;
+	for (i = 0; i < nworkers; i++)
+		starpu_worker_get_name(i, _get_block(STARPU_PERF_EXPORT_PER_WORKER, i)->name, STARPU_PERF_EXPORT_NAME_LEN);
+
+	_STARPU_CALLOC(codelets, max_codelets ? max_codelets : 1, sizeof(*codelets));
+	ncodelets = 0;
+	codelets_full = 0;
+
+	header->version = STARPU_PERF_EXPORT_VERSION;
+	header->header_size = sizeof(*header);
+	header->size = region_size;
+	header->pid = getpid();
+	header->period = export_period;
+	header->running = 1;
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+	{
+		header->ncounters[s] = export_scopes[s].ncounters;
+		header->blocks_offset[s] = blocks_offset[s];
+		header->block_size[s] = export_scopes[s].block_size;
+	}
+	header->nworkers = nworkers;
+	header->max_codelets = max_codelets;
+	header->ncodelets = 0;
+	header->counters_offset = counters_offset;
+
+	/* the counters are not updated while their collection is paused */
+	starpu_perf_counter_collection_start();
+	_publish_all();
+
+	/* readers consider the region only once the magic is set */
+	STARPU_WMB();
+	memcpy(header->magic, STARPU_PERF_EXPORT_MAGIC, sizeof(header->magic));
+
+	STARPU_PTHREAD_MUTEX_INIT(&export_mutex, NULL);
+	STARPU_PTHREAD_COND_INIT(&export_cond, NULL);
+	export_stop = 0;
+	STARPU_WMB();
+	_starpu_perf_export_enabled = 1;
+	STARPU_PTHREAD_CREATE(&export_thread, NULL, _perf_export_func, NULL);
+}
+
+void _starpu_perf_export_shutdown(void)
+{
+	if (!_starpu_perf_export_enabled)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&export_mutex);
+	export_stop = 1;
+	STARPU_PTHREAD_COND_SIGNAL(&export_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&export_mutex);
+	STARPU_PTHREAD_JOIN(export_thread, NULL);
+
+	/* publish the final values */
+	_publish_all();
+	STARPU_WMB();
+	header->running = 0;
+
+	_starpu_perf_export_enabled = 0;
+	starpu_perf_counter_collection_stop();
+
+	unsigned i;
+	for (i = 0; i < ncodelets; i++)
+	{
+		struct starpu_codelet *cl = codelets[i];
+		if (cl->perf_counter_sample == NULL)
+		{
+			free(cl->perf_counter_values);
+			cl->perf_counter_values = NULL;
+		}
+		else
+			/* let the listener free them */
+			cl->perf_counter_values->exported = 0;
+	}
+	free(codelets);
+	codelets = NULL;
+
+	int s;
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+	{
+		struct export_scope *scope = &export_scopes[s];
+		scope->sample.listener = NULL;
+		_starpu_perf_counter_sample_exit(&scope->sample);
+		starpu_perf_counter_listener_exit(scope->listener);
+		starpu_perf_counter_set_free(scope->set);
+		free(scope->types);
+		memset(scope, 0, sizeof(*scope));
+	}
+
+	munmap(header, region_size);
+	header = NULL;
+	shm_unlink(region_name);
+
+	STARPU_PTHREAD_MUTEX_DESTROY(&export_mutex);
+	STARPU_PTHREAD_COND_DESTROY(&export_cond);
+}
+
+void _starpu_perf_export_register_codelet(struct starpu_codelet *cl)
+{
+	if (codelets_full)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&export_mutex);
+	/* another thread may have registered it meanwhile */
+	if (cl->perf_counter_values == NULL || !cl->perf_counter_values->exported)
+	{
+		if (ncodelets == max_codelets)
+		{
+			_STARPU_DISP("The performance counters of only %u codelets are exported, STARPU_PERF_COUNTER_EXPORT_MAX_CODELETS can be used to increase this number\n", max_codelets);
+			codelets_full = 1;
+		}
+		else
+		{
+			const char *name = cl->name;
+			if (name == NULL && cl->model != NULL)
+				name = cl->model->symbol;
+			snprintf(_get_block(STARPU_PERF_EXPORT_PER_CODELET, ncodelets)->name, STARPU_PERF_EXPORT_NAME_LEN, "%s", name ? name : "unknown");
+
+			/* the values may have already been allocated for a per-codelet listener */
+			struct starpu_perf_counter_sample_cl_values *values = cl->perf_counter_values;
+			if (values == NULL)
+				_STARPU_CALLOC(values, 1, sizeof(*values));
+			values->exported = 1;
+			STARPU_WMB();
+
+			/* the export thread reads the values as soon as the
+			 * codelet is published */
+			cl->perf_counter_values = values;
+			codelets[ncodelets++] = cl;
+			STARPU_WMB();
+			header->ncodelets = ncodelets;
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&export_mutex);
+}
+
+#else /* !HAVE_MMAP || STARPU_SIMGRID */
+
+void _starpu_perf_export_init(void)
+{
+	if (starpu_getenv("STARPU_PERF_COUNTER_EXPORT"))
+		_STARPU_DISP("Exporting performance counters in shared memory is not supported in this build\n");
+}
+
+void _starpu_perf_export_shutdown(void)
+{
+}
+
+void _starpu_perf_export_register_codelet(struct starpu_codelet *cl)
+{
+	(void) cl;
+}
+
+#endif /* !HAVE_MMAP || STARPU_SIMGRID */
@@ -0,0 +1,44 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* Export of the performance counters in a shared memory region */
+
+#ifndef __PERF_EXPORT_H__
+#define __PERF_EXPORT_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <common/config.h>
+
+#pragma GCC visibility push(hidden)
+
+/** Whether the performance counters are exported, i.e. STARPU_PERF_COUNTER_EXPORT is set */
+extern int _starpu_perf_export_enabled;
+
+/** Create the shared memory region and start the thread which periodically
+ * publishes the counters in it. To be called once the workers are launched. */
+void _starpu_perf_export_init(void);
+/** Publish the counters a last time, stop the exporting thread and remove
+ * the shared memory region. To be called before the workers are terminated. */
+void _starpu_perf_export_shutdown(void);
+
+/** Make the per-codelet counters of the codelet be collected and exported */
+void _starpu_perf_export_register_codelet(struct starpu_codelet *cl);
+
+#pragma GCC visibility pop
+
+#endif // __PERF_EXPORT_H__
@@ -1102,6 +1102,32 @@ void _starpu_pthread_spin_do_unlock(starpu_pthread_spinlock_t *lock)
 
 #endif /* defined(STARPU_SIMGRID) || (defined(STARPU_LINUX_SYS) && defined(STARPU_HAVE_XCHG)) || !defined(STARPU_HAVE_PTHREAD_SPIN_LOCK) */
 
+#ifdef STARPU_HAVE_FUTEX_PARKING
+void _starpu_futex_park(unsigned *addr, unsigned val, unsigned long timeout_us)
+{
+	struct timespec timeout =
+	{
+		.tv_sec = timeout_us / 1000000,
+		.tv_nsec = (timeout_us % 1000000) * 1000
+	};
+
+	/* EAGAIN (*addr != val), EINTR and ETIMEDOUT are all fine */
+	if (syscall(SYS_futex, addr, _starpu_futex_wait, val, &timeout, NULL, 0) == -1 && errno == ENOSYS)
+		_starpu_futex_wait = FUTEX_WAIT;
+}
+
+void _starpu_futex_unpark(unsigned *addr)
+{
+	if (syscall(SYS_futex, addr, _starpu_futex_wake, INT_MAX, NULL, NULL, 0) == -1)
+	{
+		STARPU_ASSERT_MSG(errno == ENOSYS, "futex(wake) returned %d!", errno);
+		_starpu_futex_wake = FUTEX_WAKE;
+		if (syscall(SYS_futex, addr, _starpu_futex_wake, INT_MAX, NULL, NULL, 0) == -1)
+			STARPU_ASSERT_MSG(0, "futex(wake) returned %d!", errno);
+	}
+}
+#endif
+
 #ifdef STARPU_SIMGRID
 
 int starpu_sem_destroy(starpu_sem_t *sem)
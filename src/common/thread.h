@@ -24,6 +24,16 @@
 
 #pragma GCC visibility push(hidden)
 
+#if !defined(STARPU_SIMGRID) && !defined(STARPU_NON_BLOCKING_DRIVERS) && defined(STARPU_LINUX_SYS) && defined(STARPU_HAVE_XCHG)
+/** Idle workers can park on a futex, see _starpu_get_worker_task() */
+#define STARPU_HAVE_FUTEX_PARKING 1
+/** Block while *addr is \p val, for at most \p timeout_us microseconds.
+ * May return early, callers have to check *addr again */
+void _starpu_futex_park(unsigned *addr, unsigned val, unsigned long timeout_us);
+/** Wake all the threads blocked in _starpu_futex_park() on \p addr */
+void _starpu_futex_unpark(unsigned *addr);
+#endif
+
 #if defined(STARPU_LINUX_SYS) && defined(STARPU_HAVE_XCHG)
 int _starpu_pthread_spin_do_lock(starpu_pthread_spinlock_t *lock) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 #endif
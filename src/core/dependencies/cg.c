@@ -21,6 +21,8 @@
 #include <core/task.h>
 #include <core/dependencies/cg.h>
 #include <core/dependencies/tags.h>
+#include <core/workers.h>
+#include <profiling/critical_path.h>
 
 void _starpu_cg_list_init0(struct _starpu_cg_list *list)
 {
@@ -169,9 +171,42 @@ int _starpu_list_tag_successors_in_cg_list(struct _starpu_cg_list *successors, u
 	return n;
 }
 
+/* Let the job waiting for the cg inherit the chain of the task being
+ * terminated, if it is longer than those of its other predecessors. This has
+ * to be done for every predecessor, and before decrementing remaining, after
+ * which the job may get started by the last predecessor. */
+static void _starpu_notify_cg_critical_path(struct _starpu_cg *cg)
+{
+	struct _starpu_job *j = NULL;
+
+	if (cg->cg_type == STARPU_CG_TASK)
+		j = cg->succ.job;
+	else if (cg->cg_type == STARPU_CG_TAG)
+	{
+		struct _starpu_tag *tag = cg->succ.tag;
+
+		/* The job of a blocked tag is not started before all the
+		 * cgs of the tag are notified */
+		_starpu_spin_lock(&tag->lock);
+		if (tag->state == STARPU_ASSOCIATED || tag->state == STARPU_BLOCKED)
+			j = tag->job;
+		_starpu_spin_unlock(&tag->lock);
+	}
+
+	if (!j)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&j->sync_mutex);
+	_starpu_critical_path_job_released(j);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
+}
+
 void _starpu_notify_cg(void *pred STARPU_ATTRIBUTE_UNUSED, struct _starpu_cg *cg)
 {
 	STARPU_ASSERT(cg);
+	if (!_starpu_perf_counter_paused())
+		_starpu_notify_cg_critical_path(cg);
+
 	unsigned remaining = STARPU_ATOMIC_ADD(&cg->remaining, -1);
 	ANNOTATE_HAPPENS_BEFORE(&cg->remaining);
 
@@ -25,8 +25,10 @@
 #include <common/utils.h>
 #include <common/graph.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/prefetch_lookahead.h>
 #include <profiling/profiling.h>
 #include <profiling/bound.h>
+#include <profiling/critical_path.h>
 #include <core/debug.h>
 #include <limits.h>
 #include <core/workers.h>
@@ -191,6 +193,9 @@ void _starpu_job_destroy(struct _starpu_job *j)
 		STARPU_ASSERT(j->after_work_busy_barrier == 0);
 	}
 
+	if (j->lookahead_entry)
+		_starpu_prefetch_lookahead_drop(j);
+
 	_starpu_cg_list_deinit(&j->job_successors);
 	if (j->dyn_ordered_buffers)
 	{
@@ -206,6 +211,8 @@ void _starpu_job_destroy(struct _starpu_job *j)
 	if (_starpu_graph_record && j->graph_node)
 		_starpu_graph_drop_job(j);
 
+	free(j->critical_path);
+
 	if (max_memory_use)
 		(void) STARPU_ATOMIC_ADDL(&njobs, -1);
 
@@ -504,6 +511,12 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 	if (!callback && task->cl)
 		callback = task->cl->callback_func;
 
+	/* The successors released below inherit the critical path of the task */
+	const int track_critical_path = !continuation && !_starpu_perf_counter_paused();
+	void *notifying_critical_path = NULL;
+	if (track_critical_path)
+		notifying_critical_path = _starpu_critical_path_job_start_notify(j);
+
 	/* If this is a continuation, we do not release task dependencies now.
 	 * Task dependencies will be released only when the continued task
 	 * fully completes */
@@ -540,7 +553,13 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 		if (end_rdep)
 			starpu_task_end_dep_release(end_rdep);
 		_starpu_notify_dependencies(j);
+	}
 
+	if (track_critical_path)
+		_starpu_critical_path_job_end_notify(j, notifying_critical_path);
+
+	if (!continuation)
+	{
 		/* If this is a continuation, we do not execute the callback
 		 * now. The callback will be executed only when the continued
 		 * task fully completes */
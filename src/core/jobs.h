@@ -163,6 +163,17 @@ struct _starpu_job
 	double cumulated_energy_consumed;
 #endif
 
+	/** Date when the task became ready, and when the worker started
+	 * fetching its data, to record the latency histograms */
+	double latency_ready_date;
+	double latency_fetch_date;
+	/** Time the task waited for a worker and for its data, for the
+	 * critical path tracker */
+	double latency_queue_delay;
+	double latency_fetch_delay;
+	/** Longest chain of tasks leading to this task */
+	struct _starpu_critical_path *critical_path;
+
 	/** The value of the footprint that identifies the job may be stored in
 	 * this structure. */
 	uint32_t footprint;
@@ -209,6 +220,10 @@ struct _starpu_job
 
 	struct _starpu_graph_node *graph_node;
 
+	/** Entry in the window of the lookahead prefetch engine, if any, or whose
+	 * prefetch references are kept while the task fetches its data */
+	struct _starpu_lookahead_entry *lookahead_entry;
+
 #ifdef STARPU_DEBUG
 	/** Linked-list of all jobs, for debugging */
 	struct _starpu_job_multilist_all_submitted all_submitted;
@@ -269,6 +269,106 @@ void starpu_validate_mlr(double *coeff, unsigned ncoeff, const char *codelet_nam
 			_STARPU_DISP("Warning: Coefficient computed by least square method is extremely small (%f). The model %s is likely to be inaccurate.\n", coeff[i], codelet_name);
 }
 
+/* Initial covariance of the recursive least squares estimation, i.e. we have
+ * no idea of the coefficients yet */
+#define RLS_DELTA 1e12
+
+/*
+ * Recursive least squares: instead of solving the whole system again, update
+ * the coefficients theta and the inverse P of the weighted X^T X matrix
+ * with each new sample (x, y), in O(ncoeff^2):
+ *
+ *	k = P x / (lambda + x^T P x)
+ *	theta += k (y - theta^T x)
+ *	P = (P - k x^T P) / lambda
+ *
+ * With a forgetting factor lambda < 1, older samples get weighted down
+ * geometrically, so that the model follows changes of the machine behavior.
+ */
+void _starpu_multiple_regression_rls_update(struct starpu_perfmodel_regression_model *reg_model, struct _starpu_perfmodel_rls *rls, const double *parameters, double duration, unsigned nparameters, unsigned ncombinations, unsigned **combinations, double lambda)
+{
+	unsigned ncoeff = ncombinations + 1;
+	unsigned i, j, k;
+
+	if (reg_model->ncoeff != ncoeff)
+	{
+		/* The combinations changed, the coefficients are meaningless */
+		free(reg_model->coeff);
+		reg_model->coeff = NULL;
+		reg_model->ncoeff = ncoeff;
+		reg_model->multi_valid = 0;
+	}
+	if (rls->ncoeff != ncoeff)
+	{
+		free(rls->theta);
+		rls->theta = NULL;
+		free(rls->p);
+		rls->p = NULL;
+		rls->ncoeff = ncoeff;
+	}
+	if (!rls->p)
+	{
+		/* Possibly start from coefficients computed by the batch
+		 * regression, but do not trust them. They keep being used
+		 * for predictions until we have enough samples */
+		_STARPU_CALLOC(rls->theta, ncoeff, sizeof(double));
+		if (reg_model->coeff && reg_model->multi_valid)
+			memcpy(rls->theta, reg_model->coeff, ncoeff*sizeof(double));
+		_STARPU_CALLOC(rls->p, ncoeff*ncoeff, sizeof(double));
+		for (i = 0; i < ncoeff; i++)
+			rls->p[i*ncoeff+i] = RLS_DELTA;
+		rls->nsample = 0;
+	}
+
+	double *p = rls->p;
+	double *theta = rls->theta;
+	double x[ncoeff], px[ncoeff];
+
+	x[0] = 1.;
+	for (j = 1; j < ncoeff; j++)
+	{
+		x[j] = 1.;
+		for (k = 0; k < nparameters; k++)
+			x[j] *= pow(parameters[k], combinations[j-1][k]);
+	}
+
+	double denom = lambda;
+	double err = duration;
+	for (i = 0; i < ncoeff; i++)
+	{
+		px[i] = 0.;
+		for (j = 0; j < ncoeff; j++)
+			px[i] += p[i*ncoeff+j] * x[j];
+		denom += x[i] * px[i];
+		err -= theta[i] * x[i];
+	}
+	if (!(denom > 0.) || isinf(denom))
+		/* Numerical trouble, ignore the sample */
+		return;
+
+	for (i = 0; i < ncoeff; i++)
+		theta[i] += px[i] * err / denom;
+
+	/* P is symmetric, so x^T P = (P x)^T, update only one half to keep it
+	 * exactly symmetric */
+	for (i = 0; i < ncoeff; i++)
+		for (j = i; j < ncoeff; j++)
+		{
+			double v = (p[i*ncoeff+j] - px[i] * px[j] / denom) / lambda;
+			p[i*ncoeff+j] = v;
+			p[j*ncoeff+i] = v;
+		}
+
+	rls->nsample++;
+	if (rls->nsample >= ncoeff)
+	{
+		if (!reg_model->coeff)
+			_STARPU_MALLOC(reg_model->coeff, ncoeff*sizeof(double));
+		memcpy(reg_model->coeff, theta, ncoeff*sizeof(double));
+		reg_model->multi_valid = 1;
+	}
+}
+
 int _starpu_multiple_regression(struct starpu_perfmodel_history_list *ptr, double *coeff, unsigned ncoeff, unsigned nparameters, const char **parameters_names, unsigned **combinations, const char *codelet_name)
 {
 	unsigned long i;
@@ -29,6 +29,13 @@
 
 int _starpu_multiple_regression(struct starpu_perfmodel_history_list *ptr, double *coeff, unsigned ncoeff, unsigned nparameters, const char **parameters_names, unsigned **combinations, const char *codelet_name);
 
+/** Update the estimation \p rls of the coefficients of \p reg_model with a
+ * new sample, using recursive least squares with forgetting factor \p
+ * lambda, and copy them to \p reg_model once the estimation has enough
+ * samples. Must be called with the model_rwlock of the performance model
+ * held in write mode. */
+void _starpu_multiple_regression_rls_update(struct starpu_perfmodel_regression_model *reg_model, struct _starpu_perfmodel_rls *rls, const double *parameters, double duration, unsigned nparameters, unsigned ncombinations, unsigned **combinations, double lambda);
+
 #pragma GCC visibility pop
 
 #endif // __MULTIPLE_REGRESSION_H__
@@ -50,10 +50,26 @@ void _starpu_init_perfmodel(void);
 #define STR_LONG_LENGTH 256
 #define STR_VERY_LONG_LENGTH 1024
 
+/** Recursive least squares estimation of the coefficients of a multiple
+ * regression model, see \ref STARPU_MLR_RLS */
+struct _starpu_perfmodel_rls
+{
+	unsigned ncoeff;
+	/** coefficients being estimated, copied to the regression model once
+	 * enough samples were taken into account */
+	double *theta;
+	/** ncoeff x ncoeff covariance matrix */
+	double *p;
+	/** number of samples taken into account */
+	unsigned nsample;
+};
+
 struct _starpu_perfmodel_state
 {
 	struct starpu_perfmodel_per_arch** per_arch; /*STARPU_MAXIMPLEMENTATIONS*/
 	int** per_arch_is_set; /*STARPU_MAXIMPLEMENTATIONS*/
+	/** recursive least squares states, only allocated when used */
+	struct _starpu_perfmodel_rls** rls; /*STARPU_MAXIMPLEMENTATIONS*/
 
 	starpu_pthread_rwlock_t model_rwlock;
 	int *nimpls;
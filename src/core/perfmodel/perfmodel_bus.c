@@ -114,6 +114,9 @@ static unsigned nmem[STARPU_NRAM];
 
 static double numa_latency[STARPU_MAXNUMANODES][STARPU_MAXNUMANODES];
 static double numa_timing[STARPU_MAXNUMANODES][STARPU_MAXNUMANODES];
+/* NUMA-to-NUMA pairs whose measurements were kept from the previous bus
+ * performance model, and thus do not need to be measured again */
+static unsigned numa_calibrated[STARPU_MAXNUMANODES][STARPU_MAXNUMANODES];
 
 static int gpu_numa[STARPU_NRAM][STARPU_NMAXDEVS]; /* hwloc NUMA logical ID */
 #endif
@@ -596,8 +599,128 @@ no_calibration:
 #endif
 	{
 		/* Cannot make a real calibration */
-		numa_timing[numa_src][numa_dst] = 0.01;
-		numa_latency[numa_src][numa_dst] = 0;
+		*timing_nton = 0.01;
+		*latency_nton = 0;
+	}
+}
+
+struct numa_pair
+{
+	unsigned a;
+	unsigned b;
+};
+
+static void measure_numa_pair(unsigned a, unsigned b)
+{
+	if (!numa_calibrated[a][b])
+	{
+		_STARPU_DISP("NUMA %u -> %u...\n", a, b);
+		measure_bandwidth_latency_between_numa(a, b, &numa_timing[a][b], &numa_latency[a][b]);
+	}
+	if (!numa_calibrated[b][a])
+	{
+		_STARPU_DISP("NUMA %u -> %u...\n", b, a);
+		measure_bandwidth_latency_between_numa(b, a, &numa_timing[b][a], &numa_latency[b][a]);
+	}
+}
+
+static void *measure_numa_pair_thread(void *arg)
+{
+	struct numa_pair *pair = arg;
+	measure_numa_pair(pair->a, pair->b);
+	return NULL;
+}
+
+/* Distance reported by hwloc between NUMA nodes a and b, 0 if unknown */
+static uint64_t numa_pair_distance(unsigned a, unsigned b)
+{
+#if defined(STARPU_HAVE_HWLOC) && HAVE_DECL_HWLOC_DISTANCES_OBJ_PAIR_VALUES
+	hwloc_obj_t obj_a, obj_b;
+	hwloc_uint64_t ab, ba;
+
+	if (!numa_distances)
+		return 0;
+	obj_a = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, a);
+	obj_b = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, b);
+	if (!obj_a || !obj_b || hwloc_distances_obj_pair_values(numa_distances, obj_a, obj_b, &ab, &ba) != 0)
+		return 0;
+	return (ab + ba) / 2;
+#else
+	(void) a;
+	(void) b;
+	return 0;
+#endif
+}
+
+/* Measure the bandwidth and latency between all NUMA nodes. Unless
+ * STARPU_BUS_CALIBRATE_PARALLEL is set to 0, the pairs are measured in rounds
+ * of a round-robin tournament: the pairs of a round involve distinct NUMA
+ * nodes, which divides the calibration time by about nnumas/2.
+ *
+ * Distinct NUMA nodes may however still share the links between them: when
+ * hwloc provides NUMA distances, only the pairs at the smallest distance,
+ * i.e. directly linked, are measured concurrently, and the pairs of the
+ * round which are further away, whose transfers are routed through other
+ * links, are measured one after the other. Without distances, all the pairs
+ * of a round are measured concurrently. */
+static void measure_all_numa_pairs(void)
+{
+	unsigned i, j;
+	uint64_t min_distance = 0;
+
+	if (nnumas <= 2 || !starpu_getenv_number_default("STARPU_BUS_CALIBRATE_PARALLEL", 1))
+	{
+		for (i = 0; i < nnumas; i++)
+			for (j = i+1; j < nnumas; j++)
+				measure_numa_pair(i, j);
+		return;
+	}
+
+	for (i = 0; i < nnumas; i++)
+		for (j = i+1; j < nnumas; j++)
+		{
+			uint64_t distance = numa_pair_distance(i, j);
+			if (distance && (!min_distance || distance < min_distance))
+				min_distance = distance;
+		}
+
+	/* Add a dummy node when the number of NUMA nodes is odd */
+	unsigned n = nnumas + nnumas % 2;
+	unsigned round;
+	for (round = 0; round < n-1; round++)
+	{
+		struct numa_pair pairs[STARPU_MAXNUMANODES/2+1];
+		struct numa_pair remote_pairs[STARPU_MAXNUMANODES/2+1];
+		starpu_pthread_t threads[STARPU_MAXNUMANODES/2+1];
+		unsigned npairs = 0, nremote_pairs = 0, k;
+
+		/* Node n-1 stays in place while the others rotate */
+		for (k = 0; k < n/2; k++)
+		{
+			unsigned a = k == 0 ? n-1 : (round + k) % (n-1);
+			unsigned b = (round + n-1 - k) % (n-1);
+			if (a >= nnumas || b >= nnumas)
+				/* Paired with the dummy node */
+				continue;
+			if (min_distance && numa_pair_distance(a, b) > min_distance)
+			{
+				/* Not directly linked */
+				remote_pairs[nremote_pairs].a = a;
+				remote_pairs[nremote_pairs].b = b;
+				nremote_pairs++;
+				continue;
+			}
+			pairs[npairs].a = a;
+			pairs[npairs].b = b;
+			npairs++;
+		}
+
+		for (k = 0; k < npairs; k++)
+			STARPU_PTHREAD_CREATE(&threads[k], NULL, measure_numa_pair_thread, &pairs[k]);
+		for (k = 0; k < npairs; k++)
+			STARPU_PTHREAD_JOIN(threads[k], NULL);
+		for (k = 0; k < nremote_pairs; k++)
+			measure_numa_pair(remote_pairs[k].a, remote_pairs[k].b);
 	}
 }
 #endif /* !defined(STARPU_SIMGRID) */
@@ -609,6 +732,8 @@ static void benchmark_all_memory_nodes(void)
 	STARPU_ABORT();
 #else /* !SIMGRID */
 	unsigned i, j;
+	unsigned nreused = 0;
+	double start = starpu_timing_now();
 
 	_STARPU_DEBUG("Benchmarking the speed of the bus\n");
 
@@ -652,11 +777,9 @@ static void benchmark_all_memory_nodes(void)
 
 	for (i = 0; i < nnumas; i++)
 		for (j = 0; j < nnumas; j++)
-			if (i != j)
-			{
-				_STARPU_DISP("NUMA %d -> %d...\n", i, j);
-				measure_bandwidth_latency_between_numa(i, j, &numa_timing[i][j], &numa_latency[i][j]);
-			}
+			nreused += numa_calibrated[i][j];
+	measure_all_numa_pairs();
+	memset(numa_calibrated, 0, sizeof(numa_calibrated));
 
 #ifndef STARPU_SIMGRID
 	struct _starpu_machine_topology *topology = &_starpu_get_machine_config()->topology;
@@ -762,6 +885,8 @@ static void benchmark_all_memory_nodes(void)
 #endif
 
 	_STARPU_DEBUG("Benchmarking the speed of the bus is done.\n");
+	_STARPU_DISP("Bus calibration took %.2f s (%u NUMA pairs measured, %u kept from the previous calibration)\n",
+		     (starpu_timing_now() - start) / 1000000., nnumas * (nnumas-1) - nreused, nreused);
 	_starpu_benchmarking_bus = 0;
 	was_benchmarked = 1;
 #endif /* !SIMGRID */
@@ -1710,7 +1835,7 @@ static int mpi_check_recalibrate(int my_recalibrate)
 }
 #endif
 
-static void compare_value_and_recalibrate(enum starpu_node_kind type, const char * msg, unsigned val_file, unsigned val_detected)
+static int compare_value_and_recalibrate(enum starpu_node_kind type, const char * msg, unsigned val_file, unsigned val_detected)
 {
 	int recalibrate = 0;
 	if (val_file != val_detected &&
@@ -1730,15 +1855,39 @@ static void compare_value_and_recalibrate(enum starpu_node_kind type, const char
 		if (_starpu_mpi_common_is_src_node())
 #endif
 			_STARPU_DISP("Current configuration does not match the bus performance model (%s: (stored) %d != (current) %d), recalibrating...\n", msg, val_file, val_detected);
+	}
+	return recalibrate;
+}
 
-		int location = _starpu_get_perf_model_bus();
-		_starpu_bus_force_sampling(location);
+/* When the NUMA nodes did not change, keep the NUMA-to-NUMA measurements of the
+ * previous bus performance model, which take most of the calibration time on
+ * large NUMA machines, and only measure again the accelerators */
+static void keep_numa_calibration(void)
+{
+	char path[PATH_LENGTH];
+	unsigned i, j;
 
-#ifdef STARPU_USE_MPI_MASTER_SLAVE
-		if (_starpu_mpi_common_is_src_node())
-#endif
-			_STARPU_DISP("... done\n");
-	}
+	get_bandwidth_path(path, sizeof(path));
+	if (access(path, F_OK))
+		return;
+	get_latency_path(path, sizeof(path));
+	if (access(path, F_OK))
+		return;
+	if (!load_bus_bandwidth_file_content() || !load_bus_latency_file_content())
+		return;
+
+	for (i = 0; i < nnumas; i++)
+		for (j = 0; j < nnumas; j++)
+		{
+			double bandwidth = raw_bandwidth_matrix[i][j];
+			double latency = raw_latency_matrix[i][j];
+
+			if (i == j || !(bandwidth > 0.) || isinf(bandwidth) || isnan(latency))
+				continue;
+			numa_timing[i][j] = 1.0/bandwidth;
+			numa_latency[i][j] = latency;
+			numa_calibrated[i][j] = 1;
+		}
 }
 
 static void check_bus_config_file(void)
@@ -1823,12 +1972,25 @@ static void check_bus_config_file(void)
 		}
 
 		// Checking if both configurations match
-		compare_value_and_recalibrate(STARPU_CPU_RAM, "CPUS", read_cpus, ncpus);
+		recalibrate = compare_value_and_recalibrate(STARPU_CPU_RAM, "CPUS", read_cpus, ncpus);
 		for (type = STARPU_CPU_RAM; type < STARPU_NRAM; type++)
 		{
-			compare_value_and_recalibrate(type,
+			recalibrate |= compare_value_and_recalibrate(type,
 				starpu_memory_driver_info[type].name_upper, n_read[type], nmem[type]);
 		}
+
+		if (recalibrate)
+		{
+			if (read_cpus == ncpus && n_read[STARPU_CPU_RAM] == nnumas)
+				keep_numa_calibration();
+
+			_starpu_bus_force_sampling(location);
+
+#ifdef STARPU_USE_MPI_MASTER_SLAVE
+			if (_starpu_mpi_common_is_src_node())
+#endif
+				_STARPU_DISP("... done\n");
+		}
 	}
 }
 
@@ -50,6 +50,9 @@ static int nb_arch_combs;
 static starpu_pthread_rwlock_t arch_combs_mutex = STARPU_PTHREAD_RWLOCK_INITIALIZER;
 static int historymaxerror;
 static char ignore_devid[STARPU_NARCH];
+/* Whether to update multiple regression models with recursive least squares */
+static int mlr_rls;
+static double mlr_rls_forgetting;
 
 /* How many executions a codelet will have to be measured before we
  * consider that calibration will provide a value good enough for scheduling */
@@ -115,6 +118,9 @@ void _starpu_initialize_registered_performance_models(void)
 	current_arch_comb = 0;
 	historymaxerror = starpu_getenv_number_default("STARPU_HISTORY_MAX_ERROR", STARPU_HISTORYMAXERROR);
 	_starpu_calibration_minimum = starpu_getenv_number_default("STARPU_CALIBRATE_MINIMUM", 10);
+	mlr_rls = starpu_getenv_number_default("STARPU_MLR_RLS", 0);
+	mlr_rls_forgetting = starpu_getenv_float_default("STARPU_MLR_RLS_FORGETTING", 1.);
+	STARPU_ASSERT_MSG(mlr_rls_forgetting > 0. && mlr_rls_forgetting <= 1., "STARPU_MLR_RLS_FORGETTING must be in ]0,1]");
 
 	for (archtype = 0; archtype < STARPU_NARCH; archtype++)
 	{
@@ -438,8 +444,17 @@ static void dump_reg_model(FILE *f, struct starpu_perfmodel *model, int comb, in
 			reg_model->ncoeff = model->ncombinations + 1;
 		}
 
-		_STARPU_MALLOC(reg_model->coeff,  reg_model->ncoeff*sizeof(double));
-		_starpu_multiple_regression(per_arch_model->list, reg_model->coeff, reg_model->ncoeff, model->nparameters, model->parameters_names, model->combinations, model->symbol);
+		if (model->state->rls && model->state->rls[comb] && model->state->rls[comb][impl].p)
+		{
+			/* The recursive least squares keep the coefficients up
+			 * to date, and did not keep the samples */
+		}
+		else
+		{
+			if (!reg_model->coeff)
+				_STARPU_MALLOC(reg_model->coeff,  reg_model->ncoeff*sizeof(double));
+			_starpu_multiple_regression(per_arch_model->list, reg_model->coeff, reg_model->ncoeff, model->nparameters, model->parameters_names, model->combinations, model->symbol);
+		}
 
 		fprintf(f, "# n\tintercept\t");
 		if (reg_model->ncoeff==0 || model->ncombinations==0 || model->combinations==NULL)
@@ -479,7 +494,9 @@ static void dump_reg_model(FILE *f, struct starpu_perfmodel *model, int comb, in
 
 			fprintf(f, "\n%u", reg_model->ncoeff);
 			for (i=0; i < reg_model->ncoeff; i++)
-				fprintf(f, "\t%-15e", reg_model->coeff[i]);
+				/* The recursive least squares may not have
+				 * provided coefficients yet */
+				fprintf(f, "\t%-15e", reg_model->coeff ? reg_model->coeff[i] : nan(""));
 		}
 	}
 }
@@ -759,6 +776,60 @@ static void parse_comb(FILE *f, const char *path, struct starpu_perfmodel *model
 	parse_arch(f, path, model, scan_history, id_comb);
 }
 
+static struct _starpu_perfmodel_rls *get_rls(struct starpu_perfmodel *model, int comb, int impl)
+{
+	if (!model->state->rls[comb])
+		_STARPU_CALLOC(model->state->rls[comb], STARPU_MAXIMPLEMENTATIONS, sizeof(struct _starpu_perfmodel_rls));
+	return &model->state->rls[comb][impl];
+}
+
+static void parse_rls(FILE *f, const char *path, struct starpu_perfmodel *model, int ncombs)
+{
+	int comb, impl, res;
+	unsigned nsample, ncoeff, i;
+
+	_starpu_drop_comments(f);
+	res = fscanf(f, "%d\t%d\t%u\t%u\n", &comb, &impl, &nsample, &ncoeff);
+	STARPU_ASSERT_MSG(res == 4 && comb >= 0 && comb < ncombs && impl >= 0 && ncoeff > 0, "Incorrect performance model file %s", path);
+
+	double theta[ncoeff];
+	double *p;
+	_STARPU_MALLOC(p, ncoeff*ncoeff*sizeof(double));
+
+	_starpu_drop_comments(f);
+	for (i = 0; i < ncoeff; i++)
+	{
+		res = _starpu_read_double(f, "%le", &theta[i]);
+		STARPU_ASSERT_MSG(res == 1, "Incorrect performance model file %s", path);
+	}
+	res = fscanf(f, "\n");
+	STARPU_ASSERT_MSG(res == 0, "Incorrect performance model file %s", path);
+
+	_starpu_drop_comments(f);
+	for (i = 0; i < ncoeff*ncoeff; i++)
+	{
+		res = _starpu_read_double(f, "%le", &p[i]);
+		STARPU_ASSERT_MSG(res == 1, "Incorrect performance model file %s", path);
+	}
+	res = fscanf(f, "\n");
+	STARPU_ASSERT_MSG(res == 0, "Incorrect performance model file %s", path);
+
+	if (impl >= STARPU_MAXIMPLEMENTATIONS)
+	{
+		free(p);
+		return;
+	}
+
+	struct _starpu_perfmodel_rls *rls = get_rls(model, model->state->combs[comb], impl);
+	free(rls->theta);
+	free(rls->p);
+	rls->ncoeff = ncoeff;
+	_STARPU_MALLOC(rls->theta, ncoeff*sizeof(double));
+	memcpy(rls->theta, theta, ncoeff*sizeof(double));
+	rls->p = p;
+	rls->nsample = nsample;
+}
+
 static int parse_model_file(FILE *f, const char *path, struct starpu_perfmodel *model, unsigned scan_history)
 {
 	int ret, version=0;
@@ -801,6 +872,17 @@ static int parse_model_file(FILE *f, const char *path, struct starpu_perfmodel *
 	for(comb = 0; comb < ncombs; comb++)
 		parse_comb(f, path, model, scan_history, comb);
 
+	/* Optional recursive least squares states, older files do not have them */
+	int nrls = 0;
+	_starpu_drop_comments(f);
+	ret = fscanf(f, "%d\n", &nrls);
+	if (ret == 1)
+	{
+		int i;
+		for (i = 0; i < nrls; i++)
+			parse_rls(f, path, model, ncombs);
+	}
+
 	return 0;
 }
 
@@ -918,6 +1000,54 @@ static void check_model(struct starpu_perfmodel *model)
 	}
 }
 
+/* The recursive least squares states are appended after all the
+ * combinations, so that files without them can still be read, and readers
+ * not knowing about them just ignore them */
+static void dump_rls(FILE *f, struct starpu_perfmodel *model)
+{
+	int ncombs = model->state->ncombs;
+	int nrls = 0;
+	int i, impl;
+	unsigned j;
+
+	for(i = 0; i < ncombs; i++)
+	{
+		int comb = model->state->combs[i];
+		if (model->state->rls[comb])
+			for (impl = 0; impl < model->state->nimpls[comb]; impl++)
+				if (model->state->rls[comb][impl].p)
+					nrls++;
+	}
+	if (!nrls)
+		return;
+
+	fprintf(f, "####################\n");
+	fprintf(f, "# Recursive least squares estimations\n");
+	fprintf(f, "# number of estimations\n");
+	fprintf(f, "%d\n", nrls);
+	for(i = 0; i < ncombs; i++)
+	{
+		int comb = model->state->combs[i];
+		if (!model->state->rls[comb])
+			continue;
+		for (impl = 0; impl < model->state->nimpls[comb]; impl++)
+		{
+			struct _starpu_perfmodel_rls *rls = &model->state->rls[comb][impl];
+			if (!rls->p)
+				continue;
+			fprintf(f, "# comb\timpl\tn\tncoeff\n");
+			fprintf(f, "%d\t%d\t%u\t%u\n", i, impl, rls->nsample, rls->ncoeff);
+			fprintf(f, "# coefficients\n");
+			for (j = 0; j < rls->ncoeff; j++)
+				fprintf(f, "%s%-15e", j ? "\t" : "", rls->theta[j]);
+			fprintf(f, "\n# covariance\n");
+			for (j = 0; j < rls->ncoeff*rls->ncoeff; j++)
+				fprintf(f, "%s%-15e", j ? "\t" : "", rls->p[j]);
+			fprintf(f, "\n");
+		}
+	}
+}
+
 /* Driver porters: adding your driver here is optional, only needed for performance models.  */
 
 static void dump_model_file(FILE *f, struct starpu_perfmodel *model)
@@ -975,6 +1105,8 @@ static void dump_model_file(FILE *f, struct starpu_perfmodel *model)
 			dump_per_arch_model_file(f, model, comb, impl);
 		}
 	}
+
+	dump_rls(f, model);
 }
 #endif
 
@@ -1142,6 +1274,7 @@ void _starpu_perfmodel_realloc(struct starpu_perfmodel *model, int nb)
 #endif
 	_STARPU_REALLOC(model->state->per_arch, nb*sizeof(struct starpu_perfmodel_per_arch*));
 	_STARPU_REALLOC(model->state->per_arch_is_set, nb*sizeof(int*));
+	_STARPU_REALLOC(model->state->rls, nb*sizeof(struct _starpu_perfmodel_rls*));
 	_STARPU_REALLOC(model->state->nimpls, nb*sizeof(int));
 	_STARPU_REALLOC(model->state->nimpls_set, nb*sizeof(int));
 	_STARPU_REALLOC(model->state->combs, nb*sizeof(int));
@@ -1149,6 +1282,7 @@ void _starpu_perfmodel_realloc(struct starpu_perfmodel *model, int nb)
 	{
 		model->state->per_arch[i] = NULL;
 		model->state->per_arch_is_set[i] = NULL;
+		model->state->rls[i] = NULL;
 		model->state->nimpls[i] = 0;
 		model->state->nimpls_set[i] = 0;
 	}
@@ -1189,6 +1323,7 @@ void starpu_perfmodel_init(struct starpu_perfmodel *model)
 	STARPU_PTHREAD_RWLOCK_UNLOCK(&arch_combs_mutex);
 	_STARPU_CALLOC(model->state->per_arch, ncombs, sizeof(struct starpu_perfmodel_per_arch*));
 	_STARPU_CALLOC(model->state->per_arch_is_set, ncombs, sizeof(int*));
+	_STARPU_CALLOC(model->state->rls, ncombs, sizeof(struct _starpu_perfmodel_rls*));
 	_STARPU_CALLOC(model->state->nimpls, ncombs, sizeof(int));
 	_STARPU_CALLOC(model->state->nimpls_set, ncombs, sizeof(int));
 	_STARPU_MALLOC(model->state->combs, ncombs*sizeof(int));
@@ -1319,6 +1454,8 @@ void _starpu_deinitialize_performance_model(struct starpu_perfmodel *model)
 						}
 						archmodel->list = NULL;
 					}
+					free(archmodel->regression.coeff);
+					archmodel->regression.coeff = NULL;
 				}
 				free(model->state->per_arch[i]);
 				model->state->per_arch[i] = NULL;
@@ -1326,6 +1463,17 @@ void _starpu_deinitialize_performance_model(struct starpu_perfmodel *model)
 				free(model->state->per_arch_is_set[i]);
 				model->state->per_arch_is_set[i] = NULL;
 			}
+			if (model->state->rls[i])
+			{
+				int impl;
+				for(impl=0 ; impl<STARPU_MAXIMPLEMENTATIONS ; impl++)
+				{
+					free(model->state->rls[i][impl].theta);
+					free(model->state->rls[i][impl].p);
+				}
+				free(model->state->rls[i]);
+				model->state->rls[i] = NULL;
+			}
 		}
 		free(model->state->per_arch);
 		model->state->per_arch = NULL;
@@ -1333,6 +1481,9 @@ void _starpu_deinitialize_performance_model(struct starpu_perfmodel *model)
 		free(model->state->per_arch_is_set);
 		model->state->per_arch_is_set = NULL;
 
+		free(model->state->rls);
+		model->state->rls = NULL;
+
 		free(model->state->nimpls);
 		model->state->nimpls = NULL;
 
@@ -1708,24 +1859,36 @@ double _starpu_multiple_regression_based_job_expected_perf(struct starpu_perfmod
 		goto docal;
 	}
 	reg_model = &model->state->per_arch[comb][nimpl].regression;
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
 	if (reg_model->coeff == NULL)
+	{
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
 		goto docal;
+	}
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
 
 	double *parameters;
 	_STARPU_MALLOC(parameters, model->nparameters*sizeof(double));
 	model->parameters(j->task, parameters);
-	expected_duration=reg_model->coeff[0];
-	unsigned i;
-	for (i=0; i < model->ncombinations; i++)
+
+	/* The recursive least squares update the coefficients with the
+	 * write lock held */
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&model->state->model_rwlock);
+	if (reg_model->coeff != NULL)
 	{
-		double parameter_value=1.;
-		unsigned k;
-		for (k=0; k < model->nparameters; k++)
-			parameter_value *= pow(parameters[k],model->combinations[i][k]);
+		expected_duration=reg_model->coeff[0];
+		unsigned i;
+		for (i=0; i < model->ncombinations; i++)
+		{
+			double parameter_value=1.;
+			unsigned k;
+			for (k=0; k < model->nparameters; k++)
+				parameter_value *= pow(parameters[k],model->combinations[i][k]);
 
-		expected_duration += reg_model->coeff[i+1]*parameter_value;
+			expected_duration += reg_model->coeff[i+1]*parameter_value;
+		}
 	}
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
+	free(parameters);
 
 docal:
 	STARPU_HG_DISABLE_CHECKING(model->benchmarking);
@@ -2036,7 +2199,16 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 			}
 		}
 
-		if (model->type == STARPU_MULTIPLE_REGRESSION_BASED)
+		if (model->type == STARPU_MULTIPLE_REGRESSION_BASED && mlr_rls && model->ncombinations != 0 && model->combinations != NULL)
+		{
+			/* Update the coefficients right away, without keeping
+			 * the samples for a batch regression */
+			double parameters[model->nparameters];
+			model->parameters(j->task, parameters);
+			STARPU_ASSERT(measured >= 0);
+			_starpu_multiple_regression_rls_update(&per_arch_model->regression, get_rls(model, comb, impl), parameters, measured, model->nparameters, model->ncombinations, model->combinations, mlr_rls_forgetting);
+		}
+		else if (model->type == STARPU_MULTIPLE_REGRESSION_BASED)
 		{
 			struct starpu_perfmodel_history_entry *entry;
 			struct starpu_perfmodel_history_list **list;
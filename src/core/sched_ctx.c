@@ -30,7 +30,6 @@ enum _starpu_ctx_change_op
 	ctx_change_remove = 2
 };
 static starpu_pthread_mutex_t sched_ctx_manag = STARPU_PTHREAD_MUTEX_INITIALIZER;
-static starpu_pthread_mutex_t finished_submit_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
 static struct starpu_task stop_submission_task = STARPU_TASK_INITIALIZER;
 static starpu_pthread_key_t sched_ctx_key;
 static unsigned with_hypervisor = 0;
@@ -567,6 +566,7 @@ struct _starpu_sched_ctx* _starpu_create_sched_ctx(struct starpu_sched_policy *p
 	sched_ctx->name = sched_ctx_name;
 	sched_ctx->inheritor = STARPU_GLOBAL_SCHED_CTX;
 	sched_ctx->finished_submit = 0;
+	STARPU_PTHREAD_MUTEX_INIT(&sched_ctx->finished_submit_mutex, NULL);
 	sched_ctx->min_priority_is_set = min_prio_set;
 	if (sched_ctx->min_priority_is_set)
 		sched_ctx->min_priority = min_prio;
@@ -579,8 +579,8 @@ struct _starpu_sched_ctx* _starpu_create_sched_ctx(struct starpu_sched_policy *p
 	else
 		sched_ctx->max_priority = 0;
 
-	_starpu_barrier_counter_init(&sched_ctx->tasks_barrier, 0);
-	_starpu_barrier_counter_init(&sched_ctx->ready_tasks_barrier, 0);
+	_starpu_dist_counter_init(&sched_ctx->tasks_barrier);
+	_starpu_dist_counter_init(&sched_ctx->ready_tasks_barrier);
 
 	sched_ctx->ready_flops = 0.0;
 	for (i = 0; i < (int) (sizeof(sched_ctx->iterations)/sizeof(sched_ctx->iterations[0])); i++)
@@ -993,6 +993,7 @@ static void _starpu_delete_sched_ctx(struct _starpu_sched_ctx *sched_ctx)
 		sched_ctx->perf_arch.devices = NULL;
 	}
 
+	STARPU_PTHREAD_MUTEX_DESTROY(&sched_ctx->finished_submit_mutex);
 	sched_ctx->min_priority_is_set = 0;
 	sched_ctx->max_priority_is_set = 0;
 	sched_ctx->id = STARPU_NMAX_SCHED_CTXS;
@@ -1104,8 +1105,8 @@ void _starpu_delete_all_sched_ctxs()
 		{
 			_starpu_sched_ctx_lock_write(i);
 			_starpu_sched_ctx_free_scheduling_data(sched_ctx);
-			_starpu_barrier_counter_destroy(&sched_ctx->tasks_barrier);
-			_starpu_barrier_counter_destroy(&sched_ctx->ready_tasks_barrier);
+			_starpu_dist_counter_destroy(&sched_ctx->tasks_barrier);
+			_starpu_dist_counter_destroy(&sched_ctx->ready_tasks_barrier);
 			_starpu_sched_ctx_unlock_write(i);
 			STARPU_PTHREAD_RWLOCK_DESTROY(&sched_ctx->rwlock);
 			_starpu_delete_sched_ctx(sched_ctx);
@@ -1491,7 +1492,7 @@ int _starpu_wait_for_all_tasks_of_sched_ctx(unsigned sched_ctx_id)
 
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "starpu_task_wait_for_all must not be called from a task or callback");
 
-	_starpu_barrier_counter_wait_for_empty_counter(&sched_ctx->tasks_barrier);
+	_starpu_dist_counter_wait_for_empty(&sched_ctx->tasks_barrier);
 	return 0;
 }
 
@@ -1501,7 +1502,8 @@ int _starpu_wait_for_n_submitted_tasks_of_sched_ctx(unsigned sched_ctx_id, unsig
 
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "starpu_task_wait_for_n_submitted_tasks must not be called from a task or callback");
 
-	return _starpu_barrier_counter_wait_until_counter_reaches_down_to_n(&sched_ctx->tasks_barrier, n);
+	_starpu_dist_counter_wait_until_down_to_n(&sched_ctx->tasks_barrier, n);
+	return 0;
 }
 
 void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
@@ -1513,17 +1515,24 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 #endif
 
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	int reached = _starpu_barrier_counter_get_reached_exit(&sched_ctx->tasks_barrier);
-	int finished = reached == 1;
+	/* A context inheriting from itself, like the global context by
+	 * default, has nothing to move */
+	int inherit = sched_ctx->inheritor != STARPU_NMAX_SCHED_CTXS
+		&& sched_ctx->inheritor != sched_ctx->id;
 
-	/* when finished decrementing the tasks if the user signaled he will not submit tasks anymore
-	   we can move all its workers to the inheritor context */
-	if(finished && sched_ctx->inheritor != STARPU_NMAX_SCHED_CTXS)
+	if (inherit)
 	{
-		STARPU_PTHREAD_MUTEX_LOCK(&finished_submit_mutex);
-		if(sched_ctx->finished_submit)
+		/* The terminations of the tasks of contexts which have an
+		 * inheritor are serialized on the finished_submit_mutex of
+		 * the context, up to their decrement, so that exactly one of
+		 * them sees that it is the last one */
+		STARPU_PTHREAD_MUTEX_LOCK(&sched_ctx->finished_submit_mutex);
+
+		/* when finished decrementing the tasks if the user signaled he will not submit tasks anymore
+		   we can move all its workers to the inheritor context */
+		if(sched_ctx->finished_submit && _starpu_dist_counter_get(&sched_ctx->tasks_barrier) == 1)
 		{
-			STARPU_PTHREAD_MUTEX_UNLOCK(&finished_submit_mutex);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&sched_ctx->finished_submit_mutex);
 
 			if(sched_ctx->id != STARPU_NMAX_SCHED_CTXS)
 			{
@@ -1539,10 +1548,9 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 					free(workerids);
 				}
 			}
-			_starpu_barrier_counter_decrement_until_empty_counter(&sched_ctx->tasks_barrier, 0.0);
+			_starpu_dist_counter_decrement(&sched_ctx->tasks_barrier, 0.0);
 			return;
 		}
-		STARPU_PTHREAD_MUTEX_UNLOCK(&finished_submit_mutex);
 	}
 
 	/* We also need to check for config->submitting = 0 (i.e. the
@@ -1552,30 +1560,42 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 	 * starpu_drivers_request_termination() does.
 	 */
 
-	STARPU_PTHREAD_MUTEX_LOCK(&config->submitted_mutex);
-	if(config->submitting == 0)
+	/* Only take the mutex when the termination was requested, to avoid
+	 * serializing all the task terminations on it. This does not open a
+	 * new race: the check used to be done under the mutex but still
+	 * before our decrement, so reading 1 here is the same as having done
+	 * the check just before starpu_drivers_request_termination took the
+	 * mutex, and reading 0 makes us check again under the mutex. */
+	if(!config->submitting)
 	{
-		if(sched_ctx->id != STARPU_NMAX_SCHED_CTXS)
+		STARPU_PTHREAD_MUTEX_LOCK(&config->submitted_mutex);
+		if(config->submitting == 0)
 		{
-			if(sched_ctx->close_callback)
-				sched_ctx->close_callback(sched_ctx->id, sched_ctx->close_args);
-		}
+			if(sched_ctx->id != STARPU_NMAX_SCHED_CTXS)
+			{
+				if(sched_ctx->close_callback)
+					sched_ctx->close_callback(sched_ctx->id, sched_ctx->close_args);
+			}
 
-		ANNOTATE_HAPPENS_AFTER(&config->running);
-		config->running = 0;
-		ANNOTATE_HAPPENS_BEFORE(&config->running);
-		int s;
-		for(s = 0; s < STARPU_NMAX_SCHED_CTXS; s++)
-		{
-			if(config->sched_ctxs[s].id != STARPU_NMAX_SCHED_CTXS)
+			ANNOTATE_HAPPENS_AFTER(&config->running);
+			config->running = 0;
+			ANNOTATE_HAPPENS_BEFORE(&config->running);
+			int s;
+			for(s = 0; s < STARPU_NMAX_SCHED_CTXS; s++)
 			{
-				_starpu_check_nsubmitted_tasks_of_sched_ctx(config->sched_ctxs[s].id);
+				if(config->sched_ctxs[s].id != STARPU_NMAX_SCHED_CTXS)
+				{
+					_starpu_check_nsubmitted_tasks_of_sched_ctx(config->sched_ctxs[s].id);
+				}
 			}
 		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&config->submitted_mutex);
 	}
-	STARPU_PTHREAD_MUTEX_UNLOCK(&config->submitted_mutex);
 
-	_starpu_barrier_counter_decrement_until_empty_counter(&sched_ctx->tasks_barrier, 0.0);
+	_starpu_dist_counter_decrement(&sched_ctx->tasks_barrier, 0.0);
+
+	if (inherit)
+		STARPU_PTHREAD_MUTEX_UNLOCK(&sched_ctx->finished_submit_mutex);
 
 	return;
 }
@@ -1583,19 +1603,19 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 void _starpu_increment_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	_starpu_barrier_counter_increment(&sched_ctx->tasks_barrier, 0.0);
+	_starpu_dist_counter_increment(&sched_ctx->tasks_barrier, 0.0);
 }
 
 int _starpu_get_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	return _starpu_barrier_counter_get_reached_start(&sched_ctx->tasks_barrier);
+	return _starpu_dist_counter_get(&sched_ctx->tasks_barrier);
 }
 
 int _starpu_check_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	return _starpu_barrier_counter_check(&sched_ctx->tasks_barrier);
+	return _starpu_dist_counter_check(&sched_ctx->tasks_barrier);
 }
 
 unsigned _starpu_increment_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops, struct starpu_task *task)
@@ -1608,7 +1628,7 @@ unsigned _starpu_increment_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, doub
 		_starpu_sched_ctx_lock_write(sched_ctx->id);
 	}
 
-	_starpu_barrier_counter_increment(&sched_ctx->ready_tasks_barrier, ready_flops);
+	_starpu_dist_counter_increment(&sched_ctx->ready_tasks_barrier, ready_flops);
 
 
 	if(!sched_ctx->is_initial_sched)
@@ -1627,7 +1647,7 @@ unsigned _starpu_increment_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, doub
 void _starpu_decrement_nready_tasks_of_sched_ctx_locked(unsigned sched_ctx_id, double ready_flops)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	_starpu_barrier_counter_decrement_until_empty_counter(&sched_ctx->ready_tasks_barrier, ready_flops);
+	_starpu_dist_counter_decrement(&sched_ctx->ready_tasks_barrier, ready_flops);
 }
 
 void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops)
@@ -1639,7 +1659,7 @@ void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double r
 		_starpu_sched_ctx_lock_write(sched_ctx->id);
 	}
 
-	_starpu_barrier_counter_decrement_until_empty_counter(&sched_ctx->ready_tasks_barrier, ready_flops);
+	_starpu_dist_counter_decrement(&sched_ctx->ready_tasks_barrier, ready_flops);
 
 
 	if(!sched_ctx->is_initial_sched)
@@ -1653,19 +1673,19 @@ void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double r
 int starpu_sched_ctx_get_nready_tasks(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	return _starpu_barrier_counter_get_reached_start(&sched_ctx->ready_tasks_barrier);
+	return _starpu_dist_counter_get(&sched_ctx->ready_tasks_barrier);
 }
 
 double starpu_sched_ctx_get_nready_flops(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	return _starpu_barrier_counter_get_reached_flops(&sched_ctx->ready_tasks_barrier);
+	return _starpu_dist_counter_get_flops(&sched_ctx->ready_tasks_barrier);
 }
 
 int _starpu_wait_for_no_ready_of_sched_ctx(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	_starpu_barrier_counter_wait_for_empty_counter(&sched_ctx->ready_tasks_barrier);
+	_starpu_dist_counter_wait_for_empty(&sched_ctx->ready_tasks_barrier);
 	return 0;
 }
 
@@ -2028,9 +2048,9 @@ unsigned starpu_sched_ctx_get_hierarchy_level(unsigned sched_ctx_id)
 void starpu_sched_ctx_finished_submit(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
-	STARPU_PTHREAD_MUTEX_LOCK(&finished_submit_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(&sched_ctx->finished_submit_mutex);
 	sched_ctx->finished_submit = 1;
-	STARPU_PTHREAD_MUTEX_UNLOCK(&finished_submit_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&sched_ctx->finished_submit_mutex);
 	return;
 }
 
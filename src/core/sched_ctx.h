@@ -26,6 +26,7 @@
 #include <starpu_scheduler.h>
 #include <common/config.h>
 #include <common/barrier_counter.h>
+#include <common/dist_counter.h>
 #include <common/utils.h>
 #include <profiling/profiling.h>
 #include <semaphore.h>
@@ -70,10 +71,10 @@ struct _starpu_sched_ctx
 	unsigned is_initial_sched;
 
 	/** wait for the tasks submitted to the context to be executed */
-	struct _starpu_barrier_counter tasks_barrier;
+	struct _starpu_dist_counter tasks_barrier;
 
 	/** wait for the tasks ready of the context to be executed */
-	struct _starpu_barrier_counter ready_tasks_barrier;
+	struct _starpu_dist_counter ready_tasks_barrier;
 
 	/** amount of ready flops in a context */
 	double ready_flops;
@@ -106,6 +107,10 @@ struct _starpu_sched_ctx
 	/** indicates whether the application finished submitting tasks
 	   to this context*/
 	unsigned finished_submit;
+	/** serializes the terminations of the tasks of the context when it
+	 * has an inheritor, so that exactly one of them sees it is the last
+	 * one after finished_submit */
+	starpu_pthread_mutex_t finished_submit_mutex;
 
 	/** By default we have a binary type of priority: either a task is a priority
          * task (level 1) or it is not (level 0). */
@@ -204,6 +209,8 @@ int _starpu_wait_for_n_submitted_tasks_of_sched_ctx(unsigned sched_ctx_id, unsig
 void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
 void _starpu_increment_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
 int _starpu_get_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
+/** Wake up the threads waiting for the tasks of the context if there is none
+ * left, and return whether there is none left */
 int _starpu_check_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
 
 void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops);
@@ -22,6 +22,8 @@
 #include <common/utils.h>
 #include <core/sched_policy.h>
 #include <profiling/profiling.h>
+#include <profiling/latency.h>
+#include <profiling/critical_path.h>
 #include <datawizard/memory_nodes.h>
 #include <common/barrier.h>
 #include <core/debug.h>
@@ -619,6 +621,8 @@ int _starpu_repush_task(struct _starpu_job *j)
 			value = STARPU_PERF_COUNTER_ADD64(&pcv->task.current_ready, 1);
 			_starpu_perf_counter_update_max_int64(&pcv->task.peak_ready, value);
 		}
+		_starpu_latency_job_ready(j);
+		_starpu_critical_path_job_ready(j);
 	}
 	STARPU_AYU_ADDTOTASKQUEUE(j->job_id, -1);
 	/* if the context does not have any workers save the tasks in a temp list */
@@ -30,7 +30,9 @@
 #include <common/utils.h>
 #include <common/fxt.h>
 #include <common/knobs.h>
+#include <common/perf_export.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/prefetch_lookahead.h>
 #include <profiling/profiling.h>
 #include <profiling/bound.h>
 #include <math.h>
@@ -634,6 +636,10 @@ int _starpu_submit_job(struct _starpu_job *j, int nodeps)
 	/* notify bound computation of a new task */
 	_starpu_bound_record(j);
 
+	if (j->lookahead_entry == STARPU_LOOKAHEAD_STARTED)
+		/* Resubmitted, let it be prefetched again */
+		j->lookahead_entry = NULL;
+
 #ifdef STARPU_NOSV
 	if (!j->nosv_task_type)
 	{
@@ -1086,6 +1092,10 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 		_starpu_perf_counter_update_max_int64(&_starpu_task__g_peak_submitted__value, value);
 		_starpu_perf_counter_update_global_sample();
 
+		if (STARPU_UNLIKELY(_starpu_perf_export_enabled) && task->cl
+		    && (task->cl->perf_counter_values == NULL || !task->cl->perf_counter_values->exported))
+			_starpu_perf_export_register_codelet(task->cl);
+
 		if (task->cl && task->cl->perf_counter_values)
 		{
 			struct starpu_perf_counter_sample_cl_values * const pcv = task->cl->perf_counter_values;
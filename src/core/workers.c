@@ -37,11 +37,14 @@
 #include <datawizard/malloc.h>
 #include <profiling/profiling.h>
 #include <profiling/callbacks.h>
+#include <profiling/latency.h>
+#include <profiling/critical_path.h>
 #include <drivers/max/driver_max_fpga.h>
 #include <profiling/bound.h>
 #include <sched_policies/sched_component.h>
 #include <datawizard/memory_nodes.h>
 #include <common/knobs.h>
+#include <common/perf_export.h>
 #include <drivers/mp_common/sink_common.h>
 #include <drivers/mp_common/source_common.h>
 #include <drivers/mpi/driver_mpi_common.h>
@@ -55,6 +58,7 @@
 #include <drivers/mpi/driver_mpi_source.h>
 #include <drivers/tcpip/driver_tcpip_source.h>
 #include <drivers/disk/driver_disk.h>
+#include <drivers/driver_common/driver_common.h>
 
 #ifdef STARPU_SIMGRID
 #include <core/simgrid.h>
@@ -884,6 +888,14 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	workerarg->pop_ctx_priority = 1;
 	workerarg->is_slave_somewhere = 0;
 
+	workerarg->park_state = STARPU_WORKER_AWAKE;
+	workerarg->park_spin = 0.;
+	workerarg->park_idle_avg = 0.;
+	workerarg->park_latency_avg = 0.;
+	workerarg->park_wake_date = 0.;
+	STARPU_HG_DISABLE_CHECKING(workerarg->park_state);
+	STARPU_HG_DISABLE_CHECKING(workerarg->park_wake_date);
+
 	workerarg->state_relax_refcnt = 1;
 #ifdef STARPU_SPINLOCK_CHECK
 	workerarg->relax_on_file = __FILE__;
@@ -904,6 +916,7 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	workerarg->state_unblock_in_parallel_ack = 0;
 	workerarg->block_in_parallel_ref_count = 0;
 	_starpu_perf_counter_sample_init(&workerarg->perf_counter_sample, starpu_perf_counter_scope_per_worker);
+	_starpu_latency_worker_init(workerarg);
 	workerarg->enable_knob = 1;
 	workerarg->bindid_requested = -1;
 
@@ -919,6 +932,7 @@ static void _starpu_worker_deinit(struct _starpu_worker *workerarg)
 	starpu_pthread_wait_destroy(&workerarg->wait);
 #endif
 	_starpu_perf_counter_sample_exit(&workerarg->perf_counter_sample);
+	_starpu_latency_worker_deinit(workerarg);
 }
 
 #ifdef STARPU_USE_FXT
@@ -964,6 +978,8 @@ static void _starpu_launch_drivers(struct _starpu_machine_config *pconfig)
 	pconfig->running = 1;
 	pconfig->pause_depth = 0;
 	pconfig->submitting = 1;
+	/* Checked without the submitted_mutex on task termination */
+	STARPU_HG_DISABLE_CHECKING(pconfig->submitting);
 	STARPU_HG_DISABLE_CHECKING(pconfig->watchdog_ok);
 
 	unsigned nworkers = pconfig->topology.nworkers;
@@ -1907,7 +1923,9 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 
 	_starpu_initialize_registered_performance_models();
 	_starpu_perf_counter_init(&_starpu_config);
+	_starpu_critical_path_init();
 	_starpu_perf_knob_init();
+	_starpu_worker_parking_init();
 
 #if defined(STARPU_USE_CUDA) || defined(STARPU_SIMGRID)
 	_starpu_cuda_init();
@@ -1930,6 +1948,10 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 
 	_starpu_watchdog_init();
 
+	_starpu_perf_export_init();
+
+	_starpu_latency_init();
+
 	_starpu_profiling_start();
 
 	STARPU_PTHREAD_MUTEX_LOCK(&init_mutex);
@@ -2154,6 +2176,8 @@ void starpu_display_stats()
 {
 	starpu_profiling_bus_helper_display_summary();
 	starpu_profiling_worker_helper_display_summary();
+	starpu_profiling_latency_helper_display_summary();
+	starpu_profiling_critical_path_helper_display_summary();
 }
 
 void starpu_shutdown(void)
@@ -2196,11 +2220,14 @@ void starpu_shutdown(void)
 	     {
 		  _starpu_display_msi_stats(stderr);
 		  _starpu_display_alloc_cache_stats(stderr);
+		  _starpu_display_prefetch_lookahead_stats(stderr);
 	     }
 	}
 
 	starpu_profiling_bus_helper_display_summary();
 	starpu_profiling_worker_helper_display_summary();
+	starpu_profiling_latency_helper_display_summary();
+	starpu_profiling_critical_path_helper_display_summary();
 	starpu_bound_clear();
 
 	_starpu_deinitialize_registered_performance_models();
@@ -2210,6 +2237,12 @@ void starpu_shutdown(void)
 	/* wait for their termination */
 	_starpu_terminate_workers(&_starpu_config);
 
+	_starpu_perf_export_shutdown();
+
+	_starpu_latency_shutdown();
+
+	_starpu_critical_path_shutdown();
+
 	{
 	     int stats = starpu_getenv_number("STARPU_MEMORY_STATS");
 	     if (stats != 0)
@@ -2792,6 +2825,8 @@ static int starpu_wakeup_worker_locked(int workerid, starpu_pthread_cond_t *sche
 		/* cond_broadcast is required over cond_signal since
 		 * the condition is share for multiple purpose */
 		STARPU_PTHREAD_COND_BROADCAST(sched_cond);
+		/* It may also be parked on its futex */
+		_starpu_worker_unpark(&_starpu_config.workers[workerid]);
 		return ret;
 	}
 	else if (_starpu_config.workers[workerid].status & STATUS_SCHEDULING)
@@ -2823,6 +2858,9 @@ int starpu_wake_worker_no_relax(int workerid)
 {
 	starpu_pthread_mutex_t *sched_mutex;
 	starpu_pthread_cond_t *sched_cond;
+	if (_starpu_worker_unpark(&_starpu_config.workers[workerid]))
+		/* It was idle, no need for the mutex */
+		return 1;
 	starpu_worker_get_sched_condition(workerid, &sched_mutex, &sched_cond);
 	return starpu_wakeup_worker_no_relax(workerid, sched_cond, sched_mutex);
 }
@@ -3134,6 +3172,10 @@ int starpu_wake_worker_relax_light(int workerid)
 	int cur_workerid = starpu_worker_get_id();
 	if (workerid != cur_workerid)
 	{
+		if (_starpu_worker_unpark(worker))
+			/* It was idle, no need for the mutex */
+			return 1;
+
 		starpu_worker_relax_on();
 
 		STARPU_PTHREAD_MUTEX_LOCK_SCHED(&worker->sched_mutex);
@@ -3164,6 +3206,25 @@ int starpu_wake_worker_relax_light(int workerid)
 	return ret;
 }
 
+unsigned starpu_wake_workers_relax_light(const int *workerids, unsigned nworkers, unsigned n)
+{
+	int cur_workerid = starpu_worker_get_id();
+	unsigned i, woken = 0;
+
+	/* Idle workers are cheap to wake, wake as many as needed */
+	for (i = 0; i < nworkers && woken < n; i++)
+		if (workerids[i] != cur_workerid && _starpu_worker_unpark(_starpu_get_worker_struct(workerids[i])))
+			woken++;
+	if (woken)
+		return woken;
+
+	/* Otherwise wake up a single worker */
+	for (i = 0; i < nworkers; i++)
+		if (starpu_wake_worker_relax_light(workerids[i]))
+			return 1;
+	return 0;
+}
+
 #ifdef STARPU_WORKER_CALLBACKS
 void starpu_worker_set_going_to_sleep_callback(void (*callback)(unsigned workerid))
 {
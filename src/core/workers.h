@@ -133,6 +133,15 @@ struct _starpu_node
 	int nfreechunks;
 	/** This protects chunks and nfreechunks */
 	starpu_pthread_mutex_t chunk_mutex;
+	/** Pool of freed buffers, one list per size class */
+	struct _starpu_pool_block_list pool[MALLOC_POOL_NCLASSES];
+	/** Amount of memory currently cached in pool */
+	size_t pool_size;
+	struct _starpu_malloc_pool_stats pool_stats;
+	/** This protects pool, pool_size and pool_stats */
+	starpu_pthread_mutex_t pool_mutex;
+	/** Whether the pool was already released by _starpu_malloc_pool_shutdown */
+	unsigned pool_shutdown;
 
 	/*
 	 * used by memory_manager.c
@@ -244,6 +253,11 @@ LIST_TYPE(_starpu_worker,
 	unsigned wait_for_worker_initialization;
 	enum _starpu_worker_status status; /**< what is the worker doing now ? (eg. CALLBACK) */
 	unsigned state_keep_awake; /**< !0 if a task has been pushed to the worker and the task has not yet been seen by the worker, the worker should no go to sleep before processing this task*/
+	unsigned park_state; /**< futex word, one of STARPU_WORKER_AWAKE/SPINNING/PARKED/WOKEN, see _starpu_worker_unpark() */
+	double park_spin; /**< how long an idle worker spins before parking (us) */
+	double park_idle_avg; /**< average duration of the idle periods (us) */
+	double park_latency_avg; /**< average time needed to wake the worker from the futex (us) */
+	double park_wake_date; /**< date of the last lock-free wake-up request */
 	char name[128];
 	char short_name[32];
 	unsigned run_by_starpu; /**< Is this run by StarPU or directly by the application ? */
@@ -305,6 +319,10 @@ LIST_TYPE(_starpu_worker,
 	struct starpu_perf_counter_sample perf_counter_sample;
 	int64_t __w_total_executed__value;
 	double __w_cumul_execution_time__value;
+	int64_t __w_total_wakeups__value;
+	int64_t __w_total_parked__value;
+	double __w_cumul_wakeup_latency__value;
+	struct starpu_profiling_latency_histogram *latency_histograms; /**< one latency histogram per kind of ::starpu_profiling_latency */
 
 	int enable_knob;
 	int bindid_requested;
@@ -800,6 +818,44 @@ void _starpu_worker_set_stream_ctx(unsigned workerid, struct _starpu_sched_ctx *
 
 struct _starpu_sched_ctx* _starpu_worker_get_ctx_stream(unsigned stream_workerid);
 
+/** Values of the park_state futex word of workers */
+#define STARPU_WORKER_AWAKE	0
+/** The worker is idle and spinning, with its sched_mutex released */
+#define STARPU_WORKER_SPINNING	1
+/** The worker is idle and blocked on the futex */
+#define STARPU_WORKER_PARKED	2
+/** The worker was woken up while spinning or parked */
+#define STARPU_WORKER_WOKEN	3
+
+/** Wake \p worker up if it is spinning or parked in _starpu_get_worker_task(),
+ * without needing its sched_mutex. Returns 1 if this call woke it up, 0 if it
+ * was not spinning or parked, in which case it may be blocked on its
+ * sched_cond.
+ *
+ * Can be called with or without the worker's sched_mutex held.
+ */
+static inline int _starpu_worker_unpark(struct _starpu_worker * const worker)
+{
+#ifdef STARPU_HAVE_FUTEX_PARKING
+	while (1)
+	{
+		unsigned state = *(volatile unsigned *) &worker->park_state;
+		if (state != STARPU_WORKER_SPINNING && state != STARPU_WORKER_PARKED)
+			return 0;
+		worker->park_wake_date = starpu_timing_now();
+		if (STARPU_VAL_COMPARE_AND_SWAP(&worker->park_state, state, STARPU_WORKER_WOKEN) == state)
+		{
+			if (state == STARPU_WORKER_PARKED)
+				_starpu_futex_unpark(&worker->park_state);
+			return 1;
+		}
+	}
+#else
+	(void) worker;
+	return 0;
+#endif
+}
+
 /** Send a request to the worker to block, before a parallel task is about to
  * begin.
  *
@@ -829,6 +885,7 @@ static inline void _starpu_worker_request_blocking_in_parallel(struct _starpu_wo
 		/* trigger the block_in_parallel_req */
 		worker->state_block_in_parallel_req = 1;
 		STARPU_PTHREAD_COND_BROADCAST(&worker->sched_cond);
+		_starpu_worker_unpark(worker);
 #ifdef STARPU_SIMGRID
 		starpu_pthread_queue_broadcast(&_starpu_simgrid_task_queue[worker->workerid]);
 #endif
@@ -876,6 +933,7 @@ static inline void _starpu_worker_request_unblocking_in_parallel(struct _starpu_
 			/* trigger the unblock_in_parallel_req */
 			worker->state_unblock_in_parallel_req = 1;
 			STARPU_PTHREAD_COND_BROADCAST(&worker->sched_cond);
+			_starpu_worker_unpark(worker);
 
 			/* wait for the unblock_in_parallel_req to be processed */
 			while (!worker->state_unblock_in_parallel_ack)
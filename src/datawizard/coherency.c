@@ -24,9 +24,11 @@
 #include <datawizard/write_back.h>
 #include <datawizard/memory_nodes.h>
 #include <datawizard/sort_data_handles.h>
+#include <datawizard/prefetch_lookahead.h>
 #include <core/dependencies/data_concurrency.h>
 #include <core/disk.h>
 #include <profiling/profiling.h>
+#include <profiling/latency.h>
 #include <core/task.h>
 #include <starpu_scheduler.h>
 #include <core/workers.h>
@@ -867,6 +869,8 @@ int _starpu_fetch_data_on_node(starpu_data_handle_t handle, int node, struct _st
 			/* no valid copy, nothing to prefetch */
 			STARPU_ASSERT_MSG(handle->init_cl, "Could not find a valid copy of the data, and no handle initialization function");
 			_starpu_spin_unlock(&handle->header_lock);
+			if (callback_func)
+				callback_func(callback_arg);
 			return 0;
 		}
 	}
@@ -1082,6 +1086,8 @@ int starpu_idle_prefetch_task_input_on_node(struct starpu_task *task, unsigned n
 
 int starpu_prefetch_task_input_for_prio(struct starpu_task *task, unsigned worker, int prio)
 {
+	if (_starpu_prefetch_lookahead_enabled() && _starpu_prefetch_lookahead_push(task, worker, prio) == 0)
+		return 0;
 	return starpu_prefetch_task_input_prio(task, -1, worker, prio);
 }
 
@@ -1154,6 +1160,10 @@ int _starpu_fetch_task_input(struct starpu_task *task, struct _starpu_job *j, in
 {
 	struct _starpu_worker *worker = _starpu_get_local_worker_key();
 	int workerid = worker->workerid;
+	if (_starpu_prefetch_lookahead_enabled())
+		_starpu_prefetch_lookahead_start(j, worker);
+	if (!_starpu_perf_counter_paused())
+		_starpu_latency_fetch_start(worker, j);
 	if (async)
 	{
 		worker->task_transferring = task;
@@ -1357,11 +1367,18 @@ void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job
 	}
 	_STARPU_TRACE_DATA_LOAD(workerid,total_size);
 
+	if (_starpu_prefetch_lookahead_enabled())
+		/* The task holds its data now */
+		_starpu_prefetch_lookahead_fetched(j);
+
 	if (profiling && task->profiling_info)
 		_starpu_clock_gettime(&task->profiling_info->acquire_data_end_time);
 
 	_STARPU_TRACE_END_FETCH_INPUT(NULL);
 
+	if (!_starpu_perf_counter_paused())
+		_starpu_latency_fetch_end(worker, j);
+
 	_starpu_clear_worker_status(worker, STATUS_INDEX_WAITING, NULL);
 }
 
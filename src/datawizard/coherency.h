@@ -109,6 +109,13 @@ struct _starpu_data_replicate
 	 */
 	unsigned nb_tasks_prefetch;
 
+	/** For the belady victim selector: position of the first queued task
+	 * which uses this replicate, valid when next_use_stamp matches the
+	 * stamp of the current victim selection on this node. Both are
+	 * protected by the belady mutex of the node */
+	unsigned next_use_stamp;
+	unsigned next_use;
+
 	/** Pointer to memchunk for LRU strategy */
 	struct _starpu_mem_chunk * mc;
 };
@@ -396,6 +403,7 @@ STARPU_ATTRIBUTE_WARN_UNUSED_RESULT
 /** Fetch the data parameters for task \p task
  * Setting \p async to 1 allows to only start the fetches, and call
  * \p _starpu_fetch_task_input_tail later when the transfers are finished */
+int _starpu_prefetch_task_input_prio(struct starpu_task *task, int target_node, int worker, int prio, enum starpu_is_prefetch prefetch);
 int _starpu_fetch_task_input(struct starpu_task *task, struct _starpu_job *j, int async);
 void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job *j, struct _starpu_worker *worker);
 void _starpu_fetch_nowhere_task_input(struct _starpu_job *j);
@@ -73,6 +73,7 @@ void _starpu_wake_all_blocked_workers_on_node(unsigned nodeid)
 			condition->worker->state_keep_awake = 1;
 		}
 		STARPU_PTHREAD_COND_BROADCAST(condition->cond);
+		_starpu_worker_unpark(condition->worker);
 		STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&condition->worker->sched_mutex);
 	}
 
@@ -119,6 +120,7 @@ void starpu_wake_all_blocked_workers(void)
 			condition->worker->state_keep_awake = 1;
 		}
 		STARPU_PTHREAD_COND_BROADCAST(condition->cond);
+		_starpu_worker_unpark(condition->worker);
 		STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&condition->worker->sched_mutex);
 	}
 
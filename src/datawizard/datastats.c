@@ -18,6 +18,7 @@
 #include <datawizard/datastats.h>
 #include <datawizard/coherency.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/prefetch_lookahead.h>
 #include <common/config.h>
 
 int _starpu_enable_stats = 0;
@@ -115,3 +116,95 @@ void _starpu_display_alloc_cache_stats(FILE *stream)
 	}
 	fprintf(stream, "#---------------------\n");
 }
+
+/* measure the efficiency of the lookahead prefetch engine */
+static unsigned lookahead_issued_cnt[STARPU_MAXNODES];
+static unsigned lookahead_hit_cnt[STARPU_MAXNODES];
+static unsigned lookahead_miss_cnt[STARPU_MAXNODES];
+static unsigned lookahead_cancel_cnt[STARPU_MAXNODES];
+
+void __starpu_prefetch_lookahead_issued(unsigned node)
+{
+	STARPU_HG_DISABLE_CHECKING(lookahead_issued_cnt[node]);
+	lookahead_issued_cnt[node]++;
+}
+
+void __starpu_prefetch_lookahead_hit(unsigned node)
+{
+	STARPU_HG_DISABLE_CHECKING(lookahead_hit_cnt[node]);
+	lookahead_hit_cnt[node]++;
+}
+
+void __starpu_prefetch_lookahead_miss(unsigned node)
+{
+	STARPU_HG_DISABLE_CHECKING(lookahead_miss_cnt[node]);
+	lookahead_miss_cnt[node]++;
+}
+
+void __starpu_prefetch_lookahead_cancel(unsigned node)
+{
+	STARPU_HG_DISABLE_CHECKING(lookahead_cancel_cnt[node]);
+	lookahead_cancel_cnt[node]++;
+}
+
+/* measure the choices of the belady victim selector */
+static unsigned belady_unused_cnt[STARPU_MAXNODES];
+static unsigned belady_furthest_cnt[STARPU_MAXNODES];
+static unsigned belady_none_cnt[STARPU_MAXNODES];
+
+void __starpu_belady_victim(unsigned node, starpu_data_handle_t victim, int unused)
+{
+	if (!victim)
+	{
+		STARPU_HG_DISABLE_CHECKING(belady_none_cnt[node]);
+		belady_none_cnt[node]++;
+	}
+	else if (unused)
+	{
+		STARPU_HG_DISABLE_CHECKING(belady_unused_cnt[node]);
+		belady_unused_cnt[node]++;
+	}
+	else
+	{
+		STARPU_HG_DISABLE_CHECKING(belady_furthest_cnt[node]);
+		belady_furthest_cnt[node]++;
+	}
+}
+
+void _starpu_display_prefetch_lookahead_stats(FILE *stream)
+{
+	if (!starpu_enable_stats() || !_starpu_prefetch_lookahead_enabled())
+		return;
+
+	fprintf(stream, "\n#---------------------\n");
+	fprintf(stream, "Lookahead prefetch stats:\n");
+	unsigned node;
+	for (node = 0; node < STARPU_MAXNODES; node++)
+	{
+		unsigned started = lookahead_hit_cnt[node] + lookahead_miss_cnt[node] + lookahead_cancel_cnt[node];
+		if (lookahead_issued_cnt[node] || started)
+		{
+			char name[128];
+			starpu_memory_node_get_name(node, name, sizeof(name));
+			fprintf(stream, "memory node %s\n", name);
+			fprintf(stream, "\tissued : %u\n", lookahead_issued_cnt[node]);
+			if (started)
+			{
+				fprintf(stream, "\thit : %u (%2.2f %%)\n", lookahead_hit_cnt[node], (100.0f*lookahead_hit_cnt[node])/started);
+				fprintf(stream, "\tmiss : %u (%2.2f %%)\n", lookahead_miss_cnt[node], (100.0f*lookahead_miss_cnt[node])/started);
+				fprintf(stream, "\tcancelled : %u (%2.2f %%)\n", lookahead_cancel_cnt[node], (100.0f*lookahead_cancel_cnt[node])/started);
+			}
+		}
+		if (belady_unused_cnt[node] || belady_furthest_cnt[node] || belady_none_cnt[node])
+		{
+			char name[128];
+			starpu_memory_node_get_name(node, name, sizeof(name));
+			fprintf(stream, "belady victims on memory node %s\n", name);
+			fprintf(stream, "\tnot queued : %u\n", belady_unused_cnt[node]);
+			fprintf(stream, "\tfurthest use : %u\n", belady_furthest_cnt[node]);
+			fprintf(stream, "\tleft to LRU : %u\n", belady_none_cnt[node]);
+		}
+	}
+	fprintf(stream, "#---------------------\n");
+}
+
@@ -65,6 +65,45 @@ void __starpu_data_allocation_inc_stats(unsigned node STARPU_ATTRIBUTE_UNUSED);
 
 void _starpu_display_alloc_cache_stats(FILE *stream);
 
+void __starpu_prefetch_lookahead_issued(unsigned node);
+void __starpu_prefetch_lookahead_hit(unsigned node);
+void __starpu_prefetch_lookahead_miss(unsigned node);
+void __starpu_prefetch_lookahead_cancel(unsigned node);
+
+#define _starpu_prefetch_lookahead_issued(node) do { \
+	if (starpu_enable_stats()) \
+		__starpu_prefetch_lookahead_issued(node); \
+} while (0)
+
+/** The task had its data prefetched on the node it got started on */
+#define _starpu_prefetch_lookahead_hit(node) do { \
+	if (starpu_enable_stats()) \
+		__starpu_prefetch_lookahead_hit(node); \
+} while (0)
+
+/** The task got started before the lookahead reached it */
+#define _starpu_prefetch_lookahead_miss(node) do { \
+	if (starpu_enable_stats()) \
+		__starpu_prefetch_lookahead_miss(node); \
+} while (0)
+
+/** The task got started on another memory node than the one it was prefetched for */
+#define _starpu_prefetch_lookahead_cancel(node) do { \
+	if (starpu_enable_stats()) \
+		__starpu_prefetch_lookahead_cancel(node); \
+} while (0)
+
+void _starpu_display_prefetch_lookahead_stats(FILE *stream);
+
+void __starpu_belady_victim(unsigned node, starpu_data_handle_t victim, int unused);
+
+/** The belady victim selector chose \p victim, which is not used by any
+ * queued task if \p unused is set, or did not find any (NULL) */
+#define _starpu_belady_victim(node, victim, unused) do { \
+	if (starpu_enable_stats()) \
+		__starpu_belady_victim(node, victim, unused); \
+} while (0)
+
 #pragma GCC visibility pop
 
 #endif // __DATASTATS_H__
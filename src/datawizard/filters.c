@@ -1136,3 +1136,57 @@ void starpu_filter_nparts_compute_chunk_size_and_offset(unsigned n, unsigned npa
 	if (offset != NULL)
 		*offset = (id *(n/nparts) + STARPU_MIN(remainder, id)) * blocksize * elemsize;
 }
+
+/* Return the first row of the nnz-balanced chunk k, given the first row of
+ * chunk k-1: the non-zero entries which remain from there are shared evenly
+ * between the remaining chunks, so that a few dense rows do not unbalance the
+ * others */
+static unsigned _starpu_filter_nnz_chunk_start(const uint32_t *rowptr, unsigned nrow, unsigned nparts, unsigned k, unsigned prev_start)
+{
+	uint32_t nnz = rowptr[nrow] - rowptr[0];
+	uint32_t prev_nnz = rowptr[prev_start] - rowptr[0];
+	uint32_t target = prev_nnz + (nnz - prev_nnz) / (nparts - k + 1);
+	unsigned low = prev_start, high = nrow;
+
+	/* Find the first row whose entries start at or after the target */
+	while (low < high)
+	{
+		unsigned middle = (low + high) / 2;
+		if (rowptr[middle] - rowptr[0] < target)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	/* The previous row may be closer to the target */
+	if (low > 0 && target - (rowptr[low-1] - rowptr[0]) < (rowptr[low] - rowptr[0]) - target)
+		low--;
+
+	/* Keep at least one row in each chunk */
+	if (low <= prev_start)
+		low = prev_start + 1;
+	if (low > nrow - (nparts - k))
+		low = nrow - (nparts - k);
+	return low;
+}
+
+void starpu_filter_nparts_compute_nnz_chunk_size_and_offset(const uint32_t *rowptr, unsigned nrow, unsigned nparts,
+							    unsigned id, size_t *chunk_size, size_t *offset)
+{
+	unsigned k;
+	unsigned start = 0, end;
+
+	STARPU_ASSERT_MSG(nparts <= nrow, "cannot split %u rows into %u parts", nrow, nparts);
+
+	/* Each chunk boundary depends on the previous one */
+	for (k = 1; k <= id; k++)
+		start = _starpu_filter_nnz_chunk_start(rowptr, nrow, nparts, k, start);
+	if (id == nparts - 1)
+		end = nrow;
+	else
+		end = _starpu_filter_nnz_chunk_start(rowptr, nrow, nparts, id + 1, start);
+
+	*chunk_size = end - start;
+	if (offset != NULL)
+		*offset = start;
+}
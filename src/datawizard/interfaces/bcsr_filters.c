@@ -19,11 +19,9 @@
 #include <common/config.h>
 #include <datawizard/filters.h>
 
-void starpu_bcsr_filter_vertical_block(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, STARPU_ATTRIBUTE_UNUSED unsigned nparts)
+/* Make the child contain the child_nrow rows of blocks of the parent starting from child_rowoffset */
+static void bcsr_filter_rows(struct starpu_bcsr_interface *bcsr_parent, struct starpu_bcsr_interface *bcsr_child, size_t child_rowoffset, size_t child_nrow)
 {
-	struct starpu_bcsr_interface *bcsr_parent = (struct starpu_bcsr_interface *) parent_interface;
-	struct starpu_bcsr_interface *bcsr_child = (struct starpu_bcsr_interface *) child_interface;
-
 	size_t elemsize = bcsr_parent->elemsize;
 	uint32_t firstentry = bcsr_parent->firstentry;
 	uint32_t r = bcsr_parent->r;
@@ -31,15 +29,10 @@ void starpu_bcsr_filter_vertical_block(void *parent_interface, void *child_inter
 	uint32_t *ram_rowptr = bcsr_parent->ram_rowptr;
 	uint32_t *rowptr = bcsr_parent->rowptr;
 
-	size_t child_nrow;
-	size_t child_rowoffset;
-
 	STARPU_ASSERT_MSG(bcsr_parent->id == STARPU_BCSR_INTERFACE_ID, "%s can only be applied on a bcsr data", __func__);
 
 	bcsr_child->id = bcsr_parent->id;
 
-	starpu_filter_nparts_compute_chunk_size_and_offset(bcsr_parent->nrow, nparts, 1, id, 1, &child_nrow, &child_rowoffset);
-
 	/* child blocks indexes between these (0-based) */
 	uint32_t start_block = ram_rowptr[child_rowoffset] - firstentry;
 	uint32_t end_block = ram_rowptr[child_rowoffset + child_nrow] - firstentry;
@@ -62,6 +55,30 @@ void starpu_bcsr_filter_vertical_block(void *parent_interface, void *child_inter
 	}
 }
 
+void starpu_bcsr_filter_vertical_block(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, unsigned nparts)
+{
+	struct starpu_bcsr_interface *bcsr_parent = (struct starpu_bcsr_interface *) parent_interface;
+	struct starpu_bcsr_interface *bcsr_child = (struct starpu_bcsr_interface *) child_interface;
+
+	size_t child_nrow;
+	size_t child_rowoffset;
+
+	starpu_filter_nparts_compute_chunk_size_and_offset(bcsr_parent->nrow, nparts, 1, id, 1, &child_nrow, &child_rowoffset);
+	bcsr_filter_rows(bcsr_parent, bcsr_child, child_rowoffset, child_nrow);
+}
+
+void starpu_bcsr_filter_vertical_block_nnz(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, unsigned nparts)
+{
+	struct starpu_bcsr_interface *bcsr_parent = (struct starpu_bcsr_interface *) parent_interface;
+	struct starpu_bcsr_interface *bcsr_child = (struct starpu_bcsr_interface *) child_interface;
+
+	size_t child_nrow;
+	size_t child_rowoffset;
+
+	starpu_filter_nparts_compute_nnz_chunk_size_and_offset(bcsr_parent->ram_rowptr, bcsr_parent->nrow, nparts, id, &child_nrow, &child_rowoffset);
+	bcsr_filter_rows(bcsr_parent, bcsr_child, child_rowoffset, child_nrow);
+}
+
 void starpu_bcsr_filter_canonical_block(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, STARPU_ATTRIBUTE_UNUSED unsigned nparts)
 {
 	struct starpu_bcsr_interface *bcsr_parent = (struct starpu_bcsr_interface *) parent_interface;
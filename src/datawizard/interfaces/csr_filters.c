@@ -19,22 +19,14 @@
 #include <common/config.h>
 #include <datawizard/filters.h>
 
-void starpu_csr_filter_vertical_block(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, unsigned nchunks)
+/* Make the child contain the child_nrow rows of the parent starting from first_index */
+static void csr_filter_rows(struct starpu_csr_interface *csr_parent, struct starpu_csr_interface *csr_child, size_t first_index, size_t child_nrow)
 {
-	struct starpu_csr_interface *csr_parent = (struct starpu_csr_interface *) parent_interface;
-	struct starpu_csr_interface *csr_child = (struct starpu_csr_interface *) child_interface;
-
-	uint32_t nrow = csr_parent->nrow;
 	size_t elemsize = csr_parent->elemsize;
 	uint32_t firstentry = csr_parent->firstentry;
 
 	uint32_t *ram_rowptr = csr_parent->ram_rowptr;
 
-	size_t first_index;
-	size_t child_nrow;
-
-	starpu_filter_nparts_compute_chunk_size_and_offset(nrow, nchunks, 1, id, 1, &child_nrow, &first_index);
-
 	uint32_t local_firstentry = ram_rowptr[first_index] - firstentry;
 	uint32_t local_lastentry = ram_rowptr[first_index + child_nrow] - firstentry;
 
@@ -56,3 +48,27 @@ void starpu_csr_filter_vertical_block(void *parent_interface, void *child_interf
 		csr_child->nzval = csr_parent->nzval + local_firstentry * elemsize;
 	}
 }
+
+void starpu_csr_filter_vertical_block(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, unsigned nchunks)
+{
+	struct starpu_csr_interface *csr_parent = (struct starpu_csr_interface *) parent_interface;
+	struct starpu_csr_interface *csr_child = (struct starpu_csr_interface *) child_interface;
+
+	size_t first_index;
+	size_t child_nrow;
+
+	starpu_filter_nparts_compute_chunk_size_and_offset(csr_parent->nrow, nchunks, 1, id, 1, &child_nrow, &first_index);
+	csr_filter_rows(csr_parent, csr_child, first_index, child_nrow);
+}
+
+void starpu_csr_filter_vertical_block_nnz(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, unsigned nchunks)
+{
+	struct starpu_csr_interface *csr_parent = (struct starpu_csr_interface *) parent_interface;
+	struct starpu_csr_interface *csr_child = (struct starpu_csr_interface *) child_interface;
+
+	size_t first_index;
+	size_t child_nrow;
+
+	starpu_filter_nparts_compute_nnz_chunk_size_and_offset(csr_parent->ram_rowptr, csr_parent->nrow, nchunks, id, &child_nrow, &first_index);
+	csr_filter_rows(csr_parent, csr_child, first_index, child_nrow);
+}
@@ -106,6 +106,9 @@ struct starpu_data_interface_ops *_starpu_data_interface_get_ops(unsigned interf
 		case STARPU_NDIM_INTERFACE_ID:
 			return &starpu_interface_ndim_ops;
 
+		case STARPU_SELL_INTERFACE_ID:
+			return &starpu_interface_sell_ops;
+
 		default:
 		{
 			if (interface_id-STARPU_MAX_INTERFACE_ID > _id_to_ops_array_size || _id_to_ops_array == NULL || _id_to_ops_array[interface_id-STARPU_MAX_INTERFACE_ID]==NULL)
@@ -1292,6 +1295,9 @@ void starpu_data_print(starpu_data_handle_t handle, unsigned node, FILE *stream)
 		case(STARPU_TENSOR_INTERFACE_ID):
 			fprintf(stream, "Tensor");
 			break;
+		case(STARPU_SELL_INTERFACE_ID):
+			fprintf(stream, "SELL");
+			break;
 		case(STARPU_UNKNOWN_INTERFACE_ID):
 			fprintf(stream, "UNKNOWN");
 			break;
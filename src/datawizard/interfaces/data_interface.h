@@ -42,6 +42,7 @@ union _starpu_interface
 	struct starpu_csr_interface csr;
 	struct starpu_bcsr_interface bcsr;
 	struct starpu_coo_interface coo;
+	struct starpu_sell_interface sell;
 };
 
 /** Some data interfaces or filters use this interface internally */
@@ -0,0 +1,73 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <datawizard/filters.h>
+
+void starpu_sell_filter_vertical_block(void *parent_interface, void *child_interface, STARPU_ATTRIBUTE_UNUSED struct starpu_data_filter *f, unsigned id, unsigned nparts)
+{
+	struct starpu_sell_interface *sell_parent = (struct starpu_sell_interface *) parent_interface;
+	struct starpu_sell_interface *sell_child = (struct starpu_sell_interface *) child_interface;
+
+	uint32_t nrow = sell_parent->nrow;
+	uint32_t c = sell_parent->c;
+	uint32_t sigma = sell_parent->sigma;
+	size_t elemsize = sell_parent->elemsize;
+	uint32_t firstentry = sell_parent->firstentry;
+	uint32_t *ram_sliceptr = sell_parent->ram_sliceptr;
+
+	/* Rows are only permuted within their sorting window, so splitting
+	 * on window boundaries keeps the slices and the rows of the children
+	 * contiguous */
+	uint32_t nwindows = (nrow + sigma - 1) / sigma;
+	size_t child_nwindows;
+	size_t child_windowoffset;
+
+	STARPU_ASSERT_MSG(sell_parent->id == STARPU_SELL_INTERFACE_ID, "%s can only be applied on a sell data", __func__);
+	STARPU_ASSERT_MSG(nparts <= nwindows, "cannot split %u sorting windows in %u parts", nwindows, nparts);
+
+	starpu_filter_nparts_compute_chunk_size_and_offset(nwindows, nparts, 1, id, 1, &child_nwindows, &child_windowoffset);
+
+	uint32_t first_row = child_windowoffset * sigma;
+	uint32_t child_nrow = STARPU_MIN(child_nwindows * sigma, nrow - first_row);
+	uint32_t first_slice = first_row / c;
+	uint32_t child_nslices = (child_nrow + c - 1) / c;
+
+	/* child entries indexes between these (0-based) */
+	uint32_t start_entry = ram_sliceptr[first_slice] - firstentry;
+	uint32_t end_entry = ram_sliceptr[first_slice + child_nslices] - firstentry;
+
+	sell_child->id = sell_parent->id;
+	sell_child->nnz = end_entry - start_entry;
+	sell_child->nrow = child_nrow;
+	sell_child->c = c;
+	sell_child->sigma = sigma;
+	sell_child->firstentry = firstentry + start_entry;
+	sell_child->firstrow = sell_parent->firstrow + first_row;
+	sell_child->elemsize = elemsize;
+	sell_child->ram_colind = sell_parent->ram_colind + start_entry;
+	sell_child->ram_sliceptr = ram_sliceptr + first_slice;
+	sell_child->ram_rowind = sell_parent->ram_rowind + first_row;
+
+	if (sell_parent->sliceptr)
+	{
+		sell_child->nzval = sell_parent->nzval + start_entry * elemsize;
+		sell_child->colind = sell_parent->colind + start_entry;
+		sell_child->sliceptr = sell_parent->sliceptr + first_slice;
+		sell_child->rowind = sell_parent->rowind + first_row;
+	}
+}
@@ -0,0 +1,564 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+
+/*
+ * SELL-C-sigma: sliced ELLPACK, slices of c rows are stored column-major
+ * and padded to their longest row, rows being sorted by length within
+ * windows of sigma rows.
+ */
+
+static int copy_any_to_any(void *src_interface, unsigned src_node, void *dst_interface, unsigned dst_node, void *async_data);
+
+static const struct starpu_data_copy_methods sell_copy_data_methods_s =
+{
+	.any_to_any = copy_any_to_any,
+};
+
+static void register_sell_handle(starpu_data_handle_t handle, int home_node, void *data_interface);
+static void *sell_to_pointer(void *data_interface, unsigned node);
+static starpu_ssize_t allocate_sell_buffer_on_node(void *data_interface, unsigned dst_node);
+static void free_sell_buffer_on_node(void *data_interface, unsigned node);
+static size_t sell_interface_get_size(starpu_data_handle_t handle);
+static int sell_compare(void *data_interface_a, void *data_interface_b);
+static uint32_t footprint_sell_interface_crc32(starpu_data_handle_t handle);
+static starpu_ssize_t describe(void *data_interface, char *buf, size_t size);
+static int pack_data(starpu_data_handle_t handle, unsigned node, void **ptr, starpu_ssize_t *count);
+static int peek_data(starpu_data_handle_t handle, unsigned node, void *ptr, size_t count);
+static int unpack_data(starpu_data_handle_t handle, unsigned node, void *ptr, size_t count);
+
+struct starpu_data_interface_ops starpu_interface_sell_ops =
+{
+	.register_data_handle = register_sell_handle,
+	.allocate_data_on_node = allocate_sell_buffer_on_node,
+	.free_data_on_node = free_sell_buffer_on_node,
+	.copy_methods = &sell_copy_data_methods_s,
+	.get_size = sell_interface_get_size,
+	.interfaceid = STARPU_SELL_INTERFACE_ID,
+	.interface_size = sizeof(struct starpu_sell_interface),
+	.footprint = footprint_sell_interface_crc32,
+	.compare = sell_compare,
+	.describe = describe,
+	.to_pointer = sell_to_pointer,
+	.name = "STARPU_SELL_INTERFACE",
+	.pack_data = pack_data,
+	.peek_data = peek_data,
+	.unpack_data = unpack_data,
+	.pack_meta = NULL,
+	.unpack_meta = NULL,
+	.free_meta = NULL
+};
+
+static uint32_t sell_nslices(struct starpu_sell_interface *sell)
+{
+	return (sell->nrow + sell->c - 1) / sell->c;
+}
+
+static void *sell_to_pointer(void *data_interface, unsigned node)
+{
+	(void) node;
+	struct starpu_sell_interface *sell_interface = data_interface;
+
+	/* The slice pointers are always allocated, even for empty matrices,
+	 * the MPI datatype is thus expressed relatively to them */
+	return (void*) sell_interface->sliceptr;
+}
+
+static void register_sell_handle(starpu_data_handle_t handle, int home_node, void *data_interface)
+{
+	struct starpu_sell_interface *sell_interface = (struct starpu_sell_interface *) data_interface;
+
+	int node;
+	uint32_t *ram_colind = NULL;
+	uint32_t *ram_sliceptr = NULL;
+	uint32_t *ram_rowind = NULL;
+
+	if (home_node >= 0 && starpu_node_get_kind(home_node) == STARPU_CPU_RAM)
+	{
+		ram_colind = sell_interface->colind;
+		ram_sliceptr = sell_interface->sliceptr;
+		ram_rowind = sell_interface->rowind;
+	}
+
+	for (node = 0; node < STARPU_MAXNODES; node++)
+	{
+		struct starpu_sell_interface *local_interface = (struct starpu_sell_interface *)
+			starpu_data_get_interface_on_node(handle, node);
+
+		if (node == home_node)
+		{
+			local_interface->nzval = sell_interface->nzval;
+			local_interface->colind = sell_interface->colind;
+			local_interface->sliceptr = sell_interface->sliceptr;
+			local_interface->rowind = sell_interface->rowind;
+		}
+		else
+		{
+			local_interface->nzval = 0;
+			local_interface->colind = NULL;
+			local_interface->sliceptr = NULL;
+			local_interface->rowind = NULL;
+		}
+
+		local_interface->ram_colind = ram_colind;
+		local_interface->ram_sliceptr = ram_sliceptr;
+		local_interface->ram_rowind = ram_rowind;
+		local_interface->id = sell_interface->id;
+		local_interface->nnz = sell_interface->nnz;
+		local_interface->nrow = sell_interface->nrow;
+		local_interface->c = sell_interface->c;
+		local_interface->sigma = sell_interface->sigma;
+		local_interface->firstentry = sell_interface->firstentry;
+		local_interface->firstrow = sell_interface->firstrow;
+		local_interface->elemsize = sell_interface->elemsize;
+	}
+}
+
+void starpu_sell_data_register(starpu_data_handle_t *handleptr, int home_node,
+			       uint32_t nnz, uint32_t nrow, uint32_t c, uint32_t sigma,
+			       uintptr_t nzval, uint32_t *colind, uint32_t *sliceptr,
+			       uint32_t *rowind, uint32_t firstentry, size_t elemsize)
+{
+	struct starpu_sell_interface sell_interface =
+	{
+		.id = STARPU_SELL_INTERFACE_ID,
+		.nzval = nzval,
+		.colind = colind,
+		.sliceptr = sliceptr,
+		.rowind = rowind,
+		.nnz = nnz,
+		.nrow = nrow,
+		.c = c,
+		.sigma = sigma,
+		.firstentry = firstentry,
+		.firstrow = 0,
+		.elemsize = elemsize
+	};
+
+	STARPU_ASSERT_MSG(c > 0, "the slices of a SELL matrix need to have at least one row");
+	STARPU_ASSERT_MSG(sigma >= c && sigma % c == 0, "the sorting window of a SELL matrix (%u) needs to be a multiple of the height of its slices (%u)", sigma, c);
+
+	if (home_node >= 0)
+	{
+		starpu_check_on_node(home_node, nzval, nnz*elemsize);
+		starpu_check_on_node(home_node, (uintptr_t) colind, nnz*sizeof(uint32_t));
+		starpu_check_on_node(home_node, (uintptr_t) sliceptr, (sell_nslices(&sell_interface)+1)*sizeof(uint32_t));
+		starpu_check_on_node(home_node, (uintptr_t) rowind, nrow*sizeof(uint32_t));
+	}
+
+	starpu_data_register(handleptr, home_node, &sell_interface, &starpu_interface_sell_ops);
+}
+
+static uint32_t footprint_sell_interface_crc32(starpu_data_handle_t handle)
+{
+	uint32_t hash;
+
+	hash = starpu_hash_crc32c_be(starpu_sell_get_nnz(handle), 0);
+	hash = starpu_hash_crc32c_be(starpu_sell_get_nrow(handle), hash);
+	hash = starpu_hash_crc32c_be(starpu_sell_get_c(handle), hash);
+
+	return hash;
+}
+
+static int sell_compare(void *data_interface_a, void *data_interface_b)
+{
+	struct starpu_sell_interface *sell_a = (struct starpu_sell_interface *) data_interface_a;
+	struct starpu_sell_interface *sell_b = (struct starpu_sell_interface *) data_interface_b;
+
+	/* Two matrices are considered compatible if they have the same size */
+	return (sell_a->nnz == sell_b->nnz)
+		&& (sell_a->nrow == sell_b->nrow)
+		&& (sell_a->c == sell_b->c)
+		&& (sell_a->sigma == sell_b->sigma)
+		&& (sell_a->elemsize == sell_b->elemsize);
+}
+
+/* offer an access to the data parameters */
+uint32_t starpu_sell_get_nnz(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->nnz;
+}
+
+uint32_t starpu_sell_get_nrow(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->nrow;
+}
+
+uint32_t starpu_sell_get_c(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->c;
+}
+
+uint32_t starpu_sell_get_sigma(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->sigma;
+}
+
+uint32_t starpu_sell_get_firstentry(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->firstentry;
+}
+
+uint32_t starpu_sell_get_firstrow(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->firstrow;
+}
+
+size_t starpu_sell_get_elemsize(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->elemsize;
+}
+
+uintptr_t starpu_sell_get_local_nzval(starpu_data_handle_t handle)
+{
+	unsigned node;
+	node = starpu_worker_get_local_memory_node();
+
+	STARPU_ASSERT(starpu_data_test_if_allocated_on_node(handle, node));
+
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, node);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->nzval;
+}
+
+uint32_t *starpu_sell_get_local_colind(starpu_data_handle_t handle)
+{
+	unsigned node;
+	node = starpu_worker_get_local_memory_node();
+
+	STARPU_ASSERT(starpu_data_test_if_allocated_on_node(handle, node));
+
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, node);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->colind;
+}
+
+uint32_t *starpu_sell_get_local_sliceptr(starpu_data_handle_t handle)
+{
+	unsigned node;
+	node = starpu_worker_get_local_memory_node();
+
+	STARPU_ASSERT(starpu_data_test_if_allocated_on_node(handle, node));
+
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, node);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->sliceptr;
+}
+
+uint32_t *starpu_sell_get_local_rowind(starpu_data_handle_t handle)
+{
+	unsigned node;
+	node = starpu_worker_get_local_memory_node();
+
+	STARPU_ASSERT(starpu_data_test_if_allocated_on_node(handle, node));
+
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, node);
+
+#ifdef STARPU_DEBUG
+	STARPU_ASSERT_MSG(data_interface->id == STARPU_SELL_INTERFACE_ID, "Error. The given data is not a sell.");
+#endif
+
+	return data_interface->rowind;
+}
+
+static size_t sell_interface_get_size(starpu_data_handle_t handle)
+{
+	struct starpu_sell_interface *data_interface = (struct starpu_sell_interface *)
+		starpu_data_get_interface_on_node(handle, STARPU_MAIN_RAM);
+
+	uint32_t nnz = data_interface->nnz;
+	uint32_t nrow = data_interface->nrow;
+	uint32_t nslices = sell_nslices(data_interface);
+	size_t elemsize = data_interface->elemsize;
+
+	return nnz*elemsize + nnz*sizeof(uint32_t) + (nslices+1)*sizeof(uint32_t) + nrow*sizeof(uint32_t);
+}
+
+/* memory allocation/deallocation primitives for the SELL interface */
+
+/* returns the size of the allocated area */
+static starpu_ssize_t allocate_sell_buffer_on_node(void *data_interface_, unsigned dst_node)
+{
+	uintptr_t addr_nzval, addr_colind, addr_sliceptr, addr_rowind;
+	starpu_ssize_t allocated_memory;
+
+	/* we need the 4 arrays to be allocated */
+	struct starpu_sell_interface *sell_interface = (struct starpu_sell_interface *) data_interface_;
+
+	uint32_t nnz = sell_interface->nnz;
+	uint32_t nrow = sell_interface->nrow;
+	uint32_t nslices = sell_nslices(sell_interface);
+	size_t elemsize = sell_interface->elemsize;
+
+	if (nnz)
+	{
+		addr_nzval = starpu_malloc_on_node(dst_node, nnz*elemsize);
+		if (!addr_nzval)
+			goto fail_nzval;
+		addr_colind = starpu_malloc_on_node(dst_node, nnz*sizeof(uint32_t));
+		if (!addr_colind)
+			goto fail_colind;
+	}
+	else
+	{
+		addr_nzval = addr_colind = 0;
+	}
+	addr_sliceptr = starpu_malloc_on_node(dst_node, (nslices+1)*sizeof(uint32_t));
+	if (!addr_sliceptr)
+		goto fail_sliceptr;
+	if (nrow)
+	{
+		addr_rowind = starpu_malloc_on_node(dst_node, nrow*sizeof(uint32_t));
+		if (!addr_rowind)
+			goto fail_rowind;
+	}
+	else
+	{
+		addr_rowind = 0;
+	}
+
+	/* allocation succeeded */
+	allocated_memory =
+		nnz*elemsize + nnz*sizeof(uint32_t) + (nslices+1)*sizeof(uint32_t) + nrow*sizeof(uint32_t);
+
+	/* update the data properly in consequence */
+	sell_interface->nzval = addr_nzval;
+	sell_interface->colind = (uint32_t*) addr_colind;
+	sell_interface->sliceptr = (uint32_t*) addr_sliceptr;
+	sell_interface->rowind = (uint32_t*) addr_rowind;
+
+	return allocated_memory;
+
+fail_rowind:
+	starpu_free_on_node(dst_node, addr_sliceptr, (nslices+1)*sizeof(uint32_t));
+fail_sliceptr:
+	if (nnz)
+		starpu_free_on_node(dst_node, addr_colind, nnz*sizeof(uint32_t));
+fail_colind:
+	if (nnz)
+		starpu_free_on_node(dst_node, addr_nzval, nnz*elemsize);
+fail_nzval:
+	/* allocation failed */
+	return -ENOMEM;
+}
+
+static void free_sell_buffer_on_node(void *data_interface, unsigned node)
+{
+	struct starpu_sell_interface *sell_interface = (struct starpu_sell_interface *) data_interface;
+	uint32_t nnz = sell_interface->nnz;
+	uint32_t nrow = sell_interface->nrow;
+	uint32_t nslices = sell_nslices(sell_interface);
+	size_t elemsize = sell_interface->elemsize;
+
+	if (nnz)
+	{
+		starpu_free_on_node(node, sell_interface->nzval, nnz*elemsize);
+		sell_interface->nzval = 0;
+		starpu_free_on_node(node, (uintptr_t) sell_interface->colind, nnz*sizeof(uint32_t));
+		sell_interface->colind = NULL;
+	}
+	starpu_free_on_node(node, (uintptr_t) sell_interface->sliceptr, (nslices+1)*sizeof(uint32_t));
+	sell_interface->sliceptr = NULL;
+	if (nrow)
+	{
+		starpu_free_on_node(node, (uintptr_t) sell_interface->rowind, nrow*sizeof(uint32_t));
+		sell_interface->rowind = NULL;
+	}
+}
+
+static int copy_any_to_any(void *src_interface, unsigned src_node, void *dst_interface, unsigned dst_node, void *async_data)
+{
+	struct starpu_sell_interface *src_sell = (struct starpu_sell_interface *) src_interface;
+	struct starpu_sell_interface *dst_sell = (struct starpu_sell_interface *) dst_interface;
+
+	uint32_t nnz = src_sell->nnz;
+	uint32_t nrow = src_sell->nrow;
+	uint32_t nslices = sell_nslices(src_sell);
+	size_t elemsize = src_sell->elemsize;
+
+	int ret = 0;
+
+	if (nnz)
+	{
+		if (starpu_interface_copy(src_sell->nzval, 0, src_node, dst_sell->nzval, 0, dst_node, nnz*elemsize, async_data))
+			ret = -EAGAIN;
+
+		if (starpu_interface_copy((uintptr_t)src_sell->colind, 0, src_node, (uintptr_t)dst_sell->colind, 0, dst_node, nnz*sizeof(uint32_t), async_data))
+			ret = -EAGAIN;
+	}
+
+	if (starpu_interface_copy((uintptr_t)src_sell->sliceptr, 0, src_node, (uintptr_t)dst_sell->sliceptr, 0, dst_node, (nslices+1)*sizeof(uint32_t), async_data))
+		ret = -EAGAIN;
+
+	if (nrow)
+	{
+		if (starpu_interface_copy((uintptr_t)src_sell->rowind, 0, src_node, (uintptr_t)dst_sell->rowind, 0, dst_node, nrow*sizeof(uint32_t), async_data))
+			ret = -EAGAIN;
+	}
+
+	starpu_interface_data_copy(src_node, dst_node, nnz*elemsize + (nnz+nslices+1+nrow)*sizeof(uint32_t));
+
+	return ret;
+}
+
+static starpu_ssize_t describe(void *data_interface, char *buf, size_t size)
+{
+	struct starpu_sell_interface *sell = (struct starpu_sell_interface *) data_interface;
+	return snprintf(buf, size, "S%ux%ux%ux%ux%u",
+			(unsigned) sell->nnz,
+			(unsigned) sell->nrow,
+			(unsigned) sell->c,
+			(unsigned) sell->sigma,
+			(unsigned) sell->elemsize);
+}
+
+/* The data is packed in the same order as the blocks of the MPI datatype,
+ * i.e. sliceptr, rowind, colind then nzval, so that data received with the
+ * datatype can be unpacked and the other way round */
+static int pack_data(starpu_data_handle_t handle, unsigned node, void **ptr, starpu_ssize_t *count)
+{
+	STARPU_ASSERT(starpu_data_test_if_allocated_on_node(handle, node));
+
+	struct starpu_sell_interface *sell = (struct starpu_sell_interface *) starpu_data_get_interface_on_node(handle, node);
+	uint32_t nslices = sell_nslices(sell);
+
+	*count = (nslices + 1) * sizeof(sell->sliceptr[0]);
+	*count += sell->nrow * sizeof(sell->rowind[0]);
+	*count += sell->nnz * sizeof(sell->colind[0]);
+	*count += sell->nnz * sell->elemsize;
+
+	if (ptr != NULL)
+	{
+		*ptr = (void *)starpu_malloc_on_node_flags(node, *count, 0);
+		char *tmp = *ptr;
+		memcpy(tmp, (void*)sell->sliceptr, (nslices + 1) * sizeof(sell->sliceptr[0]));
+		tmp += (nslices + 1) * sizeof(sell->sliceptr[0]);
+		if (sell->nrow)
+		{
+			memcpy(tmp, (void*)sell->rowind, sell->nrow * sizeof(sell->rowind[0]));
+			tmp += sell->nrow * sizeof(sell->rowind[0]);
+		}
+		if (sell->nnz)
+		{
+			memcpy(tmp, (void*)sell->colind, sell->nnz * sizeof(sell->colind[0]));
+			tmp += sell->nnz * sizeof(sell->colind[0]);
+			memcpy(tmp, (void*)sell->nzval, sell->nnz * sell->elemsize);
+		}
+	}
+
+	return 0;
+}
+
+static int peek_data(starpu_data_handle_t handle, unsigned node, void *ptr, size_t count)
+{
+	STARPU_ASSERT(starpu_data_test_if_allocated_on_node(handle, node));
+
+	struct starpu_sell_interface *sell = (struct starpu_sell_interface *) starpu_data_get_interface_on_node(handle, node);
+	uint32_t nslices = sell_nslices(sell);
+
+	STARPU_ASSERT(count == (nslices + 1) * sizeof(sell->sliceptr[0]) + sell->nrow * sizeof(sell->rowind[0]) + sell->nnz * (sizeof(sell->colind[0]) + sell->elemsize));
+
+	char *tmp = ptr;
+	memcpy((void*)sell->sliceptr, tmp, (nslices + 1) * sizeof(sell->sliceptr[0]));
+	tmp += (nslices + 1) * sizeof(sell->sliceptr[0]);
+	if (sell->nrow)
+	{
+		memcpy((void*)sell->rowind, tmp, sell->nrow * sizeof(sell->rowind[0]));
+		tmp += sell->nrow * sizeof(sell->rowind[0]);
+	}
+	if (sell->nnz)
+	{
+		memcpy((void*)sell->colind, tmp, sell->nnz * sizeof(sell->colind[0]));
+		tmp += sell->nnz * sizeof(sell->colind[0]);
+		memcpy((void*)sell->nzval, tmp, sell->nnz * sell->elemsize);
+	}
+
+	return 0;
+}
+
+static int unpack_data(starpu_data_handle_t handle, unsigned node, void *ptr, size_t count)
+{
+	peek_data(handle, node, ptr, count);
+	starpu_free_on_node_flags(node, (uintptr_t)ptr, count, 0);
+
+	return 0;
+}
@@ -34,6 +34,8 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <smpi/smpi.h>
+#elif defined(HAVE_MMAP)
+#include <sys/mman.h>
 #endif
 
 #ifdef STARPU_HAVE_HWLOC
@@ -57,6 +59,13 @@
 static size_t _malloc_align = sizeof(void*);
 static int disable_pinning;
 static int enable_suballocator;
+/* Maximum amount of memory kept in the per-node pools, 0 disables them */
+static size_t malloc_pool_size;
+/* 0: no huge pages, 1: transparent huge pages, 2: 2MiB hugetlbfs pages, 3: also 1GiB hugetlbfs pages */
+static int malloc_hugepages;
+
+#define MALLOC_HUGEPAGE_SIZE (2*1024*1024)
+#define MALLOC_GIGAPAGE_SIZE (1024*1024*1024)
 
 /* This file is used for implementing "folded" allocation */
 #ifdef STARPU_SIMGRID
@@ -752,6 +761,82 @@ int starpu_free_noflag(void *A, size_t dim)
 	return starpu_free_flags(A, dim, STARPU_MALLOC_PINNED);
 }
 
+/* Return whether we should back this allocation with huge pages */
+static int _starpu_malloc_should_hugepage(unsigned dst_node, size_t size, int flags)
+{
+#if defined(HAVE_MMAP) && !defined(STARPU_SIMGRID)
+	return malloc_hugepages > 0 && !malloc_hook
+		&& size >= MALLOC_HUGEPAGE_SIZE
+		&& starpu_node_get_kind(dst_node) == STARPU_CPU_RAM
+		&& !_starpu_malloc_should_pin(flags);
+#else
+	(void) dst_node;
+	(void) size;
+	(void) flags;
+	return 0;
+#endif
+}
+
+#if defined(HAVE_MMAP) && !defined(STARPU_SIMGRID)
+/* Size actually mapped for a huge page allocation */
+static size_t _starpu_malloc_hugepage_size(size_t size)
+{
+	size_t page = MALLOC_HUGEPAGE_SIZE;
+	if (malloc_hugepages >= 3 && size >= MALLOC_GIGAPAGE_SIZE)
+		page = MALLOC_GIGAPAGE_SIZE;
+	return (size + page - 1) & ~(page - 1);
+}
+
+static uintptr_t _starpu_malloc_hugepage_on_node(unsigned dst_node, size_t size)
+{
+	size_t mapsize = _starpu_malloc_hugepage_size(size);
+	void *addr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (malloc_hugepages >= 2)
+	{
+		int mapflags = MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB;
+#ifdef MAP_HUGE_1GB
+		if (malloc_hugepages >= 3 && size >= MALLOC_GIGAPAGE_SIZE)
+			mapflags |= MAP_HUGE_1GB;
+#endif
+		addr = mmap(NULL, mapsize, PROT_READ|PROT_WRITE, mapflags, -1, 0);
+	}
+#endif
+	if (addr == MAP_FAILED)
+	{
+		/* No reserved huge pages, fallback to transparent huge pages */
+		addr = mmap(NULL, mapsize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if (addr == MAP_FAILED)
+			return 0;
+#ifdef MADV_HUGEPAGE
+		madvise(addr, mapsize, MADV_HUGEPAGE);
+#endif
+	}
+
+#ifdef STARPU_HAVE_HWLOC
+	if (starpu_memory_nodes_get_numa_count() > 1)
+	{
+		struct _starpu_machine_config *config = _starpu_get_machine_config();
+		hwloc_topology_t hwtopology = config->topology.hwtopology;
+		hwloc_obj_t numa_node_obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, starpu_memory_nodes_numa_id_to_hwloclogid(dst_node));
+		if (numa_node_obj)
+		{
+#if HWLOC_API_VERSION >= 0x00020000
+			hwloc_set_area_membind(hwtopology, addr, mapsize, numa_node_obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_BYNODESET | HWLOC_MEMBIND_NOCPUBIND);
+#else
+			hwloc_set_area_membind_nodeset(hwtopology, addr, mapsize, numa_node_obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_NOCPUBIND);
+#endif
+		}
+	}
+#else
+	(void) dst_node;
+#endif
+
+	return (uintptr_t) addr;
+}
+#endif
+
 static uintptr_t _starpu_malloc_on_node(unsigned dst_node, size_t size, int flags)
 {
 	uintptr_t addr = 0;
@@ -769,6 +854,11 @@ static uintptr_t _starpu_malloc_on_node(unsigned dst_node, size_t size, int flag
 	}
 
 	const struct _starpu_node_ops *node_ops = _starpu_memory_node_get_node_ops(dst_node);
+#if defined(HAVE_MMAP) && !defined(STARPU_SIMGRID)
+	if (_starpu_malloc_should_hugepage(dst_node, size, flags))
+		addr = _starpu_malloc_hugepage_on_node(dst_node, size);
+	else
+#endif
 	if (node_ops && node_ops->malloc_on_device)
 	{
 		int devid = starpu_memory_node_get_devid(dst_node);
@@ -796,6 +886,11 @@ void _starpu_free_on_node_flags(unsigned dst_node, uintptr_t addr, size_t size,
 		size = 1;
 
 	const struct _starpu_node_ops *node_ops = _starpu_memory_node_get_node_ops(dst_node);
+#if defined(HAVE_MMAP) && !defined(STARPU_SIMGRID)
+	if (_starpu_malloc_should_hugepage(dst_node, size, flags))
+		munmap((void*) addr, _starpu_malloc_hugepage_size(size));
+	else
+#endif
 	if (node_ops && node_ops->free_on_device)
 	{
 		int devid = starpu_memory_node_get_devid(dst_node);
@@ -861,19 +956,52 @@ _starpu_malloc_init(unsigned dst_node)
 	STARPU_PTHREAD_MUTEX_INIT(&node_struct->chunk_mutex, NULL);
 	disable_pinning = starpu_getenv_number("STARPU_DISABLE_PINNING");
 	enable_suballocator = starpu_getenv_number_default("STARPU_SUBALLOCATOR", 1);
+	malloc_pool_size = (size_t) starpu_getenv_number_default("STARPU_MALLOC_POOL", 0) << 20;
+	malloc_hugepages = starpu_getenv_number_default("STARPU_MALLOC_HUGEPAGES", 0);
 	node_struct->malloc_on_node_default_flags = STARPU_MALLOC_PINNED | STARPU_MALLOC_COUNT;
+	unsigned i;
+	for (i = 0; i < MALLOC_POOL_NCLASSES; i++)
+		_starpu_pool_block_list_init(&node_struct->pool[i]);
+	node_struct->pool_size = 0;
+	memset(&node_struct->pool_stats, 0, sizeof(node_struct->pool_stats));
+	STARPU_PTHREAD_MUTEX_INIT(&node_struct->pool_mutex, NULL);
+	node_struct->pool_shutdown = 0;
 #ifdef STARPU_SIMGRID
 	/* Reasonably "costless" */
 	_starpu_malloc_simulation_fold = starpu_getenv_number_default("STARPU_MALLOC_SIMULATION_FOLD", 1) << 20;
 #endif
 }
 
+void
+_starpu_malloc_pool_shutdown(unsigned dst_node)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+
+	if (node_struct->pool_shutdown)
+		return;
+	node_struct->pool_shutdown = 1;
+
+	if (malloc_pool_size && starpu_getenv_number("STARPU_MALLOC_POOL_STATS") > 0)
+	{
+		struct _starpu_malloc_pool_stats *stats = &node_struct->pool_stats;
+		char name[32];
+		starpu_memory_node_get_name(dst_node, name, sizeof(name));
+		_STARPU_DISP("Allocation pool on node %s: %lu hits, %lu misses, %lu frees cached, %lu frees released, %lu flushed, %lu MiB max cached\n",
+			     name, stats->hits, stats->misses, stats->cached, stats->released, stats->flushed,
+			     (unsigned long) (stats->max_cached_size >> 20));
+	}
+	_starpu_malloc_pool_flush(dst_node);
+	STARPU_PTHREAD_MUTEX_DESTROY(&node_struct->pool_mutex);
+}
+
 void
 _starpu_malloc_shutdown(unsigned dst_node)
 {
 	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
 	struct _starpu_chunk *chunk, *next_chunk;
 
+	_starpu_malloc_pool_shutdown(dst_node);
+
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->chunk_mutex);
 	for (chunk = _starpu_chunk_list_begin(&node_struct->chunks);
 	     chunk != _starpu_chunk_list_end(&node_struct->chunks);
@@ -888,6 +1016,159 @@ _starpu_malloc_shutdown(unsigned dst_node)
 	STARPU_PTHREAD_MUTEX_DESTROY(&node_struct->chunk_mutex);
 }
 
+/* Return the size class of a pool buffer */
+static unsigned _starpu_malloc_pool_class(size_t size)
+{
+	unsigned log2 = 0, sub = 0, class;
+	size_t s = size;
+
+	while (s >>= 1)
+		log2++;
+	/* Use the two bits following the most significant one */
+	if (log2 >= 2)
+		sub = (size >> (log2 - 2)) & 3;
+	class = log2 * 4 + sub;
+	if (class >= MALLOC_POOL_NCLASSES)
+		class = MALLOC_POOL_NCLASSES - 1;
+	return class;
+}
+
+size_t _starpu_malloc_pool_flush(unsigned dst_node)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+	struct _starpu_pool_block_list blocks;
+	struct _starpu_pool_block *block;
+	size_t freed = 0;
+	unsigned i;
+
+	if (!malloc_pool_size)
+		return 0;
+
+	/* Detach the cached buffers, and release them without the lock */
+	_starpu_pool_block_list_init(&blocks);
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->pool_mutex);
+	for (i = 0; i < MALLOC_POOL_NCLASSES; i++)
+		if (!_starpu_pool_block_list_empty(&node_struct->pool[i]))
+		{
+			_starpu_pool_block_list_push_list_back(&blocks, &node_struct->pool[i]);
+			_starpu_pool_block_list_init(&node_struct->pool[i]);
+		}
+	node_struct->pool_size = 0;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->pool_mutex);
+
+	while (!_starpu_pool_block_list_empty(&blocks))
+	{
+		block = _starpu_pool_block_list_pop_front(&blocks);
+		/* Cached buffers are accounted as used memory */
+		_starpu_free_on_node_flags(dst_node, block->addr, block->size, block->flags | STARPU_MALLOC_COUNT);
+		freed += block->size;
+		_starpu_pool_block_delete(block);
+		STARPU_PTHREAD_MUTEX_LOCK(&node_struct->pool_mutex);
+		node_struct->pool_stats.flushed++;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->pool_mutex);
+	}
+	return freed;
+}
+
+/* Allocate from the pool if a buffer of the same size is cached, otherwise allocate normally */
+static uintptr_t _starpu_malloc_pool_alloc(unsigned dst_node, size_t size, int flags)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+	struct _starpu_pool_block_list *list = &node_struct->pool[_starpu_malloc_pool_class(size)];
+	struct _starpu_pool_block *block;
+	int pool_flags = flags & ~STARPU_MALLOC_COUNT;
+	uintptr_t addr;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->pool_mutex);
+	for (block = _starpu_pool_block_list_begin(list);
+	     block != _starpu_pool_block_list_end(list);
+	     block = _starpu_pool_block_list_next(block))
+		if (block->size == size && block->flags == pool_flags)
+			break;
+	if (block != _starpu_pool_block_list_end(list))
+	{
+		_starpu_pool_block_list_erase(list, block);
+		node_struct->pool_size -= size;
+		node_struct->pool_stats.hits++;
+	}
+	else
+	{
+		block = NULL;
+		node_struct->pool_stats.misses++;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->pool_mutex);
+
+	if (block)
+	{
+		addr = block->addr;
+		_starpu_pool_block_delete(block);
+		/* Cached buffers are still accounted as used memory */
+		if (!(flags & STARPU_MALLOC_COUNT))
+			starpu_memory_deallocate(dst_node, size);
+		return addr;
+	}
+
+	addr = _starpu_malloc_on_node(dst_node, size, flags);
+	if (!addr && _starpu_malloc_pool_flush(dst_node))
+		/* Buffers of other sizes were holding memory, try again */
+		addr = _starpu_malloc_on_node(dst_node, size, flags);
+	return addr;
+}
+
+/* Keep the freed buffer in the pool, unless it is already full */
+static void _starpu_malloc_pool_free(unsigned dst_node, uintptr_t addr, size_t size, int flags)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+	struct _starpu_pool_block *block;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->pool_mutex);
+	if (node_struct->pool_size + size > malloc_pool_size)
+	{
+		node_struct->pool_stats.released++;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->pool_mutex);
+		_starpu_free_on_node_flags(dst_node, addr, size, flags);
+		return;
+	}
+
+	block = _starpu_pool_block_new();
+	block->addr = addr;
+	block->size = size;
+	block->flags = flags & ~STARPU_MALLOC_COUNT;
+	/* Most recently freed first, its pages are more likely to be still hot */
+	_starpu_pool_block_list_push_front(&node_struct->pool[_starpu_malloc_pool_class(size)], block);
+	node_struct->pool_size += size;
+	node_struct->pool_stats.cached++;
+	if (node_struct->pool_size > node_struct->pool_stats.max_cached_size)
+		node_struct->pool_stats.max_cached_size = node_struct->pool_size;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->pool_mutex);
+
+	/* Keep cached buffers accounted as used memory, so that they count
+	 * against the memory limits of the node, until they are flushed */
+	if (!(flags & STARPU_MALLOC_COUNT))
+		starpu_memory_allocate(dst_node, size, STARPU_MEMORY_OVERFLOW);
+}
+
+int starpu_malloc_pool_get_stats(unsigned node, struct starpu_malloc_pool_stats *stats)
+{
+	struct _starpu_node *node_struct;
+
+	STARPU_ASSERT_MSG(node < STARPU_MAXNODES, "bogus node value %u given to starpu_malloc_pool_get_stats\n", node);
+	if (!malloc_pool_size)
+		return -ENODEV;
+
+	node_struct = _starpu_get_node_struct(node);
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->pool_mutex);
+	stats->hits = node_struct->pool_stats.hits;
+	stats->misses = node_struct->pool_stats.misses;
+	stats->cached = node_struct->pool_stats.cached;
+	stats->released = node_struct->pool_stats.released;
+	stats->flushed = node_struct->pool_stats.flushed;
+	stats->cached_size = node_struct->pool_size;
+	stats->max_cached_size = node_struct->pool_stats.max_cached_size;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->pool_mutex);
+	return 0;
+}
+
 /* Create a new chunk */
 static struct _starpu_chunk *_starpu_new_chunk(unsigned dst_node, int flags)
 {
@@ -932,7 +1213,11 @@ starpu_malloc_on_node_flags(unsigned dst_node, size_t size, int flags)
 {
 	/* Big allocation, allocate normally */
 	if (!_starpu_malloc_should_suballoc(dst_node, size, flags))
+	{
+		if (malloc_pool_size)
+			return _starpu_malloc_pool_alloc(dst_node, size, flags);
 		return _starpu_malloc_on_node(dst_node, size, flags);
+	}
 
 	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
 
@@ -1035,7 +1320,10 @@ starpu_free_on_node_flags(unsigned dst_node, uintptr_t addr, size_t size, int fl
 	/* Big allocation, deallocate normally */
 	if (!_starpu_malloc_should_suballoc(dst_node, size, flags))
 	{
-		_starpu_free_on_node_flags(dst_node, addr, size, flags);
+		if (malloc_pool_size)
+			_starpu_malloc_pool_free(dst_node, addr, size, flags);
+		else
+			_starpu_free_on_node_flags(dst_node, addr, size, flags);
 		return;
 	}
 
@@ -96,6 +96,37 @@ LIST_TYPE(_starpu_chunk,
 	struct block bitmap[CHUNK_NBLOCKS+1];
 )
 
+/**
+ * For allocations which are not suballocated, keep a per-node pool of freed
+ * buffers, to be reused by later allocations of the exact same size and
+ * flags. Buffers are sorted in size classes (four classes per power of two)
+ * to keep the lists to be searched short.
+ */
+#define MALLOC_POOL_NCLASSES (64*4)
+
+/* One cached buffer */
+LIST_TYPE(_starpu_pool_block,
+	uintptr_t addr;
+	size_t size;
+	int flags;
+)
+
+/* Statistics of the pool of one node, protected by the node pool_mutex */
+struct _starpu_malloc_pool_stats
+{
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long cached;
+	unsigned long released;
+	unsigned long flushed;
+	size_t max_cached_size;
+};
+
+/** Release all the buffers cached in the pool of \p dst_node, return the amount of released memory */
+size_t _starpu_malloc_pool_flush(unsigned dst_node);
+/** Display the statistics of the pool of \p dst_node and release it, only the first call has an effect */
+void _starpu_malloc_pool_shutdown(unsigned dst_node);
+
 #pragma GCC visibility pop
 
 #endif
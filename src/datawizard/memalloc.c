@@ -19,6 +19,7 @@
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memalloc.h>
 #include <datawizard/footprint.h>
+#include <datawizard/prefetch_lookahead.h>
 #include <core/disk.h>
 #include <core/topology.h>
 #include <starpu.h>
@@ -149,6 +150,11 @@ void _starpu_mem_chunk_disk_register(unsigned disk_memnode)
 static int get_better_disk_can_accept_size(starpu_data_handle_t handle, unsigned node);
 static int choose_target(starpu_data_handle_t handle, unsigned node);
 
+/* Serializes belady victim selections on a node, and protects the
+ * next_use_stamp and next_use fields of the replicates of the node */
+static starpu_pthread_mutex_t belady_mutex[STARPU_MAXNODES];
+static unsigned belady_stamp[STARPU_MAXNODES];
+
 void _starpu_init_mem_chunk_lists(void)
 {
 	unsigned i;
@@ -161,6 +167,7 @@ void _starpu_init_mem_chunk_lists(void)
 		STARPU_HG_DISABLE_CHECKING(node->mc_nb);
 		STARPU_HG_DISABLE_CHECKING(node->mc_clean_nb);
 		STARPU_HG_DISABLE_CHECKING(node->prefetch_out_of_memory);
+		STARPU_PTHREAD_MUTEX_INIT(&belady_mutex[i], NULL);
 	}
 	/* We do not enable forcing available memory by default, since
 	  this makes StarPU spuriously free data when prefetching fills the
@@ -192,6 +199,7 @@ void _starpu_deinit_mem_chunk_lists(void)
 		STARPU_ASSERT(node->mc_cache_nb == 0);
 		STARPU_ASSERT(node->mc_cache_size == 0);
 		_starpu_spin_destroy(&node->mc_lock);
+		STARPU_PTHREAD_MUTEX_DESTROY(&belady_mutex[i]);
 	}
 }
 
@@ -571,11 +579,20 @@ int starpu_data_can_evict(starpu_data_handle_t handle, unsigned node, enum starp
 static starpu_data_victim_selector *victim_selector;
 static void *data_victim_selector;
 static starpu_data_victim_eviction_failed *victim_eviction_failed;
+/* Whether to fall back to LRU when the selected victim can not be evicted */
+static int victim_lru_fallback;
 void starpu_data_register_victim_selector(starpu_data_victim_selector selector, starpu_data_victim_eviction_failed evicted, void *data)
 {
 	victim_selector = selector;
 	data_victim_selector = data;
 	victim_eviction_failed = evicted;
+	victim_lru_fallback = 0;
+}
+
+void _starpu_data_register_belady_victim_selector(void)
+{
+	starpu_data_register_victim_selector(_starpu_belady_victim_selector, NULL, NULL);
+	victim_lru_fallback = 1;
 }
 
 /* This function is called for memory chunks that are possibly in used (ie. not
@@ -865,6 +882,72 @@ restart:
 	return success;
 }
 
+/* Evict the data whose next use by the tasks queued on the workers of the node
+ * is the furthest away. Data which is not used by any of these tasks is
+ * evicted first, in LRU order. */
+starpu_data_handle_t _starpu_belady_victim_selector(starpu_data_handle_t toload, unsigned node, enum starpu_is_prefetch is_prefetch, void *data STARPU_ATTRIBUTE_UNUSED)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+	struct _starpu_mem_chunk *mc;
+	starpu_data_handle_t victim = NULL;
+	unsigned victim_next_use = 0;
+	int unused = 0;
+	uint32_t footprint = 0;
+
+	if (toload)
+		footprint = _starpu_compute_data_alloc_footprint(toload);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&belady_mutex[node]);
+	unsigned stamp = ++belady_stamp[node];
+	_starpu_prefetch_lookahead_mark_uses(node, stamp);
+
+	_starpu_spin_lock(&node_struct->mc_lock);
+	for (mc = _starpu_mem_chunk_list_begin(&node_struct->mc_list);
+	     mc != _starpu_mem_chunk_list_end(&node_struct->mc_list);
+	     mc = _starpu_mem_chunk_list_next(mc))
+	{
+		starpu_data_handle_t handle = mc->data;
+		if (!handle || mc->remove_notify)
+			continue;
+		if (toload && (mc->footprint != footprint || _starpu_data_interface_compare(toload->per_node[node].data_interface, toload->ops, handle->per_node[node].data_interface, mc->ops) != 1))
+			/* Would not be reusable for the allocation */
+			continue;
+
+		struct _starpu_data_replicate *replicate = &handle->per_node[node];
+		if (replicate->mapped != STARPU_UNMAPPED)
+			continue;
+		if (_starpu_spin_trylock(&handle->header_lock))
+			/* Handle is busy, skip */
+			continue;
+		int can_evict = starpu_data_can_evict(handle, node, is_prefetch);
+		_starpu_spin_unlock(&handle->header_lock);
+		if (!can_evict)
+			/* Somebody refers to it */
+			continue;
+
+		if (replicate->next_use_stamp != stamp)
+		{
+			/* Not needed by any queued task */
+			victim = handle;
+			unused = 1;
+			break;
+		}
+		if (!victim || replicate->next_use > victim_next_use)
+		{
+			victim = handle;
+			victim_next_use = replicate->next_use;
+		}
+	}
+	_starpu_spin_unlock(&node_struct->mc_lock);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&belady_mutex[node]);
+
+	_starpu_belady_victim(node, victim, unused);
+
+	/* Without candidate, let the LRU policy try, which it will also do if
+	 * the victim can not be evicted after all */
+	return victim;
+}
+
 /*
  * Try to find a buffer currently in use on the memory node which has the given
  * footprint.
@@ -961,6 +1044,12 @@ restart:
 			}
 		}
 	}
+	if (victim && !success && victim_lru_fallback)
+	{
+		/* The advised data could not be evicted, try in LRU order */
+		victim = NULL;
+		goto restart;
+	}
 	_starpu_spin_unlock(&node_struct->mc_lock);
 
 	if (victim && victim_eviction_failed != NULL && success == 0)
@@ -1122,6 +1211,12 @@ restart2:
 			_starpu_spin_unlock(&handle->header_lock);
 		}
 	}
+	if (victim && !freed && victim_lru_fallback)
+	{
+		/* The advised data could not be evicted, try in LRU order */
+		victim = NULL;
+		goto restart2;
+	}
 	_starpu_spin_unlock(&node_struct->mc_lock);
 
 	/* appeler fonction call_victim_slector(succes) */
@@ -1155,8 +1250,12 @@ size_t _starpu_memory_reclaim_generic(unsigned node, unsigned force, size_t recl
 		}
 	}
 
+	/* release the buffers kept in the allocation pool */
+	freed += _starpu_malloc_pool_flush(node);
+
 	/* remove all buffers for which there was a removal request */
-	freed += flush_memchunk_cache(node, reclaim);
+	if (!reclaim || freed < reclaim)
+		freed += flush_memchunk_cache(node, reclaim ? reclaim - freed : 0);
 
 	/* try to free all allocated data potentially in use */
 	if (force || (reclaim && freed<reclaim))
@@ -1635,8 +1734,12 @@ static starpu_ssize_t _starpu_allocate_interface(starpu_data_handle_t handle, st
 			size_t handle_size = _starpu_data_get_alloc_size(handle);
 			size_t reclaim = starpu_memstrategy_data_size_coefficient*handle_size;
 
-			/* First try to flush data explicitly marked for freeing */
-			size_t freed = flush_memchunk_cache(dst_node, reclaim);
+			/* First release the buffers kept in the allocation pool */
+			size_t freed = _starpu_malloc_pool_flush(dst_node);
+
+			/* Then try to flush data explicitly marked for freeing */
+			if (freed < reclaim)
+				freed += flush_memchunk_cache(dst_node, reclaim - freed);
 
 			if (freed >= reclaim)
 			{
@@ -98,6 +98,12 @@ int _starpu_is_reclaiming(unsigned node);
 
 void _starpu_mem_chunk_disk_register(unsigned disk_memnode);
 
+/** Victim selector enabled by STARPU_VICTIM_SELECTOR=belady */
+starpu_data_handle_t _starpu_belady_victim_selector(starpu_data_handle_t toload, unsigned node, enum starpu_is_prefetch is_prefetch, void *data);
+/** Register _starpu_belady_victim_selector, falling back to LRU when its
+ * victim can not be evicted */
+void _starpu_data_register_belady_victim_selector(void);
+
 #pragma GCC visibility pop
 
 #endif
@@ -24,6 +24,7 @@
 #include <datawizard/copy_driver.h>
 #include <datawizard/memalloc.h>
 #include <datawizard/node_ops.h>
+#include <datawizard/prefetch_lookahead.h>
 
 char _starpu_worker_drives_memory[STARPU_NMAXWORKERS][STARPU_MAXNODES];
 
@@ -46,6 +47,7 @@ void _starpu_memory_nodes_init(void)
 
 	_starpu_init_mem_chunk_lists();
 	_starpu_init_data_request_lists();
+	_starpu_prefetch_lookahead_init();
 	_starpu_memory_manager_init();
 
 	STARPU_PTHREAD_RWLOCK_INIT(&_starpu_descr.conditions_rwlock, NULL);
@@ -54,6 +56,14 @@ void _starpu_memory_nodes_init(void)
 
 void _starpu_memory_nodes_deinit(void)
 {
+	unsigned node;
+
+	/* The drivers of the other nodes have released their pool already */
+	for (node = 0; node < _starpu_descr.nnodes; node++)
+		if (_starpu_descr.nodes[node] == STARPU_CPU_RAM)
+			_starpu_malloc_pool_shutdown(node);
+
+	_starpu_prefetch_lookahead_deinit();
 	_starpu_deinit_data_request_lists();
 	_starpu_deinit_mem_chunk_lists();
 
@@ -0,0 +1,476 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2009-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <core/jobs.h>
+#include <core/workers.h>
+#include <core/topology.h>
+#include <datawizard/coherency.h>
+#include <datawizard/datastats.h>
+#include <datawizard/memalloc.h>
+#include <datawizard/prefetch_lookahead.h>
+
+/* How many tasks at the head of each worker window get prefetched, 0 when
+ * the engine is disabled */
+int _starpu_prefetch_lookahead_depth;
+int _starpu_prefetch_lookahead_track;
+
+/* How far in the windows the belady victim selector looks */
+#define LOOKAHEAD_HORIZON 1024
+
+/* Maximum amount of bytes of prefetched-but-not-started tasks per memory
+ * node, 0 for no limit */
+static size_t budget;
+static unsigned long inflight[STARPU_MAXNODES];
+
+struct _starpu_lookahead_window
+{
+	starpu_pthread_mutex_t mutex;
+	/* Signaled when an entry leaves the ISSUING state */
+	starpu_pthread_cond_t cond;
+	/* Sorted by decreasing priority, then submission order */
+	struct _starpu_lookahead_entry_list entries;
+};
+
+static struct _starpu_lookahead_window windows[STARPU_NMAXWORKERS];
+
+void _starpu_prefetch_lookahead_init(void)
+{
+	int depth = starpu_getenv_number_default("STARPU_PREFETCH_LOOKAHEAD", 0);
+	if (depth < 0)
+		depth = 0;
+	budget = (size_t) starpu_getenv_number_default("STARPU_PREFETCH_LOOKAHEAD_SIZE", 0) << 20;
+
+	int track = depth > 0;
+	const char *victim = starpu_getenv("STARPU_VICTIM_SELECTOR");
+	if (victim && !strcmp(victim, "belady"))
+	{
+		_starpu_data_register_belady_victim_selector();
+		track = 1;
+	}
+	else if (victim && strcmp(victim, "lru"))
+		_STARPU_DISP("Warning: unknown victim selector %s, using lru\n", victim);
+
+	if (track)
+	{
+		unsigned i;
+		for (i = 0; i < STARPU_NMAXWORKERS; i++)
+		{
+			STARPU_PTHREAD_MUTEX_INIT(&windows[i].mutex, NULL);
+			STARPU_PTHREAD_COND_INIT(&windows[i].cond, NULL);
+			_starpu_lookahead_entry_list_init(&windows[i].entries);
+		}
+		memset(inflight, 0, sizeof(inflight));
+	}
+	_starpu_prefetch_lookahead_depth = depth;
+	_starpu_prefetch_lookahead_track = track;
+}
+
+void _starpu_prefetch_lookahead_deinit(void)
+{
+	if (!_starpu_prefetch_lookahead_enabled())
+		return;
+
+	unsigned i;
+	for (i = 0; i < STARPU_NMAXWORKERS; i++)
+	{
+		/* Tasks which were never started, e.g. because they were
+		 * unregistered from the scheduler */
+		while (!_starpu_lookahead_entry_list_empty(&windows[i].entries))
+		{
+			struct _starpu_lookahead_entry *entry = _starpu_lookahead_entry_list_pop_front(&windows[i].entries);
+			_starpu_get_job_associated_to_task(entry->task)->lookahead_entry = NULL;
+			free(entry->refs);
+			_starpu_lookahead_entry_delete(entry);
+		}
+		STARPU_PTHREAD_COND_DESTROY(&windows[i].cond);
+		STARPU_PTHREAD_MUTEX_DESTROY(&windows[i].mutex);
+	}
+	_starpu_prefetch_lookahead_depth = 0;
+	_starpu_prefetch_lookahead_track = 0;
+}
+
+/* Amount of data which the task would have to bring to node */
+static size_t entry_size(struct starpu_task *task, unsigned workerid)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned index;
+	size_t size = 0;
+
+	for (index = 0; index < nbuffers; index++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, index);
+
+		if (mode & (STARPU_SCRATCH|STARPU_REDUX))
+			continue;
+
+		int node = _starpu_task_data_get_node_on_worker(task, index, workerid);
+		if (node < 0)
+			continue;
+
+		/* Racy, but this is only an estimation */
+		if (handle->per_node[node].state != STARPU_INVALID)
+			continue;
+
+		size += _starpu_data_get_size(handle);
+	}
+	return size;
+}
+
+static void entry_release(struct _starpu_lookahead_entry *entry)
+{
+	if (STARPU_ATOMIC_ADD(&entry->refcnt, -1) == 0)
+	{
+		free(entry->refs);
+		_starpu_lookahead_entry_delete(entry);
+	}
+}
+
+/* The prefetch of a buffer is complete, take the reference which keeps the
+ * data on the node until the task starts, unless it is not needed any more */
+static void prefetch_done(void *arg)
+{
+	struct _starpu_lookahead_ref *ref = arg;
+	struct _starpu_lookahead_entry *entry = ref->entry;
+	starpu_data_handle_t handle = ref->handle;
+	struct _starpu_data_replicate *replicate = &handle->per_node[ref->node];
+
+	_starpu_spin_lock(&handle->header_lock);
+	if (ref->state == STARPU_LOOKAHEAD_REF_INFLIGHT && replicate->mc)
+	{
+		replicate->nb_tasks_prefetch++;
+		ref->state = STARPU_LOOKAHEAD_REF_HELD;
+	}
+	else
+		ref->state = STARPU_LOOKAHEAD_REF_NONE;
+	_starpu_spin_unlock(&handle->header_lock);
+
+	entry_release(entry);
+}
+
+/* Prefetch the input of the task of the entry on the node of its worker */
+static void issue_prefetches(struct _starpu_lookahead_entry *entry, int prio)
+{
+	struct starpu_task *task = entry->task;
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned index;
+
+	_STARPU_MALLOC(entry->refs, nbuffers * sizeof(*entry->refs));
+	for (index = 0; index < nbuffers; index++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, index);
+
+		if (mode & (STARPU_SCRATCH|STARPU_REDUX))
+			continue;
+
+		int node = _starpu_task_data_get_node_on_worker(task, index, entry->workerid);
+		if (node < 0)
+			continue;
+
+		struct _starpu_lookahead_ref *ref = &entry->refs[entry->nrefs++];
+		ref->entry = entry;
+		ref->handle = handle;
+		ref->node = node;
+		ref->state = STARPU_LOOKAHEAD_REF_INFLIGHT;
+		(void) STARPU_ATOMIC_ADD(&entry->refcnt, 1);
+		/* The reference is taken by prefetch_done rather than by the
+		 * request, so that we know which references we hold */
+		_starpu_fetch_data_on_node(handle, node, &handle->per_node[node], mode, 1, task, STARPU_PREFETCH, 1,
+					   prefetch_done, ref, prio, "prefetch_lookahead");
+	}
+}
+
+/* Release the references taken by the prefetches of the entry, or make sure
+ * the prefetches still in flight will not take them */
+static void release_refs(struct _starpu_lookahead_entry *entry)
+{
+	unsigned i;
+
+	for (i = 0; i < entry->nrefs; i++)
+	{
+		struct _starpu_lookahead_ref *ref = &entry->refs[i];
+		starpu_data_handle_t handle = ref->handle;
+		struct _starpu_data_replicate *replicate = &handle->per_node[ref->node];
+
+		_starpu_spin_lock(&handle->header_lock);
+		if (ref->state == STARPU_LOOKAHEAD_REF_HELD)
+		{
+			STARPU_ASSERT(replicate->nb_tasks_prefetch > 0);
+			replicate->nb_tasks_prefetch--;
+			ref->state = STARPU_LOOKAHEAD_REF_NONE;
+		}
+		else if (ref->state == STARPU_LOOKAHEAD_REF_INFLIGHT)
+			ref->state = STARPU_LOOKAHEAD_REF_CANCELED;
+		_starpu_spin_unlock(&handle->header_lock);
+	}
+}
+
+/* Prefetch the input of the first pending tasks of the window, as long as
+ * they are among the first _starpu_prefetch_lookahead_depth tasks and they
+ * fit in the budget.  Requests are submitted without holding the window mutex,
+ * since we may be called with data header locks held. */
+static void refill(unsigned workerid)
+{
+	struct _starpu_lookahead_window *window = &windows[workerid];
+
+	while (1)
+	{
+		struct _starpu_lookahead_entry *entry, *claimed = NULL;
+		int position = 0;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&window->mutex);
+		for (entry = _starpu_lookahead_entry_list_begin(&window->entries);
+		     entry != _starpu_lookahead_entry_list_end(&window->entries) && position < _starpu_prefetch_lookahead_depth;
+		     entry = _starpu_lookahead_entry_list_next(entry), position++)
+		{
+			if (entry->state != STARPU_LOOKAHEAD_PENDING)
+				continue;
+
+			size_t size = entry_size(entry->task, workerid);
+			if (budget && inflight[entry->node] && inflight[entry->node] + size > budget)
+				/* Do not let lower-priority tasks overtake this one */
+				break;
+
+			entry->size = size;
+			entry->state = STARPU_LOOKAHEAD_ISSUING;
+			(void) STARPU_ATOMIC_ADDL(&inflight[entry->node], size);
+			claimed = entry;
+			break;
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&window->mutex);
+
+		if (!claimed)
+			return;
+
+		/* Tasks further away in the window get their data later */
+		int prio = claimed->prio;
+		if (prio > INT_MIN + position)
+			prio -= position;
+		if (!claimed->task->prefetched)
+		{
+			issue_prefetches(claimed, prio);
+			_starpu_prefetch_lookahead_issued(claimed->node);
+		}
+
+		STARPU_PTHREAD_MUTEX_LOCK(&window->mutex);
+		claimed->state = STARPU_LOOKAHEAD_PREFETCHED;
+		STARPU_PTHREAD_COND_BROADCAST(&window->cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&window->mutex);
+	}
+}
+
+int _starpu_prefetch_lookahead_push(struct starpu_task *task, unsigned workerid, int prio)
+{
+	if (workerid >= starpu_worker_get_count())
+		/* Combined workers get their prefetches directly */
+		return -1;
+
+	struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
+	if (j->lookahead_entry || task->prefetched)
+		/* Already in a window, already started, or already prefetched
+		 * before the scheduling decision */
+		return 0;
+
+	struct _starpu_lookahead_window *window = &windows[workerid];
+	struct _starpu_lookahead_entry *entry = _starpu_lookahead_entry_new();
+	entry->task = task;
+	entry->workerid = workerid;
+	entry->node = starpu_worker_get_memory_node(workerid);
+	entry->prio = prio;
+	entry->state = STARPU_LOOKAHEAD_PENDING;
+	entry->size = 0;
+	entry->refs = NULL;
+	entry->nrefs = 0;
+	entry->refcnt = 1;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&window->mutex);
+	/* Most tasks come with the same priority, so look from the back */
+	struct _starpu_lookahead_entry *prev = _starpu_lookahead_entry_list_last(&window->entries);
+	while (prev && prev->prio < prio)
+		prev = _starpu_lookahead_entry_list_prev(prev);
+	if (prev)
+		_starpu_lookahead_entry_list_insert_after(&window->entries, entry, prev);
+	else
+		_starpu_lookahead_entry_list_push_front(&window->entries, entry);
+	/* Schedulers may well prefetch after queuing the task, so it may
+	 * have already been started, or pushed concurrently */
+	if (!STARPU_BOOL_COMPARE_AND_SWAP_PTR(&j->lookahead_entry, NULL, entry))
+	{
+		_starpu_lookahead_entry_list_erase(&window->entries, entry);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&window->mutex);
+		_starpu_lookahead_entry_delete(entry);
+		return 0;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&window->mutex);
+
+	if (!_starpu_prefetch_lookahead_depth)
+		/* Only tracking */
+		return -1;
+
+	refill(workerid);
+	return 0;
+}
+
+/* Remove the entry from its window, waiting for its prefetches to be
+ * submitted, if that was in progress */
+static void remove_entry(struct _starpu_lookahead_entry *entry)
+{
+	struct _starpu_lookahead_window *window = &windows[entry->workerid];
+
+	STARPU_PTHREAD_MUTEX_LOCK(&window->mutex);
+	while (entry->state == STARPU_LOOKAHEAD_ISSUING)
+		STARPU_PTHREAD_COND_WAIT(&window->cond, &window->mutex);
+	_starpu_lookahead_entry_list_erase(&window->entries, entry);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&window->mutex);
+
+	if (entry->state == STARPU_LOOKAHEAD_PREFETCHED)
+		(void) STARPU_ATOMIC_ADDL(&inflight[entry->node], -(unsigned long) entry->size);
+}
+
+void _starpu_prefetch_lookahead_start(struct _starpu_job *j, struct _starpu_worker *worker)
+{
+	struct _starpu_lookahead_entry *entry;
+
+	/* Prevent any later push from recording the task */
+	do
+		entry = j->lookahead_entry;
+	while (!STARPU_BOOL_COMPARE_AND_SWAP_PTR(&j->lookahead_entry, entry, STARPU_LOOKAHEAD_STARTED));
+	if (!entry || entry == STARPU_LOOKAHEAD_STARTED)
+		return;
+	if (entry->state == STARPU_LOOKAHEAD_FETCHING)
+	{
+		/* Fetching again, e.g. after running out of memory */
+		j->lookahead_entry = entry;
+		return;
+	}
+
+	int workerid = entry->workerid;
+
+	remove_entry(entry);
+
+	if (!_starpu_prefetch_lookahead_depth)
+		/* Only tracking */
+		;
+	else if (entry->state == STARPU_LOOKAHEAD_PREFETCHED)
+	{
+		if (worker->memory_node != entry->node)
+		{
+			/* Let the data be evicted from the original node */
+			release_refs(entry);
+			_starpu_prefetch_lookahead_cancel(entry->node);
+		}
+		else
+		{
+			_starpu_prefetch_lookahead_hit(entry->node);
+			/* Keep the references until the task has taken its
+			 * own ones, see _starpu_prefetch_lookahead_fetched */
+			entry->state = STARPU_LOOKAHEAD_FETCHING;
+			j->lookahead_entry = entry;
+			refill(workerid);
+			return;
+		}
+	}
+	else
+		_starpu_prefetch_lookahead_miss(entry->node);
+
+	entry_release(entry);
+
+	/* Let the next tasks in */
+	refill(workerid);
+}
+
+void _starpu_prefetch_lookahead_fetched(struct _starpu_job *j)
+{
+	struct _starpu_lookahead_entry *entry = j->lookahead_entry;
+	if (!entry || entry == STARPU_LOOKAHEAD_STARTED)
+		return;
+
+	STARPU_ASSERT(entry->state == STARPU_LOOKAHEAD_FETCHING);
+	j->lookahead_entry = STARPU_LOOKAHEAD_STARTED;
+	release_refs(entry);
+	entry_release(entry);
+}
+
+void _starpu_prefetch_lookahead_drop(struct _starpu_job *j)
+{
+	struct _starpu_lookahead_entry *entry = j->lookahead_entry;
+	j->lookahead_entry = NULL;
+	if (entry == STARPU_LOOKAHEAD_STARTED)
+		return;
+
+	if (entry->state == STARPU_LOOKAHEAD_FETCHING)
+	{
+		release_refs(entry);
+		entry_release(entry);
+		return;
+	}
+
+	int workerid = entry->workerid;
+
+	remove_entry(entry);
+	release_refs(entry);
+	entry_release(entry);
+	refill(workerid);
+}
+
+void _starpu_prefetch_lookahead_mark_uses(unsigned node, unsigned stamp)
+{
+	unsigned nworkers = starpu_worker_get_count();
+	unsigned workerid;
+
+	for (workerid = 0; workerid < nworkers; workerid++)
+	{
+		struct _starpu_lookahead_window *window = &windows[workerid];
+		struct _starpu_lookahead_entry *entry;
+		unsigned position = 0;
+
+		if (starpu_worker_get_memory_node(workerid) != node)
+			continue;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&window->mutex);
+		for (entry = _starpu_lookahead_entry_list_begin(&window->entries);
+		     entry != _starpu_lookahead_entry_list_end(&window->entries) && position < LOOKAHEAD_HORIZON;
+		     entry = _starpu_lookahead_entry_list_next(entry), position++)
+		{
+			/* The task is not started yet, so its handles can not
+			 * be unregistered */
+			struct starpu_task *task = entry->task;
+			unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+			unsigned index;
+
+			for (index = 0; index < nbuffers; index++)
+			{
+				starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+				if (_starpu_task_data_get_node_on_worker(task, index, workerid) != (int) node)
+					continue;
+
+				struct _starpu_data_replicate *replicate = &handle->per_node[node];
+				if (replicate->next_use_stamp != stamp)
+				{
+					replicate->next_use_stamp = stamp;
+					replicate->next_use = position;
+				}
+				else if (position < replicate->next_use)
+					replicate->next_use = position;
+			}
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&window->mutex);
+	}
+}
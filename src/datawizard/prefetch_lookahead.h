@@ -0,0 +1,138 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2009-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __PREFETCH_LOOKAHEAD_H__
+#define __PREFETCH_LOOKAHEAD_H__
+
+/** @file */
+
+/*
+ * Lookahead prefetch engine: instead of prefetching the input of a task as
+ * soon as the scheduler assigns it to a worker, tasks are recorded in a
+ * per-worker window, and only the first STARPU_PREFETCH_LOOKAHEAD tasks of
+ * the window get their data prefetched, within a per-memory-node budget. When
+ * a task starts fetching its data, it leaves the window, which lets the next
+ * tasks in.  Each entry records the prefetch references it took on the
+ * replicates, and releases exactly these once the task has fetched its data,
+ * or as soon as it is started on a worker which does not share the memory
+ * node of the worker it was queued for (i.e. it was stolen).
+ */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <common/list.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_job;
+struct _starpu_worker;
+
+enum _starpu_lookahead_state
+{
+	/** Queued in the window, not prefetched yet */
+	STARPU_LOOKAHEAD_PENDING,
+	/** Prefetch requests are being submitted, the window mutex is not held */
+	STARPU_LOOKAHEAD_ISSUING,
+	/** Prefetch requests were submitted */
+	STARPU_LOOKAHEAD_PREFETCHED,
+	/** Out of the window, the task is fetching its data on the node it was
+	 * prefetched to */
+	STARPU_LOOKAHEAD_FETCHING,
+};
+
+enum _starpu_lookahead_ref_state
+{
+	/** No reference was taken */
+	STARPU_LOOKAHEAD_REF_NONE,
+	/** The prefetch request is in flight, the reference will be taken on
+	 * completion */
+	STARPU_LOOKAHEAD_REF_INFLIGHT,
+	/** The reference was taken on nb_tasks_prefetch of the replicate */
+	STARPU_LOOKAHEAD_REF_HELD,
+	/** The prefetch request is in flight, but the reference is not needed
+	 * any more, and will not be taken on completion */
+	STARPU_LOOKAHEAD_REF_CANCELED,
+};
+
+struct _starpu_lookahead_entry;
+
+/** Prefetch of a buffer of the task of an entry */
+struct _starpu_lookahead_ref
+{
+	struct _starpu_lookahead_entry *entry;
+	starpu_data_handle_t handle;
+	unsigned node;
+	/** Protected by the header lock of the handle */
+	enum _starpu_lookahead_ref_state state;
+};
+
+LIST_TYPE(_starpu_lookahead_entry,
+	struct starpu_task *task;
+	/** Worker whose window contains the entry */
+	int workerid;
+	/** Memory node of that worker */
+	unsigned node;
+	int prio;
+	enum _starpu_lookahead_state state;
+	/** Bytes accounted in the memory node budget once prefetched */
+	size_t size;
+	/** The prefetches issued for the task */
+	struct _starpu_lookahead_ref *refs;
+	unsigned nrefs;
+	/** One for the job, plus one per prefetch request in flight */
+	int refcnt;
+);
+
+/** Value of the lookahead_entry field of jobs which have started fetching
+ * their data, until they get submitted again */
+#define STARPU_LOOKAHEAD_STARTED ((struct _starpu_lookahead_entry *) 1)
+
+extern int _starpu_prefetch_lookahead_depth;
+/** Whether the windows are maintained, either for prefetching or for the
+ * belady victim selector */
+extern int _starpu_prefetch_lookahead_track;
+
+static inline int _starpu_prefetch_lookahead_enabled(void)
+{
+	return _starpu_prefetch_lookahead_track;
+}
+
+void _starpu_prefetch_lookahead_init(void);
+void _starpu_prefetch_lookahead_deinit(void);
+
+/** Record \p task in the window of \p workerid, and prefetch from the window
+ * if there is room. Returns 0 if the engine took the task, -1 if the caller
+ * should prefetch by itself, i.e. the windows are only maintained for the
+ * victim selector, or \p workerid is a combined worker. */
+int _starpu_prefetch_lookahead_push(struct starpu_task *task, unsigned workerid, int prio);
+
+/** Called when \p worker starts fetching the input of the task of \p j */
+void _starpu_prefetch_lookahead_start(struct _starpu_job *j, struct _starpu_worker *worker);
+/** Called when the task of \p j has fetched its input, to release the
+ * prefetch references which were keeping its data on the node */
+void _starpu_prefetch_lookahead_fetched(struct _starpu_job *j);
+/** Called when the job gets destroyed with a non-NULL lookahead_entry */
+void _starpu_prefetch_lookahead_drop(struct _starpu_job *j);
+
+/** For each data used by the tasks queued for the workers of \p node, set
+ * next_use_stamp to \p stamp and next_use to the position of the first of
+ * these tasks in the windows. To be called with the belady mutex of \p node
+ * held, see _starpu_belady_victim_selector */
+void _starpu_prefetch_lookahead_mark_uses(unsigned node, unsigned stamp);
+
+#pragma GCC visibility pop
+
+#endif // __PREFETCH_LOOKAHEAD_H__
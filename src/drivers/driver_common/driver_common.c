@@ -20,6 +20,8 @@
 #include <starpu.h>
 #include <starpu_profiling.h>
 #include <profiling/profiling.h>
+#include <profiling/latency.h>
+#include <profiling/critical_path.h>
 #include <common/utils.h>
 #include <core/debug.h>
 #include <core/sched_ctx.h>
@@ -39,6 +41,33 @@
 #include <nosv.h>
 #endif
 
+/* per-worker counters */
+static int __w_total_wakeups;
+static int __w_total_parked;
+static int __w_cumul_wakeup_latency;
+
+static void per_worker_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context != NULL);
+	struct _starpu_worker *worker = context;
+
+	_starpu_perf_counter_sample_set_int64_value(sample, __w_total_wakeups, worker->__w_total_wakeups__value);
+	_starpu_perf_counter_sample_set_int64_value(sample, __w_total_parked, worker->__w_total_parked__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_cumul_wakeup_latency, worker->__w_cumul_wakeup_latency__value);
+}
+
+void _starpu__driver_common_c__register_counters(void)
+{
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_worker;
+		__STARPU_PERF_COUNTER_REG("starpu.worker", scope, w_total_wakeups, int64, "number of times this worker was woken up while spinning or parked on its futex (since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.worker", scope, w_total_parked, int64, "number of times this worker blocked on its futex (since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.worker", scope, w_cumul_wakeup_latency, double, "cumulated time between the wake-up requests and this worker actually waking up (microseconds, since StarPU initialization)");
+
+		_starpu_perf_counter_register_updater(scope, per_worker_sample_updater);
+	}
+}
+
 void _starpu_driver_start_job(struct _starpu_worker *worker, struct _starpu_job *j, struct starpu_perfmodel_arch* perf_arch, int rank, int profiling)
 {
 	struct starpu_task *task = j->task;
@@ -259,6 +288,8 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 		{
 			worker->__w_total_executed__value++;
 			worker->__w_cumul_execution_time__value += measured;
+			_starpu_latency_executed(worker, cl, measured);
+			_starpu_critical_path_job_executed(j, cl, measured);
 			_starpu_perf_counter_update_per_worker_sample(worker->workerid);
 			if (cl->perf_counter_values)
 			{
@@ -425,6 +456,114 @@ static void _starpu_exponential_backoff(struct _starpu_worker *worker)
 
 
 
+#ifdef STARPU_HAVE_FUTEX_PARKING
+static int _starpu_worker_parking;
+/* Maximum spinning time (us) */
+static double _starpu_worker_spin_max;
+/* Time after which a parked worker falls back to waiting on its sched_cond (us) */
+static double _starpu_worker_park_timeout;
+#endif
+
+void _starpu_worker_parking_init(void)
+{
+#ifdef STARPU_HAVE_FUTEX_PARKING
+	_starpu_worker_parking = starpu_getenv_number_default("STARPU_WORKER_PARKING", 1);
+	_starpu_worker_spin_max = starpu_getenv_number_default("STARPU_WORKER_SPIN_MAX", 50);
+	_starpu_worker_park_timeout = starpu_getenv_number_default("STARPU_WORKER_PARK_TIMEOUT", 10000);
+#endif
+}
+
+#ifdef STARPU_HAVE_FUTEX_PARKING
+/* Idle workers first spin, then park on their park_state futex, where
+ * _starpu_worker_unpark() can wake them without taking their sched_mutex.
+ * Spinning for as long as a futex wake-up takes costs at most twice the
+ * optimal, so the spinning time follows the observed wake-up latency, unless
+ * idle periods are much longer than this, in which case spinning is useless.
+ * If nobody wakes the worker before STARPU_WORKER_PARK_TIMEOUT, it goes
+ * waiting on its sched_cond as usual.
+ *
+ * Must be called with the sched_mutex held, which is released meanwhile.
+ * Returns 1 if the worker was woken up.
+ */
+static int _starpu_worker_park(struct _starpu_worker *worker)
+{
+	double start, now, deadline, spin;
+	unsigned state;
+	int parked = 0;
+
+	worker->park_state = STARPU_WORKER_SPINNING;
+	STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&worker->sched_mutex);
+
+	start = now = starpu_timing_now();
+	deadline = start + worker->park_spin;
+	/* Wakers which hold the sched_mutex only set state_keep_awake */
+	while (now < deadline
+		&& *(volatile unsigned *) &worker->park_state == STARPU_WORKER_SPINNING
+		&& !*(volatile unsigned *) &worker->state_keep_awake)
+	{
+		STARPU_UYIELD();
+		now = starpu_timing_now();
+	}
+
+	if (!*(volatile unsigned *) &worker->state_keep_awake
+		&& STARPU_VAL_COMPARE_AND_SWAP(&worker->park_state, STARPU_WORKER_SPINNING, STARPU_WORKER_PARKED) == STARPU_WORKER_SPINNING)
+	{
+		parked = 1;
+		deadline = now + _starpu_worker_park_timeout;
+		while (*(volatile unsigned *) &worker->park_state == STARPU_WORKER_PARKED && now < deadline)
+		{
+			_starpu_futex_park(&worker->park_state, STARPU_WORKER_PARKED, deadline - now);
+			now = starpu_timing_now();
+		}
+	}
+
+	state = STARPU_VAL_EXCHANGE(&worker->park_state, STARPU_WORKER_AWAKE);
+	now = starpu_timing_now();
+
+	worker->park_idle_avg = (7. * worker->park_idle_avg + (now - start)) / 8.;
+	if (state == STARPU_WORKER_WOKEN)
+	{
+		double latency = now - worker->park_wake_date;
+		if (parked)
+			worker->park_latency_avg = (7. * worker->park_latency_avg + latency) / 8.;
+		if (!_starpu_perf_counter_paused())
+		{
+			worker->__w_total_wakeups__value++;
+			worker->__w_cumul_wakeup_latency__value += latency;
+		}
+	}
+	if (parked && !_starpu_perf_counter_paused())
+		worker->__w_total_parked__value++;
+
+	spin = worker->park_latency_avg;
+	if (spin > _starpu_worker_spin_max)
+		spin = _starpu_worker_spin_max;
+	if (worker->park_idle_avg > 8. * spin)
+		spin = 0.;
+	worker->park_spin = spin;
+
+	STARPU_PTHREAD_MUTEX_LOCK_SCHED(&worker->sched_mutex);
+	return state == STARPU_WORKER_WOKEN || worker->state_keep_awake;
+}
+#endif
+
+#if !defined(STARPU_SIMGRID) && !defined(STARPU_NON_BLOCKING_DRIVERS)
+/* Whether a sleeping worker should keep sleeping. Must be called with the
+ * sched_mutex held. */
+static int _starpu_worker_keep_sleeping(struct _starpu_worker *worker, int workerid, unsigned memnode)
+{
+	if (!worker->state_keep_awake
+		&& _starpu_worker_can_block(memnode, worker)
+		&& !worker->state_block_in_parallel_req
+		&& !worker->state_unblock_in_parallel_req)
+	{
+		_starpu_worker_set_status_sleeping(workerid);
+		return !_starpu_sched_ctx_last_worker_awake(worker);
+	}
+	return 0;
+}
+#endif
+
 /* Workers may block when there is no work to do at all. */
 struct starpu_task *_starpu_get_worker_task(struct _starpu_worker *worker, int workerid, unsigned memnode STARPU_ATTRIBUTE_UNUSED)
 {
@@ -489,27 +628,17 @@ struct starpu_task *_starpu_get_worker_task(struct _starpu_worker *worker, int w
 			{
 				_starpu_config.conf.callback_worker_going_to_sleep(workerid);
 			}
+#endif
+#ifdef STARPU_HAVE_FUTEX_PARKING
+			if (!_starpu_worker_parking
+				|| (!_starpu_worker_park(worker)
+					&& _starpu_worker_keep_sleeping(worker, workerid, memnode)))
 #endif
 			do
 			{
 				STARPU_PTHREAD_COND_WAIT(&worker->sched_cond, &worker->sched_mutex);
-				if (!worker->state_keep_awake
-					&& _starpu_worker_can_block(memnode, worker)
-					&& !worker->state_block_in_parallel_req
-					&& !worker->state_unblock_in_parallel_req)
-				{
-					_starpu_worker_set_status_sleeping(workerid);
-					if (_starpu_sched_ctx_last_worker_awake(worker))
-					{
-						break;
-					}
-				}
-				else
-				{
-					break;
-				}
 			}
-			while (1);
+			while (_starpu_worker_keep_sleeping(worker, workerid, memnode));
 			worker->state_keep_awake = 0;
 			_starpu_worker_set_status_scheduling_done(workerid);
 			STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&worker->sched_mutex);
@@ -548,6 +548,7 @@ int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
 					  id == STARPU_TENSOR_INTERFACE_ID ||
 					  id == STARPU_CSR_INTERFACE_ID ||
 					  id == STARPU_BCSR_INTERFACE_ID ||
+					  id == STARPU_SELL_INTERFACE_ID ||
 					  id == STARPU_COO_INTERFACE_ID,
 					  "Master-Slave currently cannot work with interface type %d (%s)", id, handle->ops->name);
 
@@ -0,0 +1,303 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Critical path tracker.
+ *
+ * Contrary to the task graph of common/graph.c, no edge is recorded: each
+ * job only carries the longest chain of tasks leading to it. When a task
+ * terminates, the thread remembers its chain while notifying its
+ * successors, which keep the longest of the chains of their predecessors.
+ * When a task is executed, it appends itself to that chain, and the longest
+ * of all chains is kept as the critical path.
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include <starpu.h>
+#include <starpu_profiling.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/starpu_spinlock.h>
+#include <core/workers.h>
+#include <core/jobs.h>
+#include <common/knobs.h>
+#include <profiling/critical_path.h>
+
+/* chain of the job whose successors are being notified by the thread */
+static starpu_pthread_key_t notifying_key;
+
+static struct _starpu_spinlock critical_path_lock;
+static unsigned long generation;
+static struct _starpu_critical_path critical_path;
+/* date when the first task of the generation became ready */
+static double start_date;
+
+static int critical_path_stats;
+
+/* global counters */
+static int __g_length;
+static int __g_worker_stall;
+static int __g_data_stall;
+static int __g_ntasks;
+
+static void global_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context == NULL); /* no context for the global updater */
+	(void)context;
+
+	_starpu_perf_counter_sample_set_double_value(sample, __g_length, critical_path.length);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_worker_stall, critical_path.worker_stall);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_data_stall, critical_path.data_stall);
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_ntasks, critical_path.ntasks);
+}
+
+void _starpu__critical_path_c__register_counters(void)
+{
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+		__STARPU_PERF_COUNTER_REG("starpu.critical_path", scope, g_length, double, "sum of the execution times of the tasks of the longest chain of tasks executed (microseconds, since enabled)");
+		__STARPU_PERF_COUNTER_REG("starpu.critical_path", scope, g_worker_stall, double, "time the tasks of the critical path waited for a worker while being ready (microseconds, since enabled)");
+		__STARPU_PERF_COUNTER_REG("starpu.critical_path", scope, g_data_stall, double, "time the tasks of the critical path waited for their data (microseconds, since enabled)");
+		__STARPU_PERF_COUNTER_REG("starpu.critical_path", scope, g_ntasks, int64, "number of tasks of the critical path (since enabled)");
+
+		_starpu_perf_counter_register_updater(scope, global_sample_updater);
+	}
+}
+
+/* - */
+
+/* Keep the chain in the job if it is longer than the one it already has */
+static void _merge(struct _starpu_job *j, const struct _starpu_critical_path *path)
+{
+	if (path == NULL || path->ntasks == 0 || path->generation != generation)
+		return;
+
+	struct _starpu_critical_path *cp = j->critical_path;
+	if (cp == NULL)
+	{
+		_STARPU_MALLOC(cp, sizeof(*cp));
+		j->critical_path = cp;
+	}
+	else if (cp->generation == path->generation && cp->ntasks > 0 && cp->length >= path->length)
+		return;
+	*cp = *path;
+}
+
+static void _add_codelet(struct _starpu_critical_path *path, struct starpu_codelet *cl, double measured)
+{
+	unsigned i, min = 0;
+	for (i = 0; i < STARPU_PROFILING_CRITICAL_PATH_NCODELETS; i++)
+	{
+		if (path->codelets[i].cl == cl || path->codelets[i].cl == NULL)
+		{
+			path->codelets[i].cl = cl;
+			path->codelets[i].length += measured;
+			return;
+		}
+		if (path->codelets[i].length < path->codelets[min].length)
+			min = i;
+	}
+
+	/* no room left, evict the lightest codelet if this one weighs more */
+	if (measured > path->codelets[min].length)
+	{
+		path->codelets[min].cl = cl;
+		path->codelets[min].length = measured;
+	}
+}
+
+void _starpu_critical_path_job_ready(struct _starpu_job *j)
+{
+	if (start_date == 0.)
+	{
+		_starpu_spin_lock(&critical_path_lock);
+		if (start_date == 0.)
+			start_date = starpu_timing_now();
+		_starpu_spin_unlock(&critical_path_lock);
+	}
+
+	/* The task may have been released by tags or data, take the chain
+	 * of the task which released it */
+	_merge(j, STARPU_PTHREAD_GETSPECIFIC(notifying_key));
+}
+
+void _starpu_critical_path_job_released(struct _starpu_job *j)
+{
+	_merge(j, STARPU_PTHREAD_GETSPECIFIC(notifying_key));
+}
+
+void _starpu_critical_path_job_executed(struct _starpu_job *j, struct starpu_codelet *cl, double measured)
+{
+	struct _starpu_critical_path *cp = j->critical_path;
+	if (cp == NULL)
+	{
+		_STARPU_CALLOC(cp, 1, sizeof(*cp));
+		j->critical_path = cp;
+	}
+	else if (cp->generation != generation || cp->ntasks == 0)
+		/* chain of a previous generation or of a previous submission */
+		memset(cp, 0, sizeof(*cp));
+
+	cp->generation = generation;
+	cp->length += measured;
+	cp->worker_stall += j->latency_queue_delay;
+	cp->data_stall += j->latency_fetch_delay;
+	cp->ntasks++;
+	_add_codelet(cp, cl, measured);
+
+	j->latency_queue_delay = 0.;
+	j->latency_fetch_delay = 0.;
+
+	if (cp->length > critical_path.length)
+	{
+		_starpu_spin_lock(&critical_path_lock);
+		if (cp->generation == generation && cp->length > critical_path.length)
+			critical_path = *cp;
+		_starpu_spin_unlock(&critical_path_lock);
+	}
+}
+
+void *_starpu_critical_path_job_start_notify(struct _starpu_job *j)
+{
+	void *previous = STARPU_PTHREAD_GETSPECIFIC(notifying_key);
+	STARPU_PTHREAD_SETSPECIFIC(notifying_key, j->critical_path);
+	return previous;
+}
+
+void _starpu_critical_path_job_end_notify(struct _starpu_job *j, void *previous)
+{
+	STARPU_PTHREAD_SETSPECIFIC(notifying_key, previous);
+	/* the successors have copied the chain, start over if the task is
+	 * submitted again */
+	if (j->critical_path)
+		j->critical_path->ntasks = 0;
+}
+
+/* - */
+
+void starpu_profiling_critical_path_get_info(struct starpu_profiling_critical_path_info *info)
+{
+	struct _starpu_critical_path path;
+	double date;
+
+	_starpu_spin_lock(&critical_path_lock);
+	path = critical_path;
+	date = start_date;
+	_starpu_spin_unlock(&critical_path_lock);
+
+	memset(info, 0, sizeof(*info));
+	info->length = path.length;
+	info->worker_stall = path.worker_stall;
+	info->data_stall = path.data_stall;
+	info->elapsed = date == 0. ? 0. : starpu_timing_now() - date;
+	info->ntasks = path.ntasks;
+
+	/* sort the codelets by decreasing contribution */
+	unsigned i, k;
+	for (i = 0; i < STARPU_PROFILING_CRITICAL_PATH_NCODELETS && path.codelets[i].cl; i++)
+	{
+		for (k = info->ncodelets; k > 0 && info->codelet_length[k-1] < path.codelets[i].length; k--)
+		{
+			info->codelets[k] = info->codelets[k-1];
+			info->codelet_length[k] = info->codelet_length[k-1];
+		}
+		info->codelets[k] = path.codelets[i].cl;
+		info->codelet_length[k] = path.codelets[i].length;
+		info->ncodelets++;
+	}
+}
+
+void starpu_profiling_critical_path_reset(void)
+{
+	_starpu_spin_lock(&critical_path_lock);
+	generation++;
+	memset(&critical_path, 0, sizeof(critical_path));
+	critical_path.generation = generation;
+	start_date = 0.;
+	_starpu_spin_unlock(&critical_path_lock);
+}
+
+void starpu_profiling_critical_path_display_summary(FILE *stream)
+{
+	struct starpu_profiling_critical_path_info info;
+	starpu_profiling_critical_path_get_info(&info);
+
+	fprintf(stream, "\n#---------------------\n");
+	fprintf(stream, "Critical path stats:\n");
+
+	double span = info.length + info.worker_stall + info.data_stall;
+	fprintf(stream, "\tlength %.2lf ms (%lu task(s)), over %.2lf ms elapsed\n", info.length / 1000., info.ntasks, info.elapsed / 1000.);
+	if (span > 0.)
+	{
+		fprintf(stream, "\tstalled %.2lf ms (%.2lf%%) waiting for workers, %.2lf ms (%.2lf%%) waiting for data\n",
+			info.worker_stall / 1000., info.worker_stall * 100. / span,
+			info.data_stall / 1000., info.data_stall * 100. / span);
+		if (info.elapsed > 0.)
+			fprintf(stream, "\tthe critical path spans %.2lf%% of the elapsed time\n", span * 100. / info.elapsed);
+	}
+
+	unsigned i;
+	for (i = 0; i < info.ncodelets; i++)
+	{
+		const char *name = _starpu_codelet_get_model_name(info.codelets[i]);
+		fprintf(stream, "\t%-32s %.2lf ms (%.2lf%%)\n", name ? name : "unknown", info.codelet_length[i] / 1000., info.codelet_length[i] * 100. / info.length);
+	}
+	fprintf(stream, "#---------------------\n");
+}
+
+void starpu_profiling_critical_path_helper_display_summary(void)
+{
+	if (!critical_path_stats)
+		return;
+	const char *filename = starpu_getenv("STARPU_CRITICAL_PATH_STATS_FILE");
+	if (filename==NULL)
+		starpu_profiling_critical_path_display_summary(stderr);
+	else
+	{
+		FILE *sfile = fopen(filename, "w+");
+		STARPU_ASSERT_MSG(sfile, "Could not open file %s for displaying critical path stats (%s). You can specify another file destination with the STARPU_CRITICAL_PATH_STATS_FILE environment variable", filename, strerror(errno));
+		starpu_profiling_critical_path_display_summary(sfile);
+		fclose(sfile);
+	}
+}
+
+/* - */
+
+void _starpu_critical_path_init(void)
+{
+	STARPU_PTHREAD_KEY_CREATE(&notifying_key, NULL);
+	_starpu_spin_init(&critical_path_lock);
+	generation = 0;
+	memset(&critical_path, 0, sizeof(critical_path));
+	start_date = 0.;
+
+	critical_path_stats = starpu_getenv_number_default("STARPU_CRITICAL_PATH_STATS", 0);
+	if (critical_path_stats)
+		starpu_perf_counter_collection_start();
+}
+
+void _starpu_critical_path_shutdown(void)
+{
+	if (critical_path_stats)
+	{
+		starpu_perf_counter_collection_stop();
+		critical_path_stats = 0;
+	}
+	_starpu_spin_destroy(&critical_path_lock);
+	STARPU_PTHREAD_KEY_DELETE(notifying_key);
+}
@@ -0,0 +1,71 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __CRITICAL_PATH_H__
+#define __CRITICAL_PATH_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <starpu_profiling.h>
+#include <common/config.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_job;
+
+struct _starpu_critical_path_codelet
+{
+	struct starpu_codelet *cl;
+	double length;
+};
+
+/** Longest chain of tasks, weighted by their measured execution times */
+struct _starpu_critical_path
+{
+	/** Tracking generation the chain belongs to, chains of previous
+	 * generations are ignored after starpu_profiling_critical_path_reset() */
+	unsigned long generation;
+	double length;
+	double worker_stall;
+	double data_stall;
+	unsigned long ntasks;
+	/** Heaviest codelets of the chain, approximated when the chain
+	 * contains more than STARPU_PROFILING_CRITICAL_PATH_NCODELETS codelets */
+	struct _starpu_critical_path_codelet codelets[STARPU_PROFILING_CRITICAL_PATH_NCODELETS];
+};
+
+/** The task became ready, possibly because of the termination of the task
+ * being terminated by this thread */
+void _starpu_critical_path_job_ready(struct _starpu_job *j);
+/** A task the job depends on has terminated, to be called with the job
+ * sync_mutex held */
+void _starpu_critical_path_job_released(struct _starpu_job *j);
+/** The task was executed in \p measured microseconds, append it to the
+ * longest chain leading to it */
+void _starpu_critical_path_job_executed(struct _starpu_job *j, struct starpu_codelet *cl, double measured);
+/** The thread starts notifying the successors of the job, which thus inherit
+ * its chain. Return the chain of the job whose successors were previously
+ * being notified, to be given back to _starpu_critical_path_job_end_notify */
+void *_starpu_critical_path_job_start_notify(struct _starpu_job *j);
+void _starpu_critical_path_job_end_notify(struct _starpu_job *j, void *previous);
+
+void _starpu_critical_path_init(void);
+void _starpu_critical_path_shutdown(void);
+
+#pragma GCC visibility pop
+
+#endif // __CRITICAL_PATH_H__
@@ -0,0 +1,418 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Log-bucketed latency histograms of the workers and of the codelets.
+ *
+ * Each worker records its own queueing, fetch and execution latencies
+ * without any synchronization, the execution times of the codelets are
+ * recorded with atomic additions since a codelet runs on several workers.
+ * The histograms are only merged when percentiles are requested.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+#include <starpu.h>
+#include <starpu_profiling.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/starpu_spinlock.h>
+#include <core/workers.h>
+#include <core/jobs.h>
+#include <common/knobs.h>
+#include <profiling/latency.h>
+
+static const char *latency_names[STARPU_PROFILING_LATENCY_NKINDS] =
+{
+	[STARPU_PROFILING_LATENCY_QUEUE] = "queue",
+	[STARPU_PROFILING_LATENCY_FETCH] = "fetch",
+	[STARPU_PROFILING_LATENCY_EXEC] = "exec",
+};
+
+/* codelets which have an execution time histogram, their histogram is freed
+ * by _starpu_latency_shutdown(), the application must thus not free them
+ * before starpu_shutdown() */
+static starpu_pthread_mutex_t codelets_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static struct starpu_codelet **codelets;
+static unsigned ncodelets;
+static unsigned max_codelets;
+
+static int latency_stats;
+
+/* per-worker counters */
+static int __w_queue_p50;
+static int __w_queue_p99;
+static int __w_queue_p999;
+static int __w_fetch_p50;
+static int __w_fetch_p99;
+static int __w_fetch_p999;
+static int __w_exec_p50;
+static int __w_exec_p99;
+static int __w_exec_p999;
+
+/* per-codelet counters */
+static int __c_exec_p50;
+static int __c_exec_p99;
+static int __c_exec_p999;
+
+static const double summary_percentiles[3] = { 50., 99., 99.9 };
+
+static void per_worker_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context != NULL);
+	struct _starpu_worker *worker = context;
+	double values[3];
+
+	_starpu_latency_percentiles(&worker->latency_histograms[STARPU_PROFILING_LATENCY_QUEUE], summary_percentiles, values, 3);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_queue_p50, values[0]);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_queue_p99, values[1]);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_queue_p999, values[2]);
+
+	_starpu_latency_percentiles(&worker->latency_histograms[STARPU_PROFILING_LATENCY_FETCH], summary_percentiles, values, 3);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_fetch_p50, values[0]);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_fetch_p99, values[1]);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_fetch_p999, values[2]);
+
+	_starpu_latency_percentiles(&worker->latency_histograms[STARPU_PROFILING_LATENCY_EXEC], summary_percentiles, values, 3);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_exec_p50, values[0]);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_exec_p99, values[1]);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_exec_p999, values[2]);
+}
+
+static void per_codelet_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context != NULL);
+	struct starpu_codelet *cl = context;
+	double values[3] = { 0., 0., 0. };
+
+	if (cl->latency_histogram)
+		_starpu_latency_percentiles(cl->latency_histogram, summary_percentiles, values, 3);
+	_starpu_perf_counter_sample_set_double_value(sample, __c_exec_p50, values[0]);
+	_starpu_perf_counter_sample_set_double_value(sample, __c_exec_p99, values[1]);
+	_starpu_perf_counter_sample_set_double_value(sample, __c_exec_p999, values[2]);
+}
+
+void _starpu__latency_c__register_counters(void)
+{
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_worker;
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_queue_p50, double, "median time between tasks becoming ready and this worker starting to fetch their data (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_queue_p99, double, "99th percentile of the time between tasks becoming ready and this worker starting to fetch their data (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_queue_p999, double, "99.9th percentile of the time between tasks becoming ready and this worker starting to fetch their data (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_fetch_p50, double, "median time this worker waited for the data of tasks (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_fetch_p99, double, "99th percentile of the time this worker waited for the data of tasks (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_fetch_p999, double, "99.9th percentile of the time this worker waited for the data of tasks (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_exec_p50, double, "median execution time of tasks on this worker (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_exec_p99, double, "99th percentile of the execution time of tasks on this worker (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, w_exec_p999, double, "99.9th percentile of the execution time of tasks on this worker (microseconds, since StarPU initialization)");
+
+		_starpu_perf_counter_register_updater(scope, per_worker_sample_updater);
+	}
+
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_codelet;
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, c_exec_p50, double, "median execution time of codelet's task instances (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, c_exec_p99, double, "99th percentile of the execution time of codelet's task instances (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.latency", scope, c_exec_p999, double, "99.9th percentile of the execution time of codelet's task instances (microseconds, since StarPU initialization)");
+
+		_starpu_perf_counter_register_updater(scope, per_codelet_sample_updater);
+	}
+}
+
+/* - */
+
+/* Middle of the range of latencies recorded in the bucket, in ns */
+static double _bucket_value(unsigned idx)
+{
+	if (idx < _STARPU_LATENCY_SUB_COUNT)
+		return idx;
+
+	unsigned shift = idx / _STARPU_LATENCY_SUB_COUNT - 1;
+	uint64_t low = (uint64_t) (_STARPU_LATENCY_SUB_COUNT + idx % _STARPU_LATENCY_SUB_COUNT) << shift;
+	if (idx == _STARPU_LATENCY_NBUCKETS - 1)
+		/* the last bucket is unbounded */
+		return low;
+	return low + ((1ULL << shift) - 1) / 2.;
+}
+
+void _starpu_latency_percentiles(const struct starpu_profiling_latency_histogram *histogram, const double *percentiles, double *values, unsigned n)
+{
+	unsigned long total = 0;
+	unsigned idx, i;
+
+	for (idx = 0; idx < _STARPU_LATENCY_NBUCKETS; idx++)
+		total += histogram->count[idx];
+
+	if (total == 0)
+	{
+		for (i = 0; i < n; i++)
+			values[i] = 0.;
+		return;
+	}
+
+	unsigned long cumul = 0;
+	i = 0;
+	for (idx = 0; idx < _STARPU_LATENCY_NBUCKETS && i < n; idx++)
+	{
+		cumul += histogram->count[idx];
+		while (i < n)
+		{
+			STARPU_ASSERT(i == 0 || percentiles[i] >= percentiles[i-1]);
+			double rank = ceil(percentiles[i] / 100. * total);
+			if (rank < 1.)
+				rank = 1.;
+			if ((double) cumul < rank)
+				break;
+			values[i++] = _bucket_value(idx) / 1000.;
+		}
+	}
+
+	/* the counts may have increased since the total was computed */
+	for (; i < n; i++)
+		values[i] = _bucket_value(_STARPU_LATENCY_NBUCKETS - 1) / 1000.;
+}
+
+static void _merge(struct starpu_profiling_latency_histogram *dst, const struct starpu_profiling_latency_histogram *src)
+{
+	unsigned idx;
+	for (idx = 0; idx < _STARPU_LATENCY_NBUCKETS; idx++)
+		dst->count[idx] += src->count[idx];
+}
+
+/* - */
+
+void _starpu_latency_worker_init(struct _starpu_worker *worker)
+{
+	_STARPU_CALLOC(worker->latency_histograms, STARPU_PROFILING_LATENCY_NKINDS, sizeof(*worker->latency_histograms));
+}
+
+void _starpu_latency_worker_deinit(struct _starpu_worker *worker)
+{
+	free(worker->latency_histograms);
+	worker->latency_histograms = NULL;
+}
+
+struct starpu_profiling_latency_histogram *_starpu_latency_codelet_get(struct starpu_codelet *cl)
+{
+	struct starpu_profiling_latency_histogram *histogram = cl->latency_histogram;
+	if (histogram)
+		return histogram;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&codelets_mutex);
+	histogram = cl->latency_histogram;
+	if (histogram == NULL)
+	{
+		if (ncodelets == max_codelets)
+		{
+			max_codelets = max_codelets ? 2 * max_codelets : 16;
+			_STARPU_REALLOC(codelets, max_codelets * sizeof(*codelets));
+		}
+		codelets[ncodelets++] = cl;
+		_STARPU_CALLOC(histogram, 1, sizeof(*histogram));
+		STARPU_WMB();
+		cl->latency_histogram = histogram;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&codelets_mutex);
+	return histogram;
+}
+
+void _starpu_latency_job_ready(struct _starpu_job *j)
+{
+	j->latency_ready_date = starpu_timing_now();
+}
+
+void _starpu_latency_fetch_start(struct _starpu_worker *worker, struct _starpu_job *j)
+{
+	double now = starpu_timing_now();
+	if (j->latency_ready_date != 0.)
+	{
+		j->latency_queue_delay = now - j->latency_ready_date;
+		_starpu_latency_record(&worker->latency_histograms[STARPU_PROFILING_LATENCY_QUEUE], j->latency_queue_delay);
+		j->latency_ready_date = 0.;
+	}
+	j->latency_fetch_date = now;
+}
+
+void _starpu_latency_fetch_end(struct _starpu_worker *worker, struct _starpu_job *j)
+{
+	if (j->latency_fetch_date != 0.)
+	{
+		j->latency_fetch_delay = starpu_timing_now() - j->latency_fetch_date;
+		_starpu_latency_record(&worker->latency_histograms[STARPU_PROFILING_LATENCY_FETCH], j->latency_fetch_delay);
+		j->latency_fetch_date = 0.;
+	}
+}
+
+void _starpu_latency_executed(struct _starpu_worker *worker, struct starpu_codelet *cl, double measured)
+{
+	_starpu_latency_record(&worker->latency_histograms[STARPU_PROFILING_LATENCY_EXEC], measured);
+	_starpu_latency_record_atomic(_starpu_latency_codelet_get(cl), measured);
+}
+
+/* - */
+
+double starpu_profiling_worker_latency_percentile(int workerid, enum starpu_profiling_latency kind, double percentile)
+{
+	STARPU_ASSERT(kind < STARPU_PROFILING_LATENCY_NKINDS);
+	double value;
+
+	if (workerid >= 0)
+	{
+		STARPU_ASSERT((unsigned) workerid < starpu_worker_get_count());
+		_starpu_latency_percentiles(&_starpu_get_worker_struct(workerid)->latency_histograms[kind], &percentile, &value, 1);
+	}
+	else
+	{
+		struct starpu_profiling_latency_histogram *merged;
+		unsigned worker, nworkers = starpu_worker_get_count();
+		_STARPU_CALLOC(merged, 1, sizeof(*merged));
+		for (worker = 0; worker < nworkers; worker++)
+			_merge(merged, &_starpu_get_worker_struct(worker)->latency_histograms[kind]);
+		_starpu_latency_percentiles(merged, &percentile, &value, 1);
+		free(merged);
+	}
+	return value;
+}
+
+double starpu_profiling_codelet_latency_percentile(struct starpu_codelet *cl, double percentile)
+{
+	double value = 0.;
+	if (cl->latency_histogram)
+		_starpu_latency_percentiles(cl->latency_histogram, &percentile, &value, 1);
+	return value;
+}
+
+void starpu_profiling_latency_reset(void)
+{
+	unsigned worker, nworkers = starpu_worker_get_count();
+	for (worker = 0; worker < nworkers; worker++)
+		memset(_starpu_get_worker_struct(worker)->latency_histograms, 0, STARPU_PROFILING_LATENCY_NKINDS * sizeof(struct starpu_profiling_latency_histogram));
+
+	unsigned i;
+	STARPU_PTHREAD_MUTEX_LOCK(&codelets_mutex);
+	for (i = 0; i < ncodelets; i++)
+		memset(codelets[i]->latency_histogram, 0, sizeof(struct starpu_profiling_latency_histogram));
+	STARPU_PTHREAD_MUTEX_UNLOCK(&codelets_mutex);
+}
+
+static unsigned long _count(const struct starpu_profiling_latency_histogram *histogram)
+{
+	unsigned long total = 0;
+	unsigned idx;
+	for (idx = 0; idx < _STARPU_LATENCY_NBUCKETS; idx++)
+		total += histogram->count[idx];
+	return total;
+}
+
+static void _display_histogram(FILE *stream, const char *name, const struct starpu_profiling_latency_histogram *histogram)
+{
+	double values[3];
+	_starpu_latency_percentiles(histogram, summary_percentiles, values, 3);
+	fprintf(stream, "\t%-8s %10lu samples\tp50 %12.2lf us\tp99 %12.2lf us\tp999 %12.2lf us\n", name, _count(histogram), values[0], values[1], values[2]);
+}
+
+void starpu_profiling_latency_display_summary(FILE *stream)
+{
+	unsigned worker, nworkers = starpu_worker_get_count();
+	enum starpu_profiling_latency kind;
+	struct starpu_profiling_latency_histogram *merged;
+
+	_STARPU_CALLOC(merged, STARPU_PROFILING_LATENCY_NKINDS, sizeof(*merged));
+
+	fprintf(stream, "\n#---------------------\n");
+	fprintf(stream, "Latency stats:\n");
+
+	for (worker = 0; worker < nworkers; worker++)
+	{
+		char name[64];
+		struct starpu_profiling_latency_histogram *histograms = _starpu_get_worker_struct(worker)->latency_histograms;
+		starpu_worker_get_name(worker, name, sizeof(name));
+		fprintf(stream, "%-32s\n", name);
+		for (kind = 0; kind < STARPU_PROFILING_LATENCY_NKINDS; kind++)
+		{
+			_display_histogram(stream, latency_names[kind], &histograms[kind]);
+			_merge(&merged[kind], &histograms[kind]);
+		}
+	}
+
+	fprintf(stream, "All workers\n");
+	for (kind = 0; kind < STARPU_PROFILING_LATENCY_NKINDS; kind++)
+		_display_histogram(stream, latency_names[kind], &merged[kind]);
+
+	unsigned i;
+	STARPU_PTHREAD_MUTEX_LOCK(&codelets_mutex);
+	if (ncodelets)
+		fprintf(stream, "\nCodelets:\n");
+	for (i = 0; i < ncodelets; i++)
+	{
+		const char *name = _starpu_codelet_get_model_name(codelets[i]);
+		fprintf(stream, "%-32s\n", name ? name : "unknown");
+		_display_histogram(stream, latency_names[STARPU_PROFILING_LATENCY_EXEC], codelets[i]->latency_histogram);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&codelets_mutex);
+
+	fprintf(stream, "#---------------------\n");
+	free(merged);
+}
+
+void starpu_profiling_latency_helper_display_summary(void)
+{
+	if (!latency_stats)
+		return;
+	const char *filename = starpu_getenv("STARPU_LATENCY_STATS_FILE");
+	if (filename==NULL)
+		starpu_profiling_latency_display_summary(stderr);
+	else
+	{
+		FILE *sfile = fopen(filename, "w+");
+		STARPU_ASSERT_MSG(sfile, "Could not open file %s for displaying latency stats (%s). You can specify another file destination with the STARPU_LATENCY_STATS_FILE environment variable", filename, strerror(errno));
+		starpu_profiling_latency_display_summary(sfile);
+		fclose(sfile);
+	}
+}
+
+/* - */
+
+void _starpu_latency_init(void)
+{
+	latency_stats = starpu_getenv_number_default("STARPU_LATENCY_STATS", 0);
+	if (latency_stats)
+		starpu_perf_counter_collection_start();
+}
+
+void _starpu_latency_shutdown(void)
+{
+	if (latency_stats)
+	{
+		starpu_perf_counter_collection_stop();
+		latency_stats = 0;
+	}
+
+	unsigned i;
+	STARPU_PTHREAD_MUTEX_LOCK(&codelets_mutex);
+	for (i = 0; i < ncodelets; i++)
+	{
+		free(codelets[i]->latency_histogram);
+		codelets[i]->latency_histogram = NULL;
+	}
+	free(codelets);
+	codelets = NULL;
+	ncodelets = 0;
+	max_codelets = 0;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&codelets_mutex);
+}
@@ -0,0 +1,110 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <starpu_profiling.h>
+#include <common/config.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_worker;
+struct _starpu_job;
+
+/** Latency histograms are log-bucketed: each power of two is split into
+ * 2^_STARPU_LATENCY_SUB_BITS linear buckets, so that the relative error on a
+ * percentile is below 2^-_STARPU_LATENCY_SUB_BITS. Latencies are recorded in
+ * nanoseconds, those above 2^_STARPU_LATENCY_MAX_BITS ns (about 18 minutes)
+ * all land in the last bucket. */
+#define _STARPU_LATENCY_SUB_BITS 4
+#define _STARPU_LATENCY_SUB_COUNT (1 << _STARPU_LATENCY_SUB_BITS)
+#define _STARPU_LATENCY_MAX_BITS 40
+#define _STARPU_LATENCY_NBUCKETS ((_STARPU_LATENCY_MAX_BITS - _STARPU_LATENCY_SUB_BITS + 1) * _STARPU_LATENCY_SUB_COUNT)
+
+struct starpu_profiling_latency_histogram
+{
+	unsigned long count[_STARPU_LATENCY_NBUCKETS];
+};
+
+static inline unsigned _starpu_latency_bucket(uint64_t ns)
+{
+	if (ns < _STARPU_LATENCY_SUB_COUNT)
+		return ns;
+
+	int msb;
+#if (__GNUC__ >= 4) || ((__GNUC__ == 3) && (__GNUC_MINOR__ >= 4))
+	msb = 63 - __builtin_clzll(ns);
+#else
+	msb = 63;
+	while (!((ns >> msb) & 1))
+		msb--;
+#endif
+	if (msb >= _STARPU_LATENCY_MAX_BITS)
+		return _STARPU_LATENCY_NBUCKETS - 1;
+
+	unsigned shift = msb - _STARPU_LATENCY_SUB_BITS;
+	return (shift + 1) * _STARPU_LATENCY_SUB_COUNT + ((ns >> shift) & (_STARPU_LATENCY_SUB_COUNT - 1));
+}
+
+/** Record a latency given in microseconds. Only the owner of the histogram
+ * may call this, which thus does not need any atomic operation. */
+static inline void _starpu_latency_record(struct starpu_profiling_latency_histogram *histogram, double us)
+{
+	histogram->count[_starpu_latency_bucket(us > 0. ? (uint64_t) (us * 1000.) : 0)]++;
+}
+
+/** Same as _starpu_latency_record, for histograms which are shared between
+ * workers */
+static inline void _starpu_latency_record_atomic(struct starpu_profiling_latency_histogram *histogram, double us)
+{
+	(void) STARPU_ATOMIC_ADDL(&histogram->count[_starpu_latency_bucket(us > 0. ? (uint64_t) (us * 1000.) : 0)], 1);
+}
+
+/** Compute the \p n percentiles \p percentiles (in percent, in increasing
+ * order) of the histogram in a single pass, in microseconds. They are 0 if
+ * the histogram is empty. */
+void _starpu_latency_percentiles(const struct starpu_profiling_latency_histogram *histogram, const double *percentiles, double *values, unsigned n);
+
+/** Allocate the histograms of a worker */
+void _starpu_latency_worker_init(struct _starpu_worker *worker);
+/** Free the histograms of a worker */
+void _starpu_latency_worker_deinit(struct _starpu_worker *worker);
+
+/** Return the execution time histogram of the codelet, allocating it on
+ * first use */
+struct starpu_profiling_latency_histogram *_starpu_latency_codelet_get(struct starpu_codelet *cl);
+
+/** The task became ready */
+void _starpu_latency_job_ready(struct _starpu_job *j);
+/** The worker starts fetching the input data of the task */
+void _starpu_latency_fetch_start(struct _starpu_worker *worker, struct _starpu_job *j);
+/** The input data of the task is available on the worker */
+void _starpu_latency_fetch_end(struct _starpu_worker *worker, struct _starpu_job *j);
+/** The task was executed in \p measured microseconds */
+void _starpu_latency_executed(struct _starpu_worker *worker, struct starpu_codelet *cl, double measured);
+
+/** Start collecting the latencies if STARPU_LATENCY_STATS is set */
+void _starpu_latency_init(void);
+/** Free the codelet histograms */
+void _starpu_latency_shutdown(void);
+
+#pragma GCC visibility pop
+
+#endif // __LATENCY_H__
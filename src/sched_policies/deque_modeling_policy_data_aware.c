@@ -62,6 +62,27 @@ struct _starpu_dmda_data
 	long int ready_task_cnt;
 	long int eager_task_cnt; /* number of tasks scheduled without model */
 	int num_priorities;
+
+	/* whether to compute the predictions only once per class of workers */
+	int memoize;
+#ifdef STARPU_VERBOSE
+	long int push_task_cnt;
+	double push_time; /* cumulated time spent in taking the scheduling decisions, in us */
+#endif
+};
+
+/* Predictions of a task for a class of workers which share the same
+ * performance model architecture and the same memory node, and thus get the
+ * same predictions */
+struct _starpu_dmda_prediction_class
+{
+	struct starpu_perfmodel_arch *perf_arch;
+	unsigned memory_node;
+	/* implementations for which the predictions were already computed */
+	unsigned impl_mask;
+	double length[STARPU_MAXIMPLEMENTATIONS];
+	double data_penalty[STARPU_MAXIMPLEMENTATIONS];
+	double energy[STARPU_MAXIMPLEMENTATIONS];
 };
 
 /* performance steering knobs */
@@ -425,7 +446,60 @@ static int push_task_on_best_worker(struct starpu_task *task, int best_workerid,
 	return ret;
 }
 
-/* TODO: factorise CPU computations, expensive with a lot of cores */
+static int same_perf_arch(struct starpu_perfmodel_arch *arch1, struct starpu_perfmodel_arch *arch2)
+{
+	int dev;
+
+	if (arch1 == arch2)
+		return 1;
+	if (arch1->ndevices != arch2->ndevices)
+		return 0;
+	for (dev = 0; dev < arch1->ndevices; dev++)
+		if (arch1->devices[dev].type != arch2->devices[dev].type
+		    || arch1->devices[dev].devid != arch2->devices[dev].devid
+		    || arch1->devices[dev].ncores != arch2->devices[dev].ncores)
+			return 0;
+	return 1;
+}
+
+/* Tell whether the predictions of the task only depend on the performance
+ * model architecture and memory node of the workers, and can thus be shared
+ * between the workers of a class */
+static int predictions_can_be_shared(struct starpu_task *task)
+{
+	struct starpu_codelet *cl = task->cl;
+
+	if (!cl)
+		return 1;
+	if (cl->model && cl->model->type == STARPU_PER_WORKER)
+		return 0;
+	if (cl->energy_model && cl->energy_model->type == STARPU_PER_WORKER)
+		return 0;
+	/* The memory node of the data may depend on the NUMA node of the worker */
+	if (cl->specific_nodes)
+		return 0;
+	return 1;
+}
+
+/* Return the class of workers of the given worker, creating it if it does not
+ * exist yet */
+static struct _starpu_dmda_prediction_class *get_prediction_class(struct _starpu_dmda_prediction_class *classes, unsigned *nclasses,
+								   struct starpu_perfmodel_arch *perf_arch, unsigned memory_node)
+{
+	unsigned i;
+	struct _starpu_dmda_prediction_class *wclass;
+
+	for (i = 0; i < *nclasses; i++)
+		if (classes[i].memory_node == memory_node && same_perf_arch(classes[i].perf_arch, perf_arch))
+			return &classes[i];
+
+	wclass = &classes[(*nclasses)++];
+	wclass->perf_arch = perf_arch;
+	wclass->memory_node = memory_node;
+	wclass->impl_mask = 0;
+	return wclass;
+}
+
 static void compute_all_performance_predictions(struct starpu_task *task,
 						unsigned nworkers,
 						double local_task_length[nworkers][STARPU_MAXIMPLEMENTATIONS],
@@ -458,6 +532,12 @@ static void compute_all_performance_predictions(struct starpu_task *task,
 	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
 	double now = starpu_timing_now();
 
+	/* All the CPU workers of a NUMA node, or the workers of identical
+	 * GPUs, get the same predictions, only compute them once per class */
+	int memoize = dt->memoize && predictions_can_be_shared(task);
+	struct _starpu_dmda_prediction_class classes[memoize ? nworkers : 1];
+	unsigned nclasses = 0;
+
 	struct starpu_sched_ctx_iterator it;
 	workers->init_iterator_for_parallel_tasks(workers, &it, task);
 	while(worker_current<nworkers && workers->has_next(workers, &it))
@@ -468,6 +548,7 @@ static void compute_all_performance_predictions(struct starpu_task *task,
 		struct starpu_st_fifo_taskq *fifo = &dt->queue_array[workerid];
 		struct starpu_perfmodel_arch* perf_arch = starpu_worker_get_perf_archtype(workerid, sched_ctx_id);
 		unsigned memory_node = starpu_worker_get_memory_node(workerid);
+		struct _starpu_dmda_prediction_class *wclass = NULL;
 
 		STARPU_ASSERT_MSG(fifo != NULL, "workerid %u ctx %u\n", workerid, sched_ctx_id);
 
@@ -477,6 +558,9 @@ static void compute_all_performance_predictions(struct starpu_task *task,
 		if (!starpu_worker_can_execute_task_impl(workerid, task, &impl_mask))
 			continue;
 
+		if (memoize)
+			wclass = get_prediction_class(classes, &nclasses, perf_arch, memory_node);
+
 		for (nimpl  = 0; nimpl < STARPU_MAXIMPLEMENTATIONS; nimpl++)
 		{
 			if (!(impl_mask & (1U << nimpl)))
@@ -510,7 +594,16 @@ static void compute_all_performance_predictions(struct starpu_task *task,
 
 			//_STARPU_DEBUG("Scheduler dmda: task length (%lf) workerid (%u) kernel (%u) \n", local_task_length[workerid][nimpl],workerid,nimpl);
 
-			if (bundle)
+			if (wclass && (wclass->impl_mask & (1U << nimpl)))
+			{
+				/* Already computed for another worker of the class */
+				local_task_length[worker_current][nimpl] = wclass->length[nimpl];
+				if (local_data_penalty)
+					local_data_penalty[worker_current][nimpl] = wclass->data_penalty[nimpl];
+				if (local_energy)
+					local_energy[worker_current][nimpl] = wclass->energy[nimpl];
+			}
+			else if (bundle)
 			{
 				/* TODO : conversion time */
 				local_task_length[worker_current][nimpl] = starpu_task_bundle_expected_length(bundle, perf_arch, nimpl);
@@ -531,6 +624,16 @@ static void compute_all_performance_predictions(struct starpu_task *task,
 				if (conversion_time > 0.0)
 					local_task_length[worker_current][nimpl] += conversion_time;
 			}
+
+			if (wclass && !(wclass->impl_mask & (1U << nimpl)))
+			{
+				wclass->length[nimpl] = local_task_length[worker_current][nimpl];
+				if (local_data_penalty)
+					wclass->data_penalty[nimpl] = local_data_penalty[worker_current][nimpl];
+				if (local_energy)
+					wclass->energy[nimpl] = local_energy[worker_current][nimpl];
+				wclass->impl_mask |= 1U << nimpl;
+			}
 			double ntasks_end = fifo_ntasks / starpu_worker_get_relative_speedup(perf_arch);
 
 			/*
@@ -635,6 +738,9 @@ static double _dmda_push_task(struct starpu_task *task, unsigned prio, unsigned
 	struct _starpu_dmda_data *dt = (struct _starpu_dmda_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
 	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
 	unsigned nworkers = workers->nworkers;
+#ifdef STARPU_VERBOSE
+	double push_start = starpu_timing_now();
+#endif
 	double local_task_length[nworkers][STARPU_MAXIMPLEMENTATIONS];
 	double local_data_penalty[nworkers][STARPU_MAXIMPLEMENTATIONS];
 	double local_energy[nworkers][STARPU_MAXIMPLEMENTATIONS];
@@ -750,6 +856,10 @@ static double _dmda_push_task(struct starpu_task *task, unsigned prio, unsigned
 	if(!simulate)
 	{
 		/* we should now have the best worker in variable "best" */
+#ifdef STARPU_VERBOSE
+		dt->push_time += starpu_timing_now() - push_start;
+		dt->push_task_cnt++;
+#endif
 		return push_task_on_best_worker(task, best, model_best, transfer_model_best, prio, sched_ctx_id);
 	}
 	else
@@ -879,6 +989,7 @@ static void initialize_dmda_policy(unsigned sched_ctx_id)
 	dt->_gamma = starpu_getenv_float_default("STARPU_SCHED_GAMMA", _STARPU_SCHED_GAMMA_DEFAULT);
 	/* data->idle_power: Idle power of the whole machine in Watt */
 	dt->idle_power = starpu_getenv_float_default("STARPU_IDLE_POWER", 0.0);
+	dt->memoize = starpu_getenv_number_default("STARPU_SCHED_MEMOIZE_PREDICTIONS", 1);
 
 	if(starpu_sched_ctx_min_priority_is_set(sched_ctx_id) != 0 && starpu_sched_ctx_max_priority_is_set(sched_ctx_id) != 0)
 		dt->num_priorities = starpu_sched_ctx_get_max_priority(sched_ctx_id) - starpu_sched_ctx_get_min_priority(sched_ctx_id) + 1;
@@ -917,6 +1028,10 @@ static void deinitialize_dmda_policy(unsigned sched_ctx_id)
 			      modelled_task_cnt,
 			      (100.0f*modelled_task_cnt)/dt->total_task_cnt,
 			      modelled_task_cnt==0?" *** Check if performance models are enabled and converging on a per-codelet basis, or use an non-modeling scheduling policy. ***":"");
+		if (dt->push_task_cnt)
+			_STARPU_DEBUG("%s sched policy (sched_ctx %u): %.2f us per scheduling decision\n",
+				      sched_ctx->sched_policy?sched_ctx->sched_policy->policy_name:"<none>",
+				      sched_ctx_id, dt->push_time / dt->push_task_cnt);
 	}
 #endif
 
@@ -107,7 +107,9 @@ static int _starpu_priority_push_task(struct starpu_task *task)
 
 	struct starpu_sched_ctx_iterator it;
 #ifndef STARPU_NON_BLOCKING_DRIVERS
-	char dowake[STARPU_NMAXWORKERS] = { 0 };
+	int dowake[STARPU_NMAXWORKERS];
+	unsigned ndowake = 0;
+	unsigned ntasks = data->taskq.ntasks;
 #endif
 
 	workers->init_iterator_for_parallel_tasks(workers, &it, task);
@@ -129,7 +131,7 @@ static int _starpu_priority_push_task(struct starpu_task *task)
 			/* We really woke at least somebody, no need to wake somebody else */
 			break;
 #else
-			dowake[worker] = 1;
+			dowake[ndowake++] = worker;
 #endif
 		}
 	}
@@ -137,16 +139,9 @@ static int _starpu_priority_push_task(struct starpu_task *task)
 	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
 
 #if !defined(STARPU_NON_BLOCKING_DRIVERS) || defined(STARPU_SIMGRID)
-	/* Now that we have a list of potential workers, try to wake one */
-
-	workers->init_iterator(workers, &it);
-	while(workers->has_next(workers, &it))
-	{
-		unsigned worker = workers->get_next(workers, &it);
-		if (dowake[worker])
-			if (starpu_wake_worker_relax_light(worker))
-				break; // wake up a single worker
-	}
+	/* Now that we have a list of potential workers, wake enough of them
+	 * for the queued tasks */
+	starpu_wake_workers_relax_light(dowake, ndowake, ntasks);
 #endif
 
 	return 0;
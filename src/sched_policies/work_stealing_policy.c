@@ -28,6 +28,7 @@
 #include <core/debug.h>
 #include <core/task.h>
 #include <sched_policies/prio_deque.h>
+#include <datawizard/prefetch_lookahead.h>
 
 /* Experimental (dead) code which needs to be tested, fixed... */
 /* #define USE_OVERLOAD */
@@ -687,6 +688,10 @@ int ws_push_task(struct starpu_task *task)
 	if (workerid == -1 || !starpu_sched_ctx_contains_worker(workerid, sched_ctx_id) ||
 			!starpu_worker_can_execute_task_first_impl(workerid, task, NULL))
 		workerid = select_worker(ws, task, sched_ctx_id);
+	/* Tasks may get stolen, so we only prefetch when the lookahead engine
+	 * can cancel it */
+	if (_starpu_prefetch_lookahead_enabled())
+		(void) _starpu_prefetch_lookahead_push(task, workerid, task->priority);
 	starpu_worker_lock(workerid);
 	STARPU_AYU_ADDTOTASKQUEUE(starpu_task_get_job_id(task), workerid);
 	starpu_sched_task_break(task);
@@ -19,6 +19,7 @@
 
 #include <starpu.h>
 #include <common/config.h>
+#include <common/utils.h>
 #include <stdarg.h>
 #include <util/starpu_task_insert_utils.h>
 
@@ -173,6 +174,46 @@ int _starpu_task_insert_v(struct starpu_codelet *cl, va_list varg_list)
 	return ret;
 }
 
+struct starpu_task_insert_prepared *starpu_task_insert_prepare(struct starpu_codelet *cl, ...)
+{
+	struct starpu_task_insert_prepared *prepared;
+	va_list varg_list;
+	int ret;
+
+	_STARPU_MALLOC(prepared, sizeof(*prepared));
+	va_start(varg_list, cl);
+	ret = _starpu_task_insert_prepare_create(cl, prepared, varg_list);
+	va_end(varg_list);
+
+	if (ret != 0)
+	{
+		starpu_task_insert_prepared_destroy(prepared);
+		return NULL;
+	}
+	return prepared;
+}
+
+int starpu_task_insert_prepared_submit(struct starpu_task_insert_prepared *prepared, starpu_data_handle_t *handles, void **values)
+{
+	struct starpu_task *task;
+	int ret;
+
+	task = starpu_task_insert_prepared_build(prepared, handles, values);
+	ret = starpu_task_submit(task);
+
+	if (STARPU_UNLIKELY(ret == -ENODEV))
+	{
+		_STARPU_MSG("submission of task %p with codelet %p failed (symbol `%s') (err: ENODEV)\n",
+			    task, task->cl,
+			    task->cl->name ? task->cl->name :
+			    (task->cl->model && task->cl->model->symbol)?task->cl->model->symbol:"none");
+
+		task->destroy = 0;
+		starpu_task_destroy(task);
+	}
+	return ret;
+}
+
 #undef starpu_task_set
 int starpu_task_set(struct starpu_task *task, struct starpu_codelet *cl, ...)
 {
@@ -604,6 +604,190 @@ int _starpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *ta
 	return 0;
 }
 
+int _starpu_task_insert_prepare_create(struct starpu_codelet *cl, struct starpu_task_insert_prepared *prepared, va_list varg_list)
+{
+	int arg_type;
+	int allocated_modes = 0;
+	int allocated_values = 0;
+
+	STARPU_ASSERT_MSG(cl != NULL, "starpu_task_insert_prepare needs a codelet");
+
+	memset(prepared, 0, sizeof(*prepared));
+	prepared->cl = cl;
+	prepared->priority = STARPU_DEFAULT_PRIO;
+	prepared->sched_ctx = STARPU_NMAX_SCHED_CTXS;
+	prepared->where = -1;
+	prepared->task_modes = cl->nbuffers == STARPU_VARIABLE_NBUFFERS || (cl->nbuffers > STARPU_NMAXBUFS && !cl->dyn_modes);
+
+	/* Leave room for the number of arguments, as done by starpu_codelet_pack_arg_init */
+	prepared->arg_size = sizeof(int);
+
+	while((arg_type = va_arg(varg_list, int)) != 0)
+	{
+		if (arg_type & STARPU_R || arg_type & STARPU_W || arg_type & STARPU_SCRATCH || arg_type & STARPU_REDUX || arg_type & STARPU_MPI_REDUX)
+		{
+			int current_buffer = prepared->nbuffers;
+			enum starpu_data_access_mode arg_mode = (enum starpu_data_access_mode) arg_type & ~STARPU_SSEND & ~STARPU_NOFOOTPRINT;
+
+			STARPU_ASSERT_MSG(cl->nbuffers == STARPU_VARIABLE_NBUFFERS || current_buffer < cl->nbuffers, "Too many data passed to starpu_task_insert_prepare");
+			/* MPI_REDUX should be interpreted as RW|COMMUTE by the "ground" StarPU layer.*/
+			if (arg_mode & STARPU_MPI_REDUX)
+				arg_mode = STARPU_RW|STARPU_COMMUTE;
+
+			if (!prepared->task_modes)
+			{
+				/* Check the mode against the codelet once for all the tasks */
+				if (STARPU_CODELET_GET_MODE(cl, current_buffer))
+				{
+					STARPU_ASSERT_MSG((STARPU_CODELET_GET_MODE(cl, current_buffer) & ~STARPU_NOFOOTPRINT) == arg_mode,
+							  "The codelet <%s> defines the access mode %d for the buffer %d which is different from the mode %d given to starpu_task_insert_prepare\n",
+							  _starpu_codelet_get_name(cl), STARPU_CODELET_GET_MODE(cl, current_buffer),
+							  current_buffer, arg_mode);
+				}
+				else
+				{
+					STARPU_CODELET_SET_MODE(cl, arg_mode, current_buffer);
+				}
+			}
+
+			if (current_buffer == allocated_modes)
+			{
+				allocated_modes = allocated_modes ? 2 * allocated_modes : STARPU_NMAXBUFS;
+				_STARPU_REALLOC(prepared->modes, allocated_modes * sizeof(prepared->modes[0]));
+			}
+			prepared->modes[current_buffer] = arg_mode;
+			prepared->nbuffers++;
+		}
+		else if (arg_type==STARPU_VALUE)
+		{
+			size_t ptr_size = va_arg(varg_list, size_t);
+
+			if (prepared->nvalues == allocated_values)
+			{
+				allocated_values = allocated_values ? 2 * allocated_values : 4;
+				_STARPU_REALLOC(prepared->value_sizes, allocated_values * sizeof(prepared->value_sizes[0]));
+				_STARPU_REALLOC(prepared->value_offsets, allocated_values * sizeof(prepared->value_offsets[0]));
+			}
+			prepared->value_sizes[prepared->nvalues] = ptr_size;
+			/* Same layout as starpu_codelet_pack_arg: the size, then the value */
+			prepared->value_offsets[prepared->nvalues] = prepared->arg_size + sizeof(ptr_size);
+			prepared->arg_size += sizeof(ptr_size) + ptr_size;
+			prepared->nvalues++;
+		}
+		else if (arg_type==STARPU_PRIORITY)
+		{
+			prepared->priority = va_arg(varg_list, int);
+		}
+		else if (arg_type==STARPU_NAME)
+		{
+			prepared->name = va_arg(varg_list, const char *);
+		}
+		else if (arg_type==STARPU_SCHED_CTX)
+		{
+			prepared->sched_ctx = va_arg(varg_list, unsigned);
+		}
+		else if (arg_type==STARPU_EXECUTE_WHERE)
+		{
+			prepared->where = va_arg(varg_list, unsigned long long);
+		}
+		else if (arg_type==STARPU_FLOPS)
+		{
+			prepared->flops = va_arg(varg_list, double);
+		}
+		else if (arg_type==STARPU_CALLBACK)
+		{
+			prepared->callback_func = va_arg(varg_list, _starpu_callback_func_t);
+		}
+		else if (arg_type==STARPU_CALLBACK_ARG_NFREE)
+		{
+			prepared->callback_arg = va_arg(varg_list, void *);
+		}
+		else
+		{
+			_STARPU_DISP("Argument %d is not supported by starpu_task_insert_prepare, did you perhaps forget to end arguments with 0?\n", arg_type);
+			return -EINVAL;
+		}
+	}
+
+	if (cl->nbuffers != STARPU_VARIABLE_NBUFFERS)
+	{
+		STARPU_ASSERT_MSG(prepared->nbuffers == cl->nbuffers, "Incoherent number of buffers between cl (%d) and number of parameters (%d)", cl->nbuffers, prepared->nbuffers);
+	}
+
+	if (prepared->nvalues)
+	{
+		int i;
+		_STARPU_MALLOC(prepared->arg_template, prepared->arg_size);
+		memcpy(prepared->arg_template, &prepared->nvalues, sizeof(prepared->nvalues));
+		for (i = 0; i < prepared->nvalues; i++)
+			memcpy(prepared->arg_template + prepared->value_offsets[i] - sizeof(size_t), &prepared->value_sizes[i], sizeof(size_t));
+	}
+	else
+		prepared->arg_size = 0;
+
+	return 0;
+}
+
+struct starpu_task *starpu_task_insert_prepared_build(struct starpu_task_insert_prepared *prepared, starpu_data_handle_t *handles, void **values)
+{
+	struct starpu_codelet *cl = prepared->cl;
+	struct starpu_task *task = starpu_task_create();
+	int i;
+
+	_STARPU_TRACE_TASK_BUILD_START();
+
+	task->cl = cl;
+	task->name = prepared->name;
+	task->priority = prepared->priority;
+	task->sched_ctx = prepared->sched_ctx;
+	task->where = prepared->where;
+	task->flops = prepared->flops;
+	task->callback_func = prepared->callback_func;
+	task->callback_arg = prepared->callback_arg;
+
+	if (prepared->nbuffers > STARPU_NMAXBUFS)
+	{
+		_STARPU_MALLOC(task->dyn_handles, prepared->nbuffers * sizeof(starpu_data_handle_t));
+		if (cl->nbuffers == STARPU_VARIABLE_NBUFFERS || !cl->dyn_modes)
+			_STARPU_MALLOC(task->dyn_modes, prepared->nbuffers * sizeof(enum starpu_data_access_mode));
+	}
+	for (i = 0; i < prepared->nbuffers; i++)
+	{
+		STARPU_TASK_SET_HANDLE(task, handles[i], i);
+		if (prepared->task_modes)
+			STARPU_TASK_SET_MODE(task, prepared->modes[i], i);
+	}
+	if (cl->nbuffers == STARPU_VARIABLE_NBUFFERS)
+		task->nbuffers = prepared->nbuffers;
+
+	if (prepared->nvalues)
+	{
+		char *arg_buffer;
+		_STARPU_MALLOC(arg_buffer, prepared->arg_size);
+		/* The headers are already there, only copy the values */
+		memcpy(arg_buffer, prepared->arg_template, prepared->arg_size);
+		for (i = 0; i < prepared->nvalues; i++)
+			memcpy(arg_buffer + prepared->value_offsets[i], values[i], prepared->value_sizes[i]);
+		task->cl_arg = arg_buffer;
+		task->cl_arg_size = prepared->arg_size;
+		task->cl_arg_free = 1;
+	}
+
+	_STARPU_TRACE_TASK_BUILD_END();
+	return task;
+}
+
+void starpu_task_insert_prepared_destroy(struct starpu_task_insert_prepared *prepared)
+{
+	if (!prepared)
+		return;
+	free(prepared->modes);
+	free(prepared->value_sizes);
+	free(prepared->value_offsets);
+	free(prepared->arg_template);
+	free(prepared);
+}
+
 int _fstarpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *task, void **arglist)
 {
 	int arg_i = 0;
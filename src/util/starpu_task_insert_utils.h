@@ -28,7 +28,40 @@
 typedef void (*_starpu_callback_func_t)(void *);
 typedef void (*_starpu_callback_soon_func_t)(void *, double delay);
 
+/** Argument signature parsed once by starpu_task_insert_prepare() */
+struct starpu_task_insert_prepared
+{
+	struct starpu_codelet *cl;
+
+	/** Number of data handles, and their access modes */
+	int nbuffers;
+	enum starpu_data_access_mode *modes;
+	/** Whether the modes have to be stored in the task, i.e. they are
+	 * not already available in the codelet */
+	unsigned task_modes;
+
+	/** Number of STARPU_VALUE, with their sizes and offsets in cl_arg */
+	int nvalues;
+	size_t *value_sizes;
+	size_t *value_offsets;
+
+	/** Pre-filled cl_arg, with the number of arguments and the size
+	 * headers already in place, only the values remain to be copied */
+	char *arg_template;
+	size_t arg_size;
+
+	/** Fields shared by all the tasks */
+	const char *name;
+	int priority;
+	unsigned sched_ctx;
+	unsigned long long where;
+	double flops;
+	_starpu_callback_func_t callback_func;
+	void *callback_arg;
+};
+
 int _starpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *task, va_list varg_list) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
+int _starpu_task_insert_prepare_create(struct starpu_codelet *cl, struct starpu_task_insert_prepared *prepared, va_list varg_list);
 int _fstarpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *task, void **arglist) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 
 #pragma GCC visibility pop
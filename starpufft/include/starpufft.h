@@ -44,6 +44,9 @@
 	starpufft(plan) starpufft(plan_dft_3d)(int n, int m, int p, int sign, unsigned flags);                             \
 	starpufft(plan) starpufft(plan_dft_r2c_1d)(int n, unsigned flags);                                                 \
 	starpufft(plan) starpufft(plan_dft_c2r_1d)(int n, unsigned flags);                                                 \
+	starpufft(plan) starpufft(plan_many_dft_1d)(int n, int howmany, int batch, int sign, unsigned flags);              \
+	starpufft(plan) starpufft(plan_many_dft_r2c_1d)(int n, int howmany, int batch, unsigned flags);                    \
+	starpufft(plan) starpufft(plan_many_dft_c2r_1d)(int n, int howmany, int batch, unsigned flags);                    \
                                                                                                                            \
 	void *starpufft(malloc)(size_t n);                                                                                 \
 	void starpufft(free)(void *p, size_t dim);                                                                         \
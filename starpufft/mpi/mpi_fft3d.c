@@ -0,0 +1,596 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Distributed 3D FFT of a nx * ny * nz complex grid, with a pencil
+ * decomposition over a pr * pc grid of MPI ranks.
+ *
+ * Rank (a,b) successively owns:
+ * - an X pencil: all x, y in the a-th ny/pr range, z in the b-th nz/pc range,
+ *   stored as [z][y][x]
+ * - a Y pencil: all y, x in the a-th nx/pr range, z in the b-th nz/pc range,
+ *   stored as [z][x][y]
+ * - a Z pencil: all z, x in the a-th nx/pr range, y in the b-th ny/pc range,
+ *   stored as [y][x][z]
+ *
+ * The 1D FFT stages are performed with batched starpufft plans on the pencils.
+ * The X->Y transpose is an all-to-all between the ranks with the same b, and
+ * the Y->Z transpose an all-to-all between the ranks with the same a. Both are
+ * expressed as pack tasks on the sending rank and unpack tasks on the
+ * receiving rank, submitted with starpu_mpi_task_insert(), so that StarPU-MPI
+ * transfers the packed chunks. The X and Y pencils are cut into nslabs slabs
+ * along z, which is not involved in the first transpose, so that the transfers
+ * of a slab overlap with the FFTs of the other slabs.
+ *
+ * The result is compared with a naive approach: gather the whole grid on rank
+ * 0, perform one starpufft 3D FFT there, and scatter the result back into Z
+ * pencils. Running the example with an increasing number of ranks for the same
+ * grid size gives the strong scaling of both approaches.
+ *
+ * Usage: mpi_fft3d [-nx nx] [-ny ny] [-nz nz] [-pr pr] [-nslabs nslabs] [-niter niter]
+ */
+
+#include <complex.h>
+#include <math.h>
+#include <starpu_mpi.h>
+#include "starpufft.h"
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+#define SIGN STARPUFFT_FORWARD
+
+static int nx = 32, ny = 32, nz = 32;
+static int pr, pc;
+static int nslabs = 2;
+static int niter = 2;
+
+/* Sizes of the pencil pieces */
+static int nxa, nya, nyb, nzb, nzs;
+
+#define RANK(a, b) ((a) * pc + (b))
+#define SLAB(a, b, k) (((a) * pc + (b)) * nslabs + (k))
+
+/* X pencil slabs, before and after the FFT along x */
+static starpu_data_handle_t *xin, *xout;
+/* Chunks sent from the X pencil slabs to the Y pencils */
+static starpu_data_handle_t *chunk1;
+/* Y pencil slabs, before and after the FFT along y */
+static starpu_data_handle_t *ypre, *ypost;
+/* Chunks sent from the Y pencil slabs to the Z pencils */
+static starpu_data_handle_t *chunk2;
+/* Z pencils, before and after the FFT along z */
+static starpu_data_handle_t *zpre, *zout;
+
+/* Naive version: the whole grid on rank 0 and the scattered result */
+static starpu_data_handle_t global, gout;
+static starpu_data_handle_t *zref;
+
+static starpu_mpi_tag_t tag;
+
+static void parse_args(int argc, char **argv)
+{
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-nx") == 0)
+			nx = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-ny") == 0)
+			ny = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-nz") == 0)
+			nz = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-pr") == 0)
+			pr = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-nslabs") == 0)
+			nslabs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-niter") == 0)
+			niter = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: %s [-nx nx] [-ny ny] [-nz nz] [-pr pr] [-nslabs nslabs] [-niter niter]\n", argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/* Deterministic input value of grid point (x,y,z) */
+static starpufft_complex input_value(int x, int y, int z)
+{
+	return ((x*7 + y*13 + z*29) % 17) / 17. + I * (((x*3 + y*5 + z*11) % 23) / 23.);
+}
+
+/* Register a vector of n complex numbers owned by rank owner, allocated only
+ * there */
+static void register_piece(starpu_data_handle_t *handle, int owner, int rank, size_t n)
+{
+	if (owner == rank)
+	{
+		starpufft_complex *ptr;
+		starpu_malloc((void **)&ptr, n * sizeof(*ptr));
+		starpu_vector_data_register(handle, STARPU_MAIN_RAM, (uintptr_t) ptr, n, sizeof(*ptr));
+	}
+	else
+		starpu_vector_data_register(handle, -1, (uintptr_t) NULL, n, sizeof(starpufft_complex));
+	starpu_mpi_data_register(*handle, tag++, owner);
+}
+
+static void unregister_piece(starpu_data_handle_t handle, int owner, int rank)
+{
+	void *ptr = owner == rank ? (void *) starpu_vector_get_local_ptr(handle) : NULL;
+	size_t n = starpu_vector_get_nx(handle);
+	starpu_data_unregister(handle);
+	if (ptr)
+		starpu_free_noflag(ptr, n * sizeof(starpufft_complex));
+}
+
+/*
+ * Transpose kernels
+ */
+
+/* X pencil slab [z][y][x] -> chunk [z][y][x in the a2-th range] */
+static void pack1_cpu(void *descr[], void *arg)
+{
+	starpufft_complex *xslab = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[0]);
+	starpufft_complex *chunk = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[1]);
+	int a2, z, y;
+
+	starpu_codelet_unpack_args(arg, &a2);
+	for (z = 0; z < nzs; z++)
+		for (y = 0; y < nya; y++)
+			memcpy(&chunk[(z*nya + y)*nxa], &xslab[(z*nya + y)*nx + a2*nxa], nxa * sizeof(*chunk));
+}
+
+/* chunk [z][y in the a-th range][x] -> Y pencil slab [z][x][y] */
+static void unpack1_cpu(void *descr[], void *arg)
+{
+	starpufft_complex *chunk = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[0]);
+	starpufft_complex *yslab = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[1]);
+	int a, z, y, x;
+
+	starpu_codelet_unpack_args(arg, &a);
+	for (z = 0; z < nzs; z++)
+		for (x = 0; x < nxa; x++)
+			for (y = 0; y < nya; y++)
+				yslab[(z*nxa + x)*ny + a*nya + y] = chunk[(z*nya + y)*nxa + x];
+}
+
+/* Y pencil slab [z][x][y] -> chunk [z][x][y in the b2-th range] */
+static void pack2_cpu(void *descr[], void *arg)
+{
+	starpufft_complex *yslab = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[0]);
+	starpufft_complex *chunk = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[1]);
+	int b2, z, x;
+
+	starpu_codelet_unpack_args(arg, &b2);
+	for (z = 0; z < nzs; z++)
+		for (x = 0; x < nxa; x++)
+			memcpy(&chunk[(z*nxa + x)*nyb], &yslab[(z*nxa + x)*ny + b2*nyb], nyb * sizeof(*chunk));
+}
+
+/* chunk [z in the k-th slab of the b-th range][x][y] -> Z pencil [y][x][z] */
+static void unpack2_cpu(void *descr[], void *arg)
+{
+	starpufft_complex *chunk = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[0]);
+	starpufft_complex *zpencil = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[1]);
+	int b, k, z, x, y;
+
+	starpu_codelet_unpack_args(arg, &b, &k);
+	for (y = 0; y < nyb; y++)
+		for (x = 0; x < nxa; x++)
+			for (z = 0; z < nzs; z++)
+				zpencil[(y*nxa + x)*nz + b*nzb + k*nzs + z] = chunk[(z*nxa + x)*nyb + y];
+}
+
+static struct starpu_codelet pack1_cl =
+{
+	.cpu_funcs = {pack1_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_W},
+	.name = "fft3d_pack1"
+};
+
+static struct starpu_codelet unpack1_cl =
+{
+	.cpu_funcs = {unpack1_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_RW | STARPU_COMMUTE},
+	.name = "fft3d_unpack1"
+};
+
+static struct starpu_codelet pack2_cl =
+{
+	.cpu_funcs = {pack2_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_W},
+	.name = "fft3d_pack2"
+};
+
+static struct starpu_codelet unpack2_cl =
+{
+	.cpu_funcs = {unpack2_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_RW | STARPU_COMMUTE},
+	.name = "fft3d_unpack2"
+};
+
+/*
+ * Naive version kernels
+ */
+
+/* X pencil slab of rank (a,b) -> whole grid [z][y][x] */
+static void gather_cpu(void *descr[], void *arg)
+{
+	starpufft_complex *xslab = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[0]);
+	starpufft_complex *grid = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[1]);
+	int a, b, k, z, y;
+
+	starpu_codelet_unpack_args(arg, &a, &b, &k);
+	for (z = 0; z < nzs; z++)
+		for (y = 0; y < nya; y++)
+			memcpy(&grid[((b*nzb + k*nzs + z)*ny + a*nya + y)*nx], &xslab[(z*nya + y)*nx], nx * sizeof(*grid));
+}
+
+/* whole grid [z][y][x] -> Z pencil of rank (a,b) */
+static void scatter_cpu(void *descr[], void *arg)
+{
+	starpufft_complex *grid = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[0]);
+	starpufft_complex *zpencil = (starpufft_complex *) STARPU_VECTOR_GET_PTR(descr[1]);
+	int a, b, z, y, x;
+
+	starpu_codelet_unpack_args(arg, &a, &b);
+	for (y = 0; y < nyb; y++)
+		for (x = 0; x < nxa; x++)
+			for (z = 0; z < nz; z++)
+				zpencil[(y*nxa + x)*nz + z] = grid[(z*ny + b*nyb + y)*nx + a*nxa + x];
+}
+
+static struct starpu_codelet gather_cl =
+{
+	.cpu_funcs = {gather_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_RW | STARPU_COMMUTE},
+	.name = "fft3d_gather"
+};
+
+static struct starpu_codelet scatter_cl =
+{
+	.cpu_funcs = {scatter_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_W},
+	.name = "fft3d_scatter"
+};
+
+/* Wait for the starpufft tasks, which are not detached */
+static void wait_tasks(struct starpu_task **tasks, int *ntasks)
+{
+	int i, ret;
+	for (i = 0; i < *ntasks; i++)
+	{
+		ret = starpu_task_wait(tasks[i]);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait");
+	}
+	*ntasks = 0;
+}
+
+static void submit(struct starpu_task *task, struct starpu_task **tasks, int *ntasks)
+{
+	STARPU_ASSERT(task);
+	tasks[(*ntasks)++] = task;
+}
+
+static void pencil_fft(int rank, starpufft_plan plan_x, starpufft_plan plan_y, starpufft_plan plan_z, struct starpu_task **tasks, int *ntasks)
+{
+	int a, b, k, a2, b2, ret;
+
+	for (k = 0; k < nslabs; k++)
+	{
+		/* FFT along x */
+		for (a = 0; a < pr; a++)
+			for (b = 0; b < pc; b++)
+				if (RANK(a, b) == rank)
+					submit(starpufft_start_handle(plan_x, xin[SLAB(a, b, k)], xout[SLAB(a, b, k)]), tasks, ntasks);
+
+		/* X -> Y transpose between the ranks with the same b */
+		for (a = 0; a < pr; a++)
+			for (b = 0; b < pc; b++)
+				for (a2 = 0; a2 < pr; a2++)
+				{
+					starpu_data_handle_t chunk = chunk1[SLAB(a, b, k) * pr + a2];
+					ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &pack1_cl,
+								     STARPU_R, xout[SLAB(a, b, k)],
+								     STARPU_W, chunk,
+								     STARPU_VALUE, &a2, sizeof(a2),
+								     0);
+					STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+					ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &unpack1_cl,
+								     STARPU_R, chunk,
+								     STARPU_RW | STARPU_COMMUTE, ypre[SLAB(a2, b, k)],
+								     STARPU_VALUE, &a, sizeof(a),
+								     0);
+					STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+				}
+
+		/* FFT along y */
+		for (a = 0; a < pr; a++)
+			for (b = 0; b < pc; b++)
+				if (RANK(a, b) == rank)
+					submit(starpufft_start_handle(plan_y, ypre[SLAB(a, b, k)], ypost[SLAB(a, b, k)]), tasks, ntasks);
+
+		/* Y -> Z transpose between the ranks with the same a */
+		for (a = 0; a < pr; a++)
+			for (b = 0; b < pc; b++)
+				for (b2 = 0; b2 < pc; b2++)
+				{
+					starpu_data_handle_t chunk = chunk2[SLAB(a, b, k) * pc + b2];
+					ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &pack2_cl,
+								     STARPU_R, ypost[SLAB(a, b, k)],
+								     STARPU_W, chunk,
+								     STARPU_VALUE, &b2, sizeof(b2),
+								     0);
+					STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+					ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &unpack2_cl,
+								     STARPU_R, chunk,
+								     STARPU_RW | STARPU_COMMUTE, zpre[RANK(a, b2)],
+								     STARPU_VALUE, &b, sizeof(b),
+								     STARPU_VALUE, &k, sizeof(k),
+								     0);
+					STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+				}
+	}
+
+	/* FFT along z */
+	for (a = 0; a < pr; a++)
+		for (b = 0; b < pc; b++)
+			if (RANK(a, b) == rank)
+				submit(starpufft_start_handle(plan_z, zpre[RANK(a, b)], zout[RANK(a, b)]), tasks, ntasks);
+}
+
+static void naive_fft(int rank, starpufft_plan plan_3d, struct starpu_task **tasks, int *ntasks)
+{
+	int a, b, k, ret;
+
+	for (a = 0; a < pr; a++)
+		for (b = 0; b < pc; b++)
+			for (k = 0; k < nslabs; k++)
+			{
+				ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &gather_cl,
+							     STARPU_R, xin[SLAB(a, b, k)],
+							     STARPU_RW | STARPU_COMMUTE, global,
+							     STARPU_VALUE, &a, sizeof(a),
+							     STARPU_VALUE, &b, sizeof(b),
+							     STARPU_VALUE, &k, sizeof(k),
+							     0);
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+			}
+
+	if (rank == 0)
+		submit(starpufft_start_handle(plan_3d, global, gout), tasks, ntasks);
+
+	for (a = 0; a < pr; a++)
+		for (b = 0; b < pc; b++)
+		{
+			ret = starpu_mpi_task_insert(MPI_COMM_WORLD, &scatter_cl,
+						     STARPU_R, gout,
+						     STARPU_W, zref[RANK(a, b)],
+						     STARPU_EXECUTE_ON_NODE, 0,
+						     STARPU_VALUE, &a, sizeof(a),
+						     STARPU_VALUE, &b, sizeof(b),
+						     0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_task_insert");
+		}
+}
+
+int main(int argc, char **argv)
+{
+	int rank, size, ret;
+	int a, b, k, i, iter, x, y, z;
+	int nslabs_total, ntasks = 0;
+	struct starpu_task **tasks;
+	starpufft_plan plan_x, plan_y, plan_z, plan_3d;
+	double start, pencil_timing = 0., naive_timing = 0.;
+	double maxdiff = 0., maxref = 0.;
+
+	parse_args(argc, argv);
+
+	ret = starpu_mpi_init_conf(&argc, &argv, 1, MPI_COMM_WORLD, NULL);
+	if (ret == -ENODEV) return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		FPRINTF(stderr, "We need at least 1 CPU worker.\n");
+		starpu_mpi_shutdown();
+		return rank == 0 ? 77 : 0;
+	}
+
+	/* Process grid as square as possible */
+	if (pr <= 0)
+		for (pr = 1; (pr+1) * (pr+1) <= size; pr++)
+			;
+	while (size % pr)
+		pr--;
+	pc = size / pr;
+
+	if (nx % pr || ny % pr || ny % pc || nz % (pc * nslabs))
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "%dx%dx%d grid can not be distributed on %dx%d ranks with %d slabs\n", nx, ny, nz, pr, pc, nslabs);
+		starpu_mpi_shutdown();
+		return rank == 0 ? 77 : 0;
+	}
+
+	nxa = nx / pr;
+	nya = ny / pr;
+	nyb = ny / pc;
+	nzb = nz / pc;
+	nzs = nzb / nslabs;
+
+	/* Register the pieces on all ranks, allocated only on their owner */
+	nslabs_total = pr * pc * nslabs;
+	xin = malloc(nslabs_total * sizeof(*xin));
+	xout = malloc(nslabs_total * sizeof(*xout));
+	chunk1 = malloc(nslabs_total * pr * sizeof(*chunk1));
+	ypre = malloc(nslabs_total * sizeof(*ypre));
+	ypost = malloc(nslabs_total * sizeof(*ypost));
+	chunk2 = malloc(nslabs_total * pc * sizeof(*chunk2));
+	zpre = malloc(size * sizeof(*zpre));
+	zout = malloc(size * sizeof(*zout));
+	zref = malloc(size * sizeof(*zref));
+
+	for (a = 0; a < pr; a++)
+		for (b = 0; b < pc; b++)
+		{
+			int owner = RANK(a, b);
+			for (k = 0; k < nslabs; k++)
+			{
+				int s = SLAB(a, b, k);
+				register_piece(&xin[s], owner, rank, nzs * nya * nx);
+				register_piece(&xout[s], owner, rank, nzs * nya * nx);
+				for (i = 0; i < pr; i++)
+					register_piece(&chunk1[s * pr + i], owner, rank, nzs * nya * nxa);
+				register_piece(&ypre[s], owner, rank, nzs * nxa * ny);
+				register_piece(&ypost[s], owner, rank, nzs * nxa * ny);
+				for (i = 0; i < pc; i++)
+					register_piece(&chunk2[s * pc + i], owner, rank, nzs * nxa * nyb);
+
+				if (owner == rank)
+				{
+					starpufft_complex *ptr = (starpufft_complex *) starpu_vector_get_local_ptr(xin[s]);
+					for (z = 0; z < nzs; z++)
+						for (y = 0; y < nya; y++)
+							for (x = 0; x < nx; x++)
+								ptr[(z*nya + y)*nx + x] = input_value(x, a*nya + y, b*nzb + k*nzs + z);
+				}
+			}
+			register_piece(&zpre[owner], owner, rank, nyb * nxa * nz);
+			register_piece(&zout[owner], owner, rank, nyb * nxa * nz);
+			register_piece(&zref[owner], owner, rank, nyb * nxa * nz);
+		}
+	register_piece(&global, 0, rank, nx * ny * nz);
+	register_piece(&gout, 0, rank, nx * ny * nz);
+
+	/* The 1D stages are batches of transforms on the pencils */
+	plan_x = starpufft_plan_many_dft_1d(nx, nzs * nya, 0, SIGN, 0);
+	plan_y = starpufft_plan_many_dft_1d(ny, nzs * nxa, 0, SIGN, 0);
+	plan_z = starpufft_plan_many_dft_1d(nz, nyb * nxa, 0, SIGN, 0);
+	plan_3d = starpufft_plan_dft_3d(nz, ny, nx, SIGN, 0);
+
+	tasks = malloc((2 * nslabs + 2) * sizeof(*tasks));
+
+	for (iter = 0; iter < niter; iter++)
+	{
+		starpu_mpi_barrier(MPI_COMM_WORLD);
+		start = starpu_timing_now();
+		pencil_fft(rank, plan_x, plan_y, plan_z, tasks, &ntasks);
+		wait_tasks(tasks, &ntasks);
+		starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+		starpu_mpi_barrier(MPI_COMM_WORLD);
+		pencil_timing = starpu_timing_now() - start;
+
+		start = starpu_timing_now();
+		naive_fft(rank, plan_3d, tasks, &ntasks);
+		wait_tasks(tasks, &ntasks);
+		starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+		starpu_mpi_barrier(MPI_COMM_WORLD);
+		naive_timing = starpu_timing_now() - start;
+
+		/* Do not let the next iteration reuse the input slabs cached on rank 0 */
+		starpu_mpi_cache_flush_all_data(MPI_COMM_WORLD);
+	}
+
+	/* Check the Z pencils against the naive version */
+	for (i = 0; i < size; i++)
+		if (i == rank)
+		{
+			starpufft_complex *res, *ref;
+			int n = nyb * nxa * nz;
+
+			starpu_data_acquire(zout[i], STARPU_R);
+			starpu_data_acquire(zref[i], STARPU_R);
+			res = (starpufft_complex *) starpu_vector_get_local_ptr(zout[i]);
+			ref = (starpufft_complex *) starpu_vector_get_local_ptr(zref[i]);
+			for (k = 0; k < n; k++)
+			{
+				double diff = cabs(res[k] - ref[k]);
+				if (diff > maxdiff)
+					maxdiff = diff;
+				if (cabs(ref[k]) > maxref)
+					maxref = cabs(ref[k]);
+			}
+			starpu_data_release(zout[i]);
+			starpu_data_release(zref[i]);
+		}
+	MPI_Allreduce(MPI_IN_PLACE, &maxdiff, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+	MPI_Allreduce(MPI_IN_PLACE, &maxref, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+	if (rank == 0)
+	{
+		FPRINTF(stdout, "%dx%dx%d grid on %dx%d ranks, %d slabs\n", nx, ny, nz, pr, pc, nslabs);
+		FPRINTF(stdout, "pencil FFT took %2.2f ms\n", pencil_timing / 1000.);
+		FPRINTF(stdout, "gather-FFT-scatter took %2.2f ms\n", naive_timing / 1000.);
+		FPRINTF(stdout, "relative maximum difference %g\n", maxdiff / maxref);
+	}
+
+	starpufft_destroy_plan(plan_x);
+	starpufft_destroy_plan(plan_y);
+	starpufft_destroy_plan(plan_z);
+	starpufft_destroy_plan(plan_3d);
+	free(tasks);
+
+	for (a = 0; a < pr; a++)
+		for (b = 0; b < pc; b++)
+		{
+			int owner = RANK(a, b);
+			for (k = 0; k < nslabs; k++)
+			{
+				int s = SLAB(a, b, k);
+				unregister_piece(xin[s], owner, rank);
+				unregister_piece(xout[s], owner, rank);
+				for (i = 0; i < pr; i++)
+					unregister_piece(chunk1[s * pr + i], owner, rank);
+				unregister_piece(ypre[s], owner, rank);
+				unregister_piece(ypost[s], owner, rank);
+				for (i = 0; i < pc; i++)
+					unregister_piece(chunk2[s * pc + i], owner, rank);
+			}
+			unregister_piece(zpre[owner], owner, rank);
+			unregister_piece(zout[owner], owner, rank);
+			unregister_piece(zref[owner], owner, rank);
+		}
+	unregister_piece(global, 0, rank);
+	unregister_piece(gout, 0, rank);
+
+	free(xin);
+	free(xout);
+	free(chunk1);
+	free(ypre);
+	free(ypost);
+	free(chunk2);
+	free(zpre);
+	free(zout);
+	free(zref);
+
+	starpu_mpi_shutdown();
+
+	if (maxdiff > 1e-10 * maxref)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "Failure: Difference too big\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -105,6 +105,8 @@ struct STARPUFFT(plan)
 		_fftw_plan plan1_cpu, plan2_cpu;
 		/* Sequential version */
 		_fftw_plan plan_cpu;
+		/* Batched version: full batches, and the last partial batch */
+		_fftw_plan plan_batch_cpu, plan_tail_cpu;
 #endif
 	} plans[STARPU_NMAXWORKERS];
 
@@ -121,6 +123,16 @@ struct STARPUFFT(plan)
 
 	/* Arguments for tasks */
 	struct STARPUFFT(args) *fft1_args, *fft2_args;
+
+	/* Batched version: howmany independent transforms, batch of them per task */
+	int howmany;
+	int batch;
+	int nbatches;
+	int in_len, out_len;	/* Number of elements of each transform */
+	size_t in_elemsize, out_elemsize;
+	uint32_t *in_lengths, *out_lengths;	/* Number of elements of each batch */
+	struct starpu_data_filter in_filter, out_filter;
+	starpu_data_handle_t *batch_in_handle, *batch_out_handle;
 };
 
 struct STARPUFFT(args)
@@ -199,6 +211,7 @@ static int can_execute(unsigned workerid, struct starpu_task *task STARPU_ATTRIB
 #include "starpufftx1d.c"
 #include "starpufftx2d.c"
 #include "starpufftx3d.c"
+#include "starpufftxmany.c"
 
 struct starpu_task *
 STARPUFFT(start)(STARPUFFT(plan) plan, void *_in, void *_out)
@@ -213,6 +226,13 @@ STARPUFFT(start)(STARPUFFT(plan) plan, void *_in, void *_out)
 	{
 		case 1:
 		{
+			if (plan->howmany)
+			{
+				starpu_vector_data_register(&plan->in_handle, STARPU_MAIN_RAM, (uintptr_t) plan->in, plan->howmany * plan->in_len, plan->in_elemsize);
+				starpu_vector_data_register(&plan->out_handle, STARPU_MAIN_RAM, (uintptr_t) plan->out, plan->howmany * plan->out_len, plan->out_elemsize);
+				task = STARPUFFT(start1dmany)(plan, plan->in_handle, plan->out_handle);
+				break;
+			}
 			switch (plan->type)
 			{
 			case C2C:
@@ -276,7 +296,17 @@ STARPUFFT(cleanup)(STARPUFFT(plan) plan)
 struct starpu_task *
 STARPUFFT(start_handle)(STARPUFFT(plan) plan, starpu_data_handle_t in, starpu_data_handle_t out)
 {
-	return STARPUFFT(start1dC2C)(plan, in, out);
+	if (plan->howmany)
+		return STARPUFFT(start1dmany)(plan, in, out);
+	switch (plan->dim)
+	{
+		case 2:
+			return STARPUFFT(start2dC2C)(plan, in, out);
+		case 3:
+			return STARPUFFT(start3dC2C)(plan, in, out);
+		default:
+			return STARPUFFT(start1dC2C)(plan, in, out);
+	}
 }
 
 int
@@ -328,7 +358,13 @@ STARPUFFT(destroy_plan)(STARPUFFT(plan) plan)
 		{
 		case STARPU_CPU_WORKER:
 #ifdef STARPU_HAVE_FFTW
-			if (PARALLEL)
+			if (plan->howmany)
+			{
+				_FFTW(destroy_plan)(plan->plans[workerid].plan_batch_cpu);
+				if (plan->plans[workerid].plan_tail_cpu)
+					_FFTW(destroy_plan)(plan->plans[workerid].plan_tail_cpu);
+			}
+			else if (PARALLEL)
 			{
 				_FFTW(destroy_plan)(plan->plans[workerid].plan1_cpu);
 				_FFTW(destroy_plan)(plan->plans[workerid].plan2_cpu);
@@ -350,7 +386,7 @@ STARPUFFT(destroy_plan)(STARPUFFT(plan) plan)
 		}
 	}
 
-	if (PARALLEL)
+	if (PARALLEL && !plan->howmany)
 	{
 		for (i = 0; i < plan->totsize1; i++)
 		{
@@ -412,6 +448,8 @@ STARPUFFT(destroy_plan)(STARPUFFT(plan) plan)
 		STARPUFFT(free)(plan->twisted2, plan->twisted2_size);
 		STARPUFFT(free)(plan->fft2, plan->fft2_size);
 	}
+	if (plan->howmany)
+		STARPUFFT(free_many)(plan);
 	free(plan->n);
 	free(plan);
 }
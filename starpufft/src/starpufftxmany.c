@@ -0,0 +1,343 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ *
+ * Batched version
+ *
+ */
+
+/*
+ * Overall strategy for howmany independent ffts of size n:
+ *
+ * - the transforms are stored contiguously in the input and output buffers,
+ *   n complex (C2C), n real (R2C input) or n/2+1 complex (R2C output, C2R
+ *   input) elements each.
+ * - they are grouped by batches of batch transforms, each batch being
+ *   processed by one task with a single fftw plan_many call, so that the
+ *   task overhead is amortised over the whole batch.
+ * - the input and output vectors are partitioned asynchronously on batch
+ *   boundaries at each execution, and an empty end task gathers the
+ *   completion of all batches.
+ */
+
+/* Number of batches per CPU worker when the batch size is not specified */
+#define MANY_BATCHES_PER_WORKER 4
+
+/* Largest SIMD alignment that fftw plans may rely on */
+#define MANY_ALIGNMENT 64
+
+#ifdef STARPU_HAVE_FFTW
+/* Perform a batch of ffts of size n */
+static void
+STARPUFFT(fft_many_1d_kernel_cpu)(void *descr[], void *_args)
+{
+	STARPUFFT(plan) plan = _args;
+	int workerid = starpu_worker_get_id_check();
+	void *in = (void *)STARPU_VECTOR_GET_PTR(descr[0]);
+	void *out = (void *)STARPU_VECTOR_GET_PTR(descr[1]);
+	int howmany = STARPU_VECTOR_GET_NX(descr[0]) / plan->in_len;
+	_fftw_plan fftw_plan;
+
+	STARPU_ASSERT(howmany == plan->batch || howmany == plan->howmany % plan->batch);
+	fftw_plan = howmany == plan->batch ? plan->plans[workerid].plan_batch_cpu : plan->plans[workerid].plan_tail_cpu;
+
+	task_per_worker[workerid]++;
+	samples_per_worker[workerid] += howmany * plan->n[0];
+
+	switch (plan->type)
+	{
+	case C2C:
+		_FFTW(execute_dft)(fftw_plan, in, out);
+		break;
+	case R2C:
+		_FFTW(execute_dft_r2c)(fftw_plan, in, out);
+		break;
+	case C2R:
+		_FFTW(execute_dft_c2r)(fftw_plan, in, out);
+		break;
+	}
+}
+#endif
+
+static struct starpu_perfmodel STARPUFFT(fft_many_1d_model) = {
+	.type = STARPU_HISTORY_BASED,
+	.symbol = TYPE"fft_many_1d"
+};
+
+static struct starpu_codelet STARPUFFT(fft_many_1d_codelet) = {
+	.where =
+#ifdef STARPU_HAVE_FFTW
+		STARPU_CPU|
+#endif
+		0,
+#ifdef STARPU_HAVE_FFTW
+	.cpu_funcs = {STARPUFFT(fft_many_1d_kernel_cpu)},
+#endif
+	CAN_EXECUTE
+	.model = &STARPUFFT(fft_many_1d_model),
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_W},
+	.name = "fft_many_1d_codelet"
+};
+
+#ifdef STARPU_HAVE_FFTW
+/* Plan howmany ffts of the plan type. FFTW imposes that buffer pointers are
+ * known at planning time: the input is planned aligned and the output
+ * unaligned, as in the other versions. The input batches are however only as
+ * aligned as their offset in the application buffer. */
+static _fftw_plan
+STARPUFFT(plan_many_cpu)(STARPUFFT(plan) plan, int howmany)
+{
+	unsigned flags = _FFTW_FLAGS;
+	_fftw_plan fftw_plan = NULL;
+
+	if ((plan->batch * plan->in_len * plan->in_elemsize) % MANY_ALIGNMENT)
+		flags |= FFTW_UNALIGNED;
+
+	switch (plan->type)
+	{
+	case C2C:
+		fftw_plan = _FFTW(plan_many_dft)(1, plan->n, howmany,
+				NULL, NULL, 1, plan->in_len,
+				(void*) 1, NULL, 1, plan->out_len,
+				plan->sign, flags);
+		break;
+	case R2C:
+		fftw_plan = _FFTW(plan_many_dft_r2c)(1, plan->n, howmany,
+				NULL, NULL, 1, plan->in_len,
+				(void*) 1, NULL, 1, plan->out_len,
+				flags);
+		break;
+	case C2R:
+		/* The input is accessed in R mode, it must not be overwritten */
+		fftw_plan = _FFTW(plan_many_dft_c2r)(1, plan->n, howmany,
+				NULL, NULL, 1, plan->in_len,
+				(void*) 1, NULL, 1, plan->out_len,
+				flags | FFTW_PRESERVE_INPUT);
+		break;
+	}
+	STARPU_ASSERT(fftw_plan);
+	return fftw_plan;
+}
+#endif
+
+static STARPUFFT(plan)
+STARPUFFT(plan_many_1d)(int n, int howmany, int batch, enum type type, int sign, unsigned flags)
+{
+	unsigned workerid;
+	int i;
+
+	/* TODO: flags? Automatically set FFTW_MEASURE on calibration? */
+	STARPU_ASSERT(flags == 0);
+	STARPU_ASSERT(n > 0 && howmany > 0);
+
+	if (batch <= 0)
+	{
+		unsigned ncpus = starpu_cpu_worker_get_count();
+		int nbatches = MANY_BATCHES_PER_WORKER * (ncpus ? ncpus : 1);
+		batch = (howmany + nbatches - 1) / nbatches;
+	}
+	if (batch > howmany)
+		batch = howmany;
+
+	STARPUFFT(plan) plan = malloc(sizeof(*plan));
+	memset(plan, 0, sizeof(*plan));
+
+	/* Just one dimension */
+	plan->dim = 1;
+	plan->n = malloc(plan->dim * sizeof(*plan->n));
+	plan->n[0] = n;
+
+	plan->type = type;
+	plan->sign = sign;
+
+	plan->howmany = howmany;
+	plan->batch = batch;
+	plan->nbatches = (howmany + batch - 1) / batch;
+
+	switch (type)
+	{
+	case C2C:
+		plan->in_len = n;
+		plan->out_len = n;
+		plan->in_elemsize = sizeof(STARPUFFT(complex));
+		plan->out_elemsize = sizeof(STARPUFFT(complex));
+		break;
+	case R2C:
+		plan->in_len = n;
+		plan->out_len = n/2 + 1;
+		plan->in_elemsize = sizeof(real);
+		plan->out_elemsize = sizeof(STARPUFFT(complex));
+		break;
+	case C2R:
+		plan->in_len = n/2 + 1;
+		plan->out_len = n;
+		plan->in_elemsize = sizeof(STARPUFFT(complex));
+		plan->out_elemsize = sizeof(real);
+		break;
+	}
+
+	/* Note: this is for coherency with the other cases */
+	plan->totsize = howmany * n;
+
+	/* Initialize per-worker working set */
+	for (workerid = 0; workerid < starpu_worker_get_count(); workerid++)
+	{
+		switch (starpu_worker_get_type(workerid))
+		{
+		case STARPU_CPU_WORKER:
+#ifdef STARPU_HAVE_FFTW
+			plan->plans[workerid].plan_batch_cpu = STARPUFFT(plan_many_cpu)(plan, batch);
+			if (howmany % batch)
+				plan->plans[workerid].plan_tail_cpu = STARPUFFT(plan_many_cpu)(plan, howmany % batch);
+#else
+/* #warning libstarpufft can not work correctly if libfftw3 is not installed */
+#endif
+			break;
+		default:
+			/* Do not care, we won't be executing anything there. */
+			break;
+		}
+	}
+
+	/* Prepare the partitioning of the input and output vectors on batch
+	 * boundaries */
+	plan->in_lengths = malloc(plan->nbatches * sizeof(*plan->in_lengths));
+	plan->out_lengths = malloc(plan->nbatches * sizeof(*plan->out_lengths));
+	for (i = 0; i < plan->nbatches; i++)
+	{
+		int nffts = STARPU_MIN(batch, howmany - i * batch);
+		plan->in_lengths[i] = nffts * plan->in_len;
+		plan->out_lengths[i] = nffts * plan->out_len;
+	}
+
+	plan->in_filter.filter_func = starpu_vector_filter_list;
+	plan->in_filter.nchildren = plan->nbatches;
+	plan->in_filter.filter_arg_ptr = plan->in_lengths;
+	plan->out_filter.filter_func = starpu_vector_filter_list;
+	plan->out_filter.nchildren = plan->nbatches;
+	plan->out_filter.filter_arg_ptr = plan->out_lengths;
+
+	plan->batch_in_handle = malloc(plan->nbatches * sizeof(*plan->batch_in_handle));
+	plan->batch_out_handle = malloc(plan->nbatches * sizeof(*plan->batch_out_handle));
+
+	return plan;
+}
+
+STARPUFFT(plan)
+STARPUFFT(plan_many_dft_1d)(int n, int howmany, int batch, int sign, unsigned flags)
+{
+	return STARPUFFT(plan_many_1d)(n, howmany, batch, C2C, sign, flags);
+}
+
+STARPUFFT(plan)
+STARPUFFT(plan_many_dft_r2c_1d)(int n, int howmany, int batch, unsigned flags)
+{
+	return STARPUFFT(plan_many_1d)(n, howmany, batch, R2C, STARPUFFT_FORWARD, flags);
+}
+
+STARPUFFT(plan)
+STARPUFFT(plan_many_dft_c2r_1d)(int n, int howmany, int batch, unsigned flags)
+{
+	return STARPUFFT(plan_many_1d)(n, howmany, batch, C2R, STARPUFFT_INVERSE, flags);
+}
+
+STARPUFFT(plan)
+STARPUFFT(plan_dft_r2c_1d)(int n, unsigned flags)
+{
+	return STARPUFFT(plan_many_dft_r2c_1d)(n, 1, 1, flags);
+}
+
+STARPUFFT(plan)
+STARPUFFT(plan_dft_c2r_1d)(int n, unsigned flags)
+{
+	return STARPUFFT(plan_many_dft_c2r_1d)(n, 1, 1, flags);
+}
+
+/* Actually submit all the tasks. */
+static struct starpu_task *
+STARPUFFT(start1dmany)(STARPUFFT(plan) plan, starpu_data_handle_t in, starpu_data_handle_t out)
+{
+	struct starpu_task **tasks;
+	struct starpu_task *end_task;
+	int z;
+	int ret;
+
+	STARPU_ASSERT(starpu_vector_get_nx(in) == (size_t) plan->howmany * plan->in_len);
+	STARPU_ASSERT(starpu_vector_get_nx(out) == (size_t) plan->howmany * plan->out_len);
+
+	starpu_data_partition_plan(in, &plan->in_filter, plan->batch_in_handle);
+	starpu_data_partition_plan(out, &plan->out_filter, plan->batch_out_handle);
+	starpu_data_partition_submit(in, plan->nbatches, plan->batch_in_handle);
+	starpu_data_partition_submit(out, plan->nbatches, plan->batch_out_handle);
+
+	/* Create FFT tasks */
+	tasks = malloc(plan->nbatches * sizeof(*tasks));
+	for (z = 0; z < plan->nbatches; z++)
+	{
+		struct starpu_task *task = tasks[z] = starpu_task_create();
+		task->cl = &STARPUFFT(fft_many_1d_codelet);
+		task->handles[0] = plan->batch_in_handle[z];
+		task->handles[1] = plan->batch_out_handle[z];
+		task->cl_arg = plan;
+	}
+
+	/* Create end task, only serving as a join point. */
+	end_task = starpu_task_create();
+	end_task->cl = NULL;
+	end_task->detach = 0;
+	starpu_task_declare_deps_array(end_task, plan->nbatches, tasks);
+
+	for (z = 0; z < plan->nbatches; z++)
+	{
+		ret = starpu_task_submit(tasks[z]);
+		if (ret == -ENODEV)
+		{
+			/* No worker can run any batch, nothing was submitted */
+			STARPU_ASSERT(z == 0);
+			for (z = 0; z < plan->nbatches; z++)
+				starpu_task_destroy(tasks[z]);
+			starpu_task_destroy(end_task);
+			end_task = NULL;
+			break;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+	free(tasks);
+
+	if (end_task)
+	{
+		ret = starpu_task_submit(end_task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+
+	/* Gather the batches back, the application can then use in and out */
+	starpu_data_partition_clean(in, plan->nbatches, plan->batch_in_handle);
+	starpu_data_partition_clean(out, plan->nbatches, plan->batch_out_handle);
+
+	return end_task;
+}
+
+/* Free the batch descriptions. The generic code handles freeing the fftw plans. */
+static void
+STARPUFFT(free_many)(STARPUFFT(plan) plan)
+{
+	free(plan->in_lengths);
+	free(plan->out_lengths);
+	free(plan->batch_in_handle);
+	free(plan->batch_out_handle);
+}
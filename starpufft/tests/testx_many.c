@@ -0,0 +1,231 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Perform many small independent ffts, either by submitting one starpufft
+ * task per signal, or with batched plans, and compare the per-transform
+ * throughput. The batched real-to-complex and complex-to-real transforms are
+ * checked as well.
+ *
+ * Usage: test_many [n [howmany [batch]]]
+ */
+
+#include <complex.h>
+#include <math.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/time.h>
+
+#include <starpu.h>
+
+#include <starpu_config.h>
+#include "starpufft.h"
+
+#ifdef STARPU_HAVE_FFTW
+#include <fftw3.h>
+#endif
+
+#define SIGN (-1)
+
+#define TIMING(begin,end) (double)((end.tv_sec - begin.tv_sec)*1000000 + (end.tv_usec - begin.tv_usec))
+
+#ifdef STARPU_HAVE_FFTW
+static void check(const char *what, STARPUFFT(complex) *out, STARPUFFT(complex) *ref, int size)
+{
+	int i;
+	double max = 0., norm = 0.;
+	for (i = 0; i < size; i++)
+	{
+		double diff = cabs(out[i]-ref[i]);
+		double dsize = cabs(ref[i]);
+		if (diff > max)
+			max = diff;
+		norm += dsize * dsize;
+	}
+	double relmaxdiff = max / sqrt(norm);
+	fprintf(stderr, "%s: relative maximum difference %g\n", what, relmaxdiff);
+	if (relmaxdiff > (!strcmp(TYPE, "f") ? 1e-6 : 1e-14))
+	{
+		fprintf(stderr, "Failure: Difference too big\n");
+		exit(EXIT_FAILURE);
+	}
+}
+#endif
+
+static void report(const char *what, double timing, int howmany)
+{
+	printf("%s took %2.2f ms (%2.2f us per transform)\n", what, timing/1000, timing/howmany);
+}
+
+int main(int argc, char *argv[])
+{
+	int i, ret;
+	int n = 64, howmany = 1024, batch = 0;
+	int size, csize;
+	STARPUFFT(plan) plan;
+	starpu_data_handle_t *in_handles, *out_handles;
+	struct starpu_task **tasks;
+	struct timeval begin, end;
+	double timing;
+#ifdef STARPU_HAVE_FFTW
+	_FFTW(plan) fftw_plan;
+#endif
+
+	if (argc > 1)
+		n = atoi(argv[1]);
+	if (argc > 2)
+		howmany = atoi(argv[2]);
+	if (argc > 3)
+		batch = atoi(argv[3]);
+	size = n * howmany;
+	csize = (n/2 + 1) * howmany;
+
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+	/* FIXME: batched plans are only implemented on CPUs */
+	conf.ncuda = 0;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	STARPUFFT(complex) *in = STARPUFFT(malloc)(size * sizeof(*in));
+	STARPUFFT(complex) *out = STARPUFFT(malloc)(size * sizeof(*out));
+	real *rin = STARPUFFT(malloc)(size * sizeof(*rin));
+	real *rout = STARPUFFT(malloc)(size * sizeof(*rout));
+	STARPUFFT(complex) *cout = STARPUFFT(malloc)(csize * sizeof(*cout));
+#ifdef STARPU_HAVE_FFTW
+	STARPUFFT(complex) *out_fftw = STARPUFFT(malloc)(size * sizeof(*out_fftw));
+	STARPUFFT(complex) *cout_fftw = STARPUFFT(malloc)(csize * sizeof(*cout_fftw));
+#endif
+
+	starpu_srand48(0);
+	for (i = 0; i < size; i++)
+	{
+		in[i] = starpu_drand48() + I * starpu_drand48();
+		rin[i] = starpu_drand48();
+	}
+
+#ifdef STARPU_HAVE_FFTW
+	fftw_plan = _FFTW(plan_many_dft)(1, &n, howmany, in, NULL, 1, n, out_fftw, NULL, 1, n, SIGN, FFTW_ESTIMATE);
+	gettimeofday(&begin, NULL);
+	_FFTW(execute)(fftw_plan);
+	gettimeofday(&end, NULL);
+	_FFTW(destroy_plan)(fftw_plan);
+	report("FFTW", TIMING(begin, end), howmany);
+
+	fftw_plan = _FFTW(plan_many_dft_r2c)(1, &n, howmany, rin, NULL, 1, n, cout_fftw, NULL, 1, n/2 + 1, FFTW_ESTIMATE);
+	_FFTW(execute)(fftw_plan);
+	_FFTW(destroy_plan)(fftw_plan);
+#endif
+
+	/* One task per signal */
+	in_handles = malloc(howmany * sizeof(*in_handles));
+	out_handles = malloc(howmany * sizeof(*out_handles));
+	tasks = malloc(howmany * sizeof(*tasks));
+	for (i = 0; i < howmany; i++)
+	{
+		starpu_vector_data_register(&in_handles[i], STARPU_MAIN_RAM, (uintptr_t) &in[i*n], n, sizeof(*in));
+		starpu_vector_data_register(&out_handles[i], STARPU_MAIN_RAM, (uintptr_t) &out[i*n], n, sizeof(*out));
+	}
+
+	plan = STARPUFFT(plan_dft_1d)(n, SIGN, 0);
+	gettimeofday(&begin, NULL);
+	for (i = 0; i < howmany; i++)
+	{
+		tasks[i] = STARPUFFT(start_handle)(plan, in_handles[i], out_handles[i]);
+		if (!tasks[i]) return 77;
+	}
+	for (i = 0; i < howmany; i++)
+	{
+		ret = starpu_task_wait(tasks[i]);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait");
+	}
+	gettimeofday(&end, NULL);
+	timing = TIMING(begin, end);
+	STARPUFFT(destroy_plan)(plan);
+
+	for (i = 0; i < howmany; i++)
+	{
+		starpu_data_unregister(in_handles[i]);
+		starpu_data_unregister(out_handles[i]);
+	}
+	free(in_handles);
+	free(out_handles);
+	free(tasks);
+
+	report("One task per signal", timing, howmany);
+#ifdef STARPU_HAVE_FFTW
+	check("one task per signal", out, out_fftw, size);
+#endif
+
+	/* Batched complex transforms */
+	memset(out, 0, size * sizeof(*out));
+	plan = STARPUFFT(plan_many_dft_1d)(n, howmany, batch, SIGN, 0);
+	gettimeofday(&begin, NULL);
+	ret = STARPUFFT(execute)(plan, in, out);
+	gettimeofday(&end, NULL);
+	if (ret == -1) return 77;
+	report("Batched", TIMING(begin, end), howmany);
+	STARPUFFT(showstats)(stdout);
+	STARPUFFT(destroy_plan)(plan);
+#ifdef STARPU_HAVE_FFTW
+	check("batched", out, out_fftw, size);
+#endif
+
+	/* Batched real-to-complex transforms */
+	plan = STARPUFFT(plan_many_dft_r2c_1d)(n, howmany, batch, 0);
+	gettimeofday(&begin, NULL);
+	ret = STARPUFFT(execute)(plan, rin, cout);
+	gettimeofday(&end, NULL);
+	if (ret == -1) return 77;
+	report("Batched real-to-complex", TIMING(begin, end), howmany);
+	STARPUFFT(destroy_plan)(plan);
+#ifdef STARPU_HAVE_FFTW
+	check("batched real-to-complex", cout, cout_fftw, csize);
+#endif
+
+	/* Batched complex-to-real transforms, back to the input scaled by n */
+	plan = STARPUFFT(plan_many_dft_c2r_1d)(n, howmany, batch, 0);
+	gettimeofday(&begin, NULL);
+	ret = STARPUFFT(execute)(plan, cout, rout);
+	gettimeofday(&end, NULL);
+	if (ret == -1) return 77;
+	report("Batched complex-to-real", TIMING(begin, end), howmany);
+	STARPUFFT(destroy_plan)(plan);
+#ifdef STARPU_HAVE_FFTW
+	for (i = 0; i < size; i++)
+	{
+		in[i] = rin[i] * n;
+		out[i] = rout[i];
+	}
+	check("batched complex-to-real", out, in, size);
+#endif
+
+	STARPUFFT(free)(in, size * sizeof(*in));
+	STARPUFFT(free)(out, size * sizeof(*out));
+	STARPUFFT(free)(rin, size * sizeof(*rin));
+	STARPUFFT(free)(rout, size * sizeof(*rout));
+	STARPUFFT(free)(cout, csize * sizeof(*cout));
+#ifdef STARPU_HAVE_FFTW
+	STARPUFFT(free)(out_fftw, size * sizeof(*out_fftw));
+	STARPUFFT(free)(cout_fftw, csize * sizeof(*cout_fftw));
+#endif
+
+	starpu_shutdown();
+
+	return EXIT_SUCCESS;
+}
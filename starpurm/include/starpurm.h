@@ -494,6 +494,35 @@ hwloc_cpuset_t starpurm_get_all_device_workers_cpuset(void);
 */
 hwloc_cpuset_t starpurm_get_all_device_workers_cpuset_by_type(int typeid);
 
+/** @} */
+
+/**
+   @name Statistics
+   @{
+*/
+
+/**
+   Statistics about the processing of the worker sleep/wake-up and unit
+   availability events, see starpurm_get_event_stats().
+*/
+struct starpurm_event_stats
+{
+	unsigned long nnotified;	/**< Number of events notified to StarPU-RM. */
+	unsigned long ncoalesced;	/**< Number of events merged into an event of the same unit not processed yet. */
+	unsigned long nprocessed;	/**< Number of events processed by the event thread. */
+	unsigned long nbatches;		/**< Number of batches of events processed by the event thread. */
+	double avg_latency;		/**< Average time in µs between the notification of an event and its processing. */
+	double max_latency;		/**< Maximum time in µs between the notification of an event and its processing. */
+};
+
+/**
+   Fill \p stats with the statistics about the events processed since
+   starpurm_initialize(). Return 0 on success, or \c -ENODEV if StarPU
+   was built without worker callbacks, in which case no event is
+   recorded and all the fields are 0.
+*/
+int starpurm_get_event_stats(struct starpurm_event_stats *stats);
+
 /** @} */
 /** @} */
 
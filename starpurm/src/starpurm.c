@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <assert.h>
 #include <hwloc.h>
 #include <starpu.h>
@@ -104,151 +105,253 @@ const char *_starpurm_event_to_str(int event_code)
 	return s;
 }
 
+/* Slot of the event ring.
+ *
+ * The ring is a bounded multi-producer single-consumer queue: producers
+ * reserve a slot by advancing event_ring_tail with a compare-and-swap, and
+ * publish it by setting seq to the reserved position + 1. The event thread
+ * is the only consumer, it releases a slot by setting seq to the position of
+ * the next round.
+ */
 struct s_starpurm_event
 {
-	struct s_starpurm_event *next;
-	struct s_starpurm_event *prev;
+	volatile unsigned long seq;
 	enum e_starpurm_event code;
 	int workerid;
+	/* date of the first event coalesced into this slot */
+	double timestamp;
 };
 
-static void _enqueue_event(struct s_starpurm_event *event)
+/* Maximum number of slots processed by the event thread in one go. */
+#define STARPURM_EVENT_BATCH 64
+
+static void _push_event(enum e_starpurm_event code, int workerid)
 {
-	assert(_starpurm != NULL);
-	assert(_starpurm->state != state_uninitialized);
 	struct s_starpurm *rm = _starpurm;
-	assert(event->next == NULL);
-	assert(event->prev == NULL);
-	assert(event->code >= starpurm_event_code_min && event->code <= starpurm_event_code_max);
-	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
-	if (rm->event_processing_ended)
-	{
-		STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
-		return;
-	}
-	assert((rm->event_list_head == NULL && rm->event_list_tail == NULL)
-			|| (rm->event_list_head != NULL && rm->event_list_tail != NULL));
-	if (rm->event_list_head == NULL)
+	unsigned long pos = rm->event_ring_tail;
+	struct s_starpurm_event *slot;
+	while (1)
 	{
-		rm->event_list_tail = event;
+		slot = &rm->event_ring[pos & rm->event_ring_mask];
+		long diff = (long)(slot->seq - pos);
+		if (diff == 0)
+		{
+			if (STARPU_BOOL_COMPARE_AND_SWAP(&rm->event_ring_tail, pos, pos+1))
+				break;
+		}
+		else
+		{
+			/* since sleep/wake-up events are coalesced, at most one slot per
+			 * worker and per kind of event may be in use, the ring can not be full */
+			assert(diff > 0);
+		}
+		pos = rm->event_ring_tail;
 	}
-	else
+	slot->code = code;
+	slot->workerid = workerid;
+	slot->timestamp = starpu_timing_now();
+	STARPU_WMB();
+	slot->seq = pos+1;
+}
+
+static int _event_ring_empty(void)
+{
+	struct s_starpurm *rm = _starpurm;
+	unsigned long pos = rm->event_ring_head;
+	return rm->event_ring[pos & rm->event_ring_mask].seq != pos+1;
+}
+
+/* Wake the event thread up if it is waiting for events. The caller may
+ * already hold event_list_mutex. */
+static void _notify_event_thread(int locked)
+{
+	struct s_starpurm *rm = _starpurm;
+	STARPU_SYNCHRONIZE();
+	if (rm->event_thread_waiting)
 	{
-		rm->event_list_head->prev = event;
+		if (!locked)
+			STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
+		STARPU_PTHREAD_COND_BROADCAST(&rm->event_list_cond);
+		if (!locked)
+			STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
 	}
-	event->next = rm->event_list_head;
-	rm->event_list_head = event;
-	if (event->code == starpurm_event_exit)
+}
+
+/* Record that worker workerid changed state. Only the last state of a
+ * worker matters to the event thread, so if an event for this worker is
+ * still pending, it is just overwritten instead of using a new slot. */
+static void _enqueue_worker_event(enum e_starpurm_event code, int workerid, int locked)
+{
+	struct s_starpurm *rm = _starpurm;
+	rm->event_nnotified[workerid]++;
+	if (STARPU_VAL_EXCHANGE(&rm->event_pending_state[workerid], (int)code) != 0)
 	{
-		rm->event_processing_ended = 1;
-		int i;
-		for (i=0; i<rm->nunits; i++)
-		{
-			STARPU_PTHREAD_COND_BROADCAST(&rm->units[i].unit_available_cond);
-		}
+		rm->event_ncoalesced[workerid]++;
+		return;
 	}
+	_push_event(code, workerid);
+	_notify_event_thread(locked);
+}
+
+static void _enqueue_event(enum e_starpurm_event code, int workerid)
+{
+	assert(_starpurm != NULL);
+	assert(_starpurm->state != state_uninitialized);
+	struct s_starpurm *rm = _starpurm;
+	assert(code >= starpurm_event_code_min && code <= starpurm_event_code_max);
+	if (rm->event_processing_ended)
+		return;
 #ifdef STARPURM_VERBOSE
-	if (event->code != starpurm_event_worker_waking_up)
-		fprintf(stderr, "%s: event->code=%d('%s'), workerid=%u\n", __func__, event->code, _starpurm_event_to_str(event->code), event->workerid);
+	if (code != starpurm_event_worker_waking_up)
+		fprintf(stderr, "%s: event->code=%d('%s'), workerid=%u\n", __func__, code, _starpurm_event_to_str(code), workerid);
 #endif
-	STARPU_PTHREAD_COND_BROADCAST(&rm->event_list_cond);
-#ifdef STARPURM_HAVE_DLB
-	if (event->code == starpurm_event_worker_waking_up)
+	switch (code)
 	{
-		int unit_id = rm->worker_unit_ids[event->workerid];
-		/* if DLB is in use, wait for the unit to become available from the point of view of DLB, before using it */
+		case starpurm_event_worker_going_to_sleep:
+			_enqueue_worker_event(code, workerid, 0);
+			break;
+		case starpurm_event_worker_waking_up:
+#ifdef STARPURM_HAVE_DLB
+			{
+				int unit_id = rm->worker_unit_ids[workerid];
+				/* if DLB is in use, wait for the unit to become available from the point of view of DLB, before using it */
+				STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
+				_enqueue_worker_event(code, workerid, 1);
 #ifdef STARPURM_VERBOSE
-		fprintf(stderr, "%s: event->code=%d('%s'), workerid=%u - waiting\n", __func__, event->code, _starpurm_event_to_str(event->code), event->workerid);
+				fprintf(stderr, "%s: event->code=%d('%s'), workerid=%u - waiting\n", __func__, code, _starpurm_event_to_str(code), workerid);
 #endif
-		STARPU_PTHREAD_COND_WAIT(&rm->units[unit_id].unit_available_cond, &rm->event_list_mutex);
+				if (!rm->event_processing_ended)
+					STARPU_PTHREAD_COND_WAIT(&rm->units[unit_id].unit_available_cond, &rm->event_list_mutex);
 #ifdef STARPURM_VERBOSE
-		fprintf(stderr, "%s: event->code=%d('%s'), workerid=%u - wakeup\n", __func__, event->code, _starpurm_event_to_str(event->code), event->workerid);
+				fprintf(stderr, "%s: event->code=%d('%s'), workerid=%u - wakeup\n", __func__, code, _starpurm_event_to_str(code), workerid);
 #endif
-	}
+				STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
+			}
+#else
+			_enqueue_worker_event(code, workerid, 0);
 #endif
-	STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
+			break;
+		case starpurm_event_unit_available:
+			(void)STARPU_ATOMIC_ADDL(&rm->event_nnotified_units, 1);
+			if (STARPU_VAL_EXCHANGE(&rm->event_pending_available[workerid], 1) != 0)
+			{
+				(void)STARPU_ATOMIC_ADDL(&rm->event_ncoalesced_units, 1);
+				return;
+			}
+			_push_event(code, workerid);
+			_notify_event_thread(0);
+			break;
+		case starpurm_event_exit:
+			STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
+			rm->event_processing_ended = 1;
+			{
+				int i;
+				for (i=0; i<rm->nunits; i++)
+				{
+					STARPU_PTHREAD_COND_BROADCAST(&rm->units[i].unit_available_cond);
+				}
+			}
+			_push_event(code, workerid);
+			_notify_event_thread(1);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
+			break;
+	}
 }
 
-static struct s_starpurm_event *_dequeue_event_no_lock(void)
+/* Pop at most max events, return the number of events popped. Only called
+ * by the event thread. */
+static int _dequeue_events(struct s_starpurm_event *events, int max)
 {
 	struct s_starpurm *rm = _starpurm;
-	struct s_starpurm_event *event = NULL;
-	if (rm->event_list_tail != NULL)
+	unsigned long pos = rm->event_ring_head;
+	int n = 0;
+	while (n < max)
 	{
-		event = rm->event_list_tail;
-		if (event->prev == NULL)
-		{
-			rm->event_list_head = NULL;
-			rm->event_list_tail = NULL;
-		}
-		else
-		{
-			event->prev->next = NULL;
-			rm->event_list_tail = event->prev;
-		}
-		event->prev = NULL;
-		event->next = NULL;
+		struct s_starpurm_event *slot = &rm->event_ring[pos & rm->event_ring_mask];
+		if (slot->seq != pos+1)
+			break;
+		STARPU_RMB();
+		events[n].code = slot->code;
+		events[n].workerid = slot->workerid;
+		events[n].timestamp = slot->timestamp;
+		/* the pending state of the worker is now reset, so that the next
+		 * event for it gets a new slot */
+		if (slot->code == starpurm_event_worker_going_to_sleep || slot->code == starpurm_event_worker_waking_up)
+			events[n].code = STARPU_VAL_EXCHANGE(&rm->event_pending_state[slot->workerid], 0);
+		else if (slot->code == starpurm_event_unit_available)
+			(void)STARPU_VAL_EXCHANGE(&rm->event_pending_available[slot->workerid], 0);
+		STARPU_SYNCHRONIZE();
+		slot->seq = pos + rm->event_ring_mask + 1;
+		pos++;
+		n++;
 	}
-	return event;
+	rm->event_ring_head = pos;
+	return n;
 }
 
-static struct s_starpurm_event *_wait_event_no_lock(void)
+static void _wait_event(void)
 {
 	struct s_starpurm *rm = _starpurm;
-	while (rm->event_list_head == NULL)
+	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
+	rm->event_thread_waiting = 1;
+	STARPU_SYNCHRONIZE();
+	while (_event_ring_empty())
 	{
 		STARPU_PTHREAD_COND_WAIT(&rm->event_list_cond, &rm->event_list_mutex);
 	}
-	struct s_starpurm_event *event = _dequeue_event_no_lock();
-	return event;
-}
-
-/* unused */
-static struct s_starpurm_event *_dequeue_event(void)
-{
-	assert(_starpurm != NULL);
-	assert(_starpurm->state != state_uninitialized);
-	struct s_starpurm *rm = _starpurm;
-	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
-	struct s_starpurm_event *event = _dequeue_event_no_lock();
+	rm->event_thread_waiting = 0;
 	STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
-	return event;
 }
 
-/* unused */
-static struct s_starpurm_event *_wait_event(void)
-{
-	assert(_starpurm != NULL);
-	assert(_starpurm->state != state_uninitialized);
-	struct s_starpurm *rm = _starpurm;
-	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
-	struct s_starpurm_event *event = _wait_event_no_lock();
-	STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
-	return event;
+static void _init_event_ring(struct s_starpurm *rm)
+{
+	/* one slot per worker for sleep/wake-up events, one per worker for
+	 * unit availability events, and one for the exit event */
+	unsigned long size = 1;
+	while (size < 2*STARPU_NMAXWORKERS+1)
+		size *= 2;
+	rm->event_ring = calloc(size, sizeof(*rm->event_ring));
+	unsigned long i;
+	for (i=0; i<size; i++)
+		rm->event_ring[i].seq = i;
+	rm->event_ring_mask = size-1;
+	rm->event_ring_head = 0;
+	rm->event_ring_tail = 0;
+	rm->event_thread_waiting = 0;
+	rm->event_pending_state = calloc(STARPU_NMAXWORKERS, sizeof(*rm->event_pending_state));
+	rm->event_pending_available = calloc(STARPU_NMAXWORKERS, sizeof(*rm->event_pending_available));
+	rm->event_nnotified = calloc(STARPU_NMAXWORKERS, sizeof(*rm->event_nnotified));
+	rm->event_ncoalesced = calloc(STARPU_NMAXWORKERS, sizeof(*rm->event_ncoalesced));
+	rm->event_nnotified_units = 0;
+	rm->event_ncoalesced_units = 0;
+	rm->event_nprocessed = 0;
+	rm->event_nbatches = 0;
+	rm->event_total_latency = 0.0;
+	rm->event_max_latency = 0.0;
+}
+
+static void _deinit_event_ring(struct s_starpurm *rm)
+{
+	free(rm->event_ring);
+	free(rm->event_pending_state);
+	free(rm->event_pending_available);
+	free(rm->event_nnotified);
+	free(rm->event_ncoalesced);
 }
 
 static void _enqueue_exit_event(void)
 {
-	struct s_starpurm_event *event = calloc(1, sizeof(*event));
-	event->code = starpurm_event_exit;
-	event->workerid = 0;
-	_enqueue_event(event);
+	_enqueue_event(starpurm_event_exit, 0);
 }
 
-static void callback_worker_going_to_sleep(int workerid)
+static void callback_worker_going_to_sleep(unsigned workerid)
 {
-	struct s_starpurm_event *event = calloc(1, sizeof(*event));
-	event->code = starpurm_event_worker_going_to_sleep;
-	event->workerid = workerid;
-	_enqueue_event(event);
+	_enqueue_event(starpurm_event_worker_going_to_sleep, workerid);
 }
 
-static void callback_worker_waking_up(int workerid)
+static void callback_worker_waking_up(unsigned workerid)
 {
-	struct s_starpurm_event *event = calloc(1, sizeof(*event));
-	event->code = starpurm_event_worker_waking_up;
-	event->workerid = workerid;
-	_enqueue_event(event);
+	_enqueue_event(starpurm_event_worker_waking_up, workerid);
 }
 
 void starpurm_enqueue_event_cpu_unit_available(int unit_id)
@@ -263,10 +366,43 @@ void starpurm_enqueue_event_cpu_unit_available(int unit_id)
 	 *
 	 * //assert(unit_id < rm->nunits_by_type[starpurm_unit_cpu]);
 	 */
-	int workerid = rm->units[unit_id].workerid; struct
-		s_starpurm_event *event = calloc(1, sizeof(*event));
-	event->code = starpurm_event_unit_available; event->workerid =
-		workerid; _enqueue_event(event);
+	int workerid = rm->units[unit_id].workerid;
+	_enqueue_event(starpurm_event_unit_available, workerid);
+}
+
+static void _refresh_owned_cpuset(hwloc_cpuset_t owned_cpuset, hwloc_cpuset_t to_reclaim_cpuset, hwloc_cpuset_t to_lend_cpuset)
+{
+	int did_lend_cpuset = 1;
+#ifdef STARPURM_HAVE_DLB
+	/* notify DLB about changes */
+	if (!hwloc_bitmap_iszero(to_reclaim_cpuset))
+	{
+		starpurm_dlb_notify_starpu_worker_mask_waking_up(to_reclaim_cpuset);
+	}
+	did_lend_cpuset = 0;
+	if (!hwloc_bitmap_iszero(to_lend_cpuset))
+	{
+		did_lend_cpuset = starpurm_dlb_notify_starpu_worker_mask_going_to_sleep(to_lend_cpuset);
+	}
+#endif
+	/* if DLB is not initialized, ignore lend operations */
+	if (did_lend_cpuset)
+	{
+		hwloc_bitmap_andnot(owned_cpuset, owned_cpuset, to_lend_cpuset);
+	}
+	hwloc_bitmap_or(owned_cpuset, owned_cpuset, to_reclaim_cpuset);
+
+#if 0
+	{
+		char *to_lend_str = bitmap_to_str(to_lend_cpuset);
+		char *to_reclaim_str = bitmap_to_str(to_reclaim_cpuset);
+		free(to_lend_str);
+		free(to_reclaim_str);
+	}
+#endif
+
+	hwloc_bitmap_zero(to_lend_cpuset);
+	hwloc_bitmap_zero(to_reclaim_cpuset);
 }
 
 static void *event_thread_func(void *_arg)
@@ -276,6 +412,8 @@ static void *event_thread_func(void *_arg)
 	assert(_starpurm->state != state_uninitialized);
 	struct s_starpurm *rm = _starpurm;
 	int need_refresh = 0;
+	int exiting = 0;
+	struct s_starpurm_event events[STARPURM_EVENT_BATCH];
 
 	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
 	while (rm->event_processing_enabled == 0)
@@ -286,121 +424,110 @@ static void *event_thread_func(void *_arg)
 	hwloc_cpuset_t owned_cpuset = hwloc_bitmap_dup(rm->global_cpuset);
 	hwloc_cpuset_t to_reclaim_cpuset = hwloc_bitmap_alloc();
 	hwloc_cpuset_t to_lend_cpuset = hwloc_bitmap_alloc();
-	while (1)
+	while (!exiting)
 	{
-		struct s_starpurm_event *event = _dequeue_event();
-#ifdef STARPURM_HAVE_DLB
-		if ((event == NULL || event->code == starpurm_event_exit) || need_refresh)
-#else
-		if ((event == NULL || event->code == starpurm_event_exit) && need_refresh)
-#endif
+		int nevents = _dequeue_events(events, STARPURM_EVENT_BATCH);
+		if (nevents == 0)
 		{
-			int did_lend_cpuset = 1;
-#ifdef STARPURM_HAVE_DLB
-			/* notify DLB about changes */
-			if (!hwloc_bitmap_iszero(to_reclaim_cpuset))
-			{
-				starpurm_dlb_notify_starpu_worker_mask_waking_up(to_reclaim_cpuset);
-			}
-			did_lend_cpuset = 0;
-			if (!hwloc_bitmap_iszero(to_lend_cpuset))
-			{
-				did_lend_cpuset = starpurm_dlb_notify_starpu_worker_mask_going_to_sleep(to_lend_cpuset);
-			}
-#endif
-			/* if DLB is not initialized, ignore lend operations */
-			if (did_lend_cpuset)
+			/* all pending state changes have been accumulated, apply them */
+			if (need_refresh)
 			{
-				hwloc_bitmap_andnot(owned_cpuset, owned_cpuset, to_lend_cpuset);
+				_refresh_owned_cpuset(owned_cpuset, to_reclaim_cpuset, to_lend_cpuset);
+				need_refresh = 0;
 			}
-			hwloc_bitmap_or(owned_cpuset, owned_cpuset, to_reclaim_cpuset);
+			_wait_event();
+			continue;
+		}
 
-#if 0
+		double now = starpu_timing_now();
+		rm->event_nbatches++;
+		int i;
+		for (i=0; i<nevents; i++)
+		{
+			struct s_starpurm_event *event = &events[i];
+			double latency = now - event->timestamp;
+			rm->event_nprocessed++;
+			rm->event_total_latency += latency;
+			if (latency > rm->event_max_latency)
+				rm->event_max_latency = latency;
+
+			if (event->code == starpurm_event_exit)
 			{
-				char *to_lend_str = bitmap_to_str(to_lend_cpuset);
-				char *to_reclaim_str = bitmap_to_str(to_reclaim_cpuset);
-				free(to_lend_str);
-				free(to_reclaim_str);
+				exiting = 1;
+				break;
 			}
-#endif
-
-			need_refresh = 0;
-			hwloc_bitmap_zero(to_lend_cpuset);
-			hwloc_bitmap_zero(to_reclaim_cpuset);
-		}
-		if (event == NULL)
-		{
-			event = _wait_event();
-		}
-		if (event->code == starpurm_event_exit)
-		{
-			free(event);
-			break;
-		}
 
-		/* TODO: accumulate state change */
-		switch (event->code)
-		{
-			case starpurm_event_worker_going_to_sleep:
-				{
-					if (event->workerid < rm->nunits)
+			switch (event->code)
+			{
+				case starpurm_event_worker_going_to_sleep:
 					{
-						int unit_id = rm->worker_unit_ids[event->workerid];
-						hwloc_bitmap_or(to_lend_cpuset, to_lend_cpuset, rm->units[unit_id].worker_cpuset);
-						hwloc_bitmap_andnot(to_reclaim_cpuset, to_reclaim_cpuset, rm->units[unit_id].worker_cpuset);
+						if (event->workerid < rm->nunits)
+						{
+							int unit_id = rm->worker_unit_ids[event->workerid];
+							hwloc_bitmap_or(to_lend_cpuset, to_lend_cpuset, rm->units[unit_id].worker_cpuset);
+							hwloc_bitmap_andnot(to_reclaim_cpuset, to_reclaim_cpuset, rm->units[unit_id].worker_cpuset);
+						}
 					}
-				}
-				break;
-			case starpurm_event_worker_waking_up:
-				{
-					if (event->workerid < rm->nunits)
+					break;
+				case starpurm_event_worker_waking_up:
 					{
-						int unit_id = rm->worker_unit_ids[event->workerid];
-						hwloc_bitmap_andnot(to_lend_cpuset, to_lend_cpuset, rm->units[unit_id].worker_cpuset);
-#ifdef STARPURM_HAVE_DLB
-						if (rm->units[unit_id].type == starpurm_unit_cpu && !hwloc_bitmap_intersects(rm->units[unit_id].worker_cpuset, owned_cpuset))
+						if (event->workerid < rm->nunits)
 						{
-							/* Only reclaim the unit from DLB if StarPU does not own it already. */
+							int unit_id = rm->worker_unit_ids[event->workerid];
+							hwloc_bitmap_andnot(to_lend_cpuset, to_lend_cpuset, rm->units[unit_id].worker_cpuset);
+#ifdef STARPURM_HAVE_DLB
+							if (rm->units[unit_id].type == starpurm_unit_cpu && !hwloc_bitmap_intersects(rm->units[unit_id].worker_cpuset, owned_cpuset))
+							{
+								/* Only reclaim the unit from DLB if StarPU does not own it already. */
+								hwloc_bitmap_or(to_reclaim_cpuset, to_reclaim_cpuset, rm->units[unit_id].worker_cpuset);
+							}
+							else
+							{
+								STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
+								STARPU_PTHREAD_COND_BROADCAST(&rm->units[unit_id].unit_available_cond);
+								STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
+							}
+#else
 							hwloc_bitmap_or(to_reclaim_cpuset, to_reclaim_cpuset, rm->units[unit_id].worker_cpuset);
+#endif
 						}
-						else
+					}
+					break;
+#ifdef STARPURM_HAVE_DLB
+				case starpurm_event_unit_available:
+					{
+						if (event->workerid < rm->nunits)
 						{
+							/* a reclaimed unit is now available from DLB, unlock the corresponding worker waking up */
+							int unit_id = rm->worker_unit_ids[event->workerid];
+							STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
 							STARPU_PTHREAD_COND_BROADCAST(&rm->units[unit_id].unit_available_cond);
+							STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
 						}
-#else
-						hwloc_bitmap_or(to_reclaim_cpuset, to_reclaim_cpuset, rm->units[unit_id].worker_cpuset);
-#endif
 					}
-				}
-				break;
+					break;
+#endif
+				default:
+					/* unknown event code */
+					assert(0);
+					break;
+			}
+			need_refresh = 1;
+		}
 #ifdef STARPURM_HAVE_DLB
-			case starpurm_event_unit_available:
-				{
-					if (event->workerid < rm->nunits)
-					{
-						/* a reclaimed unit is now available from DLB, unlock the corresponding worker waking up */
-						int unit_id = rm->worker_unit_ids[event->workerid];
-						STARPU_PTHREAD_COND_BROADCAST(&rm->units[unit_id].unit_available_cond);
-					}
-				}
-				break;
+		/* let DLB know about the changes as soon as possible */
+		if (need_refresh || exiting)
+#else
+		if (exiting && need_refresh)
 #endif
-			default:
-				/* unknown event code */
-				assert(0);
-				break;
+		{
+			_refresh_owned_cpuset(owned_cpuset, to_reclaim_cpuset, to_lend_cpuset);
+			need_refresh = 0;
 		}
-		free(event);
-		need_refresh = 1;
 	}
-	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
-	/* exit event should be last */
-	assert(rm->event_list_head == NULL);
-	assert(rm->event_list_tail == NULL);
 	hwloc_bitmap_free(owned_cpuset);
 	hwloc_bitmap_free(to_reclaim_cpuset);
 	hwloc_bitmap_free(to_lend_cpuset);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
 	return NULL;
 }
 #endif /* STARPURM_STARPU_HAVE_WORKER_CALLBACKS */
@@ -674,15 +801,16 @@ void starpurm_initialize_with_cpuset(const hwloc_cpuset_t initially_owned_cpuset
 	rm->all_device_workers_cpuset = hwloc_bitmap_alloc();
 	hwloc_bitmap_zero(rm->all_device_workers_cpuset);
 
-	/* init event list, before StarPU is initialized */
+	/* init event ring, before StarPU is initialized */
 	STARPU_PTHREAD_MUTEX_INIT(&rm->event_list_mutex, NULL);
 	STARPU_PTHREAD_COND_INIT(&rm->event_list_cond, NULL);
 	STARPU_PTHREAD_COND_INIT(&rm->event_processing_cond, NULL);
 	STARPU_PTHREAD_MUTEX_LOCK(&rm->event_list_mutex);
 	rm->event_processing_enabled = 0;
 	rm->event_processing_ended = 0;
-	rm->event_list_head = NULL;
-	rm->event_list_tail = NULL;
+#ifdef STARPURM_STARPU_HAVE_WORKER_CALLBACKS
+	_init_event_ring(rm);
+#endif
 	STARPU_PTHREAD_MUTEX_UNLOCK(&rm->event_list_mutex);
 
 	/* set _starpurm here since StarPU's callbacks may reference it once starpu_init is called */
@@ -968,8 +1096,9 @@ void starpurm_shutdown(void)
 #ifdef STARPURM_STARPU_HAVE_WORKER_CALLBACKS
 	STARPU_PTHREAD_JOIN(rm->event_thread, NULL);
 #endif
-	assert(rm->event_list_head == NULL);
-	assert(rm->event_list_tail == NULL);
+#ifdef STARPURM_STARPU_HAVE_WORKER_CALLBACKS
+	_deinit_event_ring(rm);
+#endif
 	STARPU_PTHREAD_COND_DESTROY(&rm->event_list_cond);
 	STARPU_PTHREAD_MUTEX_DESTROY(&rm->event_list_mutex);
 
@@ -1817,3 +1946,28 @@ hwloc_cpuset_t starpurm_get_all_device_workers_cpuset_by_type(int typeid)
 	hwloc_bitmap_zero(empty_bitmap);
 	return empty_bitmap;
 }
+
+int starpurm_get_event_stats(struct starpurm_event_stats *stats)
+{
+	assert(_starpurm != NULL);
+	assert(_starpurm->state != state_uninitialized);
+	memset(stats, 0, sizeof(*stats));
+#ifdef STARPURM_STARPU_HAVE_WORKER_CALLBACKS
+	struct s_starpurm *rm = _starpurm;
+	int i;
+	for (i=0; i<STARPU_NMAXWORKERS; i++)
+	{
+		stats->nnotified += rm->event_nnotified[i];
+		stats->ncoalesced += rm->event_ncoalesced[i];
+	}
+	stats->nnotified += rm->event_nnotified_units;
+	stats->ncoalesced += rm->event_ncoalesced_units;
+	stats->nprocessed = rm->event_nprocessed;
+	stats->nbatches = rm->event_nbatches;
+	stats->avg_latency = rm->event_nprocessed ? rm->event_total_latency / rm->event_nprocessed : 0.0;
+	stats->max_latency = rm->event_max_latency;
+	return 0;
+#else
+	return -ENODEV;
+#endif
+}
@@ -129,15 +129,38 @@ struct s_starpurm
 	/** Global StarPU pause state */
 	int starpu_in_pause;
 
-	/** Event list. */
+	/** Event processing. */
 	pthread_t event_thread;
 	starpu_pthread_mutex_t event_list_mutex;
 	starpu_pthread_cond_t event_list_cond;
 	starpu_pthread_cond_t event_processing_cond;
 	int event_processing_enabled;
 	int event_processing_ended;
-	struct s_starpurm_event *event_list_head;
-	struct s_starpurm_event *event_list_tail;
+
+	/** Lock-free ring of events, see s_starpurm_event */
+	struct s_starpurm_event *event_ring;
+	unsigned long event_ring_mask;
+	/** Next slot to be consumed, only accessed by the event thread */
+	unsigned long event_ring_head;
+	/** Next slot to be reserved by a producer */
+	volatile unsigned long event_ring_tail;
+	/** Whether the event thread is waiting on event_list_cond */
+	volatile int event_thread_waiting;
+
+	/** Last sleep/wake-up event not yet processed, per worker, 0 if none */
+	int *event_pending_state;
+	/** Whether a unit availability event is not yet processed, per worker */
+	int *event_pending_available;
+
+	/** Event statistics, see starpurm_get_event_stats() */
+	unsigned long *event_nnotified;
+	unsigned long *event_ncoalesced;
+	unsigned long event_nnotified_units;
+	unsigned long event_ncoalesced_units;
+	unsigned long event_nprocessed;
+	unsigned long event_nbatches;
+	double event_total_latency;
+	double event_max_latency;
 };
 
 
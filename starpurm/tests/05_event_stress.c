@@ -0,0 +1,126 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* This test spawns many short kernels on the CPU units, so that the workers
+ * keep going to sleep and waking up, and checks the statistics of the
+ * processing of the corresponding events. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <assert.h>
+#include <starpu.h>
+#include <starpurm.h>
+
+#define NSPAWNS 200
+#define NASYNC 4
+#define NTASKS 16
+
+static void dummy_func(void *buffers[], void *cl_arg)
+{
+	(void)buffers;
+	(void)cl_arg;
+}
+
+static struct starpu_codelet dummy_cl =
+{
+	.cpu_funcs = {dummy_func},
+	.nbuffers = 0
+};
+
+static void kernel(void *args)
+{
+	(void)args;
+	int i;
+	for (i = 0; i < NTASKS; i++)
+	{
+		int ret = starpu_task_insert(&dummy_cl, 0);
+		assert(ret == 0);
+	}
+	starpu_task_wait_for_all();
+}
+
+static starpu_pthread_mutex_t mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static starpu_pthread_cond_t cond = STARPU_PTHREAD_COND_INITIALIZER;
+static int nrunning;
+
+static void kernel_done(void *args)
+{
+	(void)args;
+	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
+	nrunning--;
+	STARPU_PTHREAD_COND_SIGNAL(&cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+}
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+	int i, j;
+	starpurm_initialize();
+
+	int cpu_type_id = starpurm_device_type_name_to_id("cpu");
+	if (starpurm_get_nb_devices_by_type(cpu_type_id) < 1)
+	{
+		starpurm_shutdown();
+		return 77;
+	}
+
+	hwloc_cpuset_t cpuset = starpurm_get_all_cpu_workers_cpuset();
+	double start = starpu_timing_now();
+	for (i = 0; i < NSPAWNS; i++)
+	{
+		if (i % 2)
+		{
+			starpurm_spawn_kernel_on_cpus(NULL, kernel, NULL, cpuset);
+			continue;
+		}
+
+		nrunning = NASYNC;
+		for (j = 0; j < NASYNC; j++)
+			starpurm_spawn_kernel_on_cpus_callback(NULL, kernel, NULL, hwloc_bitmap_dup(cpuset), kernel_done, NULL);
+		STARPU_PTHREAD_MUTEX_LOCK(&mutex);
+		while (nrunning > 0)
+			STARPU_PTHREAD_COND_WAIT(&cond, &mutex);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+	}
+	double end = starpu_timing_now();
+	hwloc_bitmap_free(cpuset);
+
+	struct starpurm_event_stats stats;
+	if (starpurm_get_event_stats(&stats) == -ENODEV)
+	{
+		/* StarPU does not notify the workers going to sleep */
+		starpurm_shutdown();
+		return 77;
+	}
+	printf("%d spawns in %.2f ms\n", NSPAWNS, (end-start)/1000.);
+	printf("%lu events notified, %lu coalesced, %lu processed in %lu batches\n",
+	       stats.nnotified, stats.ncoalesced, stats.nprocessed, stats.nbatches);
+	printf("event latency: %.2f us average, %.2f us max\n", stats.avg_latency, stats.max_latency);
+
+	/* the workers went to sleep between the spawns */
+	assert(stats.nnotified > 0);
+	assert(stats.nprocessed > 0);
+	/* each processed event corresponds to a notification which was not coalesced */
+	assert(stats.ncoalesced <= stats.nnotified);
+	assert(stats.nprocessed <= stats.nnotified - stats.ncoalesced);
+	assert(stats.nbatches <= stats.nprocessed);
+
+	starpurm_shutdown();
+	return 0;
+}
@@ -0,0 +1,176 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+#include <starpu.h>
+#include "../test_interfaces.h"
+#include "../../../helper.h"
+
+/* Rows of WIDTH entries, stored in slices of C rows sorted in windows of SIGMA rows */
+#define WIDTH   4
+#define HEIGHT  8
+#define C       4
+#define SIGMA   8
+#define NSLICES ((HEIGHT + C - 1) / C)
+#define NNZ     (WIDTH * HEIGHT)
+
+#ifdef STARPU_USE_CPU
+void test_sell_cpu_func(void *buffers[], void *args);
+#endif /* !STARPU_USE_CPU */
+
+static int nzval[NNZ];
+static int nzval2[NNZ];
+
+static uint32_t colind[NNZ];
+static uint32_t colind2[NNZ];
+
+static uint32_t sliceptr[NSLICES+1];
+static uint32_t sliceptr2[NSLICES+1];
+
+static uint32_t rowind[HEIGHT];
+static uint32_t rowind2[HEIGHT];
+
+static starpu_data_handle_t sell_handle;
+static starpu_data_handle_t sell2_handle;
+
+struct test_config sell_config =
+{
+#ifdef STARPU_USE_CPU
+	.cpu_func      = test_sell_cpu_func,
+#endif /* ! STARPU_USE_CPU */
+	.handle        = &sell_handle,
+	.ptr           = sliceptr,
+	.dummy_handle  = &sell2_handle,
+	.dummy_ptr     = sliceptr2,
+	.copy_failed   = SUCCESS,
+	.name          = "sell_interface"
+};
+
+static void
+register_data(void)
+{
+	int i;
+	for (i = 0; i < NNZ; i++)
+	{
+		nzval[i] = i+1;
+		nzval2[i] = 42;
+
+		colind[i] = (i / C) % WIDTH;
+		colind2[i] = colind[i];
+	}
+
+	for (i = 0; i <= NSLICES; i++)
+	{
+		sliceptr[i] = i * C * WIDTH;
+		sliceptr2[i] = sliceptr[i];
+	}
+
+	/* Rows are all of the same length, any order within the window is fine */
+	for (i = 0; i < HEIGHT; i++)
+	{
+		rowind[i] = HEIGHT - 1 - i;
+		rowind2[i] = rowind[i];
+	}
+
+	starpu_sell_data_register(&sell_handle,
+				  STARPU_MAIN_RAM,
+				  NNZ,
+				  HEIGHT,
+				  C,
+				  SIGMA,
+				  (uintptr_t) nzval,
+				  colind,
+				  sliceptr,
+				  rowind,
+				  0,
+				  sizeof(nzval[0]));
+	starpu_sell_data_register(&sell2_handle,
+				  STARPU_MAIN_RAM,
+				  NNZ,
+				  HEIGHT,
+				  C,
+				  SIGMA,
+				  (uintptr_t) nzval2,
+				  colind2,
+				  sliceptr2,
+				  rowind2,
+				  0,
+				  sizeof(nzval2[0]));
+}
+
+static void
+unregister_data(void)
+{
+	starpu_data_unregister(sell_handle);
+	starpu_data_unregister(sell2_handle);
+}
+
+void
+test_sell_cpu_func(void *buffers[], void *args)
+{
+	STARPU_SKIP_IF_VALGRIND;
+
+	int *val;
+	int factor;
+	int i;
+
+	uint32_t nnz = STARPU_SELL_GET_NNZ(buffers[0]);
+	uint32_t nrow = STARPU_SELL_GET_NROW(buffers[0]);
+	uint32_t *sliceptr_local = STARPU_SELL_GET_SLICEPTR(buffers[0]);
+	uint32_t *rowind_local = STARPU_SELL_GET_ROWIND(buffers[0]);
+	val = (int *) STARPU_SELL_GET_NZVAL(buffers[0]);
+	factor = *(int *) args;
+
+	if (sliceptr_local[NSLICES] != NNZ || rowind_local[0] != HEIGHT - 1 || nrow != HEIGHT)
+	{
+		sell_config.copy_failed = FAILURE;
+		return;
+	}
+
+	for (i = 0; i < (int)nnz; i++)
+	{
+		if (val[i] != (i+1) * factor)
+		{
+			sell_config.copy_failed = FAILURE;
+			return;
+		}
+		val[i] *= -1;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct data_interface_test_summary summary;
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+
+	conf.ncuda = 0;
+	conf.nopencl = 0;
+
+	int ret = starpu_initialize(&conf, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	register_data();
+
+	ret = run_tests(&sell_config, &summary);
+
+	unregister_data();
+
+	starpu_shutdown();
+
+	if (ret) data_interface_test_summary_print(stderr, &summary);
+
+	return data_interface_test_summary_success(&summary);
+}
@@ -0,0 +1,150 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include "../helper.h"
+
+/*
+ * Run tasks with the lookahead prefetch engine enabled, with a small window
+ * and a small budget, with schedulers which prefetch on push, and with the
+ * work stealing scheduler, whose tasks get stolen.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NDATA	16
+#define NITER	4
+#else
+#define NDATA	64
+#define NITER	16
+#endif
+#define NX	(64*1024)
+
+void scale_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	int *src = (int *) STARPU_VECTOR_GET_PTR(descr[0]);
+	int *dst = (int *) STARPU_VECTOR_GET_PTR(descr[1]);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		dst[i] += 2*src[i];
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {scale_cpu},
+	.cpu_funcs_name = {"scale_cpu"},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_RW},
+};
+
+static int run(const char *sched)
+{
+	starpu_data_handle_t src_handle[NDATA], dst_handle[NDATA];
+	int *src[NDATA], *dst[NDATA];
+	struct starpu_conf conf;
+	unsigned i, j, iter;
+	int ret;
+
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = sched;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_malloc((void **) &src[i], NX * sizeof(int));
+		starpu_malloc((void **) &dst[i], NX * sizeof(int));
+		for (j = 0; j < NX; j++)
+		{
+			src[i][j] = i + j;
+			dst[i][j] = 0;
+		}
+		starpu_vector_data_register(&src_handle[i], STARPU_MAIN_RAM, (uintptr_t) src[i], NX, sizeof(int));
+		starpu_vector_data_register(&dst_handle[i], STARPU_MAIN_RAM, (uintptr_t) dst[i], NX, sizeof(int));
+	}
+
+	for (iter = 0; iter < NITER; iter++)
+		for (i = 0; i < NDATA; i++)
+		{
+			ret = starpu_task_insert(&cl,
+						 STARPU_R, src_handle[i],
+						 STARPU_RW, dst_handle[i],
+						 STARPU_PRIORITY, (int) (i % 3) - 1,
+						 0);
+			if (ret == -ENODEV)
+				goto enodev;
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_data_unregister(src_handle[i]);
+		starpu_data_unregister(dst_handle[i]);
+		for (j = 0; j < NX; j++)
+			if (dst[i][j] != (int) (2*NITER*(i+j)))
+			{
+				FPRINTF(stderr, "%s: dst[%u][%u] is %d instead of %d\n", sched, i, j, dst[i][j], (int) (2*NITER*(i+j)));
+				ret = EXIT_FAILURE;
+				break;
+			}
+		starpu_free_noflag(src[i], NX * sizeof(int));
+		starpu_free_noflag(dst[i], NX * sizeof(int));
+	}
+
+	starpu_shutdown();
+	return ret;
+
+enodev:
+	starpu_task_wait_for_all();
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_data_unregister(src_handle[i]);
+		starpu_data_unregister(dst_handle[i]);
+		starpu_free_noflag(src[i], NX * sizeof(int));
+		starpu_free_noflag(dst[i], NX * sizeof(int));
+	}
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+int main(void)
+{
+	static const char *scheds[] = { "dmda", "ws", "lws", "modular-heft" };
+	unsigned i;
+	int ret = EXIT_SUCCESS;
+
+	setenv("STARPU_PREFETCH_LOOKAHEAD", "2", 1);
+	/* 1MiB, i.e. a couple of tasks only */
+	setenv("STARPU_PREFETCH_LOOKAHEAD_SIZE", "1", 1);
+
+	for (i = 0; i < sizeof(scheds)/sizeof(scheds[0]); i++)
+	{
+		ret = run(scheds[i]);
+		if (ret != EXIT_SUCCESS)
+			break;
+	}
+
+	return ret;
+}
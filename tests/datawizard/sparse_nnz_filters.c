@@ -0,0 +1,169 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Partition a CSR and a BCSR matrix whose first row holds most of the
+ * non-zero entries with the nnz-balanced filters, and check that the parts
+ * cover the matrix, contain about the same number of non-zero entries, and
+ * see the right values.
+ */
+
+#define NROWS	64
+#define NPARTS	4
+/* Number of non-zero entries of the first row */
+#define DENSE	(2*NROWS)
+#define NNZ	(DENSE + NROWS - 1)
+
+static int nzval[NNZ];
+static uint32_t colind[NNZ];
+static uint32_t rowptr[NROWS+1];
+
+/* Check that the values of the part are the ones of its rows */
+void check_csr_cpu(void *descr[], void *arg)
+{
+	int *nzval_part = (int *)STARPU_CSR_GET_NZVAL(descr[0]);
+	uint32_t *rowptr_part = STARPU_CSR_GET_ROWPTR(descr[0]);
+	uint32_t nnz_part = STARPU_CSR_GET_NNZ(descr[0]);
+	uint32_t first_row;
+	uint32_t i;
+
+	starpu_codelet_unpack_args(arg, &first_row);
+	STARPU_ASSERT(rowptr_part[0] == rowptr[first_row]);
+	for (i = 0; i < nnz_part; i++)
+		STARPU_ASSERT(nzval_part[i] == (int) (rowptr[first_row] + i));
+}
+
+struct starpu_codelet check_csr_cl =
+{
+	.cpu_funcs = { check_csr_cpu },
+	.nbuffers = 1,
+	.modes = { STARPU_R },
+};
+
+static void check_parts(starpu_data_handle_t handle, uint32_t (*get_nrow)(starpu_data_handle_t), uint32_t (*get_nnz)(starpu_data_handle_t), struct starpu_codelet *cl)
+{
+	unsigned part;
+	uint32_t nrow = 0, nnz = 0;
+
+	for (part = 0; part < NPARTS; part++)
+	{
+		starpu_data_handle_t sub_handle = starpu_data_get_sub_data(handle, 1, part);
+		size_t part_nrow, offset;
+		uint32_t first_row = nrow;
+
+		starpu_filter_nparts_compute_nnz_chunk_size_and_offset(rowptr, NROWS, NPARTS, part, &part_nrow, &offset);
+		STARPU_ASSERT(offset == nrow);
+		STARPU_ASSERT(part_nrow == get_nrow(sub_handle));
+		STARPU_ASSERT(get_nrow(sub_handle) >= 1);
+
+		FPRINTF(stderr, "part %u: %u rows, %u non-zero entries\n", part, get_nrow(sub_handle), get_nnz(sub_handle));
+
+		/* The first part is the dense row, the others share the rest */
+		if (part == 0)
+			STARPU_ASSERT(get_nrow(sub_handle) == 1);
+		else
+			STARPU_ASSERT(get_nnz(sub_handle) >= (NROWS - 1) / (NPARTS - 1) - 1 && get_nnz(sub_handle) <= (NROWS - 1) / (NPARTS - 1) + 2);
+
+		nrow += get_nrow(sub_handle);
+		nnz += get_nnz(sub_handle);
+
+		if (cl)
+		{
+			int ret = starpu_task_insert(cl, STARPU_R, sub_handle, STARPU_VALUE, &first_row, sizeof(first_row), 0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	}
+	STARPU_ASSERT(nrow == NROWS);
+	STARPU_ASSERT(nnz == NNZ);
+}
+
+int main(int argc, char **argv)
+{
+	starpu_data_handle_t handle;
+	uint32_t row, i, pos;
+	int ret;
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_initialize(&conf, &argc, &argv);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* The first row is dense, the others have one entry */
+	for (row = 0, pos = 0; row < NROWS; row++)
+	{
+		uint32_t row_nnz = row == 0 ? DENSE : 1;
+		rowptr[row] = pos;
+		for (i = 0; i < row_nnz; i++)
+		{
+			nzval[pos] = pos;
+			colind[pos] = i;
+			pos++;
+		}
+	}
+	rowptr[NROWS] = pos;
+	STARPU_ASSERT(pos == NNZ);
+
+	/* CSR */
+	{
+		struct starpu_data_filter filter =
+		{
+			.filter_func = starpu_csr_filter_vertical_block_nnz,
+			.nchildren = NPARTS,
+		};
+
+		starpu_csr_data_register(&handle, STARPU_MAIN_RAM, NNZ, NROWS, (uintptr_t) nzval, colind, rowptr, 0, sizeof(nzval[0]));
+		starpu_data_partition(handle, &filter);
+		check_parts(handle, starpu_csr_get_nrow, starpu_csr_get_nnz, &check_csr_cl);
+		starpu_data_unpartition(handle, STARPU_MAIN_RAM);
+		starpu_data_unregister(handle);
+	}
+
+	/* BCSR, with 1x1 blocks */
+	{
+		struct starpu_data_filter filter =
+		{
+			.filter_func = starpu_bcsr_filter_vertical_block_nnz,
+			.nchildren = NPARTS,
+		};
+
+		starpu_bcsr_data_register(&handle, STARPU_MAIN_RAM, NNZ, NROWS, (uintptr_t) nzval, colind, rowptr, 0, 1, 1, sizeof(nzval[0]));
+		starpu_data_partition(handle, &filter);
+		check_parts(handle, starpu_bcsr_get_nrow, starpu_bcsr_get_nnz, NULL);
+		starpu_data_unpartition(handle, STARPU_MAIN_RAM);
+		starpu_data_unregister(handle);
+	}
+
+	starpu_shutdown();
+
+	return 0;
+}
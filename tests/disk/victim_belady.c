@@ -0,0 +1,189 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Read data cyclically out of core, with more data than what the RAM can fit,
+ * which is the worst case for LRU eviction, and compare the amount of data
+ * read back from the disk with the LRU and the belady victim selectors.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define NDATA 8
+#  define NITER 4
+#else
+#  define NDATA 16
+#  define NITER 16
+#endif
+#  define MEMSIZE 1
+#  define MEMSIZE_STR "1"
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static void fill(void *buffers[], void *args)
+{
+	unsigned *val = (unsigned*) STARPU_VECTOR_GET_PTR(buffers[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(buffers[0]);
+	unsigned i, j;
+	starpu_codelet_unpack_args(args, &i);
+	for (j = 0; j < n; j++)
+		val[j] = i;
+}
+
+static void check(void *buffers[], void *args)
+{
+	unsigned *val = (unsigned*) STARPU_VECTOR_GET_PTR(buffers[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(buffers[0]);
+	unsigned i;
+	starpu_codelet_unpack_args(args, &i);
+	STARPU_ASSERT_MSG(val[0] == i && val[n-1] == i, "Incorrect value. Value %u should be %u", val[0], i);
+}
+
+static struct starpu_codelet fill_cl =
+{
+	.cpu_funcs = { fill },
+	.nbuffers = 1,
+	.modes = { STARPU_W },
+};
+
+static struct starpu_codelet check_cl =
+{
+	.cpu_funcs = { check },
+	.nbuffers = 1,
+	.modes = { STARPU_R },
+};
+
+static int dotest(char *base, const char *selector, long long *read_bytes)
+{
+	starpu_data_handle_t handles[NDATA];
+	unsigned i, iter;
+	int ret;
+
+	setenv("STARPU_VICTIM_SELECTOR", selector, 1);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	/* A single worker, so that the queued tasks give the exact future */
+	conf.ncpus = 1;
+	conf.sched_policy_name = "dmda";
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+
+	int disk = starpu_disk_register(&starpu_disk_unistd_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	if (disk == -ENOENT)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Twice as much data as available memory */
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_vector_data_register(&handles[i], -1, 0, (MEMSIZE*1024*1024*2) / NDATA / sizeof(unsigned), sizeof(unsigned));
+		ret = starpu_task_insert(&fill_cl, STARPU_W, handles[i], STARPU_VALUE, &i, sizeof(i), 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	int busid = starpu_bus_get_id(disk, STARPU_MAIN_RAM);
+	struct starpu_profiling_bus_info info;
+	starpu_profiling_status_set(STARPU_PROFILING_ENABLE);
+	/* Reset the counters */
+	starpu_bus_get_profiling_info(busid, &info);
+
+	starpu_pause();
+	for (iter = 0; iter < NITER; iter++)
+		for (i = 0; i < NDATA; i++)
+		{
+			ret = starpu_task_insert(&check_cl, STARPU_R, handles[i], STARPU_VALUE, &i, sizeof(i), 0);
+			if (ret == -ENODEV) goto enodev_paused;
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	starpu_bus_get_profiling_info(busid, &info);
+	*read_bytes = info.transferred_bytes;
+	starpu_profiling_status_set(STARPU_PROFILING_DISABLE);
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enodev_paused:
+	starpu_resume();
+enodev:
+	starpu_task_wait_for_all();
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+int main(void)
+{
+	long long lru = 0, belady = 0;
+	int ret, ret2;
+	char s[128];
+	char *ptr;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	setenv("STARPU_LIMIT_CPU_MEM", MEMSIZE_STR, 1);
+
+	ret = dotest(s, "lru", &lru);
+	if (ret == EXIT_SUCCESS)
+		ret = dotest(s, "belady", &belady);
+
+	if (ret == EXIT_SUCCESS)
+		FPRINTF(stderr, "read from disk: lru %lld bytes, belady %lld bytes\n", lru, belady);
+
+	ret2 = rmdir(s);
+	STARPU_CHECK_RETURN_VALUE(ret2, "rmdir '%s'\n", s);
+
+	return ret;
+}
+#endif
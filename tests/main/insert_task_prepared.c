@@ -0,0 +1,163 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2010-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit tasks through a prepared insertion descriptor, and check that
+ * handles and values reach the codelet as with starpu_task_insert
+ */
+
+#define NTASKS 16
+#define FFACTOR 2.0f
+
+void func_cpu(void *descr[], void *_args)
+{
+	int *x0 = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	float *x1 = (float *)STARPU_VARIABLE_GET_PTR(descr[1]);
+	int ifactor;
+	float ffactor;
+
+	starpu_codelet_unpack_args(_args, &ifactor, &ffactor);
+
+	*x0 = *x0 * ifactor;
+	*x1 = *x1 * ffactor;
+}
+
+struct starpu_codelet mycodelet =
+{
+	.cpu_funcs = {func_cpu},
+	.cpu_funcs_name = {"func_cpu"},
+	.nbuffers = 2,
+	.modes = {STARPU_RW, STARPU_RW}
+};
+
+void func_cpu_variable(void *descr[], void *_args)
+{
+	int nbuffers = STARPU_TASK_GET_NBUFFERS(starpu_task_get_current());
+	int i;
+	(void)_args;
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		int *x = (int *)STARPU_VARIABLE_GET_PTR(descr[i]);
+		*x = *x + 1;
+	}
+}
+
+struct starpu_codelet mycodelet_variable =
+{
+	.cpu_funcs = {func_cpu_variable},
+	.cpu_funcs_name = {"func_cpu_variable"},
+	.nbuffers = STARPU_VARIABLE_NBUFFERS,
+};
+
+int main(void)
+{
+	int x[NTASKS];
+	float f[NTASKS];
+	starpu_data_handle_t xh[NTASKS], fh[NTASKS];
+	struct starpu_task_insert_prepared *prepared;
+	int i, ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		x[i] = 1;
+		f[i] = 1.0f;
+		starpu_variable_data_register(&xh[i], STARPU_MAIN_RAM, (uintptr_t)&x[i], sizeof(x[i]));
+		starpu_variable_data_register(&fh[i], STARPU_MAIN_RAM, (uintptr_t)&f[i], sizeof(f[i]));
+	}
+
+	prepared = starpu_task_insert_prepare(&mycodelet,
+					      STARPU_RW, STARPU_RW,
+					      STARPU_VALUE, sizeof(int),
+					      STARPU_VALUE, sizeof(float),
+					      STARPU_NAME, "prepared",
+					      0);
+	STARPU_ASSERT(prepared);
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		float ffactor = FFACTOR;
+		starpu_data_handle_t handles[2] = { xh[i], fh[i] };
+		void *values[2] = { &i, &ffactor };
+		ret = starpu_task_insert_prepared_submit(prepared, handles, values);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert_prepared_submit");
+	}
+	starpu_task_insert_prepared_destroy(prepared);
+
+	/* Variable number of buffers, the modes are stored in the tasks */
+	prepared = starpu_task_insert_prepare(&mycodelet_variable, STARPU_RW, STARPU_R|STARPU_W, STARPU_RW, 0);
+	STARPU_ASSERT(prepared);
+	for (i = 0; i+2 < NTASKS; i++)
+	{
+		starpu_data_handle_t handles[3] = { xh[i], xh[i+1], xh[i+2] };
+		ret = starpu_task_insert_prepared_submit(prepared, handles, NULL);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert_prepared_submit");
+	}
+	starpu_task_insert_prepared_destroy(prepared);
+
+	/* Unsupported arguments are rejected */
+	prepared = starpu_task_insert_prepare(&mycodelet, STARPU_RW, STARPU_RW, STARPU_TAG, (starpu_tag_t) 42, 0);
+	STARPU_ASSERT(prepared == NULL);
+
+	starpu_task_wait_for_all();
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		starpu_data_unregister(xh[i]);
+		starpu_data_unregister(fh[i]);
+	}
+	starpu_shutdown();
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		/* Multiplied by i, then incremented by each task of the second series accessing it */
+		int j, expected = i;
+		for (j = i-2; j <= i; j++)
+			if (j >= 0 && j+2 < NTASKS)
+				expected++;
+		if (x[i] != expected || f[i] != FFACTOR)
+		{
+			FPRINTF(stderr, "Incorrect value x[%d] = %d (expected %d), f[%d] = %f (expected %f)\n", i, x[i], expected, i, f[i], FFACTOR);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+
+enodev:
+	for (i = 0; i < NTASKS; i++)
+	{
+		starpu_data_unregister(xh[i]);
+		starpu_data_unregister(fh[i]);
+	}
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
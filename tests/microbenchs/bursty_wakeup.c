@@ -0,0 +1,192 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit bursts of short tasks separated by idle periods, so that the workers
+ * go idle between the bursts, with and without worker parking
+ * (STARPU_WORKER_PARKING), and measure the time to process a burst, as well as
+ * the wake-up counters of the workers.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned nbursts = 20;
+#else
+static unsigned nbursts = 200;
+#endif
+/* Idle time between bursts (us) */
+static unsigned idle = 1000;
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static unsigned executed;
+
+static int id_w_total_wakeups;
+static int id_w_total_parked;
+static int id_w_cumul_wakeup_latency;
+
+static int64_t total_wakeups[STARPU_NMAXWORKERS];
+static int64_t total_parked[STARPU_NMAXWORKERS];
+static double cumul_wakeup_latency[STARPU_NMAXWORKERS];
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+	(void) STARPU_ATOMIC_ADD(&executed, 1);
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = NULL,
+	.nbuffers = 0,
+};
+
+static void w_listener_cb(struct starpu_perf_counter_listener *listener, struct starpu_perf_counter_sample *sample, void *context)
+{
+	(void) listener;
+	(void) context;
+	int workerid = starpu_worker_get_id();
+	if (workerid < 0)
+		return;
+	/* The values are cumulated since initialization, keep the last ones */
+	total_wakeups[workerid] = starpu_perf_counter_sample_get_int64_value(sample, id_w_total_wakeups);
+	total_parked[workerid] = starpu_perf_counter_sample_get_int64_value(sample, id_w_total_parked);
+	cumul_wakeup_latency[workerid] = starpu_perf_counter_sample_get_double_value(sample, id_w_cumul_wakeup_latency);
+}
+
+static int dotest(const char *parking)
+{
+	const enum starpu_perf_counter_scope w_scope = starpu_perf_counter_scope_per_worker;
+	struct starpu_conf conf;
+	unsigned burst, i, nworkers;
+	int64_t wakeups = 0, parked = 0;
+	double latency = 0., start, elapsed = 0.;
+	int ret;
+
+	setenv("STARPU_WORKER_PARKING", parking, 1);
+
+	starpu_conf_init(&conf);
+	conf.start_perf_counter_collection = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nworkers = starpu_worker_get_count();
+	memset(total_wakeups, 0, sizeof(total_wakeups));
+	memset(total_parked, 0, sizeof(total_parked));
+	memset(cumul_wakeup_latency, 0, sizeof(cumul_wakeup_latency));
+	executed = 0;
+
+	id_w_total_wakeups = starpu_perf_counter_name_to_id(w_scope, "starpu.worker.w_total_wakeups");
+	id_w_total_parked = starpu_perf_counter_name_to_id(w_scope, "starpu.worker.w_total_parked");
+	id_w_cumul_wakeup_latency = starpu_perf_counter_name_to_id(w_scope, "starpu.worker.w_cumul_wakeup_latency");
+	STARPU_ASSERT(id_w_total_wakeups != -1 && id_w_total_parked != -1 && id_w_cumul_wakeup_latency != -1);
+
+	struct starpu_perf_counter_set *w_set = starpu_perf_counter_set_alloc(w_scope);
+	STARPU_ASSERT(w_set != NULL);
+	starpu_perf_counter_set_enable_id(w_set, id_w_total_wakeups);
+	starpu_perf_counter_set_enable_id(w_set, id_w_total_parked);
+	starpu_perf_counter_set_enable_id(w_set, id_w_cumul_wakeup_latency);
+	struct starpu_perf_counter_listener *w_listener = starpu_perf_counter_listener_init(w_set, w_listener_cb, NULL);
+	starpu_perf_counter_set_all_per_worker_listeners(w_listener);
+
+	for (burst = 0; burst < nbursts; burst++)
+	{
+		/* Let the workers go idle */
+		usleep(idle);
+
+		start = starpu_timing_now();
+		for (i = 0; i < nworkers; i++)
+		{
+			struct starpu_task *task = starpu_task_create();
+			task->cl = &dummy_codelet;
+			ret = starpu_task_submit(task);
+			if (ret == -ENODEV)
+			{
+				task->destroy = 0;
+				starpu_task_destroy(task);
+				goto enodev;
+			}
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		}
+		ret = starpu_task_wait_for_all();
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+		elapsed += starpu_timing_now() - start;
+	}
+
+	starpu_perf_counter_unset_all_per_worker_listeners();
+	starpu_perf_counter_listener_exit(w_listener);
+	starpu_perf_counter_set_disable_id(w_set, id_w_cumul_wakeup_latency);
+	starpu_perf_counter_set_disable_id(w_set, id_w_total_parked);
+	starpu_perf_counter_set_disable_id(w_set, id_w_total_wakeups);
+	starpu_perf_counter_set_free(w_set);
+
+	starpu_shutdown();
+
+	if (executed != nbursts * nworkers)
+	{
+		FPRINTF(stderr, "%u tasks were executed instead of %u\n", executed, nbursts * nworkers);
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < nworkers; i++)
+	{
+		wakeups += total_wakeups[i];
+		parked += total_parked[i];
+		latency += cumul_wakeup_latency[i];
+	}
+
+	FPRINTF(stderr, "STARPU_WORKER_PARKING=%s: %u bursts of %u tasks, %.2f usecs per burst, %"PRId64" wake-ups (%.2f usecs on average), %"PRId64" parkings\n",
+		parking, nbursts, nworkers, elapsed / nbursts, wakeups, wakeups ? latency / wakeups : 0., parked);
+
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_task_wait_for_all();
+	starpu_perf_counter_unset_all_per_worker_listeners();
+	starpu_perf_counter_listener_exit(w_listener);
+	starpu_perf_counter_set_free(w_set);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+int main(void)
+{
+	int ret;
+
+	ret = dotest("0");
+	if (ret == EXIT_SUCCESS)
+		ret = dotest("1");
+
+	return ret;
+}
+#endif
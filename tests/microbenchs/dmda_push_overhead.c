@@ -0,0 +1,156 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the time the dm and dmda family of schedulers take to push
+ * independent tasks which have a performance model and read some data, with
+ * and without computing the predictions once per class of workers
+ * (STARPU_SCHED_MEMOIZE_PREDICTIONS).
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ntasks = 256;
+#else
+static unsigned ntasks = 16384;
+#endif
+
+#define NBUFFERS 4
+#define BUFFERSIZE 16
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static const char *policies[] = { "dm", "dmda", "dmdas", "dmdar" };
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static double cost_function(struct starpu_task *task, unsigned nimpl)
+{
+	(void)task;
+	(void)nimpl;
+	return 10.;
+}
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_COMMON,
+	.cost_function = cost_function,
+	.symbol = "dmda_push_overhead"
+};
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cuda_funcs = {dummy_func},
+	.opencl_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = &model,
+	.nbuffers = NBUFFERS,
+	.modes = {STARPU_R, STARPU_R, STARPU_R, STARPU_R}
+};
+
+static int dotest(const char *policy, const char *memoize)
+{
+	struct starpu_conf conf;
+	starpu_data_handle_t handles[NBUFFERS];
+	float buffers[NBUFFERS][BUFFERSIZE];
+	unsigned i, buffer;
+	double start, timing;
+	int ret;
+
+	setenv("STARPU_SCHED_MEMOIZE_PREDICTIONS", memoize, 1);
+
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = policy;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (buffer = 0; buffer < NBUFFERS; buffer++)
+		starpu_vector_data_register(&handles[buffer], STARPU_MAIN_RAM, (uintptr_t)buffers[buffer], BUFFERSIZE, sizeof(float));
+
+	/* Do not let the workers run the tasks while we push them */
+	starpu_pause();
+
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &dummy_codelet;
+		for (buffer = 0; buffer < NBUFFERS; buffer++)
+			task->handles[buffer] = handles[buffer];
+		ret = starpu_task_submit(task);
+		if (ret == -ENODEV)
+		{
+			task->destroy = 0;
+			starpu_task_destroy(task);
+			starpu_resume();
+			goto enodev;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+	timing = starpu_timing_now() - start;
+
+	starpu_resume();
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+
+	FPRINTF(stderr, "%s with STARPU_SCHED_MEMOIZE_PREDICTIONS=%s, %u workers: %f usecs per task push\n",
+		policy, memoize, starpu_worker_get_count(), timing / ntasks);
+
+	for (buffer = 0; buffer < NBUFFERS; buffer++)
+		starpu_data_unregister(handles[buffer]);
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_task_wait_for_all();
+	for (buffer = 0; buffer < NBUFFERS; buffer++)
+		starpu_data_unregister(handles[buffer]);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+int main(void)
+{
+	unsigned i;
+	int ret = EXIT_SUCCESS;
+
+	for (i = 0; ret == EXIT_SUCCESS && i < sizeof(policies)/sizeof(policies[0]); i++)
+	{
+		ret = dotest(policies[i], "0");
+		if (ret == EXIT_SUCCESS)
+			ret = dotest(policies[i], "1");
+	}
+
+	return ret;
+}
+#endif
@@ -0,0 +1,170 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2009-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the latency of starpu_malloc_on_node_flags for large tiles, and the
+ * time to access the tiles page by page in random order (which is dominated by
+ * TLB misses), without and with the allocation pool and huge pages
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned niter = 4;
+static unsigned ntiles = 4;
+#else
+static unsigned niter = 32;
+static unsigned ntiles = 16;
+#endif
+/* 960x960 double tile */
+static size_t tile_size = 960*960*sizeof(double);
+
+#define PAGE_SIZE 4096
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "Usage: %s [-i niter] [-n ntiles] [-s tile_size] [-h]\n", argv[0]);
+	exit(EXIT_FAILURE);
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:n:s:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			niter = atoi(optarg);
+			break;
+		case 'n':
+			ntiles = atoi(optarg);
+			break;
+		case 's':
+			tile_size = atol(optarg);
+			break;
+		case 'h':
+			usage(argv);
+			break;
+	}
+}
+
+static int bench(const char *name, double *alloc_time, double *access_time)
+{
+	uintptr_t *tiles;
+	unsigned *order;
+	size_t npages = tile_size / PAGE_SIZE;
+	unsigned iter, tile, n;
+	double start, end;
+	int ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	tiles = calloc(ntiles, sizeof(*tiles));
+	order = malloc(ntiles * npages * sizeof(*order));
+	/* Random order of the pages of all tiles */
+	for (n = 0; n < ntiles * npages; n++)
+		order[n] = n;
+	for (n = ntiles * npages - 1; n > 0; n--)
+	{
+		unsigned j = starpu_lrand48() % (n+1);
+		unsigned tmp = order[n];
+		order[n] = order[j];
+		order[j] = tmp;
+	}
+
+	*alloc_time = 0.;
+	*access_time = 0.;
+	for (iter = 0; iter < niter; iter++)
+	{
+		start = starpu_timing_now();
+		for (tile = 0; tile < ntiles; tile++)
+		{
+			tiles[tile] = starpu_malloc_on_node_flags(STARPU_MAIN_RAM, tile_size, STARPU_MALLOC_COUNT);
+			STARPU_ASSERT(tiles[tile]);
+		}
+		end = starpu_timing_now();
+		*alloc_time += end - start;
+
+		/* First touch */
+		for (tile = 0; tile < ntiles; tile++)
+			memset((void*) tiles[tile], 0, tile_size);
+
+		start = starpu_timing_now();
+		for (n = 0; n < ntiles * npages; n++)
+		{
+			unsigned page = order[n];
+			char *ptr = (char*) tiles[page / npages] + (page % npages) * PAGE_SIZE;
+			(*ptr)++;
+		}
+		end = starpu_timing_now();
+		*access_time += end - start;
+
+		start = starpu_timing_now();
+		for (tile = 0; tile < ntiles; tile++)
+			starpu_free_on_node_flags(STARPU_MAIN_RAM, tiles[tile], tile_size, STARPU_MALLOC_COUNT);
+		end = starpu_timing_now();
+		*alloc_time += end - start;
+	}
+
+	{
+		struct starpu_malloc_pool_stats stats;
+		if (starpu_malloc_pool_get_stats(STARPU_MAIN_RAM, &stats) == 0)
+			FPRINTF(stderr, "%s: pool hits %lu misses %lu\n", name, stats.hits, stats.misses);
+	}
+
+	free(order);
+	free(tiles);
+	starpu_shutdown();
+
+	*alloc_time /= niter * ntiles;
+	*access_time /= niter * ntiles * npages;
+	FPRINTF(stderr, "%s: %f usecs per allocation and deallocation, %f nsecs per page access\n", name, *alloc_time, *access_time * 1000.);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	double alloc_default, access_default;
+	double alloc_pool, access_pool;
+	char pool_size[32];
+	int ret;
+
+	parse_args(argc, argv);
+
+	FPRINTF(stderr, "#tiles : %u\n#size : %lu\n", ntiles, (unsigned long) tile_size);
+
+	setenv("STARPU_MALLOC_POOL", "0", 1);
+	setenv("STARPU_MALLOC_HUGEPAGES", "0", 1);
+	ret = bench("default", &alloc_default, &access_default);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+
+	snprintf(pool_size, sizeof(pool_size), "%lu", (unsigned long) ((ntiles * tile_size) >> 20) + 1);
+	setenv("STARPU_MALLOC_POOL", pool_size, 1);
+	setenv("STARPU_MALLOC_HUGEPAGES", "1", 1);
+	ret = bench("pool+hugepages", &alloc_pool, &access_pool);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+
+	FPRINTF(stderr, "allocation speedup: %f\n", alloc_default / alloc_pool);
+	FPRINTF(stderr, "access speedup: %f\n", access_default / access_pool);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit short tasks from several application threads at the same time, which
+ * stresses the accounting of the submitted and ready tasks, while other
+ * threads wait for the number of submitted tasks to go down, and measure the
+ * time per task.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ntasks = 1024;
+#else
+static unsigned ntasks = 65536;
+#endif
+static unsigned nthreads = 4;
+
+#define MAXTHREADS 64
+
+static unsigned executed;
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+	(void) STARPU_ATOMIC_ADD(&executed, 1);
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = NULL,
+	.nbuffers = 0,
+};
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "Usage: %s [-i ntasks] [-t nthreads] [-p sched_policy] [-h]\n", argv[0]);
+	exit(EXIT_FAILURE);
+}
+
+static void parse_args(int argc, char **argv, struct starpu_conf *conf)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:t:p:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			ntasks = atoi(optarg);
+			break;
+		case 't':
+			nthreads = atoi(optarg);
+			if (nthreads > MAXTHREADS)
+				nthreads = MAXTHREADS;
+			break;
+		case 'p':
+			conf->sched_policy_name = optarg;
+			break;
+		case 'h':
+			usage(argv);
+			break;
+	}
+}
+
+static void *submitter(void *arg)
+{
+	unsigned i, n = ntasks / nthreads;
+	int ret;
+	(void)arg;
+
+	for (i = 0; i < n; i++)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &dummy_codelet;
+		ret = starpu_task_submit(task);
+		if (ret == -ENODEV)
+		{
+			task->destroy = 0;
+			starpu_task_destroy(task);
+			return (void *) (uintptr_t) ret;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+
+		/* Throttle the submission, which makes the waiters use the threshold */
+		if (i % 1024 == 1023)
+			starpu_task_wait_for_n_submitted(512 * nthreads);
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	starpu_pthread_t threads[MAXTHREADS];
+	unsigned t;
+	int ret, enodev = 0;
+	double start, end;
+	struct starpu_conf conf;
+
+	starpu_conf_init(&conf);
+	parse_args(argc, argv, &conf);
+
+	ret = starpu_initialize(&conf, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	start = starpu_timing_now();
+	for (t = 0; t < nthreads; t++)
+		STARPU_PTHREAD_CREATE(&threads[t], NULL, submitter, NULL);
+	for (t = 0; t < nthreads; t++)
+	{
+		void *retval;
+		STARPU_PTHREAD_JOIN(threads[t], &retval);
+		if (retval)
+			enodev = 1;
+	}
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	end = starpu_timing_now();
+
+	starpu_shutdown();
+
+	if (enodev)
+		return STARPU_TEST_SKIPPED;
+
+	if (executed != (ntasks / nthreads) * nthreads)
+	{
+		FPRINTF(stderr, "%u tasks were executed instead of %u\n", executed, (ntasks / nthreads) * nthreads);
+		return EXIT_FAILURE;
+	}
+
+	FPRINTF(stderr, "%u threads submitted %u tasks in %.2f ms, %.2f usecs per task\n",
+		nthreads, executed, (end - start) / 1000., (end - start) / executed);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2009-2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Compare the submission time of tasks inserted with starpu_task_insert and
+ * with a prepared insertion descriptor
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ntasks = 128;
+#else
+static unsigned ntasks = 65536;
+#endif
+static unsigned nbuffers = 1;
+
+#define BUFFERSIZE 16
+#define MAXBUFFERS 8
+
+starpu_data_handle_t data_handles[MAXBUFFERS];
+float *buffers[MAXBUFFERS];
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cuda_funcs = {dummy_func},
+	.opencl_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = NULL,
+	.nbuffers = STARPU_VARIABLE_NBUFFERS,
+};
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "Usage: %s [-i ntasks] [-p sched_policy] [-b nbuffers] [-h]\n", argv[0]);
+	exit(EXIT_FAILURE);
+}
+
+static void parse_args(int argc, char **argv, struct starpu_conf *conf)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:b:p:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			ntasks = atoi(optarg);
+			break;
+		case 'b':
+			nbuffers = atoi(optarg);
+			if (nbuffers > MAXBUFFERS)
+				nbuffers = MAXBUFFERS;
+			break;
+		case 'p':
+			conf->sched_policy_name = optarg;
+			break;
+		case 'h':
+			usage(argv);
+			break;
+	}
+}
+
+static int submit_insert(void)
+{
+	struct starpu_data_descr descrs[MAXBUFFERS];
+	unsigned i, buffer;
+	int ret;
+
+	for (buffer = 0; buffer < nbuffers; buffer++)
+	{
+		descrs[buffer].handle = data_handles[buffer];
+		descrs[buffer].mode = STARPU_R;
+	}
+
+	for (i = 0; i < ntasks; i++)
+	{
+		float f = i;
+		ret = starpu_task_insert(&dummy_codelet,
+					 STARPU_DATA_MODE_ARRAY, descrs, nbuffers,
+					 STARPU_VALUE, &i, sizeof(i),
+					 STARPU_VALUE, &f, sizeof(f),
+					 0);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static int submit_prepared(void)
+{
+	struct starpu_task_insert_prepared *prepared;
+	unsigned i;
+	int ret = 0;
+
+	/* The modes are given once, the handles at each submission */
+	switch (nbuffers)
+	{
+		case 0: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 1: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 2: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 3: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 4: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 5: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 6: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		case 7: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+		default: prepared = starpu_task_insert_prepare(&dummy_codelet, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_R, STARPU_VALUE, sizeof(i), STARPU_VALUE, sizeof(float), 0); break;
+	}
+	STARPU_ASSERT(prepared);
+
+	for (i = 0; i < ntasks; i++)
+	{
+		float f = i;
+		void *values[2] = { &i, &f };
+		ret = starpu_task_insert_prepared_submit(prepared, data_handles, values);
+		if (ret)
+			break;
+	}
+
+	starpu_task_insert_prepared_destroy(prepared);
+	return ret;
+}
+
+static double bench(int (*submit)(void), const char *name, double *timing_exec)
+{
+	double start_submit, end_submit, end_exec;
+	int ret;
+
+	/* Do not let the workers interfere with the submission measurement */
+	starpu_pause();
+	start_submit = starpu_timing_now();
+	ret = submit();
+	end_submit = starpu_timing_now();
+	starpu_resume();
+	if (ret == -ENODEV)
+		return -1.;
+	STARPU_CHECK_RETURN_VALUE(ret, "%s", name);
+
+	starpu_task_wait_for_all();
+	end_exec = starpu_timing_now();
+
+	*timing_exec = end_exec - end_submit;
+	return end_submit - start_submit;
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	unsigned buffer;
+	double timing_insert, timing_prepared;
+	double timing_exec_insert, timing_exec_prepared;
+	struct starpu_conf conf;
+
+	starpu_conf_init(&conf);
+	conf.ncpus = 2;
+
+	parse_args(argc, argv, &conf);
+
+	ret = starpu_initialize(&conf, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (buffer = 0; buffer < nbuffers; buffer++)
+	{
+		starpu_malloc((void**)&buffers[buffer], BUFFERSIZE*sizeof(float));
+		starpu_vector_data_register(&data_handles[buffer], STARPU_MAIN_RAM, (uintptr_t)buffers[buffer], BUFFERSIZE, sizeof(float));
+	}
+
+	fprintf(stderr, "#tasks : %u\n#buffers : %u\n", ntasks, nbuffers);
+
+	timing_insert = bench(submit_insert, "starpu_task_insert", &timing_exec_insert);
+	if (timing_insert < 0.)
+		goto enodev;
+	timing_prepared = bench(submit_prepared, "starpu_task_insert_prepared_submit", &timing_exec_prepared);
+	if (timing_prepared < 0.)
+		goto enodev;
+
+	fprintf(stderr, "starpu_task_insert per task submit: %f usecs\n", timing_insert/ntasks);
+	fprintf(stderr, "starpu_task_insert per task execution: %f usecs\n", timing_exec_insert/ntasks);
+	fprintf(stderr, "prepared per task submit: %f usecs\n", timing_prepared/ntasks);
+	fprintf(stderr, "prepared per task execution: %f usecs\n", timing_exec_prepared/ntasks);
+	fprintf(stderr, "submit speedup: %f\n", timing_insert/timing_prepared);
+
+	{
+		char *output_dir = getenv("STARPU_BENCH_DIR");
+		char *bench_id = getenv("STARPU_BENCH_ID");
+
+		if (output_dir && bench_id)
+		{
+			char file[1024];
+			FILE *f;
+
+			snprintf(file, sizeof(file), "%s/tasks_overhead_per_task_submit_insert_%u.dat", output_dir, nbuffers);
+			f = fopen(file, "a");
+			fprintf(f, "%s\t%f\n", bench_id, timing_insert/ntasks);
+			fclose(f);
+
+			snprintf(file, sizeof(file), "%s/tasks_overhead_per_task_submit_prepared_%u.dat", output_dir, nbuffers);
+			f = fopen(file, "a");
+			fprintf(f, "%s\t%f\n", bench_id, timing_prepared/ntasks);
+			fclose(f);
+		}
+	}
+
+	for (buffer = 0; buffer < nbuffers; buffer++)
+	{
+		starpu_data_unregister(data_handles[buffer]);
+		starpu_free_noflag((void*)buffers[buffer], BUFFERSIZE*sizeof(float));
+	}
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enodev:
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	for (buffer = 0; buffer < nbuffers; buffer++)
+	{
+		starpu_data_unregister(data_handles[buffer]);
+		starpu_free_noflag((void*)buffers[buffer], BUFFERSIZE*sizeof(float));
+	}
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,262 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <core/perfmodel/perfmodel.h>
+#include <math.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Feed a multiple regression model with synthetic measurements, and check the
+ * coefficients computed by recursive least squares (STARPU_MLR_RLS), as well as
+ * their saving and loading, and that coefficients computed before keep being
+ * used until the estimation has enough samples. Compare accuracy and cost with
+ * the batch dgels regression performed when saving the model.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NSAMPLES 500
+#else
+#define NSAMPLES 10000
+#endif
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+/* T = a + b * M^2*N + c * N^3*K */
+#define A 20.
+#define B 0.5
+#define C 0.002
+
+#define NPARAMS 3
+static unsigned combi1[NPARAMS] = { 2, 1, 0 };
+static unsigned combi2[NPARAMS] = { 0, 3, 1 };
+static unsigned *combinations[] = { combi1, combi2 };
+static const char *parameters_names[] = { "M", "N", "K" };
+
+/* Parameters of the sample being recorded */
+static double current[NPARAMS];
+
+static void params(struct starpu_task *task, double *parameters)
+{
+	(void) task;
+	unsigned i;
+	for (i = 0; i < NPARAMS; i++)
+		parameters[i] = current[i];
+}
+
+static struct starpu_perfmodel rls_model =
+{
+	.type = STARPU_MULTIPLE_REGRESSION_BASED,
+	.symbol = "mlr_rls",
+	.parameters = params,
+	.nparameters = NPARAMS,
+	.parameters_names = parameters_names,
+	.ncombinations = 2,
+	.combinations = combinations,
+};
+
+static struct starpu_perfmodel prev_model =
+{
+	.type = STARPU_MULTIPLE_REGRESSION_BASED,
+	.symbol = "mlr_rls_prev",
+	.parameters = params,
+	.nparameters = NPARAMS,
+	.parameters_names = parameters_names,
+	.ncombinations = 2,
+	.combinations = combinations,
+};
+
+#ifdef STARPU_MLR_MODEL
+static struct starpu_perfmodel batch_model =
+{
+	.type = STARPU_MULTIPLE_REGRESSION_BASED,
+	.symbol = "mlr_batch",
+	.parameters = params,
+	.nparameters = NPARAMS,
+	.parameters_names = parameters_names,
+	.ncombinations = 2,
+	.combinations = combinations,
+};
+#endif
+
+static struct starpu_codelet cl =
+{
+	.nbuffers = 0,
+};
+
+static struct starpu_perfmodel_device device = { .type = STARPU_CPU_WORKER, .devid = 0, .ncores = 1 };
+static struct starpu_perfmodel_arch arch = { .ndevices = 1, .devices = &device };
+
+/* Feed the model with the same pseudo-random measurements, and return the
+ * time spent in recording them */
+static double feed(struct starpu_perfmodel *model, unsigned nsamples)
+{
+	struct starpu_task task;
+	unsigned i;
+	double start, end;
+
+	starpu_task_init(&task);
+	cl.model = model;
+	task.cl = &cl;
+
+	starpu_srand48(42);
+	start = starpu_timing_now();
+	for (i = 0; i < nsamples; i++)
+	{
+		double m = 1 + (int) (starpu_drand48() * 32);
+		double n = 1 + (int) (starpu_drand48() * 32);
+		double k = 1 + (int) (starpu_drand48() * 32);
+		double noise = 1. + (starpu_drand48() - 0.5) * 0.02;
+		current[0] = m;
+		current[1] = n;
+		current[2] = k;
+		starpu_perfmodel_update_history(model, &task, &arch, 0, 0, (A + B*m*m*n + C*n*n*n*k) * noise);
+	}
+	end = starpu_timing_now();
+
+	task.cl = NULL;
+	starpu_task_clean(&task);
+	return end - start;
+}
+
+static double error(const double *coeff)
+{
+	double err = fabs(coeff[0] - A) / A;
+	err = STARPU_MAX(err, fabs(coeff[1] - B) / B);
+	err = STARPU_MAX(err, fabs(coeff[2] - C) / C);
+	return err;
+}
+
+static struct _starpu_perfmodel_rls *get_rls(struct starpu_perfmodel *model)
+{
+	int comb = starpu_perfmodel_arch_comb_get(arch.ndevices, arch.devices);
+	STARPU_ASSERT(comb >= 0 && comb < model->state->ncombs_set && model->state->rls[comb]);
+	return &model->state->rls[comb][0];
+}
+
+static int init(const char *rls)
+{
+	struct starpu_conf conf;
+	int ret;
+
+	setenv("STARPU_MLR_RLS", rls, 1);
+	starpu_conf_init(&conf);
+	/* Start from scratch */
+	conf.calibrate = 2;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+	return 0;
+}
+
+int main(void)
+{
+	struct starpu_perfmodel lmodel;
+	struct starpu_perfmodel_per_arch *per_arch;
+	double rls_feed, rls_err;
+	int ret;
+
+	ret = init("1");
+	if (ret)
+		return ret;
+
+	rls_feed = feed(&rls_model, NSAMPLES);
+	per_arch = starpu_perfmodel_get_model_per_arch(&rls_model, &arch, 0);
+	STARPU_ASSERT(per_arch->regression.multi_valid);
+	STARPU_ASSERT(get_rls(&rls_model)->nsample == NSAMPLES);
+	rls_err = error(per_arch->regression.coeff);
+	FPRINTF(stderr, "rls: a=%g b=%g c=%g, max relative error %g, %.2f us per measurement\n",
+		per_arch->regression.coeff[0], per_arch->regression.coeff[1], per_arch->regression.coeff[2],
+		rls_err, rls_feed / NSAMPLES);
+
+	/* Check that saving and loading keeps the estimation state */
+	starpu_save_history_based_model(&rls_model);
+	memset(&lmodel, 0, sizeof(lmodel));
+	lmodel.type = STARPU_MULTIPLE_REGRESSION_BASED;
+	ret = starpu_perfmodel_load_symbol(rls_model.symbol, &lmodel);
+	STARPU_ASSERT(ret == 0);
+	struct starpu_perfmodel_per_arch *lper_arch = starpu_perfmodel_get_model_per_arch(&lmodel, &arch, 0);
+	STARPU_ASSERT(lper_arch->regression.multi_valid);
+	STARPU_ASSERT(get_rls(&lmodel)->p != NULL);
+	STARPU_ASSERT(get_rls(&lmodel)->nsample == NSAMPLES);
+	STARPU_ASSERT(fabs(lper_arch->regression.coeff[1] - per_arch->regression.coeff[1]) <= 1e-5 * fabs(per_arch->regression.coeff[1]));
+	starpu_perfmodel_unload_model(&lmodel);
+
+	/* Coefficients computed before, e.g. loaded from a file, keep being
+	 * used until the estimation has as many samples as coefficients. The
+	 * model would be loaded since we have recorded measurements, start
+	 * from scratch */
+	char path[256];
+	starpu_perfmodel_get_model_path(prev_model.symbol, path, sizeof(path));
+	if (path[0])
+		unlink(path);
+	feed(&prev_model, 1);
+	per_arch = starpu_perfmodel_get_model_per_arch(&prev_model, &arch, 0);
+	STARPU_ASSERT(per_arch->regression.coeff == NULL);
+	STARPU_ASSERT(per_arch->regression.ncoeff == 3);
+	per_arch->regression.coeff = malloc(3*sizeof(double));
+	per_arch->regression.coeff[0] = 1.;
+	per_arch->regression.coeff[1] = 2.;
+	per_arch->regression.coeff[2] = 3.;
+	per_arch->regression.multi_valid = 1;
+	feed(&prev_model, 1);
+	STARPU_ASSERT(per_arch->regression.multi_valid);
+	STARPU_ASSERT(per_arch->regression.coeff[1] == 2.);
+	feed(&prev_model, 1);
+	STARPU_ASSERT(per_arch->regression.multi_valid);
+	STARPU_ASSERT(get_rls(&prev_model)->nsample == 3);
+	STARPU_ASSERT(per_arch->regression.coeff[1] != 2.);
+
+	starpu_shutdown();
+
+	if (rls_err > 0.05)
+	{
+		FPRINTF(stderr, "recursive least squares error too big\n");
+		return EXIT_FAILURE;
+	}
+
+#ifdef STARPU_MLR_MODEL
+	double batch_feed, batch_save, batch_err, start;
+
+	ret = init("0");
+	if (ret)
+		return ret;
+
+	batch_feed = feed(&batch_model, NSAMPLES);
+	start = starpu_timing_now();
+	/* This computes the coefficients */
+	starpu_save_history_based_model(&batch_model);
+	batch_save = starpu_timing_now() - start;
+	per_arch = starpu_perfmodel_get_model_per_arch(&batch_model, &arch, 0);
+	batch_err = error(per_arch->regression.coeff);
+	FPRINTF(stderr, "dgels: a=%g b=%g c=%g, max relative error %g, %.2f us per measurement, %.2f ms to compute\n",
+		per_arch->regression.coeff[0], per_arch->regression.coeff[1], per_arch->regression.coeff[2],
+		batch_err, batch_feed / NSAMPLES, batch_save / 1000.);
+
+	starpu_shutdown();
+#endif
+
+	return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,286 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2024  University of Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Display the performance counters that a running StarPU application
+ * exports in shared memory when STARPU_PERF_COUNTER_EXPORT is set.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include <common/config.h>
+#include <starpu.h>
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define PROGNAME "starpu_perf_counter_display"
+
+/* name of the shared memory region */
+static char *pname = NULL;
+/* interval between two displays in ms, 0 to display only once */
+static int pinterval = 0;
+/* number of displays, 0 for until the application terminates */
+static int pcount = 0;
+/* scope to display, -1 for all */
+static int pscope = -1;
+
+static const char *scope_names[STARPU_PERF_EXPORT_NSCOPES] =
+{
+	[STARPU_PERF_EXPORT_GLOBAL] = "global",
+	[STARPU_PERF_EXPORT_PER_WORKER] = "per_worker",
+	[STARPU_PERF_EXPORT_PER_CODELET] = "per_codelet",
+};
+
+static void usage()
+{
+	fprintf(stderr, "Display the performance counters exported by a StarPU application\n\n");
+	fprintf(stderr, "Usage: %s [ options ]\n", PROGNAME);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "The application has to be run with STARPU_PERF_COUNTER_EXPORT set to the name of\n");
+	fprintf(stderr, "a shared memory region. Each line displays the date of the values, in us, the\n");
+	fprintf(stderr, "scope, the worker or codelet, the counter name, and its value.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "   -n <name>		name of the shared memory region (default: $STARPU_PERF_COUNTER_EXPORT)\n");
+	fprintf(stderr, "   -i <interval>	display the counters every <interval> ms until the application terminates\n");
+	fprintf(stderr, "   -c <count>		display the counters <count> times at most\n");
+	fprintf(stderr, "   -s <scope>		only display the counters of the scope (global, per_worker, per_codelet)\n");
+	fprintf(stderr, "   -h, --help		display this help and exit\n");
+	fprintf(stderr, "   -v, --version	output version information and exit\n\n");
+	fprintf(stderr, "Report bugs to <%s>.", PACKAGE_BUGREPORT);
+	fprintf(stderr, "\n");
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	int i;
+
+	static struct option long_options[] =
+	{
+		{"name",     required_argument, NULL, 'n'},
+		{"interval", required_argument, NULL, 'i'},
+		{"count",    required_argument, NULL, 'c'},
+		{"scope",    required_argument, NULL, 's'},
+		{"help",     no_argument,       NULL, 'h'},
+		{"version",  no_argument,       NULL, 'v'},
+		{0, 0, 0, 0}
+	};
+
+	int option_index;
+	while ((c = getopt_long(argc, argv, "n:i:c:s:hv", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			pname = optarg;
+			break;
+
+		case 'i':
+			pinterval = atoi(optarg);
+			break;
+
+		case 'c':
+			pcount = atoi(optarg);
+			break;
+
+		case 's':
+			for (i = 0; i < STARPU_PERF_EXPORT_NSCOPES; i++)
+				if (strcmp(optarg, scope_names[i]) == 0)
+					pscope = i;
+			if (pscope == -1)
+			{
+				fprintf(stderr, "Unknown scope %s\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+
+		case 'v':
+			fputs(PROGNAME " (" PACKAGE_NAME ") " PACKAGE_VERSION "\n", stderr);
+			exit(EXIT_SUCCESS);
+
+		case '?':
+		default:
+			fprintf(stderr, "Unrecognized option: -%c\n", optopt);
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (pname == NULL)
+		pname = getenv("STARPU_PERF_COUNTER_EXPORT");
+	if (pname == NULL || pname[0] == '\0')
+	{
+		fprintf(stderr, "The name of the shared memory region has to be given with -n or STARPU_PERF_COUNTER_EXPORT\n");
+		usage();
+		exit(EXIT_FAILURE);
+	}
+}
+
+#ifdef HAVE_MMAP
+/* Copy a value block, retrying until it was not updated during the copy */
+static void read_block(const struct starpu_perf_export_block *block, size_t size, struct starpu_perf_export_block *copy)
+{
+	while (1)
+	{
+		uint64_t seq = block->seq;
+		if (seq & 1)
+			continue;
+		STARPU_RMB();
+		memcpy(copy, (const void *) block, size);
+		STARPU_RMB();
+		if (block->seq == seq)
+			return;
+	}
+}
+
+static void display_value(const union starpu_perf_export_value *value, int type)
+{
+	switch (type)
+	{
+		case starpu_perf_counter_type_int32:
+			printf("%"PRId32"\n", value->int32_val);
+			break;
+		case starpu_perf_counter_type_int64:
+			printf("%"PRId64"\n", value->int64_val);
+			break;
+		case starpu_perf_counter_type_float:
+			printf("%f\n", value->float_val);
+			break;
+		case starpu_perf_counter_type_double:
+			printf("%f\n", value->double_val);
+			break;
+		default:
+			printf("?\n");
+	}
+}
+
+static void display(const struct starpu_perf_export_header *header, struct starpu_perf_export_block *copy)
+{
+	const char *base = (const char *) header;
+	const struct starpu_perf_export_counter *counters = (const struct starpu_perf_export_counter *) (base + header->counters_offset);
+	unsigned nblocks[STARPU_PERF_EXPORT_NSCOPES] = { 1, header->nworkers, header->ncodelets };
+	int s;
+	unsigned b, c;
+
+	/* the names of the codelets are set before they are counted */
+	STARPU_RMB();
+
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+	{
+		if (pscope == -1 || pscope == s)
+		{
+			for (b = 0; b < nblocks[s]; b++)
+			{
+				const struct starpu_perf_export_block *block = (const struct starpu_perf_export_block *) (base + header->blocks_offset[s] + b * header->block_size[s]);
+				read_block(block, header->block_size[s], copy);
+				const union starpu_perf_export_value *values = (const union starpu_perf_export_value *) (copy + 1);
+				for (c = 0; c < header->ncounters[s]; c++)
+				{
+					printf("%.0f\t%s\t%s\t%s\t", copy->timestamp, scope_names[s], copy->name, counters[c].name);
+					display_value(&values[c], counters[c].type);
+				}
+			}
+		}
+		counters += header->ncounters[s];
+	}
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	parse_args(argc, argv);
+
+	char name[256];
+	snprintf(name, sizeof(name), "%s%s", pname[0] == '/' ? "" : "/", pname);
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Could not open shared memory region %s: %s\n", name, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(struct starpu_perf_export_header))
+	{
+		fprintf(stderr, "Shared memory region %s is not initialized yet\n", name);
+		close(fd);
+		return EXIT_FAILURE;
+	}
+	void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		fprintf(stderr, "Could not map shared memory region %s: %s\n", name, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	const struct starpu_perf_export_header *header = addr;
+	if (memcmp(header->magic, STARPU_PERF_EXPORT_MAGIC, sizeof(header->magic)) != 0)
+	{
+		fprintf(stderr, "Shared memory region %s does not contain StarPU performance counters\n", name);
+		return EXIT_FAILURE;
+	}
+	STARPU_RMB();
+	if (header->version != STARPU_PERF_EXPORT_VERSION || header->size > (uint64_t) st.st_size)
+	{
+		fprintf(stderr, "Shared memory region %s has version %u, while version %d is supported\n", name, header->version, STARPU_PERF_EXPORT_VERSION);
+		return EXIT_FAILURE;
+	}
+
+	size_t max_block_size = 0;
+	int s;
+	for (s = 0; s < STARPU_PERF_EXPORT_NSCOPES; s++)
+		if (header->block_size[s] > max_block_size)
+			max_block_size = header->block_size[s];
+	struct starpu_perf_export_block *copy = malloc(max_block_size);
+
+	int n = 0;
+	while (1)
+	{
+		int running = header->running;
+		display(header, copy);
+		n++;
+		if (pinterval <= 0 || !running || (pcount > 0 && n >= pcount))
+			break;
+		starpu_usleep(pinterval * 1000.);
+	}
+
+	free(copy);
+	munmap(addr, st.st_size);
+	return EXIT_SUCCESS;
+}
+#else
+int main(int argc, char **argv)
+{
+	parse_args(argc, argv);
+	fprintf(stderr, "Shared memory is not supported on this system\n");
+	return EXIT_FAILURE;
+}
+#endif